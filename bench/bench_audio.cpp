@@ -0,0 +1,100 @@
+#include <benchmark/benchmark.h>
+
+#include "audio/null_audio_sink.h"
+#include "audio/resampler.h"
+#include "core/apu.h"
+#include "core/blip_buffer.h"
+#include "core/scheduler.h"
+
+#include <random>
+#include <utility>
+#include <vector>
+
+using namespace geemuboi::audio;
+using namespace geemuboi::core;
+
+namespace {
+
+const int CLOCK_RATE = 4194304;
+const int SAMPLE_RATE = 48000;
+
+// One flush of the APU output, 8 frame sequencer steps in M-cycles
+const int APU_FRAME_CYCLES = 8 * 2048;
+
+}
+
+
+static void BM_Resampler(benchmark::State& state) {
+    const int FRAMES = 4096;
+    std::mt19937 random(1);
+    std::uniform_int_distribution<int> values(-20000, 20000);
+    std::vector<int16_t> in(FRAMES * 2);
+    for (int16_t& sample : in) {
+        sample = values(random);
+    }
+
+    Resampler resampler;
+    resampler.set_ratio(1.003);
+    std::vector<int16_t> out;
+    out.reserve(FRAMES * 3);
+
+    for (auto _ : state) {
+        out.clear();
+        benchmark::DoNotOptimize(resampler.process(in.data(), FRAMES, out));
+    }
+
+    state.SetItemsProcessed(state.iterations() * FRAMES);
+}
+BENCHMARK(BM_Resampler);
+
+static void BM_BlipBuffer(benchmark::State& state) {
+    // A square wave at 4 kHz on every channel is around 32 steps per sample
+    const int FRAME_CLOCKS = APU_FRAME_CYCLES * 4;
+    const int STEP_CLOCKS = 128;
+    BlipBuffer buffer(CLOCK_RATE, SAMPLE_RATE);
+    std::vector<int16_t> out(4096 * 2);
+
+    int samples = 0;
+    for (auto _ : state) {
+        int delta = 7680;
+        for (int time = 0; time < FRAME_CLOCKS; time += STEP_CLOCKS) {
+            buffer.add_delta(time, delta);
+            delta = -delta;
+        }
+        buffer.end_frame(FRAME_CLOCKS);
+        samples += buffer.read_samples(out.data(), 4096, 2);
+    }
+
+    state.SetItemsProcessed(samples);
+}
+BENCHMARK(BM_BlipBuffer);
+
+static void BM_Apu(benchmark::State& state) {
+    Scheduler scheduler;
+    NullAudioSink sink;
+    APU apu(scheduler, sink);
+
+    apu.write_register(0xFF24, 0x77);
+    apu.write_register(0xFF25, 0xFF);
+    for (uint16_t addr = 0xFF30; addr != 0xFF40; ++addr) {
+        apu.write_register(addr, addr * 37);
+    }
+
+    // All four channels playing, without envelopes or lengths running out
+    const std::pair<uint16_t, uint8_t> TRIGGERS[] = {
+        {0xFF12, 0xF0}, {0xFF13, 0x00}, {0xFF14, 0x87},
+        {0xFF17, 0xA0}, {0xFF18, 0x80}, {0xFF19, 0x86},
+        {0xFF1A, 0x80}, {0xFF1C, 0x20}, {0xFF1D, 0x00}, {0xFF1E, 0x87},
+        {0xFF21, 0xF0}, {0xFF22, 0x21}, {0xFF23, 0x80}
+    };
+    for (const auto& [addr, val] : TRIGGERS) {
+        apu.write_register(addr, val);
+    }
+
+    for (auto _ : state) {
+        scheduler.advance(APU_FRAME_CYCLES);
+    }
+
+    state.SetItemsProcessed(state.iterations() * APU_FRAME_CYCLES * 4LL * SAMPLE_RATE / CLOCK_RATE);
+}
+BENCHMARK(BM_Apu);
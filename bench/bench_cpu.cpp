@@ -0,0 +1,68 @@
+#include <benchmark/benchmark.h>
+
+#include "core/cpu_factory.h"
+#include "core/flat_mmu.h"
+
+#include <vector>
+
+using namespace geemuboi::core;
+using geemuboi::test::core::FlatMmu;
+
+namespace {
+
+const uint16_t PROGRAM_START = 0x100;
+const int CYCLES_PER_ITERATION = 10000;
+
+enum Mixes {
+    MIX_ALU,
+    MIX_MEMORY,
+    MIX_BRANCH,
+    MIX_BITS
+};
+
+// Endless loops of one kind of instruction each
+const std::vector<uint8_t> PROGRAMS[] = {
+    // inc b / inc c / add a,b / xor c / sub c / or b / cpl / rla / ld b,a / jr -11
+    {0x04, 0x0C, 0x80, 0xA9, 0x91, 0xB0, 0x2F, 0x17, 0x47, 0x18, 0xF5},
+    // ld hl,0xC000 / ld a,(hl+) / ld (hl),a / inc (hl) / ld (0xD000),a / ld a,(0xD001) /
+    // push bc / pop de / ld a,h / and 0xCF / ld h,a / jr -17
+    {0x21, 0x00, 0xC0, 0x2A, 0x77, 0x34, 0xEA, 0x00, 0xD0, 0xFA, 0x01, 0xD0,
+     0xC5, 0xD1, 0x7C, 0xE6, 0xCF, 0x67, 0x18, 0xEF},
+    // call 0x10A / dec b / jr nz,-6 / jp 0x100 / 0x10A: dec c / ret nz / ret
+    {0xCD, 0x0A, 0x01, 0x05, 0x20, 0xFA, 0xC3, 0x00, 0x01, 0x00, 0x0D, 0xC0, 0xC9},
+    // swap a / rl c / bit 0,b / set 0,a / srl a / jr -12
+    {0xCB, 0x37, 0xCB, 0x11, 0xCB, 0x40, 0xCB, 0xC7, 0xCB, 0x3F, 0x18, 0xF4}
+};
+
+const char* MIX_NAMES[] = {"alu", "memory", "branch", "bits"};
+
+}
+
+
+// M-cycles per second executing an instruction mix, by mix and CPU type
+static void BM_CpuExecute(benchmark::State& state) {
+    const int mix = state.range(0);
+    FlatMmu mmu;
+    mmu.load(PROGRAM_START, PROGRAMS[mix]);
+    ICpu::Registers regs{};
+    regs.pc = PROGRAM_START;
+    regs.sp = 0xFFFE;
+    std::unique_ptr<ICpu> cpu = create_cpu(mmu, regs, static_cast<CpuType>(state.range(1)));
+
+    uint64_t cycles = 0;
+    for (auto _ : state) {
+        int iteration_cycles = 0;
+        while (iteration_cycles < CYCLES_PER_ITERATION) {
+            iteration_cycles += cpu->execute();
+        }
+        cycles += iteration_cycles;
+    }
+
+    state.SetLabel(MIX_NAMES[mix]);
+    state.counters["m_cycles"] = benchmark::Counter(static_cast<double>(cycles),
+                                                     benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_CpuExecute)
+    ->ArgNames({"mix", "cpu"})
+    ->ArgsProduct({{MIX_ALU, MIX_MEMORY, MIX_BRANCH, MIX_BITS},
+                   {CPU_TYPE_INTERPRETER, CPU_TYPE_CACHED, CPU_TYPE_JIT}});
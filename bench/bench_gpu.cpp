@@ -0,0 +1,76 @@
+#include <benchmark/benchmark.h>
+
+#include "core/gpu.h"
+#include "core/interrupts.h"
+#include "core/scheduler.h"
+#include "view/renderer.h"
+
+#include <cstdint>
+
+using namespace geemuboi::core;
+using namespace geemuboi::view;
+
+namespace {
+
+const int OAM_SPRITES = 40;
+
+class ShadeRenderer : public Renderer {
+public:
+    void render_frame(uint32_t[]) {}
+    bool accepts_shades() const { return true; }
+};
+
+// Gets colors, so every line is expanded as well
+class ColorRenderer : public Renderer {
+public:
+    void render_frame(uint32_t[]) {}
+};
+
+// Tiles and maps full of different values, and every sprite on line 0
+void fill_memory(GPU& gpu) {
+    uint8_t* vram = gpu.get_vram();
+    for (int i = 0; i != 0x2000; ++i) {
+        vram[i] = static_cast<uint8_t>(i * 7 + (i >> 5));
+    }
+
+    uint8_t* oam = gpu.get_oam();
+    for (int i = 0; i != OAM_SPRITES; ++i) {
+        oam[i * 4] = 16;
+        oam[i * 4 + 1] = static_cast<uint8_t>(8 + i * 4);
+        oam[i * 4 + 2] = static_cast<uint8_t>(i);
+        oam[i * 4 + 3] = static_cast<uint8_t>(i & 1 ? 0xA0 : 0x00);
+    }
+}
+
+}
+
+
+// One line at a time by LCDC value, background only or with sprites, tile
+// set and map variants, and the background off
+static void BM_GpuRenderScanline(benchmark::State& state) {
+    ShadeRenderer shade_renderer;
+    ColorRenderer color_renderer;
+    Renderer& renderer = state.range(1) ? static_cast<Renderer&>(color_renderer) : shade_renderer;
+    Scheduler scheduler;
+    Interrupts interrupts;
+    GPU gpu(renderer, scheduler, interrupts);
+    fill_memory(gpu);
+    gpu.set_lcd_control(static_cast<uint8_t>(state.range(0)));
+    gpu.set_bg_palette(0xE4);
+    gpu.set_obj_palette(0, 0xE4);
+    gpu.set_obj_palette(1, 0x1B);
+
+    uint8_t scroll = 0;
+    for (auto _ : state) {
+        // Another row of tiles now and then
+        gpu.set_scroll_x(scroll);
+        gpu.set_scroll_y(scroll);
+        ++scroll;
+        gpu.render_scanline();
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GpuRenderScanline)
+    ->ArgNames({"lcdc", "colors"})
+    ->ArgsProduct({{0x80, 0x91, 0x81, 0x99, 0x93}, {0, 1}});
@@ -0,0 +1,86 @@
+#include <benchmark/benchmark.h>
+
+#include "core/machine.h"
+#include "core/test_roms.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+using namespace geemuboi::core;
+using geemuboi::test::core::make_rom;
+
+namespace {
+
+// Frames run before measuring, so the setup of the ROM isn't measured
+const int WARMUP_FRAMES = 10;
+
+// A homebrew style demo: fills the tiles, maps and sprites with a pattern,
+// turns on the background and sprites, and then scrolls diagonally once
+// every vblank, halting in between. The vblank handler just returns.
+std::vector<uint8_t> make_demo_rom() {
+    return make_rom({
+        // xor a / ldh (0x40),a / ld hl,0x8000
+        0xAF, 0xE0, 0x40, 0x21, 0x00, 0x80,
+        // ld a,l / xor h / ld (hl+),a / ld a,h / cp 0xA0 / jr nz,-8
+        0x7D, 0xAC, 0x22, 0x7C, 0xFE, 0xA0, 0x20, 0xF8,
+        // ld hl,0xFE00 / ld a,l / ld (hl+),a / ld a,l / cp 0xA0 / jr nz,-7
+        0x21, 0x00, 0xFE, 0x7D, 0x22, 0x7D, 0xFE, 0xA0, 0x20, 0xF9,
+        // ld a,0x93 / ldh (0x40),a / ld a,0x01 / ldh (0xFF),a / ei
+        0x3E, 0x93, 0xE0, 0x40, 0x3E, 0x01, 0xE0, 0xFF, 0xFB,
+        // halt / ldh a,(0x43) / inc a / ldh (0x43),a / ldh a,(0x42) / inc a / ldh (0x42),a / jr -13
+        0x76, 0xF0, 0x43, 0x3C, 0xE0, 0x43, 0xF0, 0x42, 0x3C, 0xE0, 0x42, 0x18, 0xF3
+    }, 0x40, {0xD9});
+}
+
+std::vector<uint8_t> read_file(const char* path) {
+    std::ifstream ifs(path, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+}
+
+void run_frames(benchmark::State& state, const std::vector<uint8_t>& rom) {
+    Machine machine(rom, {}, static_cast<CpuType>(state.range(0)));
+    for (int i = 0; i != WARMUP_FRAMES; ++i) {
+        machine.step_frame();
+    }
+
+    for (auto _ : state) {
+        machine.step_frame();
+        benchmark::DoNotOptimize(machine.get_framebuffer());
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+}
+
+
+// Frames per second of the whole machine, CPU, GPU, APU and all
+static void BM_MachineFrame(benchmark::State& state) {
+    run_frames(state, make_demo_rom());
+}
+BENCHMARK(BM_MachineFrame)
+    ->ArgNames({"cpu"})
+    ->Arg(CPU_TYPE_INTERPRETER)
+    ->Arg(CPU_TYPE_CACHED)
+    ->Arg(CPU_TYPE_JIT)
+    ->Unit(benchmark::kMicrosecond);
+
+// The same on a ROM of your own from GEEMUBOI_BENCH_ROM, no ROMs come with
+// the source
+static void BM_MachineFrameRom(benchmark::State& state) {
+    const char* rom_path = std::getenv("GEEMUBOI_BENCH_ROM");
+    if (!rom_path) {
+        state.SkipWithError("Set GEEMUBOI_BENCH_ROM");
+        return;
+    }
+
+    run_frames(state, read_file(rom_path));
+}
+BENCHMARK(BM_MachineFrameRom)
+    ->ArgNames({"cpu"})
+    ->Arg(CPU_TYPE_INTERPRETER)
+    ->Arg(CPU_TYPE_CACHED)
+    ->Arg(CPU_TYPE_JIT)
+    ->Unit(benchmark::kMicrosecond);
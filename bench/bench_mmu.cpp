@@ -0,0 +1,109 @@
+#include <benchmark/benchmark.h>
+
+#include "audio/null_audio_sink.h"
+#include "core/apu.h"
+#include "core/gpu.h"
+#include "core/input.h"
+#include "core/interrupts.h"
+#include "core/mmu.h"
+#include "core/scheduler.h"
+#include "core/serial.h"
+#include "core/timer.h"
+#include "view/renderer.h"
+
+#include <iterator>
+#include <vector>
+
+using namespace geemuboi::audio;
+using namespace geemuboi::core;
+using namespace geemuboi::view;
+
+namespace {
+
+const int ACCESSES_PER_ITERATION = 256;
+
+struct Region {
+    const char* name;
+    uint16_t start;
+    int size;
+};
+
+const Region REGIONS[] = {
+    {"rom", 0x0150, 0x100},
+    {"vram", 0x8000, 0x100},
+    {"wram", 0xC000, 0x100},
+    {"echo", 0xE000, 0x100},
+    {"oam", 0xFE00, 0xA0},
+    {"io", 0xFF42, 2},
+    {"hram", 0xFF80, 0x7F}
+};
+
+class NullRenderer : public Renderer {
+public:
+    void render_frame(uint32_t[]) {}
+    bool accepts_shades() const { return true; }
+};
+
+// Every component the MMU dispatches to, with no BIOS mapped
+struct Bus {
+    Bus() : renderer{},
+        scheduler{},
+        interrupts{},
+        gpu{renderer, scheduler, interrupts},
+        input{},
+        timer{scheduler, interrupts},
+        serial{scheduler, interrupts},
+        audio_sink{},
+        apu{scheduler, audio_sink},
+        mmu{gpu, input, interrupts, timer, serial, scheduler, apu, std::vector<uint8_t>{},
+            std::vector<uint8_t>(0x8000)} {}
+
+    NullRenderer renderer;
+    Scheduler scheduler;
+    Interrupts interrupts;
+    GPU gpu;
+    Input input;
+    Timer timer;
+    Serial serial;
+    NullAudioSink audio_sink;
+    APU apu;
+    MMU mmu;
+};
+
+}
+
+
+static void BM_MmuRead(benchmark::State& state) {
+    const Region& region = REGIONS[state.range(0)];
+    Bus bus;
+
+    for (auto _ : state) {
+        uint8_t sum = 0;
+        for (int i = 0; i != ACCESSES_PER_ITERATION; ++i) {
+            sum += bus.mmu.read_byte(static_cast<uint16_t>(region.start + i % region.size));
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+
+    state.SetLabel(region.name);
+    state.SetItemsProcessed(state.iterations() * ACCESSES_PER_ITERATION);
+}
+BENCHMARK(BM_MmuRead)->ArgNames({"region"})->DenseRange(0, std::size(REGIONS) - 1);
+
+static void BM_MmuWrite(benchmark::State& state) {
+    const Region& region = REGIONS[state.range(0)];
+    Bus bus;
+
+    for (auto _ : state) {
+        for (int i = 0; i != ACCESSES_PER_ITERATION; ++i) {
+            bus.mmu.write_byte(static_cast<uint16_t>(region.start + i % region.size),
+                               static_cast<uint8_t>(i));
+        }
+        benchmark::ClobberMemory();
+    }
+
+    state.SetLabel(region.name);
+    state.SetItemsProcessed(state.iterations() * ACCESSES_PER_ITERATION);
+}
+// Writes to the ROM would switch banks, so it's left out
+BENCHMARK(BM_MmuWrite)->ArgNames({"region"})->DenseRange(1, std::size(REGIONS) - 1);
@@ -0,0 +1,71 @@
+#include <benchmark/benchmark.h>
+
+#include "core/hash.h"
+#include "core/machine.h"
+#include "core/movie.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+using namespace geemuboi::core;
+
+namespace {
+
+// Frames played after the last button change, so the run ends in gameplay
+// and not at the last input
+const int TAIL_FRAMES = 60;
+
+std::vector<uint8_t> read_file(const char* path) {
+    std::ifstream ifs(path, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+}
+
+}
+
+
+// Frames per second playing back real gameplay. The ROM and a movie
+// recorded on it without a BIOS come from GEEMUBOI_BENCH_ROM and
+// GEEMUBOI_BENCH_MOVIE, only the CPU type of the movie runs.
+static void BM_MoviePlayback(benchmark::State& state) {
+    const char* rom_path = std::getenv("GEEMUBOI_BENCH_ROM");
+    const char* movie_path = std::getenv("GEEMUBOI_BENCH_MOVIE");
+    if (!rom_path || !movie_path) {
+        state.SkipWithError("Set GEEMUBOI_BENCH_ROM and GEEMUBOI_BENCH_MOVIE");
+        return;
+    }
+
+    std::vector<uint8_t> rom = read_file(rom_path);
+    Movie movie = read_movie(movie_path);
+    if (movie.rom_hash != hash_bytes(rom.data(), rom.size()) ||
+        movie.bios_hash != hash_bytes(nullptr, 0)) {
+        state.SkipWithError("The movie was recorded with another ROM or with a BIOS");
+        return;
+    }
+
+    const CpuType cpu_type = static_cast<CpuType>(state.range(0));
+    if (movie.cpu_type != cpu_type) {
+        state.SkipWithError("The movie was recorded with another CPU type");
+        return;
+    }
+    const uint64_t frames = (movie.events.empty() ? 0 : movie.events.back().frame) + TAIL_FRAMES;
+
+    for (auto _ : state) {
+        Machine machine(rom, {}, cpu_type);
+        MoviePlayer player(movie, machine.get_input(), machine.get_scheduler(), cpu_type);
+        // Guest frames, so that it ends at the same point whatever the LCD does
+        while (machine.get_time() < frames * GPU::CYCLES_PER_FRAME) {
+            machine.run_until(frames * GPU::CYCLES_PER_FRAME);
+        }
+        benchmark::DoNotOptimize(machine.get_framebuffer());
+    }
+
+    state.SetItemsProcessed(state.iterations() * frames);
+}
+BENCHMARK(BM_MoviePlayback)
+    ->ArgNames({"cpu"})
+    ->Arg(CPU_TYPE_INTERPRETER)
+    ->Arg(CPU_TYPE_CACHED)
+    ->Arg(CPU_TYPE_JIT)
+    ->Unit(benchmark::kMillisecond);
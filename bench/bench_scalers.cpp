@@ -0,0 +1,51 @@
+#include <benchmark/benchmark.h>
+
+#include "view/renderer.h"
+#include "view/scaler.h"
+
+#include <random>
+#include <vector>
+
+using namespace geemuboi::view;
+
+namespace {
+
+const int PIXELS = Renderer::SCREEN_WIDTH * Renderer::SCREEN_HEIGHT;
+
+// Tiles of random shades, so that the filters find edges to work on
+std::vector<uint32_t> make_screen() {
+    const uint32_t COLORS[] = {0xFFFFFF, 0xC0C0C0, 0x5C5C5C, 0x000000};
+    std::mt19937 random(1);
+    std::uniform_int_distribution<int> shades(0, 3);
+
+    std::vector<uint32_t> screen(PIXELS);
+    for (uint32_t& pixel : screen) {
+        pixel = COLORS[shades(random) & shades(random)];
+    }
+    return screen;
+}
+
+}
+
+
+static void BM_Scaler(benchmark::State& state) {
+    Scaler scaler(state.range(0), state.range(1));
+    int factor = scaler.get_factor();
+    std::vector<uint32_t> src = make_screen();
+    std::vector<uint32_t> dst(PIXELS * factor * factor);
+
+    for (auto _ : state) {
+        scaler.scale(src.data(), Renderer::SCREEN_WIDTH, dst.data(),
+                     Renderer::SCREEN_WIDTH * factor);
+        benchmark::DoNotOptimize(dst.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * PIXELS);
+}
+BENCHMARK(BM_Scaler)
+    ->ArgNames({"filter", "factor"})
+    ->Args({Scaler::FILTER_NEAREST, 2})
+    ->Args({Scaler::FILTER_NEAREST, 3})
+    ->Args({Scaler::FILTER_SCALE2X, 2})
+    ->Args({Scaler::FILTER_SCALE3X, 3})
+    ->Args({Scaler::FILTER_XBR_LITE, 2});
@@ -0,0 +1,43 @@
+#include <benchmark/benchmark.h>
+
+#include "core/test_roms.h"
+#include "core/vec_machine.h"
+
+#include <vector>
+
+using namespace geemuboi::core;
+using geemuboi::test::core::make_rom;
+
+namespace {
+
+// Reads the joypad and keeps a counter in WRAM:
+// ld a,0x10 / ldh (0x00),a / ldh a,(0x00) / ld hl,0xC000 / inc (hl) / jr -12
+std::vector<uint8_t> make_counter_rom() {
+    return make_rom({0x3E, 0x10, 0xE0, 0x00, 0xF0, 0x00, 0x21, 0x00, 0xC0, 0x34, 0x18, 0xF4});
+}
+
+}
+
+
+// Frames per second over all machines, by number of machines and threads
+static void BM_VecMachine(benchmark::State& state) {
+    const int count = state.range(0);
+    const int frames = 4;
+    VecMachine machines(count, make_counter_rom(), VecMachine::OBSERVATION_PIXELS, 2, state.range(1));
+    std::vector<uint8_t> actions(count);
+    std::vector<uint8_t> observations(count * machines.get_observation_size());
+
+    for (auto _ : state) {
+        machines.step(actions.data(), frames, observations.data());
+        benchmark::DoNotOptimize(observations.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * count * frames);
+}
+BENCHMARK(BM_VecMachine)
+    ->ArgNames({"machines", "threads"})
+    ->Args({16, 1})
+    ->Args({16, 4})
+    ->Args({64, 0})
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
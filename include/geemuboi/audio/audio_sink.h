@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+
+namespace geemuboi::audio {
+
+
+class AudioSink {
+public:
+    virtual ~AudioSink() {}
+
+    virtual int get_sample_rate() const = 0;
+    // Interleaved left and right samples, frames is the number of pairs.
+    virtual void write_samples(const int16_t* samples, int frames) = 0;
+
+    // Blocks until the buffered audio has played down to the sink's target
+    // latency. Returns false if the sink has no clock to pace emulation by.
+    virtual bool wait_until_drained() { return false; }
+};
+
+
+}
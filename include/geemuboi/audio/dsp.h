@@ -0,0 +1,176 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace geemuboi::audio::dsp {
+
+
+// Inner loops of the audio path. The vector versions are picked when the
+// build targets them, SSE2 is always there on x86-64 and AVX2 is enabled
+// with GEEMUBOI_AVX2. The scalar versions are the reference.
+
+namespace scalar {
+
+inline void add_impulse(int32_t* dst, const int16_t* kernel, int width, int delta) {
+    for (int i = 0; i != width; ++i) {
+        dst[i] += delta * kernel[i];
+    }
+}
+
+inline void interpolate_cubic(const float* in, const int32_t* index, const float* t, int count,
+                              float* out) {
+    for (int i = 0; i != count; ++i) {
+        const float* taps = in + index[i];
+        float t1 = t[i];
+        float t2 = t1 * t1;
+        float t3 = t2 * t1;
+        out[i] = (-0.5f * t3 + t2 - 0.5f * t1) * taps[0] +
+            (1.5f * t3 - 2.5f * t2 + 1.0f) * taps[1] +
+            (-1.5f * t3 + 2.0f * t2 + 0.5f * t1) * taps[2] +
+            (0.5f * t3 - 0.5f * t2) * taps[3];
+    }
+}
+
+inline int16_t to_sample(float value) {
+    return static_cast<int16_t>(std::clamp(std::nearbyint(value), -32768.0f, 32767.0f));
+}
+
+inline void interleave(const float* left, const float* right, int count, int16_t* out) {
+    for (int i = 0; i != count; ++i) {
+        out[i * 2] = to_sample(left[i]);
+        out[i * 2 + 1] = to_sample(right[i]);
+    }
+}
+
+}
+
+#if defined(__SSE2__)
+
+namespace simd {
+
+// Width must be a multiple of 8 and delta fit in 16 bits.
+inline void add_impulse(int32_t* dst, const int16_t* kernel, int width, int delta) {
+    __m128i deltas = _mm_set1_epi16(static_cast<int16_t>(delta));
+    for (int i = 0; i != width; i += 8) {
+        __m128i taps = _mm_loadu_si128(reinterpret_cast<const __m128i*>(kernel + i));
+        __m128i low = _mm_mullo_epi16(taps, deltas);
+        __m128i high = _mm_mulhi_epi16(taps, deltas);
+
+        __m128i* out = reinterpret_cast<__m128i*>(dst + i);
+        _mm_storeu_si128(out, _mm_add_epi32(_mm_loadu_si128(out), _mm_unpacklo_epi16(low, high)));
+        _mm_storeu_si128(out + 1,
+                         _mm_add_epi32(_mm_loadu_si128(out + 1), _mm_unpackhi_epi16(low, high)));
+    }
+}
+
+#if defined(__AVX2__)
+
+inline void interpolate_cubic(const float* in, const int32_t* index, const float* t, int count,
+                              float* out) {
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i indices = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(index + i));
+        __m256 t1 = _mm256_loadu_ps(t + i);
+        __m256 t2 = _mm256_mul_ps(t1, t1);
+        __m256 t3 = _mm256_mul_ps(t2, t1);
+        __m256 half = _mm256_set1_ps(0.5f);
+        __m256 one_half = _mm256_set1_ps(1.5f);
+
+        __m256 w0 = _mm256_sub_ps(_mm256_sub_ps(t2, _mm256_mul_ps(half, t3)),
+                                  _mm256_mul_ps(half, t1));
+        __m256 w1 = _mm256_add_ps(_mm256_sub_ps(_mm256_mul_ps(one_half, t3),
+                                                _mm256_mul_ps(_mm256_set1_ps(2.5f), t2)),
+                                  _mm256_set1_ps(1.0f));
+        __m256 w2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(-1.5f), t3),
+                                                _mm256_mul_ps(_mm256_set1_ps(2.0f), t2)),
+                                  _mm256_mul_ps(half, t1));
+        __m256 w3 = _mm256_sub_ps(_mm256_mul_ps(half, t3), _mm256_mul_ps(half, t2));
+
+        __m256 sum = _mm256_mul_ps(w0, _mm256_i32gather_ps(in, indices, 4));
+        sum = _mm256_add_ps(sum, _mm256_mul_ps(w1, _mm256_i32gather_ps(in + 1, indices, 4)));
+        sum = _mm256_add_ps(sum, _mm256_mul_ps(w2, _mm256_i32gather_ps(in + 2, indices, 4)));
+        sum = _mm256_add_ps(sum, _mm256_mul_ps(w3, _mm256_i32gather_ps(in + 3, indices, 4)));
+        _mm256_storeu_ps(out + i, sum);
+    }
+
+    scalar::interpolate_cubic(in, index + i, t + i, count - i, out + i);
+}
+
+#else
+
+inline void interpolate_cubic(const float* in, const int32_t* index, const float* t, int count,
+                              float* out) {
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const int32_t* at = index + i;
+        __m128 t1 = _mm_loadu_ps(t + i);
+        __m128 t2 = _mm_mul_ps(t1, t1);
+        __m128 t3 = _mm_mul_ps(t2, t1);
+        __m128 half = _mm_set1_ps(0.5f);
+        __m128 one_half = _mm_set1_ps(1.5f);
+
+        __m128 w0 = _mm_sub_ps(_mm_sub_ps(t2, _mm_mul_ps(half, t3)), _mm_mul_ps(half, t1));
+        __m128 w1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(one_half, t3),
+                                          _mm_mul_ps(_mm_set1_ps(2.5f), t2)),
+                               _mm_set1_ps(1.0f));
+        __m128 w2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(-1.5f), t3),
+                                          _mm_mul_ps(_mm_set1_ps(2.0f), t2)),
+                               _mm_mul_ps(half, t1));
+        __m128 w3 = _mm_sub_ps(_mm_mul_ps(half, t3), _mm_mul_ps(half, t2));
+
+        // No gather before AVX2, the four taps of each output are adjacent
+        __m128 taps0 = _mm_loadu_ps(in + at[0]);
+        __m128 taps1 = _mm_loadu_ps(in + at[1]);
+        __m128 taps2 = _mm_loadu_ps(in + at[2]);
+        __m128 taps3 = _mm_loadu_ps(in + at[3]);
+        _MM_TRANSPOSE4_PS(taps0, taps1, taps2, taps3);
+
+        __m128 sum = _mm_mul_ps(w0, taps0);
+        sum = _mm_add_ps(sum, _mm_mul_ps(w1, taps1));
+        sum = _mm_add_ps(sum, _mm_mul_ps(w2, taps2));
+        sum = _mm_add_ps(sum, _mm_mul_ps(w3, taps3));
+        _mm_storeu_ps(out + i, sum);
+    }
+
+    scalar::interpolate_cubic(in, index + i, t + i, count - i, out + i);
+}
+
+#endif
+
+inline void interleave(const float* left, const float* right, int count, int16_t* out) {
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        // Conversion rounds to nearest even and the pack saturates
+        __m128i l = _mm_cvtps_epi32(_mm_loadu_ps(left + i));
+        __m128i r = _mm_cvtps_epi32(_mm_loadu_ps(right + i));
+        __m128i frames = _mm_packs_epi32(_mm_unpacklo_epi32(l, r), _mm_unpackhi_epi32(l, r));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 2), frames);
+    }
+
+    scalar::interleave(left + i, right + i, count - i, out + i * 2);
+}
+
+}
+
+using simd::add_impulse;
+using simd::interpolate_cubic;
+using simd::interleave;
+
+#else
+
+using scalar::add_impulse;
+using scalar::interpolate_cubic;
+using scalar::interleave;
+
+#endif
+
+
+}
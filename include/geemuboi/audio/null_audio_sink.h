@@ -0,0 +1,18 @@
+#pragma once
+
+#include "audio/audio_sink.h"
+
+namespace geemuboi::audio {
+
+
+// Discards everything, for running without an audio device.
+class NullAudioSink : public AudioSink {
+public:
+    static const int SAMPLE_RATE = 48000;
+
+    int get_sample_rate() const { return SAMPLE_RATE; }
+    void write_samples(const int16_t*, int) {}
+};
+
+
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace geemuboi::audio {
+
+
+// Cubic Hermite resampler for interleaved stereo. The ratio can be changed
+// between calls without discontinuities, which is what rate control needs.
+//
+// Output positions are found first, then both channels are interpolated
+// as planar blocks by the vector kernels in dsp.h.
+class Resampler {
+public:
+    Resampler();
+
+    // Output frames per input frame
+    void set_ratio(double ratio);
+    double get_ratio() const;
+
+    // Appends the resampled frames to out and returns how many there were.
+    int process(const int16_t* in, int frames, std::vector<int16_t>& out);
+
+private:
+    static const int TAPS = 4;
+
+    // Input frames per output frame
+    double step;
+    // Between the second and third tap, in input frames
+    double position;
+
+    // Planar input, starting with the last TAPS - 1 frames of the previous call
+    std::vector<float> left_in;
+    std::vector<float> right_in;
+    std::vector<int32_t> indices;
+    std::vector<float> fractions;
+    std::vector<float> left_out;
+    std::vector<float> right_out;
+};
+
+
+}
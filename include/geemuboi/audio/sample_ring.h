@@ -0,0 +1,33 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace geemuboi::audio {
+
+
+// Lock-free ring of stereo frames for exactly one writing and one reading
+// thread. Neither side ever blocks, frames that don't fit are dropped.
+class SampleRing {
+public:
+    // Capacity is rounded up to a power of two
+    explicit SampleRing(int capacity);
+
+    int write(const int16_t* samples, int frames);
+    int read(int16_t* samples, int frames);
+    int get_frames_available() const;
+    int get_capacity() const;
+
+private:
+    std::vector<int16_t> samples;
+    std::size_t mask;
+
+    // Both only grow, their difference is the number of frames stored
+    std::atomic<std::size_t> write_index;
+    std::atomic<std::size_t> read_index;
+};
+
+
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "audio/audio_sink.h"
+#include "audio/resampler.h"
+#include "audio/sample_ring.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include <SDL2/SDL.h>
+
+namespace geemuboi::audio {
+
+
+// Plays samples on the default SDL audio device. The emulator thread writes
+// into a ring that SDL's audio thread drains from its callback.
+//
+// The emulated and the device clock never quite agree, so samples are
+// resampled at a ratio nudged by up to half a percent towards keeping the
+// ring at its target fill level.
+class SDLAudioSink : public AudioSink {
+public:
+    SDLAudioSink();
+    ~SDLAudioSink();
+
+    int get_sample_rate() const;
+    void write_samples(const int16_t* samples, int frames);
+    bool wait_until_drained();
+
+private:
+    static const int SAMPLE_RATE = 48000;
+    static const int DEVICE_FRAMES = 512;
+    static const int RING_FRAMES = 8192;
+    static const int TARGET_FRAMES = 2048;
+    static constexpr double MAX_RATE_DELTA = 0.005;
+
+    static void callback(void* userdata, Uint8* stream, int length);
+
+    SampleRing ring;
+    SDL_AudioDeviceID device;
+
+    Resampler resampler;
+    std::vector<int16_t> resampled;
+
+    std::mutex drained_mutex;
+    std::condition_variable drained;
+};
+
+
+}
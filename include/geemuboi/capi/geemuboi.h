@@ -0,0 +1,78 @@
+#pragma once
+
+/*
+ * C interface for embedding the emulator. Every machine is independent of
+ * the others, any number of them can be driven from different threads as
+ * long as each one is only used by one thread at a time.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Bumped whenever the interface changes incompatibly, as is the SOVERSION */
+#define GEEMUBOI_API_VERSION 1
+
+#define GEEMUBOI_SCREEN_WIDTH 160
+#define GEEMUBOI_SCREEN_HEIGHT 144
+
+typedef struct geemuboi_machine geemuboi_machine;
+
+enum geemuboi_result {
+    GEEMUBOI_OK = 0,
+    GEEMUBOI_ERROR_INVALID_ARGUMENT = -1,
+    GEEMUBOI_ERROR_NO_ROM = -2,
+    GEEMUBOI_ERROR_INVALID_STATE = -3,
+    GEEMUBOI_ERROR_BUFFER_TOO_SMALL = -4,
+    GEEMUBOI_ERROR_EMULATION = -5
+};
+
+enum geemuboi_buttons {
+    GEEMUBOI_BUTTON_A = 0x01,
+    GEEMUBOI_BUTTON_B = 0x02,
+    GEEMUBOI_BUTTON_SELECT = 0x04,
+    GEEMUBOI_BUTTON_START = 0x08,
+    GEEMUBOI_BUTTON_RIGHT = 0x10,
+    GEEMUBOI_BUTTON_LEFT = 0x20,
+    GEEMUBOI_BUTTON_UP = 0x40,
+    GEEMUBOI_BUTTON_DOWN = 0x80
+};
+
+int geemuboi_api_version(void);
+
+/* NULL if out of memory */
+geemuboi_machine* geemuboi_create(void);
+void geemuboi_destroy(geemuboi_machine* machine);
+
+/*
+ * Copies the ROM and powers the machine on, replacing anything loaded
+ * before. Without a BIOS (NULL, 0) it starts out the way the BIOS leaves it.
+ */
+int geemuboi_load_rom(geemuboi_machine* machine, const uint8_t* rom, size_t rom_size,
+                      const uint8_t* bios, size_t bios_size);
+
+/* Runs until a whole frame has been drawn */
+int geemuboi_step_frame(geemuboi_machine* machine);
+
+/* A mask of geemuboi_buttons held down, until set again */
+int geemuboi_set_input(geemuboi_machine* machine, uint8_t buttons);
+
+/*
+ * GEEMUBOI_SCREEN_WIDTH x GEEMUBOI_SCREEN_HEIGHT pixels as 0x00RRGGBB. The
+ * pointer stays valid until the next geemuboi_load_rom or geemuboi_destroy.
+ * NULL if no ROM is loaded.
+ */
+const uint32_t* geemuboi_get_framebuffer(const geemuboi_machine* machine);
+
+/* Every state of a loaded machine has this size, 0 if no ROM is loaded */
+size_t geemuboi_get_state_size(const geemuboi_machine* machine);
+int geemuboi_save_state(const geemuboi_machine* machine, uint8_t* buffer, size_t size);
+/* A state that is rejected leaves the machine as it was */
+int geemuboi_load_state(geemuboi_machine* machine, const uint8_t* buffer, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "audio/audio_sink.h"
+#include "core/blip_buffer.h"
+#include "core/scheduler.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace geemuboi::core {
+
+
+// The two square channels, the wave channel and the noise channel. Nothing
+// is stepped per CPU cycle: channels are rendered up to the current time
+// when a register is written and at frame sequencer events, and the mixed
+// output is passed to the sink every 8 frame sequencer steps, 16384
+// M-cycles or about once per video frame.
+class APU {
+public:
+    APU(Scheduler& scheduler_in, geemuboi::audio::AudioSink& sink_in);
+
+    uint8_t read_register(uint16_t addr);
+    void write_register(uint16_t addr, uint8_t val);
+
+    void save_state(StateWriter& writer) const;
+    void load_state(StateReader& reader);
+
+    static const uint16_t FIRST_REGISTER = 0xFF10;
+    static const uint16_t LAST_REGISTER = 0xFF3F;
+
+private:
+    enum Registers {
+        REG_NR10 = 0x00,
+        REG_NR11 = 0x01,
+        REG_NR12 = 0x02,
+        REG_NR13 = 0x03,
+        REG_NR14 = 0x04,
+        REG_NR21 = 0x06,
+        REG_NR22 = 0x07,
+        REG_NR23 = 0x08,
+        REG_NR24 = 0x09,
+        REG_NR30 = 0x0A,
+        REG_NR31 = 0x0B,
+        REG_NR32 = 0x0C,
+        REG_NR33 = 0x0D,
+        REG_NR34 = 0x0E,
+        REG_NR41 = 0x10,
+        REG_NR42 = 0x11,
+        REG_NR43 = 0x12,
+        REG_NR44 = 0x13,
+        REG_NR50 = 0x14,
+        REG_NR51 = 0x15,
+        REG_NR52 = 0x16,
+        REG_WAVE_RAM = 0x20
+    };
+
+    enum ChannelIndex {
+        CHANNEL_SQUARE_1,
+        CHANNEL_SQUARE_2,
+        CHANNEL_WAVE,
+        CHANNEL_NOISE,
+        NBR_CHANNELS
+    };
+
+    struct Channel {
+        bool enabled;
+        bool dac_enabled;
+        int length;
+        bool length_enabled;
+
+        int volume;
+        int envelope_period;
+        int envelope_timer;
+        bool envelope_increase;
+
+        int position;
+        uint64_t next_step_time;
+        uint16_t lfsr;
+
+        // Amplitudes currently in the output buffers
+        int left;
+        int right;
+    };
+
+    // In T-cycles, the channels step at up to a quarter M-cycle
+    static const int CLOCK_RATE = 4194304;
+    static const int FRAME_SEQUENCER_CYCLES = 2048;
+    static const int FRAME_SEQUENCER_STEPS = 8;
+    static const int AMPLITUDE_SCALE = 64;
+    static const int MAX_FRAME_SAMPLES = 4096;
+
+    void step_frame_sequencer();
+    void clock_lengths();
+    void clock_sweep();
+    void clock_envelopes();
+    int calculate_sweep();
+
+    void render(uint64_t time);
+    void render_channel(int index, uint64_t time);
+    void step_channel(int index);
+    void flush();
+
+    void trigger(int index);
+    void set_output(int index, uint64_t time);
+    void update_outputs(uint64_t time);
+    void power_off();
+
+    int get_digital(int index) const;
+    int get_period(int index) const;
+    uint64_t get_time() const;
+
+    Scheduler& scheduler;
+    geemuboi::audio::AudioSink& sink;
+
+    BlipBuffer left_buffer;
+    BlipBuffer right_buffer;
+    std::vector<int16_t> samples;
+
+    uint8_t registers[0x30];
+    Channel channels[NBR_CHANNELS];
+    bool powered;
+    int frame_sequencer_step;
+
+    int sweep_timer;
+    bool sweep_enabled;
+    int sweep_shadow;
+
+    uint64_t frame_start_time;
+};
+
+
+}
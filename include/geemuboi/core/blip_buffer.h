@@ -0,0 +1,50 @@
+#pragma once
+
+#include "core/state.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace geemuboi::core {
+
+
+// Band-limited synthesis of a signal that only changes in steps. Every
+// step is added as a windowed-sinc impulse at its exact fractional sample
+// position, so square waves come out without the aliasing a naive
+// point-sampled output has.
+class BlipBuffer {
+public:
+    BlipBuffer(int clock_rate, int sample_rate);
+
+    // Steps the signal by delta at time, in clocks since the last end_frame.
+    // Deltas have to fit in 16 bits.
+    void add_delta(uint32_t time, int delta);
+    // Makes the samples before time available for reading.
+    void end_frame(uint32_t time);
+    int get_samples_available() const;
+    // Reads samples into every stride'th element of out.
+    int read_samples(int16_t* out, int count, int stride);
+
+    void save_state(StateWriter& writer) const;
+    void load_state(StateReader& reader);
+
+private:
+    static const int FRAC_BITS = 32;
+    static const int PHASE_BITS = 5;
+    static const int PHASES = 1 << PHASE_BITS;
+    static const int KERNEL_WIDTH = 16;
+    static const int KERNEL_BITS = 12;
+    // High-pass that removes the DC offset, in the style of a capacitor
+    static const int BASS_SHIFT = 9;
+    static const int BUFFER_SAMPLES = 4096;
+
+    uint64_t factor;
+    // Position of the frame start in samples, FRAC_BITS fixed point
+    uint64_t offset;
+    int32_t integrator;
+    std::vector<int32_t> buffer;
+    int16_t kernel[PHASES][KERNEL_WIDTH];
+};
+
+
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace geemuboi::core {
+
+
+// Little endian regardless of the host, for files shared between machines
+inline void write_fixed(std::vector<uint8_t>& out, uint64_t val, int size) {
+    for (int i = 0; i != size; ++i) {
+        out.push_back(static_cast<uint8_t>(val >> (8 * i)));
+    }
+}
+
+// Seven bits per byte, the top bit is set on all but the last
+inline void write_varint(std::vector<uint8_t>& out, uint64_t val) {
+    while (val >= 0x80) {
+        out.push_back(static_cast<uint8_t>(val | 0x80));
+        val >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(val));
+}
+
+
+// Reads what the functions above write. Running out of data or an overlong
+// varint throws an Exception, constructed from a message naming the format.
+template <typename Exception>
+class ByteReader {
+public:
+    ByteReader(const uint8_t* data_in, size_t size_in, const std::string& format_in)
+        : data{data_in}, size{size_in}, position{}, format{format_in} {}
+
+    uint64_t read_fixed(int bytes) {
+        const uint8_t* in = read_bytes(bytes);
+        uint64_t val = 0;
+        for (int i = 0; i != bytes; ++i) {
+            val |= static_cast<uint64_t>(in[i]) << (8 * i);
+        }
+        return val;
+    }
+
+    uint64_t read_varint() {
+        uint64_t val = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            uint64_t byte = read_fixed(1);
+            val |= (byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                return val;
+            }
+        }
+
+        throw Exception("The " + format + " has an invalid number.");
+    }
+
+    const uint8_t* read_bytes(uint64_t count) {
+        if (count > size - position) {
+            throw Exception("The " + format + " is truncated.");
+        }
+
+        const uint8_t* bytes = data + position;
+        position += count;
+        return bytes;
+    }
+
+    bool at_end() const { return position == size; }
+
+private:
+    const uint8_t* data;
+    size_t size;
+    size_t position;
+    std::string format;
+};
+
+
+}
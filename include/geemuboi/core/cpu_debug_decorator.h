@@ -20,8 +20,13 @@ public:
         const std::unordered_set<uint16_t>& breakpoints_in);
 
     virtual int execute();
+    virtual int execute(int max_cycles);
     virtual unsigned get_cycles_executed();
+    virtual void sync_registers();
+    virtual void save_state(StateWriter& writer) const;
+    virtual void load_state(StateReader& reader);
 private:
+    std::string get_instruction_name(uint8_t opcode) const;
     void print_breakpoint() const;
     void print_cpu_context() const;
     void print_stack(int before, int after) const;
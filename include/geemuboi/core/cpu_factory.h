@@ -2,13 +2,27 @@
 
 #include "core/icpu.h"
 #include "core/immu.h"
+#include "core/interrupts.h"
+#include "core/scheduler.h"
 
 #include <memory>
 
 namespace geemuboi::core {
 
 
-std::unique_ptr<ICpu> create_cpu(IMmu& mmu, ICpu::Registers& regs);
+enum CpuType {
+    CPU_TYPE_INTERPRETER,
+    CPU_TYPE_CACHED,
+    // Recompiles to x86-64, the cached interpreter on other hosts
+    CPU_TYPE_JIT
+};
+
+// With a scheduler, halt and idle loops fast-forward to its next event.
+// Interrupts are only dispatched if interrupts is given.
+std::unique_ptr<ICpu> create_cpu(IMmu& mmu, ICpu::Registers& regs,
+                                 CpuType type = CPU_TYPE_INTERPRETER,
+                                 const Scheduler* scheduler = nullptr,
+                                 Interrupts* interrupts = nullptr);
 
 
 }
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "core/interrupts.h"
+#include "core/scheduler.h"
 #include "view/renderer.h"
 
 #include <cstdint>
@@ -9,11 +11,12 @@ namespace geemuboi::core {
 
 class GPU {
 public:
-    GPU(geemuboi::view::Renderer& renderer_in);
+    GPU(geemuboi::view::Renderer& renderer_in, Scheduler& scheduler_in, Interrupts& interrupts_in);
 
-    void step(int cpu_cycles);
     void write_byte_vram(uint16_t addr, uint8_t val);
     void write_word_vram(uint16_t addr, uint16_t val);
+    uint8_t* get_vram();
+    uint8_t* get_oam();
     uint8_t read_byte_oam(uint16_t addr) const;
     void write_byte_oam(uint16_t addr, uint8_t val);
     uint16_t read_word_oam(uint16_t addr) const;
@@ -33,12 +36,17 @@ public:
     uint8_t get_obj_palette(int index);
     void set_obj_palette(int index, uint8_t val);
 
+    // The frame being drawn is left to the renderer
+    void save_state(StateWriter& writer) const;
+    void load_state(StateReader& reader);
+
+    // In M-cycles, like the scheduler
     enum Cycles {
         CYCLES_HORIZONTAL_BLANK = 51,
         CYCLES_VERTICAL_BLANK = 114,
         CYCLES_SCANLINE_OAM = 20,
         CYCLES_SCANLINE_VRAM = 43,
-        CYCLES_PER_FRAME = 70224
+        CYCLES_PER_FRAME = 154 * CYCLES_VERTICAL_BLANK
     };
 private:
     enum States {
@@ -67,13 +75,6 @@ private:
         LCD_CONTROL_DISPLAY = 0x80
     };
 
-    enum PixelColors {
-        PIXEL_COLOR_WHITE = 0x00FFFFFF,
-        PIXEL_COLOR_LIGHT_GREY = 0x00C0C0C0,
-        PIXEL_COLOR_DARK_GREY = 0x005C5C5C,
-        PIXEL_COLOR_BLACK = 0x00000000
-    };
-
     static const int LAST_LINE = 143;
     static const int VBLANK_LAST_LINE = 153;
 
@@ -92,14 +93,17 @@ private:
         uint8_t flags;
     };
 
-    void render_background();
-    void render_sprites();
+    void change_state();
+    int get_state_cycles() const;
+    void begin_frame();
+    void end_frame();
+    void render_background(uint8_t* line);
+    void render_sprites(uint8_t* line);
 
     uint8_t vram[0x2000];
     uint8_t oam[NBR_OAMS * OAM_SIZE];
 
     int curr_state;
-    int state_cycles;
 
     uint8_t lcd_control;
     uint8_t scroll_y;
@@ -109,8 +113,21 @@ private:
     uint8_t obj_palette[2];
 
     geemuboi::view::Renderer& renderer;
+    Scheduler& scheduler;
+    Interrupts& interrupts;
     uint32_t framebuffer[geemuboi::view::Renderer::SCREEN_WIDTH * 
                          geemuboi::view::Renderer::SCREEN_HEIGHT];
+
+    uint8_t shades[geemuboi::view::Renderer::SCREEN_WIDTH *
+                   geemuboi::view::Renderer::SCREEN_HEIGHT];
+    // Lines are drawn as shades and expanded to colors here, if needed
+    uint8_t line_shades[geemuboi::view::Renderer::SCREEN_WIDTH];
+
+    // One of the two is set, either to the renderer's own memory or to
+    // framebuffer or shades. The pitch is in pixels.
+    uint32_t* frame;
+    uint8_t* shade_frame;
+    int frame_pitch;
 };
 
 
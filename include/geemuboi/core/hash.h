@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace geemuboi::core {
+
+
+// Fast non-cryptographic 64-bit hash in the style of XXH3: eight 64-bit
+// lanes accumulate 64 byte stripes with one 32x32 multiply each. Meant for
+// telling frames and files apart, not for anything adversarial. Runs on
+// SSE2 or AVX2 when built for them, with the same results everywhere.
+uint64_t hash_bytes(const void* data, size_t size, uint64_t seed = 0);
+
+
+}
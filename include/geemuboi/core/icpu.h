@@ -1,5 +1,7 @@
 #pragma once
 
+#include "core/state.h"
+
 #include <cstdint>
 #include <stdexcept>
 
@@ -42,7 +44,19 @@ public:
     };
 
     virtual int execute() = 0;
+    // Runs no further than max_cycles, give or take the last instruction.
+    // CPUs that run blocks fall back to single instructions near the end,
+    // and halt sleeps no longer than that.
+    virtual int execute(int max_cycles) = 0;
     virtual unsigned get_cycles_executed() = 0;
+    // F may lag behind in between instructions. Brings the registers the
+    // CPU was created with up to date, after which they can be read and
+    // written from outside until the next execute().
+    virtual void sync_registers() = 0;
+
+    // Includes the registers the CPU was created with
+    virtual void save_state(StateWriter& writer) const = 0;
+    virtual void load_state(StateReader& reader) = 0;
 
     virtual ~ICpu() {}
 };
@@ -34,6 +34,22 @@ public:
     virtual void write_byte(uint16_t addr, uint8_t val) = 0;
     virtual void write_word(uint16_t addr, uint16_t val) = 0;
 
+    // Identifies the memory currently mapped at addr. Code caches key on it
+    // so that e.g. the BIOS overlay and the cartridge ROM are told apart.
+    virtual int get_bank(uint16_t) { return 0; }
+
+    // Host memory of the 256 byte page holding addr, or nullptr if accesses
+    // to that page have side effects and must go through read_byte and
+    // write_byte.
+    virtual const uint8_t* get_read_page(uint16_t) { return nullptr; }
+    virtual uint8_t* get_write_page(uint16_t) { return nullptr; }
+
+    // The pages above as arrays indexed by addr >> 8, for code that looks
+    // them up itself. They are updated in place whenever pages are remapped.
+    // MMUs without them must never remap a page.
+    virtual const uint8_t* const* get_read_page_table() { return nullptr; }
+    virtual uint8_t* const* get_write_page_table() { return nullptr; }
+
     virtual ~IMmu() {}
 };
 
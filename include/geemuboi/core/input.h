@@ -1,19 +1,38 @@
 #pragma once
 
+#include "core/state.h"
+
+#include <atomic>
 #include <cstdint>
 
 namespace geemuboi::core {
 
 
+// Told about button changes on the emulation thread, at the first read of
+// the joypad register that can see them, which is when they take effect.
+class InputListener {
+public:
+    virtual ~InputListener() {}
+
+    virtual void buttons_changed(int column, uint8_t buttons_pressed) = 0;
+};
+
+
 class Input {
 public:
     Input();
 
-    uint8_t get_buttons_pressed() const;
+    uint8_t get_buttons_pressed();
     void set_buttons_pressed_switch(uint8_t buttons_pressed);
     void set_buttons_pressed(int column, uint8_t buttons_pressed);
     bool get_column_down(int column) const;
 
+    // Not owned, nullptr to stop listening
+    void set_listener(InputListener* listener_in);
+
+    void save_state(StateWriter& writer) const;
+    void load_state(StateReader& reader);
+
     enum Buttons {
         BUTTON_A = 0xE,
         BUTTON_B = 0xD,
@@ -26,8 +45,13 @@ public:
     };
 
 private:
-    uint8_t buttons_pressed[2];
+    // Set from the thread handling input events
+    std::atomic<uint8_t> buttons_pressed[2];
     bool column_down[2];
+
+    InputListener* listener;
+    // What the listener was last told
+    uint8_t buttons_heard[2];
 };
 
 
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "core/state.h"
+
+#include <cstdint>
+
+namespace geemuboi::core {
+
+
+// IE and IF. Hardware requests interrupts here, the CPU dispatches them.
+class Interrupts {
+public:
+    Interrupts();
+
+    void request(uint8_t interrupt);
+    void acknowledge(uint8_t interrupt);
+    uint8_t get_pending() const;
+
+    uint8_t get_enabled() const;
+    void set_enabled(uint8_t val);
+    uint8_t get_requested() const;
+    void set_requested(uint8_t val);
+
+    void save_state(StateWriter& writer) const;
+    void load_state(StateReader& reader);
+
+    // In order of priority, the lowest bit is dispatched first.
+    enum InterruptFlags {
+        INTERRUPT_VBLANK = 0x01,
+        INTERRUPT_LCD_STAT = 0x02,
+        INTERRUPT_TIMER = 0x04,
+        INTERRUPT_SERIAL = 0x08,
+        INTERRUPT_JOYPAD = 0x10
+    };
+
+    static const int NBR_INTERRUPTS = 5;
+
+private:
+    static const uint8_t INTERRUPT_MASK = 0x1F;
+
+    uint8_t enabled;
+    uint8_t requested;
+};
+
+
+}
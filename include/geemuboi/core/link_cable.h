@@ -0,0 +1,52 @@
+#pragma once
+
+#include "core/machine.h"
+#include "core/serial_sink.h"
+
+#include <cstdint>
+
+namespace geemuboi::core {
+
+
+// Two machines connected by a link cable, run on one thread. Bytes only
+// cross the cable when a transfer on the internal clock completes, and a
+// transfer takes Serial::TRANSFER_CYCLES from the write that starts it. So
+// each machine can run that far past the other without missing anything,
+// and the machines only meet when one of them is about to complete a
+// transfer. The exchange then happens with both at its cycle, give or take
+// the instruction that crossed it. That holds for the CPUs running blocks
+// too, Machine::run_until() hands them the cycles left as a budget.
+class LinkCable {
+public:
+    // Plugs into both machines, which have to outlive the cable
+    LinkCable(Machine& first_in, Machine& second_in);
+    ~LinkCable();
+
+    LinkCable(const LinkCable&) = delete;
+    LinkCable& operator=(const LinkCable&) = delete;
+
+    // Runs until both machines have finished a frame. A machine that is
+    // done first only runs on when the other one can't go further without
+    // it, so with machines that started together both frames are whole.
+    void step_frame();
+    // Runs until both machines have reached time
+    void run_until(uint64_t time);
+
+private:
+    static constexpr int NBR_MACHINES = 2;
+
+    // How far the other machine may run: up to this machine's transfer
+    // completing, or as far as one started right now could complete
+    uint64_t get_horizon(int index) const;
+    uint64_t get_round_target() const;
+    // The machine clocking a transfer due at the target goes last, so the
+    // other one is there when the bytes are exchanged.
+    int get_first_in_round(uint64_t target) const;
+
+    Machine* machines[NBR_MACHINES];
+    LinkSerialSink first_sink;
+    LinkSerialSink second_sink;
+};
+
+
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "audio/null_audio_sink.h"
+#include "core/apu.h"
+#include "core/cpu_factory.h"
+#include "core/gpu.h"
+#include "core/icpu.h"
+#include "core/input.h"
+#include "core/interrupts.h"
+#include "core/mmu.h"
+#include "core/scheduler.h"
+#include "core/serial.h"
+#include "core/serial_sink.h"
+#include "core/state.h"
+#include "core/timer.h"
+#include "view/renderer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace geemuboi::core {
+
+
+// One emulated Game Boy with everything it consists of, for embedding.
+// Instances share no state, so any number of them can run side by side on
+// different threads. Frames are drawn into memory owned by the machine and
+// audio is discarded.
+class Machine {
+public:
+    enum Buttons {
+        BUTTON_A = 0x01,
+        BUTTON_B = 0x02,
+        BUTTON_SELECT = 0x04,
+        BUTTON_START = 0x08,
+        BUTTON_RIGHT = 0x10,
+        BUTTON_LEFT = 0x20,
+        BUTTON_UP = 0x40,
+        BUTTON_DOWN = 0x80
+    };
+
+    // A whole frame in M-cycles, in case the GPU never finishes one
+    static constexpr int MAX_FRAME_CYCLES = GPU::CYCLES_PER_FRAME;
+
+    // Without a BIOS the machine starts out the way the BIOS leaves it.
+    Machine(const std::vector<uint8_t>& rom, const std::vector<uint8_t>& bios = {},
+            CpuType cpu_type = CPU_TYPE_INTERPRETER);
+
+    Machine(const Machine&) = delete;
+    Machine& operator=(const Machine&) = delete;
+
+    // Runs until the GPU has finished a frame.
+    void step_frame();
+    // Runs until guest time reaches time, or until a frame is finished.
+    // Returns true for the frame. Whatever the CPU type, time is overshot by
+    // an instruction at the most, see ICpu::execute(int).
+    bool run_until(uint64_t time);
+    // In M-cycles since power on
+    uint64_t get_time() const;
+    // A mask of Buttons held down
+    void set_buttons(uint8_t buttons);
+    // Not owned, nullptr unplugs the cable
+    void set_serial_sink(SerialSink* sink);
+    Serial& get_serial();
+    const Serial& get_serial() const;
+    // For recording and playing movies, see core/movie.h
+    Input& get_input();
+    Scheduler& get_scheduler();
+
+    // SCREEN_WIDTH x SCREEN_HEIGHT pixels as 0x00RRGGBB, valid for the
+    // lifetime of the machine
+    const uint32_t* get_framebuffer() const;
+    uint64_t get_frame_count() const;
+    // Hashes every finished frame as it is finished, off by default
+    void set_frame_hashing(bool enabled);
+    // Of the framebuffer as the last frame was finished, see core/hash.h
+    uint64_t get_frame_hash() const;
+
+    // WRAM followed by HRAM
+    static constexpr int RAM_SIZE = MMU::WRAM_SIZE + MMU::HRAM_SIZE;
+    void copy_ram(uint8_t* out) const;
+
+    std::vector<uint8_t> save_state() const;
+    size_t get_state_size() const;
+    // States with another magic or STATE_VERSION, or not the size of this
+    // machine's states, are rejected with an InvalidStateException before
+    // anything is loaded. Nothing else about the layout is checked.
+    void load_state(const uint8_t* data, size_t size);
+
+private:
+    class FrameRenderer : public geemuboi::view::Renderer {
+    public:
+        FrameRenderer();
+
+        void render_frame(uint32_t[]) {}
+        uint32_t* lock_frame(int& pitch);
+        void unlock_frame();
+
+        uint32_t pixels[SCREEN_WIDTH * SCREEN_HEIGHT];
+        bool frame_done;
+        bool hash_frames;
+        uint64_t frame_hash;
+    };
+
+    // "GBST"
+    static constexpr uint32_t STATE_MAGIC = 0x54534247;
+    static constexpr uint32_t STATE_VERSION = 2;
+
+    void skip_bios();
+
+    FrameRenderer renderer;
+    geemuboi::audio::NullAudioSink audio_sink;
+
+    Scheduler scheduler;
+    Interrupts interrupts;
+    GPU gpu;
+    Input input;
+    Timer timer;
+    Serial serial;
+    APU apu;
+    MMU mmu;
+
+    ICpu::Registers regs;
+    std::unique_ptr<ICpu> cpu;
+
+    uint64_t frames;
+    size_t state_size;
+};
+
+
+}
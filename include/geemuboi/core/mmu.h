@@ -1,25 +1,64 @@
 #pragma once
 
+#include "core/apu.h"
 #include "core/gpu.h"
 #include "core/input.h"
+#include "core/interrupts.h"
+#include "core/scheduler.h"
+#include "core/serial.h"
+#include "core/timer.h"
 #include "core/immu.h"
 
 #include <cstdint>
 #include <string>
+#include <vector>
 
 namespace geemuboi::core {
 
 
 class MMU : public IMmu {
 public:
-    MMU(GPU& gpu, Input& input_in, const std::string& bios_file, const std::string& rom_file);
+    MMU(GPU& gpu, Input& input_in, Interrupts& interrupts_in, Timer& timer_in,
+        Serial& serial_in, Scheduler& scheduler_in, APU& apu_in,
+        const std::string& bios_file, const std::string& rom_file);
+    // Without a BIOS, the cartridge is mapped from the start
+    MMU(GPU& gpu, Input& input_in, Interrupts& interrupts_in, Timer& timer_in,
+        Serial& serial_in, Scheduler& scheduler_in, APU& apu_in,
+        const std::vector<uint8_t>& bios_in, const std::vector<uint8_t>& rom_in);
     
     virtual uint8_t read_byte(uint16_t addr);
     virtual uint16_t read_word(uint16_t addr);
     virtual void write_byte(uint16_t addr, uint8_t val);
     virtual void write_word(uint16_t addr, uint16_t val);
+    virtual int get_bank(uint16_t addr);
+    virtual const uint8_t* get_read_page(uint16_t addr);
+    virtual uint8_t* get_write_page(uint16_t addr);
+    virtual const uint8_t* const* get_read_page_table();
+    virtual uint8_t* const* get_write_page_table();
+
+    static constexpr int WRAM_SIZE = 0x2000;
+    static constexpr int HRAM_SIZE = 0x7F;
+
+    const uint8_t* get_wram() const;
+    const uint8_t* get_hram() const;
+
+    // RAM and mapping state. The ROM and BIOS are not part of it, writes
+    // never change them.
+    void save_state(StateWriter& writer) const;
+    void load_state(StateReader& reader);
 private:
     int get_area(uint16_t addr);
+    void map_pages();
+    void start_dma(uint8_t val);
+    void end_dma();
+
+    static constexpr int PAGE_SHIFT = 8;
+    static constexpr int PAGE_MASK = 0xFF;
+    static constexpr int NBR_PAGES = 0x100;
+    static constexpr int HIGH_PAGE = 0xFF;
+
+    static constexpr int DMA_CYCLES = 160;
+    static constexpr int DMA_LENGTH = 0xA0;
 
     enum Area {
         AREA_BIOS,
@@ -39,11 +78,29 @@ private:
         JOYPAD_REG = 0xFF00
     };
 
+    enum SerialRegs {
+        SERIAL_REG_DATA = 0xFF01,
+        SERIAL_REG_CONTROL = 0xFF02
+    };
+
+    enum TimerRegs {
+        TIMER_REG_DIVIDER = 0xFF04,
+        TIMER_REG_COUNTER = 0xFF05,
+        TIMER_REG_MODULO = 0xFF06,
+        TIMER_REG_CONTROL = 0xFF07
+    };
+
+    enum InterruptRegs {
+        INTERRUPT_REG_FLAGS = 0xFF0F,
+        INTERRUPT_REG_ENABLE = 0xFFFF
+    };
+
     enum GPURegs {
         GPU_REG_LCD_CONTROL = 0xFF40,
         GPU_REG_SCROLL_Y = 0xFF42,
         GPU_REG_SCROLL_X = 0xFF43,
         GPU_REG_CURR_SCANLINE = 0xFF44,
+        GPU_REG_DMA = 0xFF46,
         GPU_REG_BG_PALETTE = 0xFF47,
         GPU_REG_OBJ_PALETTE_0 = 0xFF48,
         GPU_REG_OBJ_PALETTE_1 = 0xFF49
@@ -51,14 +108,29 @@ private:
 
     GPU& gpu;
     Input& input;
+    Interrupts& interrupts;
+    Timer& timer;
+    Serial& serial;
+    Scheduler& scheduler;
+    APU& apu;
 
     bool in_bios;
 
     uint8_t bios[0x100];
-    uint8_t rom[0x4000];
+    uint8_t rom[0x8000];
     uint8_t eram[0x2000];
-    uint8_t wram[0x2000];
-    uint8_t hram[0x7F];
+    uint8_t wram[WRAM_SIZE];
+    uint8_t hram[HRAM_SIZE];
+
+    const uint8_t* read_pages[NBR_PAGES];
+    uint8_t* write_pages[NBR_PAGES];
+
+    // While an OAM DMA runs only the high page is accessible, every other
+    // page is mapped to these.
+    bool dma_active;
+    uint8_t dma_source;
+    uint8_t dma_open_bus[0x100];
+    uint8_t dma_ignored_writes[0x100];
 };
 
 
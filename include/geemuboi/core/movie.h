@@ -0,0 +1,103 @@
+#pragma once
+
+#include "core/cpu_factory.h"
+#include "core/gpu.h"
+#include "core/input.h"
+#include "core/scheduler.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace geemuboi::core {
+
+
+class InvalidMovieException : public std::logic_error {
+public:
+    InvalidMovieException(const std::string& what_in) : std::logic_error(what_in) {}
+};
+
+
+// A button change, at the first read of the joypad register that saw it.
+struct MovieEvent {
+    // Counted in guest time, every frame is GPU::CYCLES_PER_FRAME long
+    uint64_t frame;
+    // M-cycles into the frame
+    uint32_t cycle;
+    uint8_t column;
+    uint8_t buttons_pressed;
+
+    uint64_t get_time() const;
+};
+
+// Every button change since power on. Replaying them into a machine booted
+// the same way reproduces the run exactly.
+struct Movie {
+    // Of the ROM and BIOS, see core/hash.h. An empty BIOS is a machine that
+    // skipped it.
+    uint64_t rom_hash;
+    uint64_t bios_hash;
+    // The block CPUs see the time at the start of a block, not of the read,
+    // so a movie only replays on the CPU it was recorded with.
+    CpuType cpu_type;
+    std::vector<MovieEvent> events;
+};
+
+// A small header and then every event as variable length deltas, most of
+// them take four bytes. Decoding throws InvalidMovieException.
+std::vector<uint8_t> encode_movie(const Movie& movie);
+Movie decode_movie(const uint8_t* data, size_t size);
+void write_movie(const std::string& path, const Movie& movie);
+Movie read_movie(const std::string& path);
+
+
+// Records the button changes of a machine running from power on.
+class MovieRecorder : public InputListener {
+public:
+    MovieRecorder(Input& input_in, const Scheduler& scheduler_in, uint64_t rom_hash,
+                  uint64_t bios_hash, CpuType cpu_type);
+    ~MovieRecorder();
+
+    MovieRecorder(const MovieRecorder&) = delete;
+    MovieRecorder& operator=(const MovieRecorder&) = delete;
+
+    void buttons_changed(int column, uint8_t buttons_pressed);
+
+    const Movie& get_movie() const;
+
+private:
+    Input& input;
+    const Scheduler& scheduler;
+    Movie movie;
+};
+
+
+// Feeds a movie into a machine from power on, through a scheduled event, so
+// every change is in place before the read that saw it when recording. Live
+// input has to be kept away while playing. Throws InvalidMovieException if
+// the machine runs another CPU type than the movie was recorded with.
+class MoviePlayer {
+public:
+    MoviePlayer(const Movie& movie_in, Input& input_in, Scheduler& scheduler_in,
+                CpuType cpu_type);
+    ~MoviePlayer();
+
+    MoviePlayer(const MoviePlayer&) = delete;
+    MoviePlayer& operator=(const MoviePlayer&) = delete;
+
+    bool is_done() const;
+
+private:
+    void play_events();
+    void schedule_next();
+
+    Movie movie;
+    Input& input;
+    Scheduler& scheduler;
+    size_t next_event;
+};
+
+
+}
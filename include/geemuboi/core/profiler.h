@@ -0,0 +1,145 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace geemuboi::core {
+
+
+// A cheap timestamp, the TSC where there is one. Only differences mean
+// anything, get_ticks_per_second() converts them.
+uint64_t read_ticks();
+// Measured against the steady clock on the first call, which takes a few
+// milliseconds
+double get_ticks_per_second();
+
+
+// Durations counted into power of two buckets of microseconds. Any number
+// of threads can record and read at the same time without locks.
+class Histogram {
+public:
+    // Bucket 0 is below a microsecond, bucket i up to 2^i microseconds and
+    // the last one everything longer
+    static constexpr int NBR_BUCKETS = 24;
+
+    struct Snapshot {
+        uint64_t count;
+        uint64_t sum_nanos;
+        uint64_t max_nanos;
+        uint64_t buckets[NBR_BUCKETS];
+
+        // What was recorded between the other snapshot and this one, but
+        // the max of both
+        Snapshot since(const Snapshot& earlier) const;
+        double get_mean_millis() const;
+        // The upper limit of the bucket holding the percentile, 0 to 1
+        uint64_t get_percentile_nanos(double percentile) const;
+    };
+
+    Histogram();
+
+    void record(uint64_t nanos);
+    Snapshot get_snapshot() const;
+
+    static uint64_t get_bucket_limit_nanos(int bucket);
+
+private:
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> sum_nanos;
+    std::atomic<uint64_t> max_nanos;
+    std::atomic<uint64_t> buckets[NBR_BUCKETS];
+};
+
+
+// Where the time of each frame goes, one histogram per part of the
+// emulator. Shared by every thread taking part.
+class PerfStats {
+public:
+    enum Sections {
+        // Everything emulated outside the other sections
+        SECTION_CPU,
+        // Scanline events, drawing included
+        SECTION_GPU,
+        // Frame sequencer events, handing samples to the sink included
+        SECTION_AUDIO,
+        SECTION_INPUT,
+        SECTION_PRESENT,
+        SECTION_SLEEP,
+        // From the start of one frame to the next
+        SECTION_FRAME,
+        NBR_SECTIONS
+    };
+
+    static const char* get_section_name(int section);
+
+    void record_ticks(int section, uint64_t ticks);
+    Histogram& get_histogram(int section);
+    const Histogram& get_histogram(int section) const;
+
+    // Count, mean, percentiles and max of each section in milliseconds
+    std::string format_json() const;
+    // A histogram per section in the Prometheus text format
+    std::string format_prometheus() const;
+
+private:
+    Histogram histograms[NBR_SECTIONS];
+};
+
+
+// Splits the time of one thread into sections. Sections nest, and the time
+// of an inner one isn't counted in the outer one, so they add up to the
+// frame. Only to be used by the one thread.
+class Profiler {
+public:
+    static constexpr int MAX_DEPTH = 8;
+
+    Profiler(PerfStats& stats_in);
+
+    void enter(int section);
+    void leave();
+
+    // Records the time of every section entered since the last call, and
+    // the time since then as the frame.
+    void end_frame();
+    // The same without recording a frame, for threads that don't run them
+    void flush();
+
+private:
+    void switch_section();
+
+    PerfStats& stats;
+    uint64_t section_start;
+    uint64_t frame_start;
+    int stack[MAX_DEPTH];
+    int depth;
+
+    uint64_t section_ticks[PerfStats::NBR_SECTIONS];
+    bool entered[PerfStats::NBR_SECTIONS];
+};
+
+
+// In a section for as long as it lives. Does nothing without a profiler.
+class ProfilerSection {
+public:
+    ProfilerSection(Profiler* profiler_in, int section) : profiler{profiler_in} {
+        if (profiler) {
+            profiler->enter(section);
+        }
+    }
+
+    ~ProfilerSection() {
+        if (profiler) {
+            profiler->leave();
+        }
+    }
+
+    ProfilerSection(const ProfilerSection&) = delete;
+    ProfilerSection& operator=(const ProfilerSection&) = delete;
+
+private:
+    Profiler* profiler;
+};
+
+
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "core/profiler.h"
+#include "core/state.h"
+
+#include <cstdint>
+#include <functional>
+
+namespace geemuboi::core {
+
+
+// Keeps track of guest time in M-cycles and runs hardware events once time
+// has passed them. Every source of events owns a fixed slot, so an event is
+// rescheduled by simply setting its time again.
+class Scheduler {
+public:
+    enum Events {
+        EVENT_GPU,
+        EVENT_TIMER,
+        EVENT_DMA,
+        EVENT_APU,
+        EVENT_SERIAL,
+        EVENT_INPUT,
+        NBR_EVENTS
+    };
+
+    static constexpr uint64_t NEVER = UINT64_MAX;
+
+    Scheduler();
+
+    void set_handler(int event, std::function<void()> handler);
+    void schedule(int event, uint64_t event_time);
+    void schedule_in(int event, uint64_t cycles);
+    void cancel(int event);
+
+    // Times the handlers of events that belong to a section of their own,
+    // nullptr to stop
+    void set_profiler(Profiler* profiler_in);
+
+    // Moves time forward, running every event that is due in order.
+    void advance(int cycles);
+
+    uint64_t get_time() const;
+    uint64_t get_next_event_time() const;
+    // NEVER if the event isn't scheduled
+    uint64_t get_event_time(int event) const;
+
+    // Event times only, handlers are set up by their owners
+    void save_state(StateWriter& writer) const;
+    void load_state(StateReader& reader);
+private:
+    void find_next_event();
+
+    uint64_t time;
+    uint64_t next_event_time;
+    int next_event;
+
+    uint64_t event_times[NBR_EVENTS];
+    std::function<void()> handlers[NBR_EVENTS];
+
+    Profiler* profiler;
+};
+
+
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "core/interrupts.h"
+#include "core/scheduler.h"
+#include "core/serial_sink.h"
+#include "core/state.h"
+
+#include <cstdint>
+
+namespace geemuboi::core {
+
+
+// SB and SC. A transfer on the internal clock shifts out SB at 8192 Hz and
+// is a single scheduled event; the whole byte is exchanged with the sink
+// when it completes. On the external clock a transfer waits for a peer.
+class Serial {
+public:
+    Serial(Scheduler& scheduler_in, Interrupts& interrupts_in);
+
+    uint8_t get_data() const;
+    void set_data(uint8_t val);
+    uint8_t get_control() const;
+    void set_control(uint8_t val);
+
+    // Not owned, nullptr is an unplugged cable
+    void set_sink(SerialSink* sink_in);
+
+    // When the transfer on the internal clock in progress completes, which
+    // is the only time bytes reach the other end. Scheduler::NEVER without
+    // one.
+    uint64_t get_transfer_end_time() const;
+
+    // 8 bits at 8192 Hz in M-cycles
+    static constexpr int TRANSFER_CYCLES = 8 * 128;
+
+    // A peer clocking a transfer. Takes the byte it shifted out if a
+    // transfer on the external clock is waiting, and returns the byte
+    // shifted back. Returns 0xFF if nothing is waiting.
+    uint8_t receive(uint8_t val);
+
+    // The sink is not part of the state
+    void save_state(StateWriter& writer) const;
+    void load_state(StateReader& reader);
+
+private:
+    enum ControlFlags {
+        CONTROL_INTERNAL_CLOCK = 0x01,
+        CONTROL_START = 0x80
+    };
+
+    void end_transfer();
+    void complete(uint8_t val);
+
+    Scheduler& scheduler;
+    Interrupts& interrupts;
+    SerialSink* sink;
+
+    uint8_t data;
+    uint8_t control;
+};
+
+
+}
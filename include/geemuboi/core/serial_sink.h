@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+namespace geemuboi::core {
+
+class Serial;
+
+
+// The other end of the link port, for transfers this side clocks.
+class SerialSink {
+public:
+    virtual ~SerialSink() {}
+
+    // Takes the byte shifted out and returns the byte shifted in.
+    virtual uint8_t transfer(uint8_t val) = 0;
+};
+
+
+// Collects everything sent, for test ROMs reporting their results.
+class BufferSerialSink : public SerialSink {
+public:
+    BufferSerialSink();
+
+    uint8_t transfer(uint8_t val);
+
+    const std::string& get_text() const;
+    void clear();
+
+private:
+    std::string text;
+};
+
+
+class FileSerialSink : public SerialSink {
+public:
+    // Throws std::runtime_error if the file can't be created
+    FileSerialSink(const std::string& path);
+
+    uint8_t transfer(uint8_t val);
+
+private:
+    std::ofstream file;
+};
+
+
+// A cable to the serial port of another machine, which has to be driven
+// on the same thread and be at the same point in time when a transfer
+// completes, see LinkCable.
+class LinkSerialSink : public SerialSink {
+public:
+    LinkSerialSink(Serial& peer_in);
+
+    uint8_t transfer(uint8_t val);
+
+private:
+    Serial& peer;
+};
+
+
+}
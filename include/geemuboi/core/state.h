@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace geemuboi::core {
+
+
+class InvalidStateException : public std::logic_error {
+public:
+    InvalidStateException(const std::string& what_in) : std::logic_error(what_in) {}
+};
+
+
+// A save state is every component's fields as raw bytes, in the order they
+// are written. It is only meant to be loaded by the same build.
+class StateWriter {
+public:
+    template <typename T>
+    void write(const T& val) {
+        static_assert(std::is_trivially_copyable_v<T>, "Only plain data can be saved");
+        write_bytes(&val, sizeof(T));
+    }
+
+    void write_bytes(const void* bytes, size_t size) {
+        const uint8_t* begin = static_cast<const uint8_t*>(bytes);
+        data.insert(data.end(), begin, begin + size);
+    }
+
+    void reserve(size_t size) { data.reserve(size); }
+
+    const std::vector<uint8_t>& get_data() const { return data; }
+    std::vector<uint8_t> release() { return std::move(data); }
+
+private:
+    std::vector<uint8_t> data;
+};
+
+
+class StateReader {
+public:
+    StateReader(const uint8_t* data_in, size_t size_in) : data{data_in}, size{size_in}, position{} {}
+
+    template <typename T>
+    void read(T& val) {
+        static_assert(std::is_trivially_copyable_v<T>, "Only plain data can be loaded");
+        read_bytes(&val, sizeof(T));
+    }
+
+    void read_bytes(void* bytes, size_t count) {
+        if (count > size - position) {
+            throw InvalidStateException("The save state is truncated.");
+        }
+
+        std::memcpy(bytes, data + position, count);
+        position += count;
+    }
+
+    bool at_end() const { return position == size; }
+
+private:
+    const uint8_t* data;
+    size_t size;
+    size_t position;
+};
+
+
+}
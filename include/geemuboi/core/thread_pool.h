@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace geemuboi::core {
+
+
+// Runs the iterations of a loop on a fixed set of threads, the calling one
+// included. Every thread starts out with an equal share of the iterations
+// and steals from the others once its own are done, so a few slow ones
+// don't hold everyone up. Nothing is allocated per loop.
+class ThreadPool {
+public:
+    // 0 threads is one per hardware thread
+    explicit ThreadPool(int threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int get_threads() const;
+
+    // Calls body(i) for every i in [0, count) and returns once all are done.
+    // Not reentrant, body must not call run() itself. If any call throws,
+    // the rest still run and the first exception is rethrown at the end.
+    void run(int count, const std::function<void(int)>& body);
+
+private:
+    // Iterations left in one thread's share, taken from the front by the
+    // owner and thieves alike
+    struct alignas(64) Share {
+        std::atomic<int> next;
+        int end;
+    };
+
+    void work_loop(int index);
+    void work(int index);
+
+    std::vector<std::thread> workers;
+    std::unique_ptr<Share[]> shares;
+    int nbr_shares;
+
+    std::mutex mutex;
+    std::condition_variable started;
+    std::condition_variable finished;
+    unsigned generation;
+    int busy_workers;
+    bool stopping;
+    std::exception_ptr error;
+
+    const std::function<void(int)>* job;
+};
+
+
+}
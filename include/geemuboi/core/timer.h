@@ -0,0 +1,59 @@
+#pragma once
+
+#include "core/interrupts.h"
+#include "core/scheduler.h"
+
+#include <cstdint>
+
+namespace geemuboi::core {
+
+
+// DIV, TIMA, TMA and TAC. Nothing is counted per cycle: DIV and TIMA are
+// derived from the scheduler's time when accessed, and the TIMA overflow
+// is a scheduled event.
+class Timer {
+public:
+    Timer(Scheduler& scheduler_in, Interrupts& interrupts_in);
+
+    uint8_t get_divider() const;
+    void reset_divider();
+    uint8_t get_counter();
+    void set_counter(uint8_t val);
+    uint8_t get_modulo() const;
+    void set_modulo(uint8_t val);
+    uint8_t get_control() const;
+    void set_control(uint8_t val);
+
+    void save_state(StateWriter& writer) const;
+    void load_state(StateReader& reader);
+
+private:
+    enum ControlFlags {
+        CONTROL_CLOCK_SELECT = 0x3,
+        CONTROL_ENABLE = 0x4
+    };
+
+    // TIMA increments whenever the divider passes a multiple of the period
+    static const int PERIODS[4];
+    static const int DIVIDER_SHIFT = 6;
+
+    void overflow();
+    void sync();
+    void increment_counter();
+    void reschedule();
+    bool get_tick_signal() const;
+    uint64_t get_divider_cycles(uint64_t time) const;
+    int get_period() const;
+
+    Scheduler& scheduler;
+    Interrupts& interrupts;
+
+    uint64_t divider_reset_time;
+    uint64_t counter_sync_time;
+    uint8_t counter;
+    uint8_t modulo;
+    uint8_t control;
+};
+
+
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "core/cpu_factory.h"
+#include "core/machine.h"
+#include "core/thread_pool.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace geemuboi::core {
+
+
+// A batch of machines running the same ROM, stepped together on a thread
+// pool, for reinforcement learning. Actions go in and observations come out
+// as contiguous arrays with one row per machine. Stepping allocates nothing.
+class VecMachine {
+public:
+    enum Observations {
+        // Gray levels of the screen averaged over downsample x downsample
+        // blocks, row by row
+        OBSERVATION_PIXELS,
+        // Machine::RAM_SIZE bytes of WRAM and HRAM
+        OBSERVATION_RAM
+    };
+
+    // The downsample factor has to divide both screen dimensions. 0 threads
+    // is one per hardware thread.
+    VecMachine(int count, const std::vector<uint8_t>& rom, int observation_in = OBSERVATION_PIXELS,
+               int downsample_in = 2, int threads = 0, CpuType cpu_type = CPU_TYPE_INTERPRETER);
+
+    int get_count() const;
+    int get_observation_width() const;
+    int get_observation_height() const;
+    // In bytes, per machine
+    int get_observation_size() const;
+
+    // Holds actions[i], a mask of Machine::Buttons, on machine i for the
+    // given number of frames. Then writes the observation of machine i to
+    // observations + i * get_observation_size(). A machine that throws, on
+    // an undefined instruction or unmapped memory, has crashed: it keeps
+    // its last observation and isn't stepped again until it is reset.
+    void step(const uint8_t* actions, int frames, uint8_t* observations);
+    // Only writes the observations.
+    void observe(uint8_t* observations);
+    // Back to how the machine was right after power on, not crashed
+    void reset(int index);
+
+    bool has_crashed(int index) const;
+    // What the machine threw, empty unless it has crashed
+    const std::string& get_crash_reason(int index) const;
+
+    Machine& get_machine(int index);
+
+private:
+    void step_machine(int index);
+    void observe_machine(int index, uint8_t* out) const;
+    void downsample_frame(const uint32_t* frame, uint8_t* out) const;
+
+    std::vector<std::unique_ptr<Machine>> machines;
+    std::vector<uint8_t> initial_state;
+    // One per machine, only written by the thread stepping it
+    std::vector<std::string> crash_reasons;
+
+    int observation;
+    int downsample;
+
+    ThreadPool pool;
+    const std::function<void(int)> step_job;
+    const std::function<void(int)> observe_job;
+
+    // Arguments of the step in progress
+    const uint8_t* step_actions;
+    int step_frames;
+    uint8_t* step_observations;
+};
+
+
+}
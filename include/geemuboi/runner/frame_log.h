@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace geemuboi::runner {
+
+
+// The hash of every frame of a run in order, one per line in hex, see
+// core/hash.h. Being text, two logs can be compared with diff as well.
+std::vector<uint64_t> read_frame_log(const std::string& path);
+void write_frame_log(const std::string& path, const std::vector<uint64_t>& hashes);
+
+// The first frame where hashes differs from golden, or -1 if they are the
+// same. A log ending before the other differs where it ends.
+int find_divergent_frame(const std::vector<uint64_t>& golden, const std::vector<uint64_t>& hashes);
+
+
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "runner/manifest.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace geemuboi::runner {
+
+
+struct JobResult {
+    enum Status {
+        STATUS_PASS,
+        STATUS_FAIL,
+        // The ROM couldn't be read or the emulator gave up on it
+        STATUS_ERROR
+    };
+
+    int status;
+    std::string detail;
+    double seconds;
+};
+
+// Empty if the file can't be read
+std::vector<uint8_t> read_rom(const std::string& path);
+
+// Identifies a result: changes with the ROM contents, the emulator build,
+// the golden frame log and anything in the entry that affects the outcome.
+uint64_t get_cache_key(const ManifestEntry& entry, const std::vector<uint8_t>& rom,
+                       uint64_t build_hash);
+
+// Runs the entry on a machine of its own, so jobs can run on any thread.
+// Updating writes the frame logs of EXPECT_FRAME_LOG entries instead of
+// comparing with them.
+JobResult run_job(const ManifestEntry& entry, const std::vector<uint8_t>& rom,
+                  bool update_logs = false);
+
+
+}
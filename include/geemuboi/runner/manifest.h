@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace geemuboi::runner {
+
+
+class ManifestException : public std::logic_error {
+public:
+    ManifestException(const std::string& what_in, int line_in)
+        : std::logic_error(what_in), line{line_in} {}
+
+    int get_line() const { return line; }
+private:
+    int line;
+};
+
+
+// One test: run a ROM for a number of frames and check the outcome.
+struct ManifestEntry {
+    enum Expectations {
+        // The hash of the last frame, see core/hash.h
+        EXPECT_FRAME_HASH,
+        // Text sent over the link port. The test ends as soon as it shows
+        // up, or "Failed" does, and frames is only the limit.
+        EXPECT_SERIAL,
+        // The hash of every frame, as in a golden frame log, see
+        // runner/frame_log.h
+        EXPECT_FRAME_LOG
+    };
+
+    std::string rom;
+    int frames;
+    int expectation;
+    uint64_t frame_hash;
+    std::string serial_text;
+    std::string frame_log;
+    int line;
+};
+
+// A manifest has one entry per line, as the ROM path, the number of frames
+// and the expectation, separated by whitespace:
+//
+//   # Comments and blank lines are skipped
+//   games/tetris.gb  600  hash:3f2a9c0d1e4b5a67
+//   blargg/cpu_instrs.gb  3600  serial:Passed
+//   games/tetris.gb  3600  log:logs/tetris.log
+//
+// The serial text is the rest of the line, without trailing whitespace.
+// Relative ROM and log paths are relative to base_dir.
+std::vector<ManifestEntry> parse_manifest(std::istream& in, const std::string& base_dir);
+std::vector<ManifestEntry> read_manifest(const std::string& path);
+
+
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "runner/job.h"
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace geemuboi::runner {
+
+
+// Results of earlier runs by cache key, kept in a text file with one
+// result per line. Lookups and stores may come from any thread.
+class ResultCache {
+public:
+    // Starts out empty if the file doesn't exist yet
+    explicit ResultCache(const std::string& path_in);
+
+    bool lookup(uint64_t key, JobResult& result) const;
+    void store(uint64_t key, const JobResult& result);
+    bool save() const;
+
+private:
+    std::string path;
+    std::unordered_map<uint64_t, JobResult> results;
+    mutable std::mutex mutex;
+};
+
+
+}
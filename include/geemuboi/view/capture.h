@@ -0,0 +1,56 @@
+#pragma once
+
+#include "view/renderer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace geemuboi::view {
+
+
+class InvalidCaptureException : public std::logic_error {
+public:
+    InvalidCaptureException(const std::string& what_in) : std::logic_error(what_in) {}
+};
+
+
+// A lossless video of the screen. After a small header every frame is its
+// shades packed four to a byte, XORed with the frame before it and stored
+// as runs of unchanged and changed bytes. A still screen is a few bytes a
+// frame, a scrolling one rarely more than a couple of kilobytes.
+struct CaptureFrame {
+    // Frames since the first one, gaps are frames that were dropped
+    uint64_t frame;
+    // Renderer::SCREEN_WIDTH * Renderer::SCREEN_HEIGHT of them
+    std::vector<uint8_t> shades;
+};
+
+class CaptureEncoder {
+public:
+    CaptureEncoder();
+
+    // Appended to out, the header once before any frames.
+    void encode_header(std::vector<uint8_t>& out) const;
+    void encode_frame(const uint8_t shades[], uint64_t frame, std::vector<uint8_t>& out);
+
+private:
+    std::vector<uint8_t> previous;
+    std::vector<uint8_t> packed;
+    uint64_t next_frame;
+};
+
+// Throws InvalidCaptureException.
+std::vector<CaptureFrame> decode_capture(const uint8_t* data, size_t size);
+std::vector<CaptureFrame> read_capture(const std::string& path);
+
+
+// A full frame of 8-bit planar YUV 4:2:0, what rawvideo encoders call
+// yuv420p, with the shades as BT.601 studio range grays.
+const int YUV_FRAME_SIZE = Renderer::SCREEN_WIDTH * Renderer::SCREEN_HEIGHT * 3 / 2;
+void shades_to_yuv(const uint8_t shades[], uint8_t yuv[]);
+
+
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "view/renderer.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+namespace geemuboi::view {
+
+
+// Records every frame passing through to the wrapped renderer. Frames are
+// copied into a fixed pool and written by a thread of its own, so the
+// emulation never waits for the disk. When the writer falls so far behind
+// that the pool is full, new frames are dropped and counted instead.
+class RecordingRenderer : public Renderer {
+public:
+    enum Formats {
+        // See view/capture.h, keeps the place of dropped frames
+        FORMAT_INDEXED,
+        // Raw yuv420p frames for an encoder to read, dropped frames are
+        // just missing
+        FORMAT_YUV
+    };
+
+    // The stream has to outlive the recorder.
+    RecordingRenderer(Renderer& renderer_in, std::ostream& out_in, int format_in = FORMAT_INDEXED,
+                      int pool_frames = 8);
+    // Writes what is still queued first.
+    ~RecordingRenderer();
+
+    RecordingRenderer(const RecordingRenderer&) = delete;
+    RecordingRenderer& operator=(const RecordingRenderer&) = delete;
+
+    void render_frame(uint32_t img[]);
+    bool accepts_shades() const;
+    void render_shades(uint8_t shades[]);
+    uint8_t* lock_shades(int& pitch);
+    void unlock_frame();
+
+    // Counting those lost after a failure
+    uint64_t get_written_frames() const;
+    uint64_t get_dropped_frames() const;
+    // The stream failed and nothing more is written
+    bool has_failed() const;
+
+private:
+    // A pool frame for the next frame, nullptr if it has to be dropped
+    uint8_t* claim_frame();
+    void queue_frame();
+    void copy_frame(const uint8_t* shades, int pitch);
+    void show_shades(uint8_t shades[]);
+    void write_frames();
+
+    Renderer& renderer;
+    std::ostream& out;
+    int format;
+
+    std::vector<std::vector<uint8_t>> pool;
+    std::vector<uint64_t> pool_frame_numbers;
+    // Frames ever queued and written, the difference is the queue. Each is
+    // only changed by one side.
+    std::atomic<uint64_t> queued;
+    std::atomic<uint64_t> written;
+    std::atomic<uint64_t> dropped;
+    std::atomic<bool> failed;
+    uint64_t next_frame;
+
+    // Frames are drawn here when the wrapped renderer has no memory for it
+    std::vector<uint8_t> staging;
+    std::vector<uint32_t> colors;
+    uint8_t* locked;
+    int locked_pitch;
+
+    // Only for waking the writer
+    std::mutex writer_mutex;
+    std::condition_variable frame_queued;
+    std::atomic<bool> stopping;
+    std::thread writer;
+};
+
+
+}
@@ -10,8 +10,51 @@ public:
     static const int SCREEN_WIDTH = 160;
     static const int SCREEN_HEIGHT = 144;
 
+    enum Shades {
+        SHADE_WHITE,
+        SHADE_LIGHT_GREY,
+        SHADE_DARK_GREY,
+        SHADE_BLACK,
+        NBR_SHADES
+    };
+
     virtual ~Renderer() {}
     virtual void render_frame(uint32_t img[]) = 0;
+
+    // Renderers owning memory that a frame can be drawn into directly hand
+    // it out here, with the pitch in pixels. The others return nullptr and
+    // get the frame through render_frame() instead.
+    virtual uint32_t* lock_frame(int&) { return nullptr; }
+    // Shows what was drawn since lock_frame() or lock_shades().
+    virtual void unlock_frame() {}
+
+    // The same with one shade per pixel instead of a color, a quarter of
+    // the size. Renderers returning true here get their frames this way and
+    // expand them to colors only if and where they need to.
+    virtual bool accepts_shades() const { return false; }
+    virtual void render_shades(uint8_t[]) {}
+    virtual uint8_t* lock_shades(int&) { return nullptr; }
+
+    static void expand_shades(const uint8_t shades[], int count, uint32_t colors[]) {
+        static const uint32_t SHADE_COLORS[NBR_SHADES] = {
+            0x00FFFFFF, 0x00C0C0C0, 0x005C5C5C, 0x00000000
+        };
+
+        for (int i = 0; i != count; ++i) {
+            colors[i] = SHADE_COLORS[shades[i] & 0x3];
+        }
+    }
+
+    // The other way, colors go to the nearest shade
+    static void reduce_colors(const uint32_t colors[], int count, uint8_t shades[]) {
+        for (int i = 0; i != count; ++i) {
+            // The shades get darker with every step down in any channel
+            int level = colors[i] & 0xFF;
+            shades[i] = level > 0xE0 ? SHADE_WHITE :
+                level > 0x8E ? SHADE_LIGHT_GREY :
+                level > 0x2E ? SHADE_DARK_GREY : SHADE_BLACK;
+        }
+    }
 };
 
 
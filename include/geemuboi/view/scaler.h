@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace geemuboi::view {
+
+
+// Pixel-art upscaling of a whole screen, meant to run on the presenting
+// thread. Every filter has a vector kernel, the last few pixels of a row
+// that don't fill a whole vector go through the scalar one.
+class Scaler {
+public:
+    enum Filters {
+        FILTER_NEAREST,
+        FILTER_SCALE2X,
+        FILTER_SCALE3X,
+        // Edge-directed 2x in the spirit of xBR, on the 3x3 neighbourhood
+        FILTER_XBR_LITE
+    };
+
+    // The factor only matters for nearest, the others have theirs built in.
+    Scaler(int filter_in, int factor_in = 2);
+
+    int get_factor() const;
+
+    // Scales SCREEN_WIDTH x SCREEN_HEIGHT pixels, the pitches are in pixels.
+    void scale(const uint32_t* src, int src_pitch, uint32_t* dst, int dst_pitch);
+
+private:
+    static const int MAX_FACTOR = 8;
+
+    void pad(const uint32_t* src, int src_pitch);
+
+    int filter;
+    int factor;
+
+    // The screen with its edge pixels repeated once all around, so that
+    // every pixel has neighbours
+    std::vector<uint32_t> padded;
+    std::vector<int32_t> luma;
+};
+
+
+}
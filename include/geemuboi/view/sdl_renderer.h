@@ -1,21 +1,53 @@
 #pragma once
 
 #include "view/renderer.h"
+#include "view/scaler.h"
 
 #include <SDL2/SDL.h>
 
+#include <memory>
+#include <string>
+#include <vector>
+
 namespace geemuboi::view {
 
 
 class SDLRenderer : public Renderer {
 public:
-    SDLRenderer();
+    struct OverlayBar {
+        // Of the window width
+        double fraction;
+        uint32_t color;
+    };
+
+
+    // A streaming texture can be drawn into directly through lock_frame().
+    // With a scaler, frames are upscaled by it before they are presented.
+    SDLRenderer(bool streaming_in = false, std::unique_ptr<Scaler> scaler_in = nullptr);
     void render_frame(uint32_t img[]);
-    void update_fps_indicator(int frames);
+    uint32_t* lock_frame(int& pitch);
+    void unlock_frame();
+    // The details follow the frame rate in the window title
+    void update_fps_indicator(int frames, const std::string& details = "");
+    // Bars drawn over every frame from now on, one after the other along
+    // the bottom edge. Empty to remove them.
+    void set_overlay(const std::vector<OverlayBar>& overlay_in);
 private:
+    void present_scaled(const uint32_t* img);
+    void present();
+
     SDL_Window* window;
     SDL_Renderer* renderer;
     SDL_Texture* framebuffer;
+    bool streaming;
+
+    std::unique_ptr<Scaler> scaler;
+    // What lock_frame() hands out when scaling, and what a static texture is
+    // updated from
+    std::vector<uint32_t> unscaled;
+    std::vector<uint32_t> scaled;
+
+    std::vector<OverlayBar> overlay;
 };
 
 
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "view/renderer.h"
+#include "view/triple_buffer.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace geemuboi::view {
+
+
+// Lets the emulation run on its own thread while another thread presents.
+// Frames are drawn as shades straight into a triple buffer through
+// lock_shades(), so emulation never waits for the display. present() shows
+// the newest finished frame through the wrapped renderer, on the thread
+// that owns it, and expands it to colors only if that renderer needs them.
+class ThreadedRenderer : public Renderer {
+public:
+    ThreadedRenderer(Renderer& renderer_in);
+
+    // Colors are reduced to the nearest shade
+    void render_frame(uint32_t img[]);
+    bool accepts_shades() const;
+    void render_shades(uint8_t shades[]);
+    uint8_t* lock_shades(int& pitch);
+    void unlock_frame();
+
+    // Waits up to timeout for a new frame. Returns false if none came.
+    bool present(std::chrono::milliseconds timeout);
+
+private:
+    void publish();
+
+    Renderer& renderer;
+    TripleBuffer<uint8_t> frames;
+    std::vector<uint32_t> colors;
+
+    // Only held for publishing and waiting, so the presenter can't miss a
+    // wakeup. The frames themselves are lock-free.
+    std::mutex frame_mutex;
+    std::condition_variable frame_ready;
+};
+
+
+}
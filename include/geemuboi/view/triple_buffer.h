@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+namespace geemuboi::view {
+
+
+// Three frames shared by one producing and one consuming thread. The
+// producer draws into the back frame and publishes it by swapping it with
+// the middle one, the consumer takes the middle one by swapping it with the
+// front. Neither side ever waits for the other, and frames the consumer
+// doesn't get to in time are replaced by newer ones.
+template <typename Pixel>
+class TripleBuffer {
+public:
+    explicit TripleBuffer(int frame_size) : frames{},
+        back{0},
+        front{1},
+        middle{2} {
+
+        for (std::vector<Pixel>& frame : frames) {
+            frame.resize(frame_size);
+        }
+    }
+
+    Pixel* get_back() {
+        return frames[back].data();
+    }
+
+    void publish() {
+        back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    // Moves the newest published frame to the front, false if there is none.
+    bool acquire() {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH)) {
+            return false;
+        }
+
+        front = middle.exchange(front, std::memory_order_acq_rel) & INDEX_MASK;
+        return true;
+    }
+
+    Pixel* get_front() {
+        return frames[front].data();
+    }
+
+private:
+    static const int INDEX_MASK = 0x3;
+    static const int FRESH = 0x4;
+
+    std::vector<Pixel> frames[3];
+
+    int back;
+    int front;
+    // Index of the middle frame, with FRESH set if it's not yet acquired
+    std::atomic<int> middle;
+};
+
+
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "core/immu.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace geemuboi::test::core {
+
+
+// 64 KB of plain memory without any hardware behind it. Pages are handed
+// out for the fast paths of the CPUs.
+class FlatMmu : public geemuboi::core::IMmu {
+public:
+    FlatMmu() : memory{} {}
+
+    // Copies a program or data to addr, wrapping around at the end
+    void load(uint16_t addr, const std::vector<uint8_t>& bytes) {
+        for (uint8_t byte : bytes) {
+            memory[addr++] = byte;
+        }
+    }
+
+    uint8_t read_byte(uint16_t addr) { return memory[addr]; }
+    uint16_t read_word(uint16_t addr) {
+        return memory[addr] + (memory[static_cast<uint16_t>(addr + 1)] << 8);
+    }
+    void write_byte(uint16_t addr, uint8_t val) { memory[addr] = val; }
+    void write_word(uint16_t addr, uint16_t val) {
+        memory[addr] = val;
+        memory[static_cast<uint16_t>(addr + 1)] = val >> 8;
+    }
+    const uint8_t* get_read_page(uint16_t addr) { return &memory[addr & 0xFF00]; }
+    uint8_t* get_write_page(uint16_t addr) { return &memory[addr & 0xFF00]; }
+
+    uint8_t memory[0x10000];
+};
+
+
+// FlatMmu with E000-FDFF mirroring C000-DDFF, like echo RAM
+class EchoMmu : public FlatMmu {
+public:
+    uint8_t read_byte(uint16_t addr) { return memory[get_ram_addr(addr)]; }
+    uint16_t read_word(uint16_t addr) {
+        return read_byte(addr) + (read_byte(static_cast<uint16_t>(addr + 1)) << 8);
+    }
+    void write_byte(uint16_t addr, uint8_t val) { memory[get_ram_addr(addr)] = val; }
+    void write_word(uint16_t addr, uint16_t val) {
+        write_byte(addr, val);
+        write_byte(static_cast<uint16_t>(addr + 1), val >> 8);
+    }
+    const uint8_t* get_read_page(uint16_t addr) { return &memory[get_ram_addr(addr) & 0xFF00]; }
+    uint8_t* get_write_page(uint16_t addr) { return &memory[get_ram_addr(addr) & 0xFF00]; }
+
+private:
+    static uint16_t get_ram_addr(uint16_t addr) {
+        return addr >= 0xE000 && addr < 0xFE00 ? addr - 0x2000 : addr;
+    }
+};
+
+
+}
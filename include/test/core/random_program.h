@@ -0,0 +1,128 @@
+#pragma once
+
+#include "core/flat_mmu.h"
+
+#include <cstdint>
+#include <random>
+
+namespace geemuboi::test::core {
+
+
+// Cartridge-like memory, code below 0x8000 can not be overwritten by the
+// random instruction streams.
+class RomMmu : public FlatMmu {
+public:
+    void write_byte(uint16_t addr, uint8_t val) {
+        if (addr >= 0x8000) {
+            FlatMmu::write_byte(addr, val);
+        }
+    }
+
+    void write_word(uint16_t addr, uint16_t val) {
+        write_byte(addr, val);
+        write_byte(addr + 1, val >> 8);
+    }
+
+    uint8_t* get_write_page(uint16_t addr) {
+        return addr >= 0x8000 ? FlatMmu::get_write_page(addr) : nullptr;
+    }
+};
+
+inline bool is_straight_line_opcode(uint8_t opcode) {
+    switch (opcode) {
+    case 0x10: case 0x76: case 0xF3: case 0xFB: case 0xCB:
+    case 0x18: case 0xC3: case 0xCD: case 0xE9:
+    case 0xC0: case 0xC8: case 0xC9: case 0xD0: case 0xD8: case 0xD9:
+    case 0xC4: case 0xCC: case 0xD4: case 0xDC:
+    case 0xC7: case 0xCF: case 0xD7: case 0xDF:
+    case 0xE7: case 0xEF: case 0xF7: case 0xFF:
+    case 0xD3: case 0xDB: case 0xDD: case 0xE3: case 0xE4: case 0xEB:
+    case 0xEC: case 0xED: case 0xF4: case 0xFC: case 0xFD:
+        return false;
+    default:
+        return true;
+    }
+}
+
+// Random code without control flow, except for conditional branches which
+// skip up to four of the instructions after them. They end blocks on both
+// of their paths.
+inline void generate_program(uint8_t memory[], int size, unsigned seed) {
+    static const uint8_t lengths[0x100] = {
+        1, 3, 1, 1, 1, 1, 2, 1, 3, 1, 1, 1, 1, 1, 2, 1,
+        2, 3, 1, 1, 1, 1, 2, 1, 2, 1, 1, 1, 1, 1, 2, 1,
+        2, 3, 1, 1, 1, 1, 2, 1, 2, 1, 1, 1, 1, 1, 2, 1,
+        2, 3, 1, 1, 1, 1, 2, 1, 2, 1, 1, 1, 1, 1, 2, 1,
+        1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+        1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+        1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+        1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+        1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+        1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+        1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+        1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+        1, 1, 3, 3, 3, 1, 2, 1, 1, 1, 3, 2, 3, 3, 2, 1,
+        1, 1, 3, 1, 3, 1, 2, 1, 1, 1, 3, 1, 3, 1, 2, 1,
+        2, 1, 1, 1, 1, 1, 2, 1, 2, 1, 3, 1, 1, 1, 2, 1,
+        2, 1, 1, 1, 1, 1, 2, 1, 2, 1, 3, 1, 1, 1, 2, 1
+    };
+
+    std::mt19937 rng(seed);
+    int addr = 0;
+    int branch_addr = -1;
+    int branch_skip = 0;
+    while (addr < size - 8) {
+        // The offset of the last branch is known once it has skipped enough
+        if (branch_addr >= 0 && branch_skip == 0) {
+            memory[branch_addr + 1] = addr - (branch_addr + 2);
+            branch_addr = -1;
+        }
+
+        uint8_t opcode = rng();
+        if (rng() % 8 == 0) {
+            memory[addr++] = 0xCB;
+            memory[addr++] = rng();
+            --branch_skip;
+            continue;
+        }
+
+        if (!is_straight_line_opcode(opcode)) {
+            continue;
+        }
+
+        int next = addr + lengths[opcode];
+        memory[addr] = opcode;
+        --branch_skip;
+        switch (opcode) {
+        case 0x20: case 0x28: case 0x30: case 0x38:
+            if (branch_addr >= 0) {
+                memory[branch_addr + 1] = addr - (branch_addr + 2);
+            }
+            memory[addr + 1] = 0;
+            branch_addr = addr;
+            branch_skip = rng() % 5;
+            break;
+        case 0xC2: case 0xCA: case 0xD2: case 0xDA:
+            memory[addr + 1] = next;
+            memory[addr + 2] = next >> 8;
+            break;
+        default:
+            for (int i = addr + 1; i != next; ++i) {
+                memory[i] = rng();
+            }
+        }
+        addr = next;
+    }
+
+    if (branch_addr >= 0) {
+        memory[branch_addr + 1] = addr - (branch_addr + 2);
+    }
+
+    // jp 0x0000
+    memory[addr] = 0xC3;
+    memory[addr + 1] = 0x00;
+    memory[addr + 2] = 0x00;
+}
+
+
+}
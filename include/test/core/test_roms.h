@@ -0,0 +1,47 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace geemuboi::test::core {
+
+
+// 32 KB without a header, with the program at the entry point 0x100 and
+// the data at data_addr. The ROMs of all the tests and benchmarks are built
+// with it.
+inline std::vector<uint8_t> make_rom(const std::vector<uint8_t>& program, uint16_t data_addr = 0,
+                                     const std::vector<uint8_t>& data = {}) {
+    std::vector<uint8_t> rom(0x8000);
+    std::copy(program.begin(), program.end(), rom.begin() + 0x100);
+    std::copy(data.begin(), data.end(), rom.begin() + data_addr);
+    return rom;
+}
+
+// ld hl,0x8000 / inc (hl) / jr -3, the top row of tile 0 keeps changing
+inline std::vector<uint8_t> make_counting_rom() {
+    return make_rom({0x21, 0x00, 0x80, 0x34, 0x18, 0xFD});
+}
+
+// Sends the zero terminated text at 0x200 over the link port, a byte at a
+// time, waiting for each transfer to finish. Then loops forever.
+inline std::vector<uint8_t> make_serial_rom(const std::string& text) {
+    return make_rom({
+        0x21, 0x00, 0x02,   // ld hl,0x200
+        0x2A,               // ld a,(hl+)
+        0xB7,               // or a
+        0x28, 0x0E,         // jr z,+14
+        0xE0, 0x01,         // ldh (0x01),a
+        0x3E, 0x81,         // ld a,0x81
+        0xE0, 0x02,         // ldh (0x02),a
+        0xF0, 0x02,         // ldh a,(0x02)
+        0xE6, 0x80,         // and 0x80
+        0x20, 0xFA,         // jr nz,-6
+        0x18, 0xEE,         // jr -18
+        0x18, 0xFE          // jr -2
+    }, 0x200, std::vector<uint8_t>(text.begin(), text.end()));
+}
+
+
+}
@@ -1,22 +1,48 @@
+#include "audio/null_audio_sink.h"
+#include "audio/sdl_audio_sink.h"
+#include "core/apu.h"
 #include "core/cpu_debug_decorator.h"
 #include "core/cpu_factory.h"
 #include "core/icpu.h"
 #include "core/gpu.h"
+#include "core/hash.h"
 #include "core/input.h"
+#include "core/interrupts.h"
 #include "core/mmu.h"
+#include "core/movie.h"
+#include "core/profiler.h"
+#include "core/scheduler.h"
+#include "core/serial.h"
+#include "core/serial_sink.h"
+#include "core/timer.h"
+#include "view/recording_renderer.h"
+#include "view/scaler.h"
 #include "view/sdl_renderer.h"
+#include "view/threaded_renderer.h"
 #include "input/sdl_keyboard.h"
 
+#include <atomic>
+#include <fstream>
+#include <iterator>
 #include <iostream>
 #include <memory>
 #include <string>
 #include <chrono>
+#include <cstdio>
 #include <thread>
+#include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include <SDL2/SDL.h>
 #include <args.hxx>
 
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace geemuboi::audio;
 using namespace geemuboi::core;
 using namespace geemuboi::view;
 using namespace geemuboi::input;
@@ -24,6 +50,107 @@ using namespace geemuboi::input;
 const double MILLIS_PER_FRAME = 1000 / 60;
 
 
+uint64_t hash_file(const std::string& path) {
+    std::ifstream ifs(path, std::ios::binary);
+    std::vector<char> data((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    return hash_bytes(data.data(), data.size());
+}
+
+// Keeps events handled while emulation is stopped at a breakpoint
+const int PRESENT_TIMEOUT_MILLIS = 50;
+
+// What the HUD measures the sections against
+const double FRAME_BUDGET_MILLIS = 1000.0 / 60;
+
+
+// Times everything the wrapped renderer does to show a frame
+class ProfiledRenderer : public Renderer {
+public:
+    ProfiledRenderer(Renderer& renderer_in, Profiler* profiler_in) : renderer(renderer_in),
+        profiler{profiler_in} {}
+
+    void render_frame(uint32_t img[]) {
+        ProfilerSection section(profiler, PerfStats::SECTION_PRESENT);
+        renderer.render_frame(img);
+    }
+
+    uint32_t* lock_frame(int& pitch) {
+        return renderer.lock_frame(pitch);
+    }
+
+    void unlock_frame() {
+        ProfilerSection section(profiler, PerfStats::SECTION_PRESENT);
+        renderer.unlock_frame();
+    }
+
+    bool accepts_shades() const {
+        return renderer.accepts_shades();
+    }
+
+    void render_shades(uint8_t shades[]) {
+        ProfilerSection section(profiler, PerfStats::SECTION_PRESENT);
+        renderer.render_shades(shades);
+    }
+
+    uint8_t* lock_shades(int& pitch) {
+        return renderer.lock_shades(pitch);
+    }
+
+private:
+    Renderer& renderer;
+    Profiler* profiler;
+};
+
+
+// A Unix socket handing the latest metrics to everyone connecting, polled
+// without blocking. Returns -1 if it couldn't be opened.
+int open_metrics_socket(const std::string& path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        return -1;
+    }
+    path.copy(address.sun_path, path.size());
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    unlink(path.c_str());
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 ||
+        listen(fd, 8) < 0 || fcntl(fd, F_SETFL, O_NONBLOCK) < 0) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+void serve_metrics(int fd, const std::string& text) {
+    int client;
+    while ((client = accept(fd, nullptr, nullptr)) >= 0) {
+        // Small enough for the socket buffer, a client not reading just
+        // gets less
+        send(client, text.data(), text.size(), MSG_DONTWAIT | MSG_NOSIGNAL);
+        close(client);
+    }
+}
+
+// Replaced as a whole, so readers never see half a dump
+void write_metrics(const std::string& path, const std::string& text) {
+    std::string temp_path = path + ".tmp";
+    {
+        std::ofstream ofs(temp_path, std::ios::binary);
+        ofs << text;
+        if (!ofs) {
+            return;
+        }
+    }
+    std::rename(temp_path.c_str(), path.c_str());
+}
+
+
 int main(int argc, char* argv[]) {
     using namespace std::chrono;
 
@@ -32,6 +159,32 @@ int main(int argc, char* argv[]) {
     args::Positional<std::string> bios(parser, "BIOS", "The GameBoy BIOS ROM.");
     args::Positional<std::string> rom(parser, "ROM", "A GameBoy ROM.");
     args::ValueFlagList<std::string> breakpoints(parser, "breakpoint", "A breakpoint address.", {"b"});
+    args::Flag cached(parser, "cached", "Use the cached basic-block interpreter.", {"cached"});
+    args::Flag jit(parser, "jit", "Use the x86-64 recompiler.", {"jit"});
+    args::Flag audio_sync(parser, "audio-sync", "Pace emulation by audio playback instead of the frame rate.", {"audio-sync"});
+    args::Flag streaming(parser, "streaming", "Draw frames straight into a streaming texture.", {"streaming"});
+    args::Flag single_thread(parser, "single-thread", "Emulate and present on the same thread.", {"single-thread"});
+    args::Flag no_audio(parser, "no-audio", "Run without opening an audio device.", {"no-audio"});
+    args::ValueFlag<std::string> filter(parser, "filter",
+            "Upscale frames with nearest2, nearest3, scale2x, scale3x or xbr.", {"filter"});
+    args::ValueFlag<std::string> serial_file(parser, "serial",
+            "Write everything sent over the link port to a file.", {"serial"});
+    args::ValueFlag<std::string> record(parser, "record",
+            "Record the buttons pressed into a movie file.", {"record"});
+    args::ValueFlag<std::string> play(parser, "play",
+            "Play the buttons of a movie file instead of reading the keyboard.", {"play"});
+    args::ValueFlag<std::string> capture(parser, "capture",
+            "Record the screen into a file or named pipe.", {"capture"});
+    args::Flag capture_yuv(parser, "capture-yuv",
+            "Capture raw 160x144 yuv420p frames for an encoder instead.", {"capture-yuv"});
+    args::Flag hud(parser, "hud",
+            "Show where the time of each frame goes, as bars and in the title.", {"hud"});
+    args::ValueFlag<std::string> metrics_file(parser, "metrics",
+            "Write frame timing metrics to a file every second.", {"metrics"});
+    args::ValueFlag<std::string> metrics_socket_path(parser, "metrics-socket",
+            "Serve frame timing metrics on a Unix socket.", {"metrics-socket"});
+    args::ValueFlag<std::string> metrics_format(parser, "metrics-format",
+            "Metrics as prometheus (the default) or json.", {"metrics-format"});
 
     try {
         parser.ParseCLI(argc, argv);
@@ -66,57 +219,281 @@ int main(int argc, char* argv[]) {
         }
     }
 
-    SDLRenderer renderer;
+    std::unique_ptr<Scaler> scaler;
+    if (filter) {
+        const std::unordered_map<std::string, std::pair<int, int>> filters{
+            {"nearest2", {Scaler::FILTER_NEAREST, 2}},
+            {"nearest3", {Scaler::FILTER_NEAREST, 3}},
+            {"scale2x", {Scaler::FILTER_SCALE2X, 2}},
+            {"scale3x", {Scaler::FILTER_SCALE3X, 3}},
+            {"xbr", {Scaler::FILTER_XBR_LITE, 2}}
+        };
+
+        auto it = filters.find(args::get(filter));
+        if (it == filters.end()) {
+            std::cout << "Unknown filter " << args::get(filter) << std::endl;
+            return 1;
+        }
+        scaler = std::make_unique<Scaler>(it->second.first, it->second.second);
+    }
+
+    bool json_metrics = false;
+    if (metrics_format) {
+        json_metrics = args::get(metrics_format) == "json";
+        if (!json_metrics && args::get(metrics_format) != "prometheus") {
+            std::cout << "Unknown metrics format " << args::get(metrics_format) << std::endl;
+            return 1;
+        }
+    }
+
+    int metrics_socket = -1;
+    if (metrics_socket_path) {
+        metrics_socket = open_metrics_socket(args::get(metrics_socket_path));
+        if (metrics_socket < 0) {
+            std::cout << "Could not open " << args::get(metrics_socket_path) << std::endl;
+            return 1;
+        }
+    }
+
+    // The presenting thread has a profiler of its own unless it's the
+    // emulating one
+    PerfStats perf_stats;
+    Profiler emulation_profiler(perf_stats);
+    Profiler presenter_profiler(perf_stats);
+    bool profiling = hud || metrics_file || metrics_socket_path;
+    Profiler* emulation_profiling = profiling ? &emulation_profiler : nullptr;
+    Profiler* presenter_profiling = !profiling ? nullptr :
+        single_thread ? &emulation_profiler : &presenter_profiler;
+
+    SDLRenderer renderer(static_cast<bool>(streaming), std::move(scaler));
+    ProfiledRenderer profiled_renderer(renderer, presenter_profiling);
+    ThreadedRenderer presenter(profiled_renderer);
+    Renderer* gpu_renderer = single_thread ? static_cast<Renderer*>(&profiled_renderer) : &presenter;
+
+    std::ofstream capture_file;
+    std::unique_ptr<RecordingRenderer> recorder_renderer;
+    if (capture) {
+        capture_file.open(args::get(capture), std::ios::binary);
+        if (!capture_file) {
+            std::cout << "Could not open " << args::get(capture) << std::endl;
+            return 1;
+        }
+
+        int format = capture_yuv ? RecordingRenderer::FORMAT_YUV : RecordingRenderer::FORMAT_INDEXED;
+        recorder_renderer = std::make_unique<RecordingRenderer>(*gpu_renderer, capture_file, format);
+        gpu_renderer = recorder_renderer.get();
+    }
     SDL_Event event;
 
-    GPU gpu(renderer);
+    std::unique_ptr<AudioSink> audio_sink;
+    if (no_audio) {
+        audio_sink = std::make_unique<NullAudioSink>();
+    } else {
+        audio_sink = std::make_unique<SDLAudioSink>();
+    }
+
+    Scheduler scheduler;
+    Interrupts interrupts;
+    GPU gpu(*gpu_renderer, scheduler, interrupts);
     Input input;
-    MMU mmu(gpu, input, args::get(bios), args::get(rom)); 
+    Timer timer(scheduler, interrupts);
+    Serial serial(scheduler, interrupts);
+    APU apu(scheduler, *audio_sink);
+    MMU mmu(gpu, input, interrupts, timer, serial, scheduler, apu, args::get(bios), args::get(rom)); 
+    scheduler.set_profiler(emulation_profiling);
+
+    uint64_t rom_hash = hash_file(args::get(rom));
+    uint64_t bios_hash = hash_file(args::get(bios));
+
+    CpuType cpu_type = jit ? CPU_TYPE_JIT : cached ? CPU_TYPE_CACHED : CPU_TYPE_INTERPRETER;
+
+    std::unique_ptr<MovieRecorder> recorder;
+    if (record) {
+        recorder = std::make_unique<MovieRecorder>(input, scheduler, rom_hash, bios_hash, cpu_type);
+    }
+
+    std::unique_ptr<MoviePlayer> player;
+    if (play) {
+        try {
+            Movie movie = read_movie(args::get(play));
+            if (movie.rom_hash != rom_hash || movie.bios_hash != bios_hash) {
+                std::cout << "The movie was recorded with another ROM or BIOS" << std::endl;
+                return 1;
+            }
+            player = std::make_unique<MoviePlayer>(movie, input, scheduler, cpu_type);
+        } catch (const std::exception& e) {
+            std::cout << e.what() << std::endl;
+            return 1;
+        }
+    }
+
+    std::unique_ptr<SerialSink> serial_sink;
+    if (serial_file) {
+        serial_sink = std::make_unique<FileSerialSink>(args::get(serial_file));
+        serial.set_sink(serial_sink.get());
+    }
 
     ICpu::Registers regs{};
     std::unique_ptr<ICpu> cpu{
-        std::make_unique<CpuDebugDecorator>(std::move(create_cpu(mmu, regs)), 
+        std::make_unique<CpuDebugDecorator>(std::move(create_cpu(mmu, regs, cpu_type, &scheduler, &interrupts)), 
         mmu,
         regs, 
         bps)};
 
     SDLKeyboard joypad(input);
 
+    std::atomic<bool> run{true};
+    std::atomic<int> frames{0};
     high_resolution_clock clock;
-    auto start_time = clock.now();
 
-    int frames = 0;
-    bool run = true;
-    while (run) {
+    auto pace_frame = [&](high_resolution_clock::time_point frame_start_time) {
+        // Falls back to pacing by the frame rate without an audio device
+        if (audio_sync && audio_sink->wait_until_drained()) {
+            return;
+        }
+
+        auto frame_time = duration_cast<milliseconds>(clock.now() - frame_start_time);
+        if (frame_time.count() < MILLIS_PER_FRAME) {
+            int time_to_sleep = MILLIS_PER_FRAME - frame_time.count();
+            std::this_thread::sleep_for(milliseconds(time_to_sleep));
+        }
+    };
+
+    auto emulate_frame = [&]() {
         int frame_cycles = 0;
         auto frame_start_time = clock.now();
-        while (frame_cycles <= GPU::CYCLES_PER_FRAME) {
-            int cycles = cpu->execute();
-            gpu.step(cycles);
-            frame_cycles += cycles;
+        {
+            ProfilerSection section(emulation_profiling, PerfStats::SECTION_CPU);
+            while (frame_cycles < GPU::CYCLES_PER_FRAME) {
+                int cycles = cpu->execute();
+                scheduler.advance(cycles);
+                frame_cycles += cycles;
+            }
+        }
+
+        ++frames;
+
+        {
+            ProfilerSection section(emulation_profiling, PerfStats::SECTION_SLEEP);
+            pace_frame(frame_start_time);
+        }
+
+        if (emulation_profiling) {
+            emulation_profiling->end_frame();
         }
+    };
 
-        while (SDL_PollEvent(&event)) {
-            joypad.update_button_presses();
-            if (event.type == SDL_QUIT) {
-                run = false;
+    // Once a second, with the means since the last time on the HUD
+    Histogram::Snapshot last_snapshots[PerfStats::NBR_SECTIONS]{};
+    auto report_perf = [&]() {
+        std::string details;
+        std::vector<SDLRenderer::OverlayBar> bars;
+        const uint32_t SECTION_COLORS[PerfStats::NBR_SECTIONS] = {
+            0x3060E0, 0x30C060, 0xE0C030, 0xC040C0, 0xE05030, 0x000000, 0x000000
+        };
+
+        for (int section = 0; section != PerfStats::NBR_SECTIONS; ++section) {
+            Histogram::Snapshot snapshot = perf_stats.get_histogram(section).get_snapshot();
+            double mean_millis = snapshot.since(last_snapshots[section]).get_mean_millis();
+            last_snapshots[section] = snapshot;
+
+            if (section == PerfStats::SECTION_SLEEP || section == PerfStats::SECTION_FRAME) {
+                continue;
             }
+
+            char text[32];
+            std::snprintf(text, sizeof(text), "%s %.2f ", PerfStats::get_section_name(section),
+                          mean_millis);
+            details += text;
+            bars.push_back({mean_millis / FRAME_BUDGET_MILLIS, SECTION_COLORS[section]});
         }
 
-        ++frames;
+        std::string metrics;
+        if (metrics_file || metrics_socket >= 0) {
+            metrics = json_metrics ? perf_stats.format_json() : perf_stats.format_prometheus();
+        }
+        if (metrics_file) {
+            write_metrics(args::get(metrics_file), metrics);
+        }
+        if (metrics_socket >= 0) {
+            serve_metrics(metrics_socket, metrics);
+        }
+
+        if (hud) {
+            renderer.set_overlay(bars);
+            details += "ms";
+            return details;
+        }
+        return std::string();
+    };
+
+    // SDL wants events and rendering on the main thread, so emulation moves
+    // to its own and hands frames over through the presenter.
+    std::thread emulation;
+    if (!single_thread) {
+        emulation = std::thread([&]() {
+            while (run) {
+                emulate_frame();
+            }
+        });
+    }
+
+    auto start_time = clock.now();
+
+    while (run) {
+        if (single_thread) {
+            emulate_frame();
+        }
+
+        {
+            ProfilerSection section(presenter_profiling, PerfStats::SECTION_INPUT);
+            while (SDL_PollEvent(&event)) {
+                if (!player) {
+                    joypad.update_button_presses();
+                }
+                if (event.type == SDL_QUIT) {
+                    run = false;
+                }
+            }
+        }
+
+        if (!single_thread) {
+            presenter.present(milliseconds(PRESENT_TIMEOUT_MILLIS));
+            if (presenter_profiling) {
+                presenter_profiling->flush();
+            }
+        }
 
         if (duration_cast<milliseconds>(clock.now() - start_time).count() >= 1000) {
             start_time = clock.now();
-            renderer.update_fps_indicator(frames);
-            frames = 0;
+            std::string details = profiling ? report_perf() : std::string();
+            renderer.update_fps_indicator(frames.exchange(0), details);
         }
+    }
 
-        auto frame_time = duration_cast<milliseconds>(clock.now() - frame_start_time);
-        if (frame_time.count() < MILLIS_PER_FRAME) {
-            int time_to_sleep = MILLIS_PER_FRAME - frame_time.count();
-            std::this_thread::sleep_for(milliseconds(time_to_sleep));
+    if (emulation.joinable()) {
+        emulation.join();
+    }
+
+    if (recorder) {
+        write_movie(args::get(record), recorder->get_movie());
+    }
+
+    if (recorder_renderer) {
+        uint64_t dropped = recorder_renderer->get_dropped_frames();
+        recorder_renderer.reset();
+        if (dropped) {
+            std::cout << dropped << " frames were dropped from the capture" << std::endl;
+        }
+        if (!capture_file) {
+            std::cout << "Could not write " << args::get(capture) << std::endl;
         }
-    } 
+    }
+
+    if (metrics_socket >= 0) {
+        close(metrics_socket);
+        unlink(args::get(metrics_socket_path).c_str());
+    }
 
     SDL_Quit();
 
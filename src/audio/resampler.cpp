@@ -0,0 +1,64 @@
+#include "audio/resampler.h"
+
+#include "audio/dsp.h"
+
+#include <algorithm>
+
+namespace geemuboi::audio {
+
+
+Resampler::Resampler() : step{1.0},
+    position{},
+    left_in(TAPS - 1),
+    right_in(TAPS - 1),
+    indices{},
+    fractions{},
+    left_out{},
+    right_out{} {}
+
+void Resampler::set_ratio(double ratio) {
+    step = 1.0 / ratio;
+}
+
+double Resampler::get_ratio() const {
+    return 1.0 / step;
+}
+
+int Resampler::process(const int16_t* in, int frames, std::vector<int16_t>& out) {
+    left_in.resize(TAPS - 1 + frames);
+    right_in.resize(TAPS - 1 + frames);
+    for (int i = 0; i != frames; ++i) {
+        left_in[TAPS - 1 + i] = in[i * 2];
+        right_in[TAPS - 1 + i] = in[i * 2 + 1];
+    }
+
+    // Output i interpolates the four frames from indices[i] on
+    indices.clear();
+    fractions.clear();
+    for (int i = 0; i != frames; ++i) {
+        for (; position < 1.0; position += step) {
+            indices.push_back(i);
+            fractions.push_back(position);
+        }
+        position -= 1.0;
+    }
+
+    int count = indices.size();
+    left_out.resize(count);
+    right_out.resize(count);
+    dsp::interpolate_cubic(left_in.data(), indices.data(), fractions.data(), count, left_out.data());
+    dsp::interpolate_cubic(right_in.data(), indices.data(), fractions.data(), count, right_out.data());
+
+    std::size_t first = out.size();
+    out.resize(first + count * 2);
+    dsp::interleave(left_out.data(), right_out.data(), count, &out[first]);
+
+    std::copy(left_in.end() - (TAPS - 1), left_in.end(), left_in.begin());
+    std::copy(right_in.end() - (TAPS - 1), right_in.end(), right_in.begin());
+    left_in.resize(TAPS - 1);
+    right_in.resize(TAPS - 1);
+    return count;
+}
+
+
+}
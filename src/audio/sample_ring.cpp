@@ -0,0 +1,62 @@
+#include "audio/sample_ring.h"
+
+#include <algorithm>
+
+namespace geemuboi::audio {
+
+
+SampleRing::SampleRing(int capacity) : samples{},
+    mask{},
+    write_index{},
+    read_index{} {
+
+    std::size_t frames = 1;
+    while (frames < static_cast<std::size_t>(capacity)) {
+        frames <<= 1;
+    }
+
+    samples.resize(frames * 2);
+    mask = frames - 1;
+}
+
+int SampleRing::write(const int16_t* in, int frames) {
+    std::size_t write_at = write_index.load(std::memory_order_relaxed);
+    std::size_t read_at = read_index.load(std::memory_order_acquire);
+    std::size_t free_frames = mask + 1 - (write_at - read_at);
+    int count = std::min(static_cast<std::size_t>(frames), free_frames);
+
+    for (int i = 0; i != count; ++i) {
+        std::size_t frame = (write_at + i) & mask;
+        samples[frame * 2] = in[i * 2];
+        samples[frame * 2 + 1] = in[i * 2 + 1];
+    }
+
+    write_index.store(write_at + count, std::memory_order_release);
+    return count;
+}
+
+int SampleRing::read(int16_t* out, int frames) {
+    std::size_t read_at = read_index.load(std::memory_order_relaxed);
+    std::size_t write_at = write_index.load(std::memory_order_acquire);
+    int count = std::min(static_cast<std::size_t>(frames), write_at - read_at);
+
+    for (int i = 0; i != count; ++i) {
+        std::size_t frame = (read_at + i) & mask;
+        out[i * 2] = samples[frame * 2];
+        out[i * 2 + 1] = samples[frame * 2 + 1];
+    }
+
+    read_index.store(read_at + count, std::memory_order_release);
+    return count;
+}
+
+int SampleRing::get_frames_available() const {
+    return write_index.load(std::memory_order_acquire) - read_index.load(std::memory_order_acquire);
+}
+
+int SampleRing::get_capacity() const {
+    return mask + 1;
+}
+
+
+}
@@ -0,0 +1,86 @@
+#include "audio/sdl_audio_sink.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+namespace geemuboi::audio {
+
+
+SDLAudioSink::SDLAudioSink() : ring(RING_FRAMES),
+    device{},
+    resampler{},
+    resampled{},
+    drained_mutex{},
+    drained{} {
+
+    if (SDL_InitSubSystem(SDL_INIT_AUDIO) < 0) {
+        std::cout << "SDL audio could not be initialized: " << SDL_GetError() << std::endl;
+        return;
+    }
+
+    SDL_AudioSpec want{};
+    want.freq = SAMPLE_RATE;
+    want.format = AUDIO_S16SYS;
+    want.channels = 2;
+    want.samples = DEVICE_FRAMES;
+    want.callback = callback;
+    want.userdata = this;
+
+    device = SDL_OpenAudioDevice(NULL, 0, &want, NULL, 0);
+    if (!device) {
+        std::cout << "Audio device could not be opened: " << SDL_GetError() << std::endl;
+        return;
+    }
+
+    SDL_PauseAudioDevice(device, 0);
+}
+
+SDLAudioSink::~SDLAudioSink() {
+    if (device) {
+        SDL_CloseAudioDevice(device);
+    }
+}
+
+int SDLAudioSink::get_sample_rate() const {
+    return SAMPLE_RATE;
+}
+
+void SDLAudioSink::write_samples(const int16_t* samples, int frames) {
+    // Produces slightly more while below the target and less while above it
+    double error = static_cast<double>(TARGET_FRAMES - ring.get_frames_available()) / TARGET_FRAMES;
+    resampler.set_ratio(1.0 + MAX_RATE_DELTA * std::clamp(error, -1.0, 1.0));
+
+    resampled.clear();
+    int resampled_frames = resampler.process(samples, frames, resampled);
+    ring.write(resampled.data(), resampled_frames);
+}
+
+bool SDLAudioSink::wait_until_drained() {
+    if (!device) {
+        return false;
+    }
+
+    // The callback notifies without taking the lock, so a wakeup can be
+    // missed. The timeout bounds how late that makes us.
+    std::unique_lock<std::mutex> lock(drained_mutex);
+    while (ring.get_frames_available() > TARGET_FRAMES) {
+        drained.wait_for(lock, std::chrono::milliseconds(2));
+    }
+
+    return true;
+}
+
+void SDLAudioSink::callback(void* userdata, Uint8* stream, int length) {
+    SDLAudioSink* sink = static_cast<SDLAudioSink*>(userdata);
+    int16_t* samples = reinterpret_cast<int16_t*>(stream);
+    int frames = length / (2 * sizeof(int16_t));
+
+    // Plays silence for whatever the emulator hasn't produced in time
+    int read = sink->ring.read(samples, frames);
+    std::fill(samples + read * 2, samples + frames * 2, 0);
+    sink->drained.notify_one();
+}
+
+
+}
@@ -0,0 +1,146 @@
+#include "capi/geemuboi.h"
+
+#include "core/machine.h"
+#include "core/state.h"
+#include "view/renderer.h"
+
+#include <algorithm>
+#include <exception>
+#include <memory>
+#include <new>
+#include <vector>
+
+using namespace geemuboi::core;
+using geemuboi::view::Renderer;
+
+static_assert(GEEMUBOI_SCREEN_WIDTH == Renderer::SCREEN_WIDTH);
+static_assert(GEEMUBOI_SCREEN_HEIGHT == Renderer::SCREEN_HEIGHT);
+
+struct geemuboi_machine {
+    std::unique_ptr<Machine> machine;
+};
+
+
+// No exception may cross into C
+extern "C" {
+
+
+int geemuboi_api_version(void) {
+    return GEEMUBOI_API_VERSION;
+}
+
+geemuboi_machine* geemuboi_create(void) {
+    return new (std::nothrow) geemuboi_machine{};
+}
+
+void geemuboi_destroy(geemuboi_machine* machine) {
+    delete machine;
+}
+
+int geemuboi_load_rom(geemuboi_machine* machine, const uint8_t* rom, size_t rom_size,
+                      const uint8_t* bios, size_t bios_size) {
+    if (!machine || !rom || !rom_size || (!bios && bios_size)) {
+        return GEEMUBOI_ERROR_INVALID_ARGUMENT;
+    }
+
+    try {
+        machine->machine.reset();
+        machine->machine = std::make_unique<Machine>(std::vector<uint8_t>(rom, rom + rom_size),
+                                                     std::vector<uint8_t>(bios, bios + bios_size));
+    } catch (const std::exception&) {
+        return GEEMUBOI_ERROR_EMULATION;
+    }
+
+    return GEEMUBOI_OK;
+}
+
+int geemuboi_step_frame(geemuboi_machine* machine) {
+    if (!machine) {
+        return GEEMUBOI_ERROR_INVALID_ARGUMENT;
+    }
+    if (!machine->machine) {
+        return GEEMUBOI_ERROR_NO_ROM;
+    }
+
+    // Unimplemented instructions and memory regions end up here
+    try {
+        machine->machine->step_frame();
+    } catch (const std::exception&) {
+        return GEEMUBOI_ERROR_EMULATION;
+    }
+
+    return GEEMUBOI_OK;
+}
+
+int geemuboi_set_input(geemuboi_machine* machine, uint8_t buttons) {
+    if (!machine) {
+        return GEEMUBOI_ERROR_INVALID_ARGUMENT;
+    }
+    if (!machine->machine) {
+        return GEEMUBOI_ERROR_NO_ROM;
+    }
+
+    // The masks are the same as Machine::Buttons
+    machine->machine->set_buttons(buttons);
+    return GEEMUBOI_OK;
+}
+
+const uint32_t* geemuboi_get_framebuffer(const geemuboi_machine* machine) {
+    if (!machine || !machine->machine) {
+        return nullptr;
+    }
+
+    return machine->machine->get_framebuffer();
+}
+
+size_t geemuboi_get_state_size(const geemuboi_machine* machine) {
+    if (!machine || !machine->machine) {
+        return 0;
+    }
+
+    return machine->machine->get_state_size();
+}
+
+int geemuboi_save_state(const geemuboi_machine* machine, uint8_t* buffer, size_t size) {
+    if (!machine || !buffer) {
+        return GEEMUBOI_ERROR_INVALID_ARGUMENT;
+    }
+    if (!machine->machine) {
+        return GEEMUBOI_ERROR_NO_ROM;
+    }
+
+    try {
+        std::vector<uint8_t> state = machine->machine->save_state();
+        if (size < state.size()) {
+            return GEEMUBOI_ERROR_BUFFER_TOO_SMALL;
+        }
+
+        std::copy(state.begin(), state.end(), buffer);
+    } catch (const std::exception&) {
+        return GEEMUBOI_ERROR_EMULATION;
+    }
+
+    return GEEMUBOI_OK;
+}
+
+int geemuboi_load_state(geemuboi_machine* machine, const uint8_t* buffer, size_t size) {
+    if (!machine || !buffer) {
+        return GEEMUBOI_ERROR_INVALID_ARGUMENT;
+    }
+    if (!machine->machine) {
+        return GEEMUBOI_ERROR_NO_ROM;
+    }
+
+    try {
+        machine->machine->load_state(buffer, size);
+    } catch (const InvalidStateException&) {
+        return GEEMUBOI_ERROR_INVALID_STATE;
+    } catch (const std::exception&) {
+        return GEEMUBOI_ERROR_EMULATION;
+    }
+
+    return GEEMUBOI_OK;
+}
+
+
+}
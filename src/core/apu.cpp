@@ -0,0 +1,431 @@
+#include "core/apu.h"
+
+namespace geemuboi::core {
+
+using namespace geemuboi::audio;
+
+namespace {
+
+// Bits that always read as set, write-only and unused bits included
+const uint8_t READ_MASKS[0x30] = {
+    0x80, 0x3F, 0x00, 0xFF, 0xBF,
+    0xFF, 0x3F, 0x00, 0xFF, 0xBF,
+    0x7F, 0xFF, 0x9F, 0xFF, 0xBF,
+    0xFF, 0xFF, 0x00, 0x00, 0xBF,
+    0x00, 0x00, 0x70,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+};
+
+const uint8_t DUTY_PATTERNS[4] = {0x01, 0x81, 0x87, 0x7E};
+const int NOISE_DIVISORS[8] = {8, 16, 32, 48, 64, 80, 96, 112};
+
+// Every channel has five registers starting at NR10, NR21 - 1, NR30 and
+// NR41 - 1: sweep, length, volume, frequency low and frequency high.
+const int CHANNEL_REGISTERS = 5;
+const int REG_OFFSET_LENGTH = 1;
+const int REG_OFFSET_VOLUME = 2;
+const int REG_OFFSET_FREQUENCY_LOW = 3;
+const int REG_OFFSET_FREQUENCY_HIGH = 4;
+
+const uint8_t TRIGGER = 0x80;
+const uint8_t LENGTH_ENABLE = 0x40;
+
+}
+
+
+APU::APU(Scheduler& scheduler_in, AudioSink& sink_in) : scheduler(scheduler_in),
+    sink(sink_in),
+    left_buffer(CLOCK_RATE, sink_in.get_sample_rate()),
+    right_buffer(CLOCK_RATE, sink_in.get_sample_rate()),
+    samples(MAX_FRAME_SAMPLES * 2),
+    registers{},
+    channels{},
+    powered{true},
+    frame_sequencer_step{},
+    sweep_timer{},
+    sweep_enabled{},
+    sweep_shadow{},
+    frame_start_time{} {
+
+    scheduler.set_handler(Scheduler::EVENT_APU, [this]() { step_frame_sequencer(); });
+    scheduler.schedule_in(Scheduler::EVENT_APU, FRAME_SEQUENCER_CYCLES);
+}
+
+uint8_t APU::read_register(uint16_t addr) {
+    int reg = addr - FIRST_REGISTER;
+    if (reg != REG_NR52) {
+        return registers[reg] | READ_MASKS[reg];
+    }
+
+    uint8_t status = READ_MASKS[reg] | (powered ? 0x80 : 0);
+    for (int i = 0; i != NBR_CHANNELS; ++i) {
+        if (channels[i].enabled) {
+            status |= 1 << i;
+        }
+    }
+
+    return status;
+}
+
+void APU::write_register(uint16_t addr, uint8_t val) {
+    int reg = addr - FIRST_REGISTER;
+    uint64_t time = get_time();
+    render(time);
+
+    if (reg >= REG_WAVE_RAM) {
+        registers[reg] = val;
+        return;
+    }
+
+    if (reg == REG_NR52) {
+        if (powered && !(val & 0x80)) {
+            power_off();
+        } else if (!powered && (val & 0x80)) {
+            frame_sequencer_step = 0;
+        }
+        powered = val & 0x80;
+        update_outputs(time);
+        return;
+    }
+
+    if (!powered) {
+        return;
+    }
+
+    registers[reg] = val;
+
+    // The volume and panning registers and the unused ones after them
+    // belong to no channel
+    if (reg >= REG_NR50) {
+        update_outputs(time);
+        return;
+    }
+
+    int index = reg / CHANNEL_REGISTERS;
+    Channel& channel = channels[index];
+
+    switch (reg) {
+    case REG_NR11:
+    case REG_NR21:
+    case REG_NR41:
+        channel.length = 64 - (val & 0x3F);
+        break;
+    case REG_NR31:
+        channel.length = 256 - val;
+        break;
+    case REG_NR12:
+    case REG_NR22:
+    case REG_NR42:
+        channel.dac_enabled = val & 0xF8;
+        channel.enabled &= channel.dac_enabled;
+        break;
+    case REG_NR30:
+        channel.dac_enabled = val & 0x80;
+        channel.enabled &= channel.dac_enabled;
+        break;
+    case REG_NR14:
+    case REG_NR24:
+    case REG_NR34:
+    case REG_NR44:
+        channel.length_enabled = val & LENGTH_ENABLE;
+        if (val & TRIGGER) {
+            trigger(index);
+        }
+        break;
+    }
+
+    update_outputs(time);
+}
+
+void APU::save_state(StateWriter& writer) const {
+    left_buffer.save_state(writer);
+    right_buffer.save_state(writer);
+    writer.write(registers);
+    writer.write(channels);
+    writer.write(powered);
+    writer.write(frame_sequencer_step);
+    writer.write(sweep_timer);
+    writer.write(sweep_enabled);
+    writer.write(sweep_shadow);
+    writer.write(frame_start_time);
+}
+
+void APU::load_state(StateReader& reader) {
+    left_buffer.load_state(reader);
+    right_buffer.load_state(reader);
+    reader.read(registers);
+    reader.read(channels);
+    reader.read(powered);
+    reader.read(frame_sequencer_step);
+    reader.read(sweep_timer);
+    reader.read(sweep_enabled);
+    reader.read(sweep_shadow);
+    reader.read(frame_start_time);
+}
+
+void APU::step_frame_sequencer() {
+    uint64_t time = get_time();
+    render(time);
+
+    if (powered) {
+        switch (frame_sequencer_step) {
+        case 0:
+        case 4:
+            clock_lengths();
+            break;
+        case 2:
+        case 6:
+            clock_lengths();
+            clock_sweep();
+            break;
+        case 7:
+            clock_envelopes();
+            break;
+        }
+
+        update_outputs(time);
+    }
+
+    frame_sequencer_step = (frame_sequencer_step + 1) % FRAME_SEQUENCER_STEPS;
+    if (frame_sequencer_step == 0) {
+        flush();
+    }
+
+    scheduler.schedule_in(Scheduler::EVENT_APU, FRAME_SEQUENCER_CYCLES);
+}
+
+void APU::clock_lengths() {
+    for (Channel& channel : channels) {
+        if (channel.length_enabled && channel.length > 0 && --channel.length == 0) {
+            channel.enabled = false;
+        }
+    }
+}
+
+void APU::clock_sweep() {
+    if (--sweep_timer > 0) {
+        return;
+    }
+
+    int period = (registers[REG_NR10] >> 4) & 0x7;
+    sweep_timer = period ? period : 8;
+    if (!sweep_enabled || !period) {
+        return;
+    }
+
+    int frequency = calculate_sweep();
+    if (frequency <= 0x7FF && (registers[REG_NR10] & 0x7)) {
+        sweep_shadow = frequency;
+        registers[REG_NR13] = frequency & 0xFF;
+        registers[REG_NR14] = (registers[REG_NR14] & ~0x7) | (frequency >> 8);
+
+        // The new frequency is checked for overflow once more
+        calculate_sweep();
+    }
+}
+
+void APU::clock_envelopes() {
+    for (int index : {CHANNEL_SQUARE_1, CHANNEL_SQUARE_2, CHANNEL_NOISE}) {
+        Channel& channel = channels[index];
+        if (!channel.envelope_period || --channel.envelope_timer > 0) {
+            continue;
+        }
+
+        channel.envelope_timer = channel.envelope_period;
+        if (channel.envelope_increase && channel.volume < 15) {
+            ++channel.volume;
+        } else if (!channel.envelope_increase && channel.volume > 0) {
+            --channel.volume;
+        }
+    }
+}
+
+int APU::calculate_sweep() {
+    int delta = sweep_shadow >> (registers[REG_NR10] & 0x7);
+    int frequency = (registers[REG_NR10] & 0x08) ? sweep_shadow - delta : sweep_shadow + delta;
+    if (frequency > 0x7FF) {
+        channels[CHANNEL_SQUARE_1].enabled = false;
+    }
+
+    return frequency;
+}
+
+void APU::render(uint64_t time) {
+    for (int index = 0; index != NBR_CHANNELS; ++index) {
+        render_channel(index, time);
+    }
+}
+
+void APU::render_channel(int index, uint64_t time) {
+    Channel& channel = channels[index];
+    if (!channel.enabled || !channel.dac_enabled) {
+        return;
+    }
+
+    // The LFSR isn't clocked at all with the two highest shifts
+    if (index == CHANNEL_NOISE && (registers[REG_NR43] >> 4) >= 14) {
+        return;
+    }
+
+    // Only steps changing the output add anything to the buffers
+    int period = get_period(index);
+    while (channel.next_step_time < time) {
+        step_channel(index);
+        set_output(index, channel.next_step_time);
+        channel.next_step_time += period;
+    }
+}
+
+void APU::step_channel(int index) {
+    Channel& channel = channels[index];
+
+    switch (index) {
+    case CHANNEL_SQUARE_1:
+    case CHANNEL_SQUARE_2:
+        channel.position = (channel.position + 1) & 0x7;
+        break;
+    case CHANNEL_WAVE:
+        channel.position = (channel.position + 1) & 0x1F;
+        break;
+    case CHANNEL_NOISE: {
+        int feedback = (channel.lfsr ^ (channel.lfsr >> 1)) & 1;
+        channel.lfsr = (channel.lfsr >> 1) | (feedback << 14);
+        if (registers[REG_NR43] & 0x08) {
+            channel.lfsr = (channel.lfsr & ~0x40) | (feedback << 6);
+        }
+        break;
+    }
+    }
+}
+
+void APU::flush() {
+    uint64_t time = get_time();
+    left_buffer.end_frame(time - frame_start_time);
+    right_buffer.end_frame(time - frame_start_time);
+    frame_start_time = time;
+
+    int frames = left_buffer.read_samples(&samples[0], MAX_FRAME_SAMPLES, 2);
+    right_buffer.read_samples(&samples[1], MAX_FRAME_SAMPLES, 2);
+    sink.write_samples(samples.data(), frames);
+}
+
+void APU::trigger(int index) {
+    Channel& channel = channels[index];
+    channel.enabled = channel.dac_enabled;
+    if (channel.length == 0) {
+        channel.length = (index == CHANNEL_WAVE) ? 256 : 64;
+    }
+    channel.next_step_time = get_time() + get_period(index);
+
+    if (index != CHANNEL_WAVE) {
+        uint8_t envelope = registers[index * CHANNEL_REGISTERS + REG_OFFSET_VOLUME];
+        channel.volume = envelope >> 4;
+        channel.envelope_increase = envelope & 0x08;
+        channel.envelope_period = envelope & 0x7;
+        channel.envelope_timer = channel.envelope_period ? channel.envelope_period : 8;
+    }
+
+    switch (index) {
+    case CHANNEL_SQUARE_1: {
+        int period = (registers[REG_NR10] >> 4) & 0x7;
+        int shift = registers[REG_NR10] & 0x7;
+        sweep_shadow = registers[REG_NR13] | ((registers[REG_NR14] & 0x7) << 8);
+        sweep_timer = period ? period : 8;
+        sweep_enabled = period || shift;
+        if (shift) {
+            calculate_sweep();
+        }
+        break;
+    }
+    case CHANNEL_WAVE:
+        channel.position = 0;
+        break;
+    case CHANNEL_NOISE:
+        channel.lfsr = 0x7FFF;
+        break;
+    }
+}
+
+void APU::set_output(int index, uint64_t time) {
+    Channel& channel = channels[index];
+    int digital = get_digital(index);
+    uint8_t panning = registers[REG_NR51];
+    uint8_t volume = registers[REG_NR50];
+
+    int left = ((panning >> (index + 4)) & 1) ? digital * (((volume >> 4) & 0x7) + 1) : 0;
+    int right = ((panning >> index) & 1) ? digital * ((volume & 0x7) + 1) : 0;
+
+    uint32_t frame_time = time - frame_start_time;
+    if (left != channel.left) {
+        left_buffer.add_delta(frame_time, (left - channel.left) * AMPLITUDE_SCALE);
+        channel.left = left;
+    }
+    if (right != channel.right) {
+        right_buffer.add_delta(frame_time, (right - channel.right) * AMPLITUDE_SCALE);
+        channel.right = right;
+    }
+}
+
+void APU::update_outputs(uint64_t time) {
+    for (int index = 0; index != NBR_CHANNELS; ++index) {
+        set_output(index, time);
+    }
+}
+
+void APU::power_off() {
+    for (int reg = 0; reg != REG_NR52; ++reg) {
+        registers[reg] = 0;
+    }
+
+    // What is in the output buffers stays, so that it can be stepped back
+    // to silence.
+    for (Channel& channel : channels) {
+        Channel off{};
+        off.left = channel.left;
+        off.right = channel.right;
+        channel = off;
+    }
+}
+
+int APU::get_digital(int index) const {
+    const Channel& channel = channels[index];
+    if (!channel.enabled || !channel.dac_enabled) {
+        return 0;
+    }
+
+    switch (index) {
+    case CHANNEL_SQUARE_1:
+    case CHANNEL_SQUARE_2: {
+        int duty = registers[index * CHANNEL_REGISTERS + REG_OFFSET_LENGTH] >> 6;
+        return ((DUTY_PATTERNS[duty] >> channel.position) & 1) ? channel.volume : 0;
+    }
+    case CHANNEL_WAVE: {
+        uint8_t byte = registers[REG_WAVE_RAM + channel.position / 2];
+        int sample = (channel.position & 1) ? (byte & 0xF) : (byte >> 4);
+        int level = (registers[REG_NR32] >> 5) & 0x3;
+        return level ? sample >> (level - 1) : 0;
+    }
+    default:
+        return (channel.lfsr & 1) ? 0 : channel.volume;
+    }
+}
+
+int APU::get_period(int index) const {
+    if (index == CHANNEL_NOISE) {
+        uint8_t polynomial = registers[REG_NR43];
+        return NOISE_DIVISORS[polynomial & 0x7] << (polynomial >> 4);
+    }
+
+    int frequency = registers[index * CHANNEL_REGISTERS + REG_OFFSET_FREQUENCY_LOW] |
+        ((registers[index * CHANNEL_REGISTERS + REG_OFFSET_FREQUENCY_HIGH] & 0x7) << 8);
+    return (2048 - frequency) * (index == CHANNEL_WAVE ? 2 : 4);
+}
+
+uint64_t APU::get_time() const {
+    return scheduler.get_time() * 4;
+}
+
+
+}
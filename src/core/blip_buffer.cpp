@@ -0,0 +1,92 @@
+#include "core/blip_buffer.h"
+
+#include "audio/dsp.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace geemuboi::core {
+
+
+BlipBuffer::BlipBuffer(int clock_rate, int sample_rate)
+    : factor{(static_cast<uint64_t>(sample_rate) << FRAC_BITS) / clock_rate},
+    offset{},
+    integrator{},
+    buffer(BUFFER_SAMPLES + KERNEL_WIDTH),
+    kernel{} {
+
+    const double pi = std::acos(-1.0);
+    const double cutoff = 0.9;
+
+    for (int phase = 0; phase != PHASES; ++phase) {
+        double taps[KERNEL_WIDTH];
+        double sum = 0;
+        for (int i = 0; i != KERNEL_WIDTH; ++i) {
+            double x = i - (KERNEL_WIDTH / 2 - 1) - static_cast<double>(phase) / PHASES;
+            double sinc = x == 0 ? 1 : std::sin(pi * cutoff * x) / (pi * cutoff * x);
+            double window = 0.42 + 0.5 * std::cos(2 * pi * x / KERNEL_WIDTH) +
+                0.08 * std::cos(4 * pi * x / KERNEL_WIDTH);
+            taps[i] = sinc * window;
+            sum += taps[i];
+        }
+
+        // Each impulse sums up to exactly one, so steps end at their delta.
+        int total = 0;
+        for (int i = 0; i != KERNEL_WIDTH; ++i) {
+            kernel[phase][i] = std::lround(taps[i] / sum * (1 << KERNEL_BITS));
+            total += kernel[phase][i];
+        }
+        kernel[phase][KERNEL_WIDTH / 2 - 1] += (1 << KERNEL_BITS) - total;
+    }
+}
+
+void BlipBuffer::add_delta(uint32_t time, int delta) {
+    uint64_t position = offset + time * factor;
+    std::size_t index = position >> FRAC_BITS;
+    int phase = (position >> (FRAC_BITS - PHASE_BITS)) & (PHASES - 1);
+
+    if (index + KERNEL_WIDTH > buffer.size()) {
+        return;
+    }
+
+    geemuboi::audio::dsp::add_impulse(&buffer[index], kernel[phase], KERNEL_WIDTH, delta);
+}
+
+void BlipBuffer::end_frame(uint32_t time) {
+    offset += time * factor;
+}
+
+int BlipBuffer::get_samples_available() const {
+    return std::min<uint64_t>(offset >> FRAC_BITS, BUFFER_SAMPLES);
+}
+
+int BlipBuffer::read_samples(int16_t* out, int count, int stride) {
+    count = std::min(count, get_samples_available());
+
+    for (int i = 0; i != count; ++i) {
+        int32_t sample = integrator >> KERNEL_BITS;
+        out[i * stride] = std::clamp(sample, -0x8000, 0x7FFF);
+        integrator += buffer[i];
+        integrator -= sample * (1 << (KERNEL_BITS - BASS_SHIFT));
+    }
+
+    std::copy(buffer.begin() + count, buffer.end(), buffer.begin());
+    std::fill(buffer.end() - count, buffer.end(), 0);
+    offset -= static_cast<uint64_t>(count) << FRAC_BITS;
+    return count;
+}
+
+void BlipBuffer::save_state(StateWriter& writer) const {
+    writer.write(offset);
+    writer.write(integrator);
+    writer.write_bytes(buffer.data(), buffer.size() * sizeof(int32_t));
+}
+
+void BlipBuffer::load_state(StateReader& reader) {
+    reader.read(offset);
+    reader.read(integrator);
+    reader.read_bytes(buffer.data(), buffer.size() * sizeof(int32_t));
+}
+
+
+}
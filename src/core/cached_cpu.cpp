@@ -0,0 +1,580 @@
+#include "cached_cpu.h"
+
+#include "opcodes.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <limits>
+
+namespace geemuboi::core {
+
+// CPU only keeps a reference to its MMU, so it can be handed the tracker
+// before the tracker itself has been constructed.
+CachedCpu::CachedCpu(IMmu& mmu_in, Registers& regs_in, const Scheduler* scheduler_in,
+                     Interrupts* interrupts_in)
+    : CPU(write_tracker, regs_in, scheduler_in, interrupts_in),
+    write_tracker(mmu_in, *this),
+    blocks{},
+    page_blocks{},
+    executing_block{},
+    retired_block{},
+    previous_block{},
+    link_epoch{} {}
+
+
+int CachedCpu::execute() {
+    return execute(std::numeric_limits<int>::max());
+}
+
+int CachedCpu::execute(int max_cycles) {
+    // The instruction after ei has to run on its own, interrupts may be
+    // dispatched right after it.
+    if (is_uncached(regs.pc) || halted || ime_pending) {
+        return CPU::execute(max_cycles);
+    }
+
+    if (int interrupt_cycles = handle_interrupts(max_cycles)) {
+        cycles += interrupt_cycles;
+        return interrupt_cycles;
+    }
+
+    retired_block.reset();
+    Block* block = get_block(regs.pc);
+
+    // A block that might not be done in time runs one instruction at a time
+    if (static_cast<int>(block->ops.size()) * MAX_INSTRUCTION_CYCLES > max_cycles) {
+        previous_block = nullptr;
+        return CPU::execute(max_cycles);
+    }
+
+    executing_block = block;
+
+    // Loops fall back to running their ops one by one if they can't be
+    // done in bulk.
+    int block_cycles = block->loop != LOOP_NONE ? execute_loop(*block, max_cycles) : 0;
+    if (!block_cycles) {
+        for (const Op& op : executing_block->ops) {
+            block_cycles += execute_op(op);
+
+            // The block wrote to its own code, the rest of it is stale.
+            if (retired_block) {
+                break;
+            }
+        }
+    }
+
+    executing_block = nullptr;
+    previous_block = retired_block ? nullptr : block;
+    cycles += block_cycles;
+    return block_cycles;
+}
+
+
+void CachedCpu::load_state(StateReader& reader) {
+    CPU::load_state(reader);
+    remove_all_blocks();
+}
+
+
+CachedCpu::Block* CachedCpu::get_block(uint16_t pc) {
+    uint32_t key = (static_cast<uint32_t>(mmu.get_bank(pc)) << 16) + pc;
+
+    // Blocks are chained to their successors, which saves the hash lookup
+    // in loops and straight-line code.
+    if (previous_block && previous_block->link_epoch == link_epoch) {
+        for (Block* link : previous_block->links) {
+            if (link && link->key == key) {
+                return link;
+            }
+        }
+    }
+
+    Block* block = lookup_block(key, pc);
+    link_block(block);
+    return block;
+}
+
+
+CachedCpu::Block* CachedCpu::lookup_block(uint32_t key, uint16_t pc) {
+    auto it = blocks.find(key);
+    if (it != blocks.end()) {
+        return it->second.get();
+    }
+
+    std::unique_ptr<Block> block = decode_block(key, pc);
+    for (int page = block->start_pc >> PAGE_SHIFT;
+         page <= (block->end_pc - 1) >> PAGE_SHIFT;
+         ++page) {
+        page_blocks[page].push_back(key);
+    }
+
+    Block* decoded = block.get();
+    blocks.emplace(key, std::move(block));
+    return decoded;
+}
+
+
+void CachedCpu::link_block(Block* block) {
+    if (!previous_block) {
+        return;
+    }
+
+    if (previous_block->link_epoch != link_epoch) {
+        previous_block->links[0] = nullptr;
+        previous_block->links[1] = nullptr;
+        previous_block->link_epoch = link_epoch;
+    }
+
+    previous_block->links[previous_block->next_link] = block;
+    previous_block->next_link ^= 1;
+}
+
+
+std::unique_ptr<CachedCpu::Block> CachedCpu::decode_block(uint32_t key, uint16_t pc) {
+    auto block = std::make_unique<Block>();
+    block->key = key;
+    block->start_pc = pc;
+    block->link_epoch = link_epoch;
+
+    int addr = pc;
+    for (int i = 0; i != MAX_BLOCK_OPS; ++i) {
+        Op op{};
+        op.opcode = mmu.read_byte(addr);
+
+        int length = get_opcode_length(op.opcode);
+        if (op.opcode == PREFIX_CB) {
+            op.opcode = 0x100 + mmu.read_byte(addr + 1);
+            op.operand_pc = addr + 2;
+        } else {
+            op.operand_pc = addr + 1;
+            if (length == 2) {
+                op.operand = mmu.read_byte(addr + 1);
+            } else if (length == 3) {
+                op.operand = mmu.read_word(addr + 1);
+            }
+        }
+
+        addr += length;
+        op.next_pc = addr;
+        block->ops.push_back(op);
+
+        if (is_block_end(op.opcode) || addr > 0xFFFF || is_uncached(addr)) {
+            break;
+        }
+    }
+
+    block->end_pc = std::min(addr, 0x10000);
+    detect_loop(*block);
+    return block;
+}
+
+
+int CachedCpu::execute_op(const Op& op) {
+    regs.pc = op.next_pc;
+
+    switch (op.opcode) {
+    case 0x01: ld_r16_r16(regs.b, regs.c, op.operand); return 3;
+    case 0x06: regs.b = op.operand; return 2;
+    case 0x0E: regs.c = op.operand; return 2;
+    case 0x11: ld_r16_r16(regs.d, regs.e, op.operand); return 3;
+    case 0x16: regs.d = op.operand; return 2;
+    case 0x18: return jump_relative(op, true);
+    case 0x1E: regs.e = op.operand; return 2;
+    case 0x20: return jump_relative(op, !flag_z());
+    case 0x21: ld_r16_r16(regs.h, regs.l, op.operand); return 3;
+    case 0x26: regs.h = op.operand; return 2;
+    case 0x28: return jump_relative(op, flag_z());
+    case 0x2E: regs.l = op.operand; return 2;
+    case 0x30: return jump_relative(op, !flag_c());
+    case 0x31: regs.sp = op.operand; return 3;
+    case 0x36: ld_mr_r8((regs.h << 8) + regs.l, op.operand); return 3;
+    case 0x38: return jump_relative(op, flag_c());
+    case 0x3E: regs.a = op.operand; return 2;
+    case 0xC2: return jump(op, !flag_z());
+    case 0xC3: return jump(op, true);
+    case 0xC4: return call(op, !flag_z());
+    case 0xC6: add_r8_r8(regs.a, op.operand); return 2;
+    case 0xCA: return jump(op, flag_z());
+    case 0xCC: return call(op, flag_z());
+    case 0xCD: return call(op, true);
+    case 0xCE: adc_r8_r8(regs.a, op.operand); return 2;
+    case 0xD2: return jump(op, !flag_c());
+    case 0xD4: return call(op, !flag_c());
+    case 0xD6: sub_r8(op.operand); return 2;
+    case 0xDA: return jump(op, flag_c());
+    case 0xDC: return call(op, flag_c());
+    case 0xDE: sbc_r8_r8(regs.a, op.operand); return 2;
+    case 0xE0: mmu.write_byte(0xFF00 + op.operand, regs.a); return 3;
+    case 0xE6: and_r8(op.operand); return 2;
+    case 0xEA: mmu.write_byte(op.operand, regs.a); return 4;
+    case 0xEE: xor_r8(op.operand); return 2;
+    case 0xF0: regs.a = mmu.read_byte(0xFF00 + op.operand); return 3;
+    case 0xF6: or_r8(op.operand); return 2;
+    case 0xFA: regs.a = mmu.read_byte(op.operand); return 4;
+    case 0xFE: cp_r8(op.operand); return 2;
+    default:
+        // Everything else is run by the regular handler, which fetches its
+        // own operands if it has any.
+        regs.pc = op.operand_pc;
+        return instructions[op.opcode]();
+    }
+}
+
+
+void CachedCpu::detect_loop(Block& block) {
+    const std::vector<Op>& ops = block.ops;
+    const Op& branch = ops.back();
+
+    bool is_loop = (branch.opcode == 0x20 || branch.opcode == 0x28) &&
+        static_cast<uint16_t>(branch.next_pc + static_cast<int8_t>(branch.operand)) == block.start_pc;
+    if (!is_loop || ops.size() < 2) {
+        return;
+    }
+
+    if (ops.size() == 3 && ops[0].opcode == 0xF0 && ops[1].opcode == 0xFE) {
+        block.loop = LOOP_POLL;
+        return;
+    }
+
+    uint8_t Registers::* counter = get_decremented_register(ops[ops.size() - 2].opcode);
+    if (branch.opcode != 0x20 || !counter) {
+        return;
+    }
+
+    bool is_fill_counter = counter != &Registers::a &&
+        counter != &Registers::h &&
+        counter != &Registers::l;
+    bool is_copy_counter = counter == &Registers::b || counter == &Registers::c;
+
+    if (ops.size() == 2) {
+        block.loop = LOOP_COUNTDOWN;
+    } else if (ops.size() == 3 && ops[0].opcode == 0x22 && is_fill_counter) {
+        block.loop = LOOP_FILL_INCREMENT;
+    } else if (ops.size() == 3 && ops[0].opcode == 0x32 && is_fill_counter) {
+        block.loop = LOOP_FILL_DECREMENT;
+    } else if (ops.size() == 5 && ops[0].opcode == 0x2A && ops[1].opcode == 0x12 &&
+               ops[2].opcode == 0x13 && is_copy_counter) {
+        block.loop = LOOP_COPY;
+    } else {
+        return;
+    }
+
+    block.loop_counter = counter;
+}
+
+
+int CachedCpu::execute_loop(const Block& block, int max_cycles) {
+    if (block.loop == LOOP_POLL) {
+        return poll(block, max_cycles);
+    }
+
+    int iteration_cycles = 0;
+    switch (block.loop) {
+    case LOOP_COUNTDOWN:
+        iteration_cycles = 4;
+        break;
+    case LOOP_COPY:
+        iteration_cycles = 10;
+        break;
+    case LOOP_FILL_INCREMENT:
+    case LOOP_FILL_DECREMENT:
+        iteration_cycles = 6;
+        break;
+    }
+
+    // The loop runs no further than max_cycles or the next event, the rest
+    // of it is left to the next call. A whole block always fits in
+    // max_cycles, so at least one iteration does.
+    uint8_t& counter = regs.*block.loop_counter;
+    int iterations = std::min(counter ? counter : 0x100, max_cycles / iteration_cycles);
+    if (scheduler) {
+        uint64_t time = scheduler->get_time();
+        uint64_t next_event_time = scheduler->get_next_event_time();
+        if (next_event_time <= time) {
+            return 0;
+        }
+
+        if (next_event_time != Scheduler::NEVER) {
+            uint64_t until_event = (next_event_time - time + iteration_cycles - 1) / iteration_cycles;
+            iterations = static_cast<int>(std::min<uint64_t>(iterations, until_event));
+        }
+    }
+    int remaining = (counter ? counter : 0x100) - iterations;
+    int hl = (regs.h << 8) + regs.l;
+
+    switch (block.loop) {
+    case LOOP_COPY: {
+        int de = (regs.d << 8) + regs.e;
+        if (!copy_memory(block, hl, de, iterations)) {
+            return 0;
+        }
+        regs.a = mmu.read_byte(hl + iterations - 1);
+        hl += iterations;
+        de += iterations;
+        regs.d = (de >> 8) & 0xFF;
+        regs.e = de & 0xFF;
+        break;
+    }
+    case LOOP_FILL_INCREMENT:
+        if (!fill_memory(block, hl, iterations)) {
+            return 0;
+        }
+        hl += iterations;
+        break;
+    case LOOP_FILL_DECREMENT:
+        if (!fill_memory(block, hl - iterations + 1, iterations)) {
+            return 0;
+        }
+        hl -= iterations;
+        break;
+    }
+
+    regs.h = (hl >> 8) & 0xFF;
+    regs.l = hl & 0xFF;
+
+    // Stopped early, the last branch was taken back to the start
+    if (remaining) {
+        counter = remaining;
+        set_lazy_flags(FLAG_OP_DEC, static_cast<uint8_t>(remaining + 1), 0, flag_c(), remaining);
+        regs.pc = block.start_pc;
+        return iterations * iteration_cycles;
+    }
+
+    // Only the last dec is visible, it took the counter from 1 to 0 and
+    // the branch fell through.
+    counter = 0;
+    set_lazy_flags(FLAG_OP_DEC, 1, 0, flag_c(), 0);
+    regs.pc = block.ops.back().next_pc;
+    return iterations * iteration_cycles - 1;
+}
+
+
+int CachedCpu::poll(const Block& block, int max_cycles) {
+    uint16_t addr = 0xFF00 + block.ops[0].operand;
+    const Op& branch = block.ops[2];
+
+    regs.a = mmu.read_byte(addr);
+    cp_r8(block.ops[1].operand);
+    regs.pc = branch.next_pc;
+    bool taken = (branch.opcode == 0x28) == flag_z();
+    int iteration_cycles = 3 + 2 + jump_relative(branch, taken);
+
+    if (!taken || !scheduler || !is_event_driven(addr)) {
+        return iteration_cycles;
+    }
+
+    // Every iteration starting before the next event reads the same value
+    // and loops again, so they can all be accounted for at once.
+    uint64_t time = scheduler->get_time();
+    uint64_t next_event_time = scheduler->get_next_event_time();
+    if (next_event_time == Scheduler::NEVER || next_event_time <= time) {
+        return iteration_cycles;
+    }
+
+    uint64_t iterations = (next_event_time - time + iteration_cycles - 1) / iteration_cycles;
+    iterations = std::min<uint64_t>(iterations, max_cycles / iteration_cycles);
+    return static_cast<int>(iterations * iteration_cycles);
+}
+
+
+bool CachedCpu::copy_memory(const Block& block, int src, int dst, int length) {
+    bool overlaps = src < dst + length && dst < src + length;
+    if (overlaps || !is_mapped(src, length, false) || !is_mapped(dst, length, true)) {
+        return false;
+    }
+
+    // Copying over the loop itself would change what it does.
+    if (overlaps_block(block, dst, length)) {
+        return false;
+    }
+
+    invalidate_range(dst, length);
+
+    while (length) {
+        int chunk = std::min({length, 0x100 - (src & 0xFF), 0x100 - (dst & 0xFF)});
+        const uint8_t* from = mmu.get_read_page(src) + (src & 0xFF);
+        uint8_t* to = mmu.get_write_page(dst) + (dst & 0xFF);
+
+        // Echo RAM can make distinct addresses share memory, in which case
+        // the bytes are copied one at a time like the loop would.
+        if (std::less<const uint8_t*>()(from, to + chunk) && std::less<const uint8_t*>()(to, from + chunk)) {
+            for (int i = 0; i != chunk; ++i) {
+                to[i] = from[i];
+            }
+        } else {
+            std::memcpy(to, from, chunk);
+        }
+
+        src += chunk;
+        dst += chunk;
+        length -= chunk;
+    }
+
+    return true;
+}
+
+
+bool CachedCpu::fill_memory(const Block& block, int dst, int length) {
+    if (!is_mapped(dst, length, true)) {
+        return false;
+    }
+
+    if (overlaps_block(block, dst, length)) {
+        return false;
+    }
+
+    invalidate_range(dst, length);
+
+    while (length) {
+        int chunk = std::min(length, 0x100 - (dst & 0xFF));
+        std::memset(mmu.get_write_page(dst) + (dst & 0xFF), regs.a, chunk);
+        dst += chunk;
+        length -= chunk;
+    }
+
+    return true;
+}
+
+
+// Echo RAM included, only ever too cautious for blocks at its end
+bool CachedCpu::overlaps_block(const Block& block, int addr, int length) {
+    int mirror = get_echo_mirror(block.start_pc);
+    int block_length = block.end_pc - block.start_pc;
+    return (addr < block.end_pc && block.start_pc < addr + length) ||
+           (addr < mirror + block_length && mirror < addr + length);
+}
+
+
+bool CachedCpu::is_mapped(int addr, int length, bool write) {
+    if (addr < 0 || addr + length > 0x10000) {
+        return false;
+    }
+
+    for (int page = addr >> PAGE_SHIFT; page <= (addr + length - 1) >> PAGE_SHIFT; ++page) {
+        uint16_t page_addr = page << PAGE_SHIFT;
+        if (write ? !mmu.get_write_page(page_addr) : !mmu.get_read_page(page_addr)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+void CachedCpu::invalidate_range(int addr, int length) {
+    for (int i = 0; i != length; ++i) {
+        invalidate(addr + i);
+    }
+}
+
+
+int CachedCpu::jump_relative(const Op& op, bool taken) {
+    if (taken) {
+        regs.pc = op.next_pc + static_cast<int8_t>(op.operand);
+        return 3;
+    }
+
+    return 2;
+}
+
+
+int CachedCpu::jump(const Op& op, bool taken) {
+    if (taken) {
+        regs.pc = op.operand;
+        return 4;
+    }
+
+    return 3;
+}
+
+
+int CachedCpu::call(const Op& op, bool taken) {
+    if (taken) {
+        mmu.write_word(regs.sp - 2, op.next_pc);
+        regs.sp -= 2;
+        regs.pc = op.operand;
+        return 6;
+    }
+
+    return 3;
+}
+
+
+void CachedCpu::invalidate(uint16_t addr) {
+    remove_blocks_at(addr);
+    uint16_t mirror = get_echo_mirror(addr);
+    if (mirror != addr) {
+        remove_blocks_at(mirror);
+    }
+}
+
+void CachedCpu::remove_blocks_at(uint16_t addr) {
+    std::vector<uint32_t>& keys = page_blocks[addr >> PAGE_SHIFT];
+
+    std::size_t i = 0;
+    while (i < keys.size()) {
+        const Block& block = *blocks.at(keys[i]);
+        if (addr >= block.start_pc && addr < block.end_pc) {
+            // Also erases the key from this page, the next one moves into i.
+            remove_block(keys[i]);
+        } else {
+            ++i;
+        }
+    }
+}
+
+
+void CachedCpu::remove_block(uint32_t key) {
+    auto it = blocks.find(key);
+    const Block& block = *it->second;
+
+    for (int page = block.start_pc >> PAGE_SHIFT;
+         page <= (block.end_pc - 1) >> PAGE_SHIFT;
+         ++page) {
+        std::vector<uint32_t>& keys = page_blocks[page];
+        auto key_it = std::find(keys.begin(), keys.end(), key);
+        *key_it = keys.back();
+        keys.pop_back();
+    }
+
+    // Links to the block may be anywhere, drop all of them at once.
+    ++link_epoch;
+    if (it->second.get() == previous_block) {
+        previous_block = nullptr;
+    }
+
+    if (it->second.get() == executing_block) {
+        retired_block = std::move(it->second);
+    }
+
+    blocks.erase(it);
+}
+
+
+void CachedCpu::remove_all_blocks() {
+    blocks.clear();
+    for (std::vector<uint32_t>& keys : page_blocks) {
+        keys.clear();
+    }
+
+    ++link_epoch;
+    previous_block = nullptr;
+}
+
+
+uint8_t CachedCpu::Registers::* CachedCpu::get_decremented_register(uint16_t opcode) {
+    switch (opcode) {
+    case 0x05: return &Registers::b;
+    case 0x0D: return &Registers::c;
+    case 0x15: return &Registers::d;
+    case 0x1D: return &Registers::e;
+    case 0x25: return &Registers::h;
+    case 0x2D: return &Registers::l;
+    case 0x3D: return &Registers::a;
+    default: return nullptr;
+    }
+}
+
+
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "cpu.h"
+#include "write_tracker.h"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace geemuboi::core {
+
+
+// Interpreter that pre-decodes guest code into basic blocks. Every block is
+// cached by PC and bank and runs as a whole per call to execute(), so the
+// opcode and immediate fetches through the MMU only happen once per block.
+//
+// With a scheduler, loops polling a register that only changes on scheduled
+// events skip ahead to the next event. Interrupts are dispatched in between
+// blocks.
+class CachedCpu : public CPU {
+public:
+    CachedCpu(IMmu& mmu_in, Registers& regs_in, const Scheduler* scheduler_in = nullptr,
+              Interrupts* interrupts_in = nullptr);
+
+    int execute();
+    int execute(int max_cycles);
+    // Memory may have changed behind the tracker's back, every block is dropped
+    void load_state(StateReader& reader);
+private:
+    friend class WriteTracker<CachedCpu>;
+
+    struct Op {
+        uint16_t opcode;
+        uint16_t operand;
+        uint16_t operand_pc;
+        uint16_t next_pc;
+    };
+
+    // Blocks that are a whole loop of a common idiom, run in one go.
+    enum Loops {
+        LOOP_NONE,
+        // dec r / jr nz
+        LOOP_COUNTDOWN,
+        // ld a,(hl+) / ld (de),a / inc de / dec r / jr nz
+        LOOP_COPY,
+        // ld (hl+),a / dec r / jr nz
+        LOOP_FILL_INCREMENT,
+        // ld (hl-),a / dec r / jr nz
+        LOOP_FILL_DECREMENT,
+        // ldh a,(n) / cp n / jr cc
+        LOOP_POLL
+    };
+
+    struct Block {
+        uint32_t key;
+        uint16_t start_pc;
+        int end_pc;
+        std::vector<Op> ops;
+
+        int loop;
+        uint8_t Registers::* loop_counter;
+
+        // Most recent successors, valid as long as link_epoch is current.
+        Block* links[2];
+        int next_link;
+        unsigned link_epoch;
+    };
+
+    static constexpr int MAX_BLOCK_OPS = 32;
+    static constexpr int PAGE_SHIFT = 8;
+    static constexpr int NBR_PAGES = 0x100;
+
+    Block* get_block(uint16_t pc);
+    Block* lookup_block(uint32_t key, uint16_t pc);
+    void link_block(Block* block);
+    std::unique_ptr<Block> decode_block(uint32_t key, uint16_t pc);
+    int execute_op(const Op& op);
+    void detect_loop(Block& block);
+    int execute_loop(const Block& block, int max_cycles);
+    int poll(const Block& block, int max_cycles);
+    bool copy_memory(const Block& block, int src, int dst, int length);
+    bool fill_memory(const Block& block, int dst, int length);
+    bool overlaps_block(const Block& block, int addr, int length);
+    bool is_mapped(int addr, int length, bool write);
+    void invalidate_range(int addr, int length);
+    int jump_relative(const Op& op, bool taken);
+    int jump(const Op& op, bool taken);
+    int call(const Op& op, bool taken);
+    void invalidate(uint16_t addr);
+    void remove_blocks_at(uint16_t addr);
+    void remove_block(uint32_t key);
+    void remove_all_blocks();
+
+    static uint8_t Registers::* get_decremented_register(uint16_t opcode);
+
+    WriteTracker<CachedCpu> write_tracker;
+
+    std::unordered_map<uint32_t, std::unique_ptr<Block>> blocks;
+    std::array<std::vector<uint32_t>, NBR_PAGES> page_blocks;
+
+    const Block* executing_block;
+    std::unique_ptr<Block> retired_block;
+
+    Block* previous_block;
+    unsigned link_epoch;
+};
+
+
+}
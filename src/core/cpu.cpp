@@ -1,9 +1,13 @@
 #include "cpu.h"
 
+#include <algorithm>
+#include <limits>
+
 namespace geemuboi::core {
 
 
-CPU::CPU(IMmu& mmu_in, Registers& regs_in) : mmu(mmu_in), 
+CPU::CPU(IMmu& mmu_in, Registers& regs_in, const Scheduler* scheduler_in, Interrupts* interrupts_in)
+    : mmu(mmu_in),
     regs(regs_in),
     instructions{
         std::bind(&CPU::nop, this),
@@ -519,13 +523,33 @@ CPU::CPU(IMmu& mmu_in, Registers& regs_in) : mmu(mmu_in),
         std::bind(&CPU::set_7_mhl, this),
         std::bind(&CPU::set_7_a, this)
     },
-    cycles{} {}
+    cycles{},
+    lazy_flags{},
+    scheduler{scheduler_in},
+    interrupts{interrupts_in},
+    ime{},
+    ime_pending{},
+    halted{} {}
 
 
 int CPU::execute() {
-    unsigned instruction_cycles = instructions[mmu.read_byte(regs.pc++)]();
-    cycles += instruction_cycles;
+    return execute(std::numeric_limits<int>::max());
+}
 
+int CPU::execute(int max_cycles) {
+    unsigned instruction_cycles = handle_interrupts(max_cycles);
+    if (!instruction_cycles) {
+        bool enable_interrupts = ime_pending;
+        instruction_cycles = instructions[mmu.read_byte(regs.pc++)]();
+
+        // Unless the instruction after ei was di
+        if (enable_interrupts && ime_pending) {
+            ime = true;
+            ime_pending = false;
+        }
+    }
+
+    cycles += instruction_cycles;
     return instruction_cycles;
 }
 
@@ -534,6 +558,77 @@ unsigned CPU::get_cycles_executed() {
     return cycles;
 }
 
+void CPU::sync_registers() {
+    if (lazy_flags.op != FLAG_OP_NONE) {
+        materialize_flags();
+    }
+}
+
+void CPU::save_state(StateWriter& writer) const {
+    writer.write(regs);
+    writer.write(cycles);
+    writer.write(lazy_flags);
+    writer.write(ime);
+    writer.write(ime_pending);
+    writer.write(halted);
+}
+
+void CPU::load_state(StateReader& reader) {
+    reader.read(regs);
+    reader.read(cycles);
+    reader.read(lazy_flags);
+    reader.read(ime);
+    reader.read(ime_pending);
+    reader.read(halted);
+}
+
+
+// Returns the cycles spent halting or dispatching an interrupt in place of
+// the next instruction, or 0 if the next instruction should run.
+int CPU::handle_interrupts(int max_cycles) {
+    uint8_t pending = interrupts ? interrupts->get_pending() : 0;
+
+    if (halted) {
+        if (!pending) {
+            return get_halt_cycles(max_cycles);
+        }
+
+        halted = false;
+    }
+
+    if (!ime || !pending) {
+        return 0;
+    }
+
+    int interrupt = 0;
+    while (!(pending & (1 << interrupt))) {
+        ++interrupt;
+    }
+
+    interrupts->acknowledge(1 << interrupt);
+    ime = false;
+    mmu.write_word(regs.sp - 2, regs.pc);
+    regs.sp -= 2;
+    regs.pc = 0x40 + interrupt * 8;
+    return 5;
+}
+
+
+int CPU::get_halt_cycles(int max_cycles) const {
+    // Only scheduled events raise interrupts, so nothing can wake the CPU
+    // before the next one. Anything else that raises one bounds the run by
+    // max_cycles.
+    if (scheduler) {
+        uint64_t time = scheduler->get_time();
+        uint64_t next_event_time = scheduler->get_next_event_time();
+        if (next_event_time != Scheduler::NEVER && next_event_time > time) {
+            return static_cast<int>(std::min<uint64_t>(next_event_time - time, std::max(max_cycles, 1)));
+        }
+    }
+
+    return 1;
+}
+
 
 // 0x00
 int CPU::nop() {
@@ -573,12 +668,13 @@ int CPU::ld_b_d8() {
 }
 
 int CPU::rlca() {
-    regs.f = 0;
+    uint8_t& f = flags();
+    f = 0;
     if (regs.a & 0x80) {
-        regs.f |= 0x10;
+        f |= 0x10;
     }
 
-    regs.a = (regs.a << 1) + (regs.f >> 4);
+    regs.a = (regs.a << 1) + (f >> 4);
     return 1;
 }
 
@@ -621,12 +717,13 @@ int CPU::ld_c_d8() {
 }
 
 int CPU::rrca() {
-    regs.f = 0;
+    uint8_t& f = flags();
+    f = 0;
     if (regs.a & 0x1) {
-        regs.f |= 0x10;
+        f |= 0x10;
     }
 
-    regs.a = (regs.a >> 1) + (regs.f << 3);
+    regs.a = (regs.a >> 1) + (f << 3);
     return 1;
 }
 
@@ -670,10 +767,11 @@ int CPU::ld_d_d8() {
 }
 
 int CPU::rla() {
-    uint8_t carry = (regs.f & 0x10) >> 4;
-    regs.f = 0;
+    uint8_t& f = flags();
+    uint8_t carry = flag_c();
+    f = 0;
     if (regs.a & 0x80) {
-        regs.f |= 0x10;
+        f |= 0x10;
     }
 
     regs.a = (regs.a << 1) + carry;
@@ -719,10 +817,11 @@ int CPU::ld_e_d8() {
 }
 
 int CPU::rra() {
-    uint8_t carry = (regs.f & 0x10) << 3;
-    regs.f = 0;
+    uint8_t& f = flags();
+    uint8_t carry = flag_c() << 7;
+    f = 0;
     if (regs.a & 0x1) {
-        regs.f |= 0x10;
+        f |= 0x10;
     }
 
     regs.a = (regs.a >> 1) + carry;
@@ -731,7 +830,7 @@ int CPU::rra() {
 
 // 0x2
 int CPU::jr_nz_r8() {
-    if (!(regs.f & ICpu::Z_FLAG)) {
+    if (!flag_z()) {
         int offset = static_cast<int8_t>(mmu.read_byte(regs.pc)) + 2;
         regs.pc += offset - 1;
         return 3;
@@ -776,24 +875,25 @@ int CPU::ld_h_d8() {
 
 int CPU::daa() {
     // CHECK
+    uint8_t& f = flags();
     uint8_t a_tmp = regs.a;
 
-    if ((regs.f & 0x20) || ((regs.a & 0xF) > 9)) {
+    if ((f & 0x20) || ((regs.a & 0xF) > 9)) {
         regs.a += 6; 
     }
 
-    regs.f &= 0xEF;
+    f &= 0xEF;
     
-    if ((regs.f & 0x20) || (a_tmp > 0x99)) { 
+    if ((f & 0x20) || (a_tmp > 0x99)) { 
         regs.a += 0x60; 
-        regs.f |= 0x10; 
+        f |= 0x10; 
     } 
 
     return 1;
 }
 
 int CPU::jr_z_r8() {
-    if (regs.f & 0x80) {
+    if (flag_z()) {
         int offset = static_cast<int8_t>(mmu.read_byte(regs.pc)) + 2;
         regs.pc += offset - 1;
         return 3;
@@ -835,14 +935,15 @@ int CPU::ld_l_d8() {
 }
 
 int CPU::cpl() {
+    uint8_t& f = flags();
     regs.a ^= 0xFF;
-    regs.f |= 0x60;
+    f |= 0x60;
     return 1;
 }
 
 // 0x3
 int CPU::jr_nc_r8() {
-    if (!(regs.f & 0x10)) {
+    if (!flag_c()) {
         int offset = static_cast<int8_t>(mmu.read_byte(regs.pc)) + 2;
         regs.pc += offset - 1;
         return 3;
@@ -899,14 +1000,15 @@ int CPU::ld_mhl_d8() {
 }
 
 int CPU::scf() {
-    regs.f &= 0x80;
-    regs.f |= 0x10;
+    uint8_t& f = flags();
+    f &= 0x80;
+    f |= 0x10;
     return 1;
 }
 
 int CPU::jr_c_r8() {
-    if (regs.f & 0x10) {
-        int8_t offset = static_cast<int8_t>(mmu.read_byte(regs.pc)) + 2;
+    if (flag_c()) {
+        int offset = static_cast<int8_t>(mmu.read_byte(regs.pc)) + 2;
         regs.pc += offset - 1;
         return 3;
     } else {
@@ -950,8 +1052,9 @@ int CPU::ld_a_d8() {
 }
 
 int CPU::ccf() {
-    regs.f &= 0x90;
-    regs.f ^= 0x10;
+    uint8_t& f = flags();
+    f &= 0x90;
+    f ^= 0x10;
     return 1;
 }
 
@@ -1242,7 +1345,7 @@ int CPU::ld_mhl_l() {
 }
 
 int CPU::halt() {
-    throw NotImplementedInstructionException();
+    halted = true;
     return 1;
 }
 
@@ -1626,7 +1729,7 @@ int CPU::cp_a() {
 
 // 0xC
 int CPU::ret_nz() {
-    if (!(regs.f & 0x80)) {
+    if (!flag_z()) {
         regs.pc = mmu.read_word(regs.sp);
         regs.sp += 2;
         return 5;
@@ -1641,7 +1744,7 @@ int CPU::pop_bc() {
 }
 
 int CPU::jp_nz_a16() {
-    if (!(regs.f & 0x80)) {
+    if (!flag_z()) {
         regs.pc = mmu.read_word(regs.pc);
         return 4;
     } else {
@@ -1656,7 +1759,7 @@ int CPU::jp_a16() {
 }
 
 int CPU::call_nz_a16() {
-    if (!(regs.f & 0x80)) {
+    if (!flag_z()) {
         mmu.write_word(regs.sp - 2, regs.pc + 2);
         regs.sp -= 2;
         regs.pc = mmu.read_word(regs.pc);
@@ -1683,7 +1786,7 @@ int CPU::rst_00h() {
 }
 
 int CPU::ret_z() {
-    if (regs.f & 0x80) {
+    if (flag_z()) {
         regs.pc = mmu.read_word(regs.sp);
         regs.sp += 2;
         return 5;
@@ -1699,7 +1802,7 @@ int CPU::ret() {
 }
 
 int CPU::jp_z_a16() {
-    if (regs.f & 0x80) {
+    if (flag_z()) {
         regs.pc = mmu.read_word(regs.pc);
         return 4;
     } else {
@@ -1713,7 +1816,7 @@ int CPU::prefix_cb() {
 }
 
 int CPU::call_z_a16() {
-    if (regs.f & 0x80) {
+    if (flag_z()) {
         mmu.write_word(regs.sp - 2, regs.pc + 2);
         regs.sp -= 2;
         regs.pc = mmu.read_word(regs.pc);
@@ -1743,7 +1846,7 @@ int CPU::rst_08h() {
 
 // 0xD
 int CPU::ret_nc() {
-    if (!(regs.f & 0x10)) {
+    if (!flag_c()) {
         regs.pc = mmu.read_word(regs.sp);
         regs.sp += 2;
         return 5;
@@ -1758,7 +1861,7 @@ int CPU::pop_de() {
 }
 
 int CPU::jp_nc_a16() {
-    if (!(regs.f & 0x10)) {
+    if (!flag_c()) {
         regs.pc = mmu.read_word(regs.pc);
         return 4;
     } else {
@@ -1768,7 +1871,7 @@ int CPU::jp_nc_a16() {
 }
 //
 int CPU::call_nc_a16() {
-    if (!(regs.f & 0x10)) {
+    if (!flag_c()) {
         mmu.write_word(regs.sp - 2, regs.pc + 2);
         regs.sp -= 2;
         regs.pc = mmu.read_word(regs.pc);
@@ -1795,7 +1898,7 @@ int CPU::rst_10h() {
 }
 
 int CPU::ret_c() {
-    if (regs.f & 0x10) {
+    if (flag_c()) {
         regs.pc = mmu.read_word(regs.sp);
         regs.sp += 2;
         return 5;
@@ -1807,13 +1910,12 @@ int CPU::ret_c() {
 int CPU::reti() {
     regs.pc = mmu.read_word(regs.sp);
     regs.sp += 2;
-    // TODO enable interrupts
-    throw NotImplementedInstructionException();
+    ime = true;
     return 4;
 }
 
 int CPU::jp_c_a16() {
-    if (regs.f & 0x10) {
+    if (flag_c()) {
         regs.pc = mmu.read_word(regs.pc);
         return 4;
     } else {
@@ -1823,7 +1925,7 @@ int CPU::jp_c_a16() {
 }
 //
 int CPU::call_c_a16() {
-    if (regs.f & 0x10) {
+    if (flag_c()) {
         mmu.write_word(regs.sp - 2, regs.pc + 2);
         regs.sp -= 2;
         regs.pc = mmu.read_word(regs.pc);
@@ -1878,15 +1980,16 @@ int CPU::rst_20h() {
 }
 
 int CPU::add_sp_r8() {
-    regs.f = 0;
+    uint8_t& f = flags();
+    f = 0;
     int8_t val = static_cast<int8_t>(mmu.read_byte(regs.pc++));
 
     if ((regs.sp & 0xFF) + val > 0xFF) {
-        regs.f |= ICpu::C_FLAG; 
+        f |= ICpu::C_FLAG; 
     }
 
     if ((regs.sp & 0xF) + (val & 0xF) > 0xF) {
-        regs.f |= ICpu::H_FLAG;
+        f |= ICpu::H_FLAG;
     }
 
     regs.sp += val;
@@ -1925,7 +2028,7 @@ int CPU::ldh_a_ma8() {
 }
 
 int CPU::pop_af() {
-    pop_r16(regs.a, regs.f);
+    pop_r16(regs.a, flags());
     return 3;
 }
 
@@ -1936,13 +2039,13 @@ int CPU::ld_a_mc() {
 }
 
 int CPU::di() {
-    // TODO
-    throw NotImplementedInstructionException();
+    ime = false;
+    ime_pending = false;
     return 1;
 }
 //
 int CPU::push_af() {
-    push_r16(regs.a, regs.f);
+    push_r16(regs.a, flags());
     return 4;
 }
 
@@ -1957,15 +2060,16 @@ int CPU::rst_30h() {
 }
 
 int CPU::ldhl_sp_r8() {
-    regs.f = 0;
+    uint8_t& f = flags();
+    f = 0;
     int8_t val = static_cast<int8_t>(mmu.read_byte(regs.pc++));
 
     if ((regs.sp & 0xFF) + val > 0xFF) {
-        regs.f |= ICpu::C_FLAG;
+        f |= ICpu::C_FLAG;
     }
 
     if ((regs.sp & 0xF) + (val & 0xF) > 0xF) {
-        regs.f |= ICpu::H_FLAG;
+        f |= ICpu::H_FLAG;
     }
 
     regs.h = (regs.sp + val) >> 8;
@@ -1984,8 +2088,7 @@ int CPU::ld_a_ma16() {
 }
 
 int CPU::ei() {
-    // TODO
-    throw NotImplementedInstructionException();
+    ime_pending = true;
     return 1;
 }
 //
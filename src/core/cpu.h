@@ -2,6 +2,8 @@
 
 #include "core/icpu.h"
 #include "core/immu.h"
+#include "core/interrupts.h"
+#include "core/scheduler.h"
 
 #include <cstdint>
 #include <vector>
@@ -13,11 +15,51 @@ namespace geemuboi::core {
 class CPU : public ICpu {
 public:
     CPU(IMmu& mmu_in);
-    CPU(IMmu& mmu_in, Registers& regs_in);
+    // Without interrupts, no interrupts are ever dispatched. With a
+    // scheduler, halt skips ahead to its next event. Its time must be the
+    // time execute() is called at.
+    CPU(IMmu& mmu_in, Registers& regs_in, const Scheduler* scheduler_in = nullptr,
+        Interrupts* interrupts_in = nullptr);
 
     int execute();
+    int execute(int max_cycles);
     unsigned get_cycles_executed();
-private:
+    void sync_registers();
+    void save_state(StateWriter& writer) const;
+    void load_state(StateReader& reader);
+protected:
+    // Flags are evaluated lazily: ALU helpers only record their operands and
+    // result, F is materialized once something reads it as a whole, be it
+    // an instruction or sync_registers().
+    enum FlagOps {
+        FLAG_OP_NONE,
+        FLAG_OP_ADD,
+        FLAG_OP_SUB,
+        FLAG_OP_AND,
+        FLAG_OP_LOGIC,
+        FLAG_OP_INC,
+        FLAG_OP_DEC,
+        FLAG_OP_SHIFT,
+        FLAG_OP_BIT
+    };
+
+    struct LazyFlags {
+        int op;
+        uint8_t lhs;
+        uint8_t rhs;
+        uint8_t carry;
+        uint8_t result;
+    };
+
+    int handle_interrupts(int max_cycles);
+    int get_halt_cycles(int max_cycles) const;
+
+    uint8_t& flags();
+    bool flag_z() const;
+    bool flag_c() const;
+    void set_lazy_flags(int op, uint8_t lhs, uint8_t rhs, uint8_t carry, uint8_t result);
+    void materialize_flags();
+
     // Generalized CPU functionality
     void dec_r8(uint8_t& r);
     void inc_r8(uint8_t& r);
@@ -592,30 +634,116 @@ private:
     const std::vector<std::function<int()>> instructions;
    
     unsigned cycles;
+    LazyFlags lazy_flags;
+
+    const Scheduler* scheduler;
+    Interrupts* interrupts;
+    bool ime;
+    // Set by ei, interrupts are enabled after the next instruction
+    bool ime_pending;
+    bool halted;
 };
 
-inline void CPU::dec_r8(uint8_t& r) {
-    regs.f &= ICpu::C_FLAG;
-    regs.f |= ICpu::N_FLAG;
-
-    if (!(r & 0xF)) {
-        regs.f |= ICpu::H_FLAG;
+inline uint8_t& CPU::flags() {
+    if (lazy_flags.op != FLAG_OP_NONE) {
+        materialize_flags();
     }
 
-    if (!--r) {
-        regs.f |= ICpu::Z_FLAG;
+    return regs.f;
+}
+
+inline bool CPU::flag_z() const {
+    if (lazy_flags.op == FLAG_OP_NONE) {
+        return regs.f & ICpu::Z_FLAG;
     }
+
+    return !lazy_flags.result;
 }
 
-inline void CPU::inc_r8(uint8_t& r) {
-    regs.f &= ICpu::C_FLAG;
-    if ((r & 0xF) == 0xF) {
-        regs.f |= ICpu::H_FLAG;
+inline bool CPU::flag_c() const {
+    switch (lazy_flags.op) {
+    case FLAG_OP_NONE: return regs.f & ICpu::C_FLAG;
+    case FLAG_OP_ADD: return lazy_flags.lhs + lazy_flags.rhs + lazy_flags.carry >= 0x100;
+    case FLAG_OP_SUB: return lazy_flags.lhs < lazy_flags.rhs - lazy_flags.carry;
+    case FLAG_OP_AND: return false;
+    case FLAG_OP_LOGIC: return false;
+    default: return lazy_flags.carry;
     }
+}
+
+inline void CPU::set_lazy_flags(int op, uint8_t lhs, uint8_t rhs, uint8_t carry, uint8_t result) {
+    lazy_flags.op = op;
+    lazy_flags.lhs = lhs;
+    lazy_flags.rhs = rhs;
+    lazy_flags.carry = carry;
+    lazy_flags.result = result;
+}
+
+inline void CPU::materialize_flags() {
+    uint8_t f = lazy_flags.result ? 0 : ICpu::Z_FLAG;
+
+    switch (lazy_flags.op) {
+    case FLAG_OP_ADD:
+        if ((lazy_flags.lhs & 0xF) + (lazy_flags.rhs & 0xF) + lazy_flags.carry >= 0x10) {
+            f |= ICpu::H_FLAG;
+        }
+
+        if (lazy_flags.lhs + lazy_flags.rhs + lazy_flags.carry >= 0x100) {
+            f |= ICpu::C_FLAG;
+        }
+
+        break;
+    case FLAG_OP_SUB:
+        f |= ICpu::N_FLAG;
+        if ((lazy_flags.lhs & 0xF) < (lazy_flags.rhs & 0xF) - lazy_flags.carry) {
+            f |= ICpu::H_FLAG;
+        }
+
+        if (lazy_flags.lhs < lazy_flags.rhs - lazy_flags.carry) {
+            f |= ICpu::C_FLAG;
+        }
+
+        break;
+    case FLAG_OP_AND:
+        f |= ICpu::H_FLAG;
+        break;
+    case FLAG_OP_LOGIC:
+        break;
+    case FLAG_OP_INC:
+        if ((lazy_flags.lhs & 0xF) == 0xF) {
+            f |= ICpu::H_FLAG;
+        }
 
-    if (!++r) {
-        regs.f |= ICpu::Z_FLAG;
+        f |= lazy_flags.carry << 4;
+        break;
+    case FLAG_OP_DEC:
+        f |= ICpu::N_FLAG;
+        if (!(lazy_flags.lhs & 0xF)) {
+            f |= ICpu::H_FLAG;
+        }
+
+        f |= lazy_flags.carry << 4;
+        break;
+    case FLAG_OP_SHIFT:
+        f |= lazy_flags.carry << 4;
+        break;
+    case FLAG_OP_BIT:
+        f |= ICpu::H_FLAG | (lazy_flags.carry << 4);
+        break;
     }
+
+    regs.f = f;
+    lazy_flags.op = FLAG_OP_NONE;
+}
+
+inline void CPU::dec_r8(uint8_t& r) {
+    set_lazy_flags(FLAG_OP_DEC, r, 0, flag_c(), r - 1);
+    --r;
+}
+
+inline void CPU::inc_r8(uint8_t& r) {
+    set_lazy_flags(FLAG_OP_INC, r, 0, flag_c(), r + 1);
+    ++r;
 }
 
 inline void CPU::dec_r16(uint8_t& high, uint8_t& low) {
@@ -631,24 +759,25 @@ inline void CPU::inc_r16(uint8_t& high, uint8_t& low) {
 }
 
 inline void CPU::add_hl_r16(uint8_t high, uint8_t low) {
-    regs.f &= ICpu::Z_FLAG;
+    uint8_t& f = flags();
+    f &= ICpu::Z_FLAG;
     uint32_t sum = regs.l + low;
     if (sum >= 0x100) {
         ++high;
 
         if (!high) {
-            regs.f |= ICpu::C_FLAG | ICpu::H_FLAG;
+            f |= ICpu::C_FLAG | ICpu::H_FLAG;
         }
     }
 
     regs.l += low;
     if ((((regs.h & 0xF) + (high & 0xF)) & 0x10) == 0x10) {
-        regs.f |= ICpu::H_FLAG;
+        f |= ICpu::H_FLAG;
     }
 
     sum = regs.h + high;
     if (sum >= 0x100) {
-        regs.f |= ICpu::C_FLAG;
+        f |= ICpu::C_FLAG;
     }
 
     regs.h += high; 
@@ -668,85 +797,35 @@ inline void CPU::ld_r8_r8(uint8_t& r1, uint8_t r2) {
 }
 
 inline void CPU::add_r8_r8(uint8_t& r1, uint8_t r2) {
-    regs.f = 0;
-    if ((r1 & 0xF) + (r2 & 0xF) >= 0x10) {
-        regs.f |= ICpu::H_FLAG;
-    }
-
-    if (r1 + r2 >= 0x100) {
-        regs.f |= ICpu::C_FLAG;
-    }
-
-    if (!(r1 += r2)) {
-        regs.f |= ICpu::Z_FLAG;
-    }
+    set_lazy_flags(FLAG_OP_ADD, r1, r2, 0, r1 + r2);
+    r1 += r2;
 }
 
 inline void CPU::adc_r8_r8(uint8_t& r1, uint8_t r2) {
-    uint8_t carry = (regs.f & ICpu::C_FLAG) >> 4;
-    regs.f = 0;
-    if ((r1 & 0xF) + (r2 & 0xF) + carry >= 0x10) {
-        regs.f |= ICpu::H_FLAG;
-    }
-
-    if (r1 + r2 + carry >= 0x100) {
-        regs.f |= ICpu::C_FLAG;
-    }
-
-    if (!(r1 += r2 + carry)) {
-        regs.f |= ICpu::Z_FLAG;
-    }
+    uint8_t carry = flag_c();
+    set_lazy_flags(FLAG_OP_ADD, r1, r2, carry, r1 + r2 + carry);
+    r1 += r2 + carry;
 }
 
 inline void CPU::sub_r8(uint8_t r) {
-    regs.f = 0;
-    regs.f |= ICpu::N_FLAG;
-
-    if ((regs.a & 0xF) < (r & 0xF)) {
-        regs.f |= ICpu::H_FLAG;
-    }
-
-    if (regs.a < r) {
-        regs.f |= ICpu::C_FLAG;
-    }
-
-    if (!(regs.a -= r)) {
-        regs.f |= ICpu::Z_FLAG;
-    }
+    set_lazy_flags(FLAG_OP_SUB, regs.a, r, 0, regs.a - r);
+    regs.a -= r;
 }
 
 inline void CPU::sbc_r8_r8(uint8_t& r1, uint8_t r2) {
-    uint8_t carry = (regs.f & ICpu::C_FLAG) >> 4;
-    regs.f = 0;
-    regs.f |= ICpu::N_FLAG;
-
-    if ((r1 & 0xF) < (r2 & 0xF) - carry) {
-        regs.f |= ICpu::H_FLAG;
-    }
-
-    if (r1 < r2 - carry) {
-        regs.f |= ICpu::C_FLAG;
-    }
-
-    if (!(r1 -= r2 - carry)) {
-        regs.f |= ICpu::Z_FLAG;
-    }
+    uint8_t carry = flag_c();
+    set_lazy_flags(FLAG_OP_SUB, r1, r2, carry, r1 - (r2 - carry));
+    r1 -= r2 - carry;
 }
 
 inline void CPU::and_r8(uint8_t r) {
-    regs.f = 0;
-    if (!(regs.a &= r)) {
-        regs.f |= ICpu::Z_FLAG | ICpu::H_FLAG;
-    } else {
-        regs.f |= ICpu::H_FLAG;
-    }
+    regs.a &= r;
+    set_lazy_flags(FLAG_OP_AND, 0, 0, 0, regs.a);
 }
 
 inline void CPU::xor_r8(uint8_t r) {
-    regs.f = 0;
-    if (!(regs.a ^= r)) {
-        regs.f |= ICpu::Z_FLAG;
-    }
+    regs.a ^= r;
+    set_lazy_flags(FLAG_OP_LOGIC, 0, 0, 0, regs.a);
 }
 
 inline void CPU::pop_r16(uint8_t& high, uint8_t& low) {
@@ -760,27 +839,12 @@ inline void CPU::push_r16(uint8_t high, uint8_t low) {
 }
 
 inline void CPU::or_r8(uint8_t r) {
-    regs.f = 0;
-    if (!(regs.a |= r)) {
-        regs.f |= ICpu::Z_FLAG;
-    }
+    regs.a |= r;
+    set_lazy_flags(FLAG_OP_LOGIC, 0, 0, 0, regs.a);
 }
 
 inline void CPU::cp_r8(uint8_t r) {
-    regs.f = 0;
-    regs.f |= ICpu::N_FLAG;
-
-    if ((regs.a & 0xF) < (r & 0xF)) {
-        regs.f |= ICpu::H_FLAG;
-    }
-
-    if (regs.a < r) {
-        regs.f |= ICpu::C_FLAG;
-    }
-
-    if (!(regs.a - r)) {
-        regs.f |= ICpu::Z_FLAG;
-    }
+    set_lazy_flags(FLAG_OP_SUB, regs.a, r, 0, regs.a - r);
 }
 
 inline void CPU::rst(uint8_t val) {
@@ -790,97 +854,52 @@ inline void CPU::rst(uint8_t val) {
 }
 
 inline void CPU::rlc_r8(uint8_t& r) {
-    regs.f = 0;
-    if (r & 0x80) {
-        regs.f |= ICpu::C_FLAG;
-    }
-
-    r = (r << 1) + (regs.f >> 4);
-    if (!r) {
-        regs.f |= ICpu::Z_FLAG;
-    }
+    uint8_t carry = r >> 7;
+    r = (r << 1) + carry;
+    set_lazy_flags(FLAG_OP_SHIFT, 0, 0, carry, r);
 }
 
 inline void CPU::rrc_r8(uint8_t& r) {
-    regs.f = 0;
-    if (r & 0x1) {
-        regs.f |= ICpu::C_FLAG;
-    }
-
-    r = (r >> 1) + (regs.f << 3);
-    if (!r) {
-        regs.f |= ICpu::Z_FLAG;
-    }
+    uint8_t carry = r & 0x1;
+    r = (r >> 1) + (carry << 7);
+    set_lazy_flags(FLAG_OP_SHIFT, 0, 0, carry, r);
 }
 
 inline void CPU::rl_r8(uint8_t& r) {
-    uint8_t carry = (regs.f & ICpu::C_FLAG) >> 4;
-    regs.f = 0;
-    if (r & 0x80) {
-        regs.f |= ICpu::C_FLAG;
-    }
-
+    uint8_t carry = flag_c();
+    set_lazy_flags(FLAG_OP_SHIFT, 0, 0, r >> 7, (r << 1) + carry);
     r = (r << 1) + carry;
-    if (!r) {
-        regs.f |= ICpu::Z_FLAG;
-    }
 }
 
 inline void CPU::rr_r8(uint8_t& r) {
-    uint8_t carry = (regs.f & ICpu::C_FLAG) << 3;
-    regs.f = 0;
-    if (r & 0x1) {
-        regs.f |= ICpu::C_FLAG;
-    }
-
+    uint8_t carry = flag_c() << 7;
+    set_lazy_flags(FLAG_OP_SHIFT, 0, 0, r & 0x1, (r >> 1) + carry);
     r = (r >> 1) + carry;
-    if (!r) {
-        regs.f |= ICpu::Z_FLAG;
-    }
 }
 
 inline void CPU::sla_r8(uint8_t& r) {
-    regs.f = 0;
-    regs.f |= (r & 0x80) << 4;
-    if (!(r <<= 1)) {
-        regs.f |= ICpu::Z_FLAG;
-    }
+    set_lazy_flags(FLAG_OP_SHIFT, 0, 0, r >> 7, r << 1);
+    r <<= 1;
 }
 
 inline void CPU::sra_r8(uint8_t& r) {
-    regs.f = 0;
-    regs.f |= (r & 0x1) << 4;
     uint8_t msb = r & 0x80;
-    r >>= 1;
-    r += msb;
-    if (!r) {
-        regs.f |= ICpu::Z_FLAG;
-    }
+    set_lazy_flags(FLAG_OP_SHIFT, 0, 0, r & 0x1, (r >> 1) + msb);
+    r = (r >> 1) + msb;
 }
 
 inline void CPU::swap_r8(uint8_t& r) {
-    regs.f = 0;
-    uint8_t high = r >> 4;
-    r = (r << 4) + high;
-    if (!r) {
-        regs.f |= ICpu::Z_FLAG;
-    }
+    r = (r << 4) + (r >> 4);
+    set_lazy_flags(FLAG_OP_SHIFT, 0, 0, 0, r);
 }
 
 inline void CPU::srl_r8(uint8_t& r) {
-    regs.f = 0;
-    regs.f |= (r & 0x1) << 4;
-    if (!(r >>= 1)) {
-        regs.f |= ICpu::Z_FLAG;
-    }
+    set_lazy_flags(FLAG_OP_SHIFT, 0, 0, r & 0x1, r >> 1);
+    r >>= 1;
 }
 
 inline void CPU::bit_b_r8(uint8_t b, uint8_t r) {
-    regs.f &= ICpu::C_FLAG;
-    regs.f |= ICpu::H_FLAG;
-    if (!(r & (1 << b))) {
-        regs.f |= ICpu::Z_FLAG;
-    }
+    set_lazy_flags(FLAG_OP_BIT, 0, 0, flag_c(), r & (1 << b));
 }
 
 inline void CPU::res_b_r8(uint8_t b, uint8_t& r) {
@@ -4,6 +4,8 @@
 #include <fstream>
 #include <iostream>
 #include <iomanip>
+#include <limits>
+#include <sstream>
 
 namespace geemuboi::core  {
 
@@ -29,16 +31,21 @@ CpuDebugDecorator::CpuDebugDecorator(
 
 
 int CpuDebugDecorator::execute() {
+    return execute(std::numeric_limits<int>::max());
+}
+
+int CpuDebugDecorator::execute(int max_cycles) {
+    cpu->sync_registers();
     regs = real_regs;
 
     if (breakpoints.find(regs.pc) != breakpoints.end()) {
         print_breakpoint();
     }
 
-    std::string next_instruction{instruction_names[mmu.read_byte(regs.pc)]};
+    std::string next_instruction{get_instruction_name(mmu.read_byte(regs.pc))};
     
     try {
-        return cpu->execute();
+        return cpu->execute(max_cycles);
     } catch (const NotImplementedInstructionException& e) {
         std::cout << e.what() << " Instruction: " << next_instruction << std::endl;
     } catch (const UndefinedInstructionException& e) {
@@ -58,6 +65,33 @@ unsigned CpuDebugDecorator::get_cycles_executed() {
 }
 
 
+void CpuDebugDecorator::sync_registers() {
+    cpu->sync_registers();
+}
+
+
+void CpuDebugDecorator::save_state(StateWriter& writer) const {
+    cpu->save_state(writer);
+}
+
+
+void CpuDebugDecorator::load_state(StateReader& reader) {
+    cpu->load_state(reader);
+}
+
+
+std::string CpuDebugDecorator::get_instruction_name(uint8_t opcode) const {
+    if (opcode < instruction_names.size()) {
+        return instruction_names[opcode];
+    }
+
+    // Without instr.txt in the working directory there are only opcodes
+    std::ostringstream name;
+    name << "0x" << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(opcode);
+    return name.str();
+}
+
+
 void CpuDebugDecorator::print_breakpoint() const {
     std::cout << "------- BREAK -------" << std::endl;
     std::cout << "-------- CPU --------\n";
@@ -110,7 +144,7 @@ void CpuDebugDecorator::print_current_instruction(int before, int after) const {
     for (int i = before; i != after; ++i) {
         std::cout << ((i == 0) ? ">" : " ");
         std::cout << "0x" << static_cast<unsigned>(regs.pc + i) << ": ";
-        std::cout << instruction_names[mmu.read_byte(regs.pc + i)] << std::endl;
+        std::cout << get_instruction_name(mmu.read_byte(regs.pc + i)) << std::endl;
     }
 }
 
@@ -2,13 +2,24 @@
 
 #include "core/icpu.h"
 
+#include "cached_cpu.h"
 #include "cpu.h"
+#include "jit_cpu.h"
 
 namespace geemuboi::core {
 
 
-std::unique_ptr<ICpu> create_cpu(IMmu& mmu, ICpu::Registers& regs) {
-    return std::make_unique<CPU>(mmu, regs);
+std::unique_ptr<ICpu> create_cpu(IMmu& mmu, ICpu::Registers& regs, CpuType type,
+                                 const Scheduler* scheduler, Interrupts* interrupts) {
+    switch (type) {
+    case CPU_TYPE_CACHED: return std::make_unique<CachedCpu>(mmu, regs, scheduler, interrupts);
+#ifdef GEEMUBOI_HAS_JIT
+    case CPU_TYPE_JIT: return std::make_unique<JitCpu>(mmu, regs, scheduler, interrupts);
+#else
+    case CPU_TYPE_JIT: return std::make_unique<CachedCpu>(mmu, regs, scheduler, interrupts);
+#endif
+    default: return std::make_unique<CPU>(mmu, regs, scheduler, interrupts);
+    }
 }
 
 
@@ -1,125 +1,161 @@
 #include "core/gpu.h"
 
+#include <algorithm>
+
 namespace geemuboi::core {
 
 using namespace geemuboi::view;
 
 
-GPU::GPU(Renderer& renderer_in) : vram{},
+GPU::GPU(Renderer& renderer_in, Scheduler& scheduler_in, Interrupts& interrupts_in) : vram{},
     oam{},
     curr_state{},
-    state_cycles{},
     lcd_control{},
     scroll_y{},
     scroll_x{},
     curr_line{},
     bg_palette{},
     renderer(renderer_in),
-    framebuffer{}
-{}
-
-void GPU::step(int cpu_cycles) {
-    state_cycles += cpu_cycles;
+    scheduler(scheduler_in),
+    interrupts(interrupts_in),
+    framebuffer{},
+    shades{},
+    line_shades{},
+    frame{},
+    shade_frame{},
+    frame_pitch{} {
+
+    begin_frame();
+    scheduler.set_handler(Scheduler::EVENT_GPU, [this]() { change_state(); });
+    scheduler.schedule_in(Scheduler::EVENT_GPU, CYCLES_HORIZONTAL_BLANK);
+}
 
+void GPU::change_state() {
     switch (curr_state) {
     case STATE_HORIZONTAL_BLANK:
-        if (state_cycles >= CYCLES_HORIZONTAL_BLANK) {
-            curr_state = (curr_line == LAST_LINE) ? STATE_VERTICAL_BLANK : STATE_SCANLINE_OAM;
-            ++curr_line;
-            state_cycles = 0;
+        if (curr_line == LAST_LINE) {
+            curr_state = STATE_VERTICAL_BLANK;
+            interrupts.request(Interrupts::INTERRUPT_VBLANK);
+        } else {
+            curr_state = STATE_SCANLINE_OAM;
         }
-
+        ++curr_line;
         break;
     case STATE_VERTICAL_BLANK:
-        if (state_cycles >= CYCLES_VERTICAL_BLANK) {
-            ++curr_line;
-            state_cycles = 0;
-
-            if (curr_line > VBLANK_LAST_LINE) {
-                curr_line = 0;
-                curr_state = STATE_SCANLINE_OAM;
+        ++curr_line;
+        if (curr_line > VBLANK_LAST_LINE) {
+            curr_line = 0;
+            curr_state = STATE_SCANLINE_OAM;
 
-                renderer.render_frame(framebuffer);
-            }
+            end_frame();
         }
-
         break;
     case STATE_SCANLINE_OAM:
-        if (state_cycles >= CYCLES_SCANLINE_OAM) {
-            curr_state = STATE_SCANLINE_VRAM;
-            state_cycles = 0;
-        }
-
+        curr_state = STATE_SCANLINE_VRAM;
         break;
     case STATE_SCANLINE_VRAM:
-        if (state_cycles >= CYCLES_SCANLINE_VRAM) {
-            curr_state = STATE_HORIZONTAL_BLANK;
-            state_cycles = 0;
+        curr_state = STATE_HORIZONTAL_BLANK;
+        render_scanline();
+        break;
+    }
 
-            render_scanline();
+    scheduler.schedule_in(Scheduler::EVENT_GPU, get_state_cycles());
+}
+
+int GPU::get_state_cycles() const {
+    switch (curr_state) {
+    case STATE_HORIZONTAL_BLANK: return CYCLES_HORIZONTAL_BLANK;
+    case STATE_VERTICAL_BLANK: return CYCLES_VERTICAL_BLANK;
+    case STATE_SCANLINE_OAM: return CYCLES_SCANLINE_OAM;
+    default: return CYCLES_SCANLINE_VRAM;
+    }
+}
+
+void GPU::begin_frame() {
+    frame = nullptr;
+    shade_frame = nullptr;
+
+    if (renderer.accepts_shades()) {
+        shade_frame = renderer.lock_shades(frame_pitch);
+        if (!shade_frame) {
+            shade_frame = shades;
+            frame_pitch = Renderer::SCREEN_WIDTH;
+        }
+    } else {
+        frame = renderer.lock_frame(frame_pitch);
+        if (!frame) {
+            frame = framebuffer;
+            frame_pitch = Renderer::SCREEN_WIDTH;
         }
     }
 }
 
+void GPU::end_frame() {
+    if (frame == framebuffer) {
+        renderer.render_frame(framebuffer);
+    } else if (shade_frame == shades) {
+        renderer.render_shades(shades);
+    } else {
+        renderer.unlock_frame();
+    }
+
+    begin_frame();
+}
+
 void GPU::render_scanline() {
+    uint8_t* line = shade_frame ? shade_frame + curr_line * frame_pitch : line_shades;
+
+    // Locked renderer memory holds garbage, so every line is written
     if (lcd_control & LCD_CONTROL_BG_ENABLE) {
-        render_background();
+        render_background(line);
+    } else {
+        std::fill(line, line + Renderer::SCREEN_WIDTH, Renderer::SHADE_WHITE);
     }
 
     if (lcd_control & LCD_CONTROL_SPRITE_ENABLE) {
-        render_sprites();
+        render_sprites(line);
+    }
+
+    if (frame) {
+        Renderer::expand_shades(line, Renderer::SCREEN_WIDTH, frame + curr_line * frame_pitch);
     }
 }
 
-void GPU::render_background() {
+void GPU::render_background(uint8_t* line) {
     uint16_t map_addr;
     map_addr = (lcd_control & LCD_CONTROL_BG_TILE_MAP) ? VRAM_TILE_MAP_1 : VRAM_TILE_MAP_0;
 
     uint16_t map_offset_y = static_cast<uint8_t>(curr_line + scroll_y) / TILE_HEIGHT_PIXELS;
     map_addr += map_offset_y * TILES_PER_MAP_ROW;
 
-    int map_offset_x = scroll_x / TILE_WIDTH_PIXELS;
-    map_addr += map_offset_x;
-
-    uint16_t tile_set_addr;
-    tile_set_addr = (lcd_control & LCD_CONTROL_BG_TILE_SET) ? VRAM_TILE_SET_1 : VRAM_TILE_SET_0;
+    // Tile numbers are unsigned from 0x8000 and signed around 0x9000
+    bool unsigned_tiles = lcd_control & LCD_CONTROL_BG_TILE_SET;
+    uint16_t tile_set_addr = unsigned_tiles ? VRAM_TILE_SET_1 : VRAM_TILE_SET_0;
 
-    if (lcd_control & LCD_CONTROL_BG_TILE_SET) {
-        // tile_nbr += 256;
-    }
-
-    int tile_nbr;
-    int initial_tile_x = scroll_x & 0x7;
+    int tile_nbr = 0;
     int tile_y = (curr_line + scroll_y) & 0x7;
     
     for (int i = 0; i < Renderer::SCREEN_WIDTH; ++i) {
-        int tile_x = (initial_tile_x + i) % TILE_WIDTH_PIXELS;
-        if (tile_x == 0) {
-            tile_nbr = static_cast<int8_t>(vram[map_addr++]);
+        // The map wraps around at 256 pixels
+        int x = (scroll_x + i) & 0xFF;
+        int tile_x = x % TILE_WIDTH_PIXELS;
+        if (tile_x == 0 || i == 0) {
+            uint8_t tile = vram[map_addr + x / TILE_WIDTH_PIXELS];
+            tile_nbr = unsigned_tiles ? tile : static_cast<int8_t>(tile);
         }
 
         uint8_t low = vram[tile_set_addr + TILE_SIZE * tile_nbr + tile_y * 2];
         uint8_t high = vram[tile_set_addr + TILE_SIZE * tile_nbr + tile_y * 2 + 1];
         
         low = (low >> (7 - tile_x)) & 0x1;
-        high = (high >> (6 - tile_x)) & 0x2;
+        high = ((high >> (7 - tile_x)) & 0x1) << 1;
 
         uint8_t color = high + low;
-        color = (bg_palette >> (color * 2)) & 0x3;
-
-        uint32_t pixel = 0;
-        switch (color) {
-            case 0: pixel = PIXEL_COLOR_WHITE; break;
-            case 1: pixel = PIXEL_COLOR_LIGHT_GREY; break;
-            case 2: pixel = PIXEL_COLOR_DARK_GREY; break;
-            case 3: pixel = PIXEL_COLOR_BLACK; break;
-        }
-
-        framebuffer[i + curr_line * Renderer::SCREEN_WIDTH] = pixel;
+        line[i] = (bg_palette >> (color * 2)) & 0x3;
     }
 }
 
-void GPU::render_sprites() {
+void GPU::render_sprites(uint8_t* line) {
     // for each sprite
     for (int i = 0; i != NBR_OAMS * OAM_SIZE; i += OAM_SIZE) {
         OamEntry sprite = {oam[i], oam[i + 1], oam[i + 2], oam[i + 3]};
@@ -147,21 +183,14 @@ void GPU::render_sprites() {
                 uint8_t high = vram[3 * 8 * 2 + 2 + x * 2 + 1];
 
                 low = (low >> (7 - x)) & 0x1;
-                high = (high >> (6 - x)) & 0x2;
+                high = ((high >> (7 - x)) & 0x1) << 1;
 
                 uint8_t color = high + low;
-                color = (palette >> (color * 2)) & 0x3;
-
 
-                uint32_t pixel = 0;
-                switch (color) {
-                    case 0: pixel = PIXEL_COLOR_WHITE; break;
-                    case 1: pixel = PIXEL_COLOR_LIGHT_GREY; break;
-                    case 2: pixel = PIXEL_COLOR_DARK_GREY; break;
-                    case 3: pixel = PIXEL_COLOR_BLACK; break;
+                int screen_x = sprite.x - 8 + x;
+                if (screen_x >= 0 && screen_x < Renderer::SCREEN_WIDTH) {
+                    line[screen_x] = (palette >> (color * 2)) & 0x3;
                 }
-
-                framebuffer[sprite.x - 8 + x + curr_line * Renderer::SCREEN_WIDTH] = pixel;
             }
         }
     }
@@ -176,6 +205,14 @@ void GPU::write_word_vram(uint16_t addr, uint16_t val) {
     vram[addr + 1] = val >> 8;
 }
 
+uint8_t* GPU::get_vram() {
+    return vram;
+}
+
+uint8_t* GPU::get_oam() {
+    return oam;
+}
+
 uint8_t GPU::read_byte_oam(uint16_t addr) const {
     return oam[addr];
 }
@@ -236,4 +273,29 @@ void GPU::set_obj_palette(int index, uint8_t val) {
     obj_palette[index] = val;
 }
 
+
+void GPU::save_state(StateWriter& writer) const {
+    writer.write(vram);
+    writer.write(oam);
+    writer.write(curr_state);
+    writer.write(lcd_control);
+    writer.write(scroll_y);
+    writer.write(scroll_x);
+    writer.write(curr_line);
+    writer.write(bg_palette);
+    writer.write(obj_palette);
+}
+
+void GPU::load_state(StateReader& reader) {
+    reader.read(vram);
+    reader.read(oam);
+    reader.read(curr_state);
+    reader.read(lcd_control);
+    reader.read(scroll_y);
+    reader.read(scroll_x);
+    reader.read(curr_line);
+    reader.read(bg_palette);
+    reader.read(obj_palette);
+}
+
 }
@@ -0,0 +1,210 @@
+#include "core/hash.h"
+
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace geemuboi::core {
+
+
+namespace {
+
+const int LANES = 8;
+const int STRIPE_SIZE = LANES * sizeof(uint64_t);
+// Stripes between two scrambles of the accumulators
+const int BLOCK_STRIPES = 16;
+
+const uint64_t PRIME32_1 = 0x9E3779B1;
+const uint64_t PRIME64_1 = 0x9E3779B185EBCA87;
+const uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4F;
+const uint64_t PRIME64_3 = 0x165667B19E3779F9;
+
+// Every stripe of a block is keyed by its own window of the secret, one
+// lane further along than the one before. The last lanes key the scramble.
+const int SECRET_SIZE = LANES + BLOCK_STRIPES;
+
+constexpr uint64_t split_mix(uint64_t val) {
+    val = (val ^ (val >> 30)) * 0xBF58476D1CE4E5B9;
+    val = (val ^ (val >> 27)) * 0x94D049BB133111EB;
+    return val ^ (val >> 31);
+}
+
+struct Secret {
+    constexpr Secret() : keys{} {
+        for (int i = 0; i != SECRET_SIZE; ++i) {
+            keys[i] = split_mix(PRIME64_1 * (i + 1));
+        }
+    }
+
+    uint64_t keys[SECRET_SIZE];
+};
+
+constexpr Secret SECRET;
+
+uint64_t read64(const uint8_t* p) {
+    uint64_t val;
+    std::memcpy(&val, p, sizeof(val));
+    return val;
+}
+
+uint64_t rotate_left(uint64_t val, int bits) {
+    return (val << bits) | (val >> (64 - bits));
+}
+
+void accumulate_stripe(uint64_t* acc, const uint8_t* stripe, const uint64_t* keys) {
+    for (int i = 0; i != LANES; ++i) {
+        uint64_t val = read64(stripe + i * sizeof(uint64_t));
+        uint64_t keyed = val ^ keys[i];
+        acc[i ^ 1] += val;
+        acc[i] += (keyed & 0xFFFFFFFF) * (keyed >> 32);
+    }
+}
+
+#if defined(__AVX2__)
+
+struct VectorLanes {
+    static const int LANES = 4;
+    using Vec = __m256i;
+
+    static Vec load(const void* p) { return _mm256_loadu_si256(static_cast<const Vec*>(p)); }
+    static void store(void* p, Vec v) { _mm256_storeu_si256(static_cast<Vec*>(p), v); }
+    static Vec set(uint64_t val) { return _mm256_set1_epi64x(static_cast<long long>(val)); }
+
+    static Vec bit_xor(Vec a, Vec b) { return _mm256_xor_si256(a, b); }
+    static Vec add(Vec a, Vec b) { return _mm256_add_epi64(a, b); }
+    static Vec shift_right(Vec a, int bits) { return _mm256_srli_epi64(a, bits); }
+    static Vec shift_left(Vec a, int bits) { return _mm256_slli_epi64(a, bits); }
+    // The low 32 bits of each lane multiplied into 64
+    static Vec multiply(Vec a, Vec b) { return _mm256_mul_epu32(a, b); }
+    // Lanes 0 1 2 3 as 1 0 3 2
+    static Vec swap_pairs(Vec a) { return _mm256_shuffle_epi32(a, _MM_SHUFFLE(1, 0, 3, 2)); }
+};
+
+#elif defined(__SSE2__)
+
+struct VectorLanes {
+    static const int LANES = 2;
+    using Vec = __m128i;
+
+    static Vec load(const void* p) { return _mm_loadu_si128(static_cast<const Vec*>(p)); }
+    static void store(void* p, Vec v) { _mm_storeu_si128(static_cast<Vec*>(p), v); }
+    static Vec set(uint64_t val) { return _mm_set1_epi64x(static_cast<long long>(val)); }
+
+    static Vec bit_xor(Vec a, Vec b) { return _mm_xor_si128(a, b); }
+    static Vec add(Vec a, Vec b) { return _mm_add_epi64(a, b); }
+    static Vec shift_right(Vec a, int bits) { return _mm_srli_epi64(a, bits); }
+    static Vec shift_left(Vec a, int bits) { return _mm_slli_epi64(a, bits); }
+    static Vec multiply(Vec a, Vec b) { return _mm_mul_epu32(a, b); }
+    static Vec swap_pairs(Vec a) { return _mm_shuffle_epi32(a, _MM_SHUFFLE(1, 0, 3, 2)); }
+};
+
+#endif
+
+#if defined(__AVX2__) || defined(__SSE2__)
+
+// The same as accumulate_stripe() and scramble() over every full stripe,
+// with the accumulators held in registers. Neighbouring lanes share a
+// vector, so adding into the other lane of the pair is a shuffle.
+void accumulate(uint64_t* acc, const uint8_t* bytes, size_t stripes, const uint64_t* keys) {
+    using V = VectorLanes;
+    const int VECTORS = LANES / V::LANES;
+
+    V::Vec accs[VECTORS];
+    for (int v = 0; v != VECTORS; ++v) {
+        accs[v] = V::load(acc + v * V::LANES);
+    }
+
+    const V::Vec prime = V::set(PRIME32_1);
+    for (size_t stripe = 0; stripe != stripes; ++stripe) {
+        int block_stripe = stripe % BLOCK_STRIPES;
+        const uint8_t* data = bytes + stripe * STRIPE_SIZE;
+        for (int v = 0; v != VECTORS; ++v) {
+            V::Vec val = V::load(data + v * sizeof(V::Vec));
+            V::Vec keyed = V::bit_xor(val, V::load(keys + block_stripe + v * V::LANES));
+            V::Vec product = V::multiply(keyed, V::shift_right(keyed, 32));
+            accs[v] = V::add(accs[v], V::add(V::swap_pairs(val), product));
+        }
+
+        if (block_stripe == BLOCK_STRIPES - 1) {
+            for (int v = 0; v != VECTORS; ++v) {
+                V::Vec a = V::bit_xor(accs[v], V::shift_right(accs[v], 47));
+                a = V::bit_xor(a, V::load(keys + BLOCK_STRIPES + v * V::LANES));
+                // 64 by 32 bit multiply out of two 32 by 32 bit ones
+                V::Vec low = V::multiply(a, prime);
+                V::Vec high = V::multiply(V::shift_right(a, 32), prime);
+                accs[v] = V::add(low, V::shift_left(high, 32));
+            }
+        }
+    }
+
+    for (int v = 0; v != VECTORS; ++v) {
+        V::store(acc + v * V::LANES, accs[v]);
+    }
+}
+
+#else
+
+void scramble(uint64_t* acc, const uint64_t* keys) {
+    for (int i = 0; i != LANES; ++i) {
+        acc[i] ^= acc[i] >> 47;
+        acc[i] ^= keys[i];
+        acc[i] *= PRIME32_1;
+    }
+}
+
+void accumulate(uint64_t* acc, const uint8_t* bytes, size_t stripes, const uint64_t* keys) {
+    for (size_t stripe = 0; stripe != stripes; ++stripe) {
+        int block_stripe = stripe % BLOCK_STRIPES;
+        accumulate_stripe(acc, bytes + stripe * STRIPE_SIZE, keys + block_stripe);
+        if (block_stripe == BLOCK_STRIPES - 1) {
+            scramble(acc, keys + BLOCK_STRIPES);
+        }
+    }
+}
+
+#endif
+
+}
+
+
+uint64_t hash_bytes(const void* data, size_t size, uint64_t seed) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+
+    uint64_t keys[SECRET_SIZE];
+    for (int i = 0; i != SECRET_SIZE; ++i) {
+        keys[i] = SECRET.keys[i] + (i & 1 ? -seed : seed);
+    }
+
+    uint64_t acc[LANES] = {
+        PRIME32_1, PRIME64_1, PRIME64_2, PRIME64_3, PRIME32_1, PRIME64_2, PRIME64_1, PRIME64_3
+    };
+
+    size_t stripes = size / STRIPE_SIZE;
+    accumulate(acc, bytes, stripes, keys);
+
+    // The tail is zero padded, the length below tells it apart from zeros
+    size_t tail = size % STRIPE_SIZE;
+    if (tail) {
+        uint8_t last[STRIPE_SIZE] = {};
+        std::memcpy(last, bytes + stripes * STRIPE_SIZE, tail);
+        accumulate_stripe(acc, last, keys + stripes % BLOCK_STRIPES);
+    }
+
+    uint64_t hash = size * PRIME64_1 + seed;
+    for (uint64_t lane : acc) {
+        hash ^= rotate_left(lane * PRIME64_2, 31) * PRIME64_1;
+        hash = rotate_left(hash, 27) * PRIME64_1 + PRIME64_3;
+    }
+
+    hash ^= hash >> 37;
+    hash *= PRIME64_3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+
+}
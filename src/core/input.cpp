@@ -4,10 +4,22 @@ namespace geemuboi::core {
 
 
 Input::Input() : buttons_pressed{0x0F, 0x0F}, 
-    column_down{}
+    column_down{},
+    listener{},
+    buttons_heard{0x0F, 0x0F}
 {}
 
-uint8_t Input::get_buttons_pressed() const {
+uint8_t Input::get_buttons_pressed() {
+    if (listener) {
+        for (int column = 0; column != 2; ++column) {
+            uint8_t buttons = buttons_pressed[column];
+            if (buttons != buttons_heard[column]) {
+                buttons_heard[column] = buttons;
+                listener->buttons_changed(column, buttons);
+            }
+        }
+    }
+
     if (column_down[0]) {
         return buttons_pressed[0];
     } else if (column_down[1]) {
@@ -30,5 +42,27 @@ bool Input::get_column_down(int column) const {
     return column_down[column];
 }
 
+void Input::set_listener(InputListener* listener_in) {
+    // Buttons already held are reported as changes from none held
+    listener = listener_in;
+    buttons_heard[0] = 0x0F;
+    buttons_heard[1] = 0x0F;
+}
+
+void Input::save_state(StateWriter& writer) const {
+    writer.write(buttons_pressed[0].load());
+    writer.write(buttons_pressed[1].load());
+    writer.write(column_down);
+}
+
+void Input::load_state(StateReader& reader) {
+    for (std::atomic<uint8_t>& buttons : buttons_pressed) {
+        uint8_t val;
+        reader.read(val);
+        buttons = val;
+    }
+    reader.read(column_down);
+}
+
 
 }
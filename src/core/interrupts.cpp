@@ -0,0 +1,50 @@
+#include "core/interrupts.h"
+
+namespace geemuboi::core {
+
+
+Interrupts::Interrupts() : enabled{},
+    requested{}
+{}
+
+void Interrupts::request(uint8_t interrupt) {
+    requested |= interrupt;
+}
+
+void Interrupts::acknowledge(uint8_t interrupt) {
+    requested &= ~interrupt;
+}
+
+uint8_t Interrupts::get_pending() const {
+    return enabled & requested & INTERRUPT_MASK;
+}
+
+uint8_t Interrupts::get_enabled() const {
+    return enabled;
+}
+
+void Interrupts::set_enabled(uint8_t val) {
+    enabled = val;
+}
+
+uint8_t Interrupts::get_requested() const {
+    // The unused upper bits always read as set
+    return requested | ~INTERRUPT_MASK;
+}
+
+void Interrupts::set_requested(uint8_t val) {
+    requested = val & INTERRUPT_MASK;
+}
+
+void Interrupts::save_state(StateWriter& writer) const {
+    writer.write(enabled);
+    writer.write(requested);
+}
+
+void Interrupts::load_state(StateReader& reader) {
+    reader.read(enabled);
+    reader.read(requested);
+}
+
+
+}
@@ -0,0 +1,1594 @@
+#include "jit_cpu.h"
+
+#ifdef GEEMUBOI_HAS_JIT
+
+#include "opcodes.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <iterator>
+#include <limits>
+
+namespace geemuboi::core {
+
+namespace {
+
+using E = X64Emitter;
+
+// Host registers holding guest state while generated code runs. The ABI has
+// callees preserve all of them, so they survive calls back into C++.
+const int REG_REGS = E::RBX;
+const int REG_CONTEXT = E::RBP;
+const int REG_A = E::R12;
+const int REG_F = E::R13;
+const int REG_HL = E::R14;
+const int REG_SP = E::R15;
+
+// As numbered by the opcodes, plus F
+enum GuestRegs { GUEST_B, GUEST_C, GUEST_D, GUEST_E, GUEST_H, GUEST_L, GUEST_MHL, GUEST_A, GUEST_F };
+
+// The slow paths get the cycles the block ran before the instruction, and
+// NO_BAIL unless it is the instruction's first access. They return BAIL to
+// leave the block before the instruction.
+const uint32_t NO_BAIL = 0x10000;
+const uint32_t CYCLES_MASK = 0xFFFF;
+const uint32_t BAIL = 0x10000;
+
+const uint8_t ALL_FLAGS = 0xFF;
+
+const int ALU_OPS[8] = {
+    E::ALU_ADD, E::ALU_ADC, E::ALU_SUB, E::ALU_SBB, E::ALU_AND, E::ALU_XOR, E::ALU_OR, E::ALU_CMP
+};
+
+// swap is done as a rotate by 4
+const int SHIFT_OPS[8] = {
+    E::SHIFT_ROL, E::SHIFT_ROR, E::SHIFT_RCL, E::SHIFT_RCR,
+    E::SHIFT_SHL, E::SHIFT_SAR, E::SHIFT_ROL, E::SHIFT_SHR
+};
+
+struct FlagUsage {
+    uint8_t uses;
+    uint8_t defines;
+    // Leaves the block in the middle, or runs a regular handler
+    bool may_exit;
+};
+
+bool may_exit(uint16_t opcode) {
+    if (opcode >= 0x100) {
+        return (opcode & 7) == GUEST_MHL;
+    }
+
+    if (opcode >= 0xC0) {
+        // Everything but the ALU ops with an immediate and ld sp,hl
+        return (opcode & 7) != 6 && opcode != 0xF9;
+    }
+
+    if (opcode >= 0x40) {
+        return (opcode & 7) == GUEST_MHL || ((opcode >> 3) & 7) == GUEST_MHL;
+    }
+
+    switch (opcode) {
+    case 0x02: case 0x12: case 0x22: case 0x32:
+    case 0x0A: case 0x1A: case 0x2A: case 0x3A:
+    case 0x08: case 0x34: case 0x35: case 0x36:
+    case 0x09: case 0x19: case 0x29: case 0x39:
+    case 0x10: case 0x27:
+        return true;
+    default:
+        return false;
+    }
+}
+
+FlagUsage get_flag_usage(uint16_t opcode) {
+    FlagUsage usage{0, 0, may_exit(opcode)};
+
+    if (opcode >= 0x100) {
+        int sub_op = (opcode >> 3) & 7;
+        switch ((opcode >> 6) & 3) {
+        case 0:
+            usage.defines = ALL_FLAGS;
+            usage.uses = sub_op == 2 || sub_op == 3 ? ICpu::C_FLAG : 0;
+            break;
+        case 1:
+            usage.defines = ALL_FLAGS & ~ICpu::C_FLAG;
+            break;
+        }
+        return usage;
+    }
+
+    bool is_alu = (opcode >= 0x80 && opcode < 0xC0) || (opcode >= 0xC0 && (opcode & 7) == 6);
+    if (is_alu) {
+        int alu_op = (opcode >> 3) & 7;
+        usage.defines = ALL_FLAGS;
+        usage.uses = alu_op == 1 || alu_op == 3 ? ICpu::C_FLAG : 0;
+        return usage;
+    }
+
+    if (opcode < 0x40 && ((opcode & 7) == 4 || (opcode & 7) == 5)) {
+        usage.defines = ALL_FLAGS & ~ICpu::C_FLAG;
+        return usage;
+    }
+
+    switch (opcode) {
+    case 0x07: case 0x0F:
+        usage.defines = ALL_FLAGS;
+        break;
+    case 0x17: case 0x1F:
+        usage.defines = ALL_FLAGS;
+        usage.uses = ICpu::C_FLAG;
+        break;
+    case 0x2F:
+        usage.defines = ICpu::N_FLAG | ICpu::H_FLAG;
+        break;
+    case 0x37:
+        usage.defines = ALL_FLAGS & ~ICpu::Z_FLAG;
+        break;
+    case 0x3F:
+        usage.defines = ALL_FLAGS & ~(ICpu::Z_FLAG | ICpu::C_FLAG);
+        usage.uses = ICpu::C_FLAG;
+        break;
+    }
+    return usage;
+}
+
+E::Mem regs_field(size_t offset) {
+    return E::mem(REG_REGS, static_cast<int32_t>(offset));
+}
+
+// HL is kept as a 16-bit value, but stored high byte first
+void load_registers(X64Emitter& e) {
+    e.load8(REG_A, regs_field(offsetof(ICpu::Registers, a)));
+    e.load8(REG_F, regs_field(offsetof(ICpu::Registers, f)));
+    e.load16(REG_HL, regs_field(offsetof(ICpu::Registers, h)));
+    e.shift16(E::SHIFT_ROL, REG_HL, 8);
+    e.load16(REG_SP, regs_field(offsetof(ICpu::Registers, sp)));
+}
+
+void store_registers(X64Emitter& e) {
+    e.store8(regs_field(offsetof(ICpu::Registers, a)), REG_A);
+    e.store8(regs_field(offsetof(ICpu::Registers, f)), REG_F);
+    e.mov(E::RAX, REG_HL);
+    e.shift16(E::SHIFT_ROL, E::RAX, 8);
+    e.store16(regs_field(offsetof(ICpu::Registers, h)), E::RAX);
+    e.store16(regs_field(offsetof(ICpu::Registers, sp)), REG_SP);
+}
+
+uint16_t get_relative_target(uint16_t operand, uint16_t next_pc) {
+    return next_pc + static_cast<int8_t>(operand);
+}
+
+}
+
+
+// Translates one block. Guest instructions are emitted in order, followed by
+// the calls to the slow paths and the code for leaving the block early,
+// which keeps the common paths free of jumps.
+class JitCpu::Compiler {
+public:
+    Compiler(JitCpu& cpu_in, Block& block_in, const std::vector<Op>& ops_in);
+
+    // False if the code didn't fit the cache
+    bool compile();
+    size_t get_size() const { return e.get_size(); }
+private:
+    enum SlowPaths { SLOW_READ_BYTE, SLOW_READ_WORD, SLOW_WRITE_BYTE, SLOW_WRITE_WORD };
+
+    // Out of the block to a PC no other block is linked to
+    struct PendingExit {
+        E::Label label;
+        uint16_t pc;
+        int cycles;
+    };
+
+    struct SlowPath {
+        E::Label entry;
+        E::Label done;
+        int kind;
+        uint32_t arg;
+        size_t bail_exit;
+    };
+
+    static E::Mem context_field(size_t offset) {
+        return E::mem(REG_CONTEXT, static_cast<int32_t>(offset));
+    }
+
+    void find_live_flags();
+    bool are_flags_live(uint8_t defines) const;
+
+    void emit_op(const Op& op);
+    void emit_prefixed(const Op& op);
+    void emit_alu(int alu_op);
+    void emit_sbc();
+    void emit_shift(int shift_op);
+    void emit_call(uint16_t return_pc);
+    void emit_ret();
+    void emit_interpreted(const Op& op);
+    void set_flags(int from_host, int set, int kept);
+
+    void load_reg(int reg, int dst);
+    void store_reg(int reg, int src);
+    void load_pair_address(int high);
+    void load_stack_address(int offset);
+
+    // The address goes in ESI, the value comes from or goes to EAX for
+    // reads and comes from EDX for writes.
+    void read_byte();
+    void read_word();
+    void write_byte();
+    void write_word();
+    SlowPath& add_slow_path(int kind);
+
+    size_t add_exit(uint16_t pc, int exit_cycles);
+    void check_stale(uint16_t pc, int exit_cycles);
+    void check_stale_call(const Op& op, int exit_cycles);
+    void static_exit(uint16_t pc, int exit_cycles);
+    void dynamic_exit(int exit_cycles);
+    void skip_unless(uint16_t opcode, E::Label& not_taken);
+
+    JitCpu& cpu;
+    Block& block;
+    const std::vector<Op>& ops;
+    X64Emitter e;
+
+    // Flags read after each op, before something else sets them
+    std::vector<uint8_t> live_flags;
+
+    std::deque<PendingExit> exits;
+    std::deque<SlowPath> slow_paths;
+
+    size_t current;
+    // Taken by the ops so far, those run by handlers take their own
+    int cycles;
+    bool accessed;
+    size_t bail_exit;
+};
+
+
+JitCpu::Compiler::Compiler(JitCpu& cpu_in, Block& block_in, const std::vector<Op>& ops_in)
+    : cpu(cpu_in),
+    block(block_in),
+    ops(ops_in),
+    e(cpu_in.code_buffer.get_data() + cpu_in.code_size,
+      cpu_in.code_buffer.get_size() - cpu_in.code_size),
+    live_flags(ops_in.size()),
+    exits{},
+    slow_paths{},
+    current{},
+    cycles{},
+    accessed{},
+    bail_exit{} {}
+
+
+bool JitCpu::Compiler::compile() {
+    find_live_flags();
+
+    for (current = 0; current != ops.size(); ++current) {
+        accessed = false;
+        bail_exit = exits.size();
+        add_exit(ops[current].pc, cycles);
+        emit_op(ops[current]);
+    }
+
+    const Op& last = ops.back();
+    if (!is_block_end(last.opcode)) {
+        static_exit(last.next_pc, cycles);
+    }
+
+    static const size_t HELPERS[] = {
+        offsetof(Context, read_byte), offsetof(Context, read_word),
+        offsetof(Context, write_byte), offsetof(Context, write_word)
+    };
+
+    for (SlowPath& slow_path : slow_paths) {
+        bool is_read = slow_path.kind == SLOW_READ_BYTE || slow_path.kind == SLOW_READ_WORD;
+
+        e.bind(slow_path.entry);
+        e.mov64(E::RDI, REG_CONTEXT);
+        e.mov_imm(is_read ? E::RDX : E::RCX, slow_path.arg);
+        e.call(context_field(HELPERS[slow_path.kind]));
+        e.alu_imm(E::ALU_CMP, E::RAX, BAIL - 1);
+        e.jcc(E::COND_A, exits[slow_path.bail_exit].label);
+        e.jmp(slow_path.done);
+    }
+
+    for (PendingExit& exit : exits) {
+        if (exit.label.fixups.empty()) {
+            continue;
+        }
+
+        e.bind(exit.label);
+        e.store16_imm(regs_field(offsetof(Registers, pc)), exit.pc);
+        if (exit.cycles) {
+            e.alu_mem_imm(E::ALU_SUB, context_field(offsetof(Context, budget)), exit.cycles);
+        }
+        e.jmp(cpu.epilogue);
+    }
+
+    return !e.has_overflowed();
+}
+
+
+void JitCpu::Compiler::find_live_flags() {
+    uint8_t live = ALL_FLAGS;
+    for (size_t i = ops.size(); i--; ) {
+        FlagUsage usage = get_flag_usage(ops[i].opcode);
+        if (usage.may_exit) {
+            live = ALL_FLAGS;
+        }
+
+        live_flags[i] = live;
+        live = (live & ~usage.defines) | usage.uses;
+        if (usage.may_exit) {
+            live = ALL_FLAGS;
+        }
+    }
+}
+
+
+bool JitCpu::Compiler::are_flags_live(uint8_t defines) const {
+    return live_flags[current] & defines;
+}
+
+
+void JitCpu::Compiler::emit_op(const Op& op) {
+    uint16_t opcode = op.opcode;
+    if (opcode >= 0x100) {
+        emit_prefixed(op);
+        return;
+    }
+
+    int dst = (opcode >> 3) & 7;
+    int src = opcode & 7;
+
+    if (opcode >= 0x40 && opcode < 0x80 && opcode != 0x76) {
+        if (dst == GUEST_MHL) {
+            e.mov(E::RSI, REG_HL);
+            load_reg(src, E::RDX);
+            write_byte();
+            check_stale(op.next_pc, cycles + 2);
+            cycles += 2;
+        } else if (src == GUEST_MHL) {
+            e.mov(E::RSI, REG_HL);
+            read_byte();
+            store_reg(dst, E::RAX);
+            cycles += 2;
+        } else {
+            if (dst != src) {
+                load_reg(src, E::RAX);
+                store_reg(dst, E::RAX);
+            }
+            cycles += 1;
+        }
+        return;
+    }
+
+    if (opcode >= 0x80 && opcode < 0xC0) {
+        if (src == GUEST_MHL) {
+            e.mov(E::RSI, REG_HL);
+            read_byte();
+            e.mov(E::RCX, E::RAX);
+            cycles += 2;
+        } else {
+            load_reg(src, E::RCX);
+            cycles += 1;
+        }
+        emit_alu(dst);
+        return;
+    }
+
+    if (opcode < 0x40 && (src == 4 || src == 5)) {
+        if (dst == GUEST_MHL) {
+            e.mov(E::RSI, REG_HL);
+            read_byte();
+        } else {
+            load_reg(dst, E::RAX);
+        }
+
+        if (src == 4) {
+            e.inc8(E::RAX);
+        } else {
+            e.dec8(E::RAX);
+        }
+
+        if (are_flags_live(ALL_FLAGS & ~ICpu::C_FLAG)) {
+            set_flags(ICpu::Z_FLAG | ICpu::H_FLAG, src == 5 ? ICpu::N_FLAG : 0, ICpu::C_FLAG);
+        }
+
+        if (dst == GUEST_MHL) {
+            e.movzx8(E::RDX, E::RAX);
+            e.mov(E::RSI, REG_HL);
+            write_byte();
+            check_stale(op.next_pc, cycles + 3);
+            cycles += 3;
+        } else {
+            store_reg(dst, E::RAX);
+            cycles += 1;
+        }
+        return;
+    }
+
+    if (opcode < 0x40 && src == 6) {
+        if (dst == GUEST_MHL) {
+            e.mov(E::RSI, REG_HL);
+            e.mov_imm(E::RDX, op.operand);
+            write_byte();
+            check_stale(op.next_pc, cycles + 3);
+            cycles += 3;
+        } else {
+            e.mov_imm(E::RAX, op.operand);
+            store_reg(dst, E::RAX);
+            cycles += 2;
+        }
+        return;
+    }
+
+    switch (opcode) {
+    case 0x00:
+        cycles += 1;
+        break;
+    case 0x01: case 0x11:
+        // High byte first
+        e.store16_imm(regs_field(offsetof(Registers, b) + (opcode >> 3)),
+                      static_cast<uint16_t>((op.operand >> 8) | (op.operand << 8)));
+        cycles += 3;
+        break;
+    case 0x21:
+        e.mov_imm(REG_HL, op.operand);
+        cycles += 3;
+        break;
+    case 0x31:
+        e.mov_imm(REG_SP, op.operand);
+        cycles += 3;
+        break;
+    case 0x02: case 0x12:
+        load_pair_address(opcode >> 3);
+        e.mov(E::RDX, REG_A);
+        write_byte();
+        check_stale(op.next_pc, cycles + 2);
+        cycles += 2;
+        break;
+    case 0x22: case 0x32:
+        e.mov(E::RSI, REG_HL);
+        e.mov(E::RDX, REG_A);
+        write_byte();
+        if (opcode == 0x22) {
+            e.inc16(REG_HL);
+        } else {
+            e.dec16(REG_HL);
+        }
+        check_stale(op.next_pc, cycles + 2);
+        cycles += 2;
+        break;
+    case 0x0A: case 0x1A:
+        load_pair_address((opcode >> 3) & 2);
+        read_byte();
+        e.mov(REG_A, E::RAX);
+        cycles += 2;
+        break;
+    case 0x2A: case 0x3A:
+        e.mov(E::RSI, REG_HL);
+        read_byte();
+        e.mov(REG_A, E::RAX);
+        if (opcode == 0x2A) {
+            e.inc16(REG_HL);
+        } else {
+            e.dec16(REG_HL);
+        }
+        cycles += 2;
+        break;
+    case 0x03: case 0x13: case 0x0B: case 0x1B: {
+        E::Mem pair = regs_field(offsetof(Registers, b) + ((opcode >> 3) & 2));
+        e.load16(E::RCX, pair);
+        e.shift16(E::SHIFT_ROL, E::RCX, 8);
+        if (opcode & 0x08) {
+            e.dec16(E::RCX);
+        } else {
+            e.inc16(E::RCX);
+        }
+        e.shift16(E::SHIFT_ROL, E::RCX, 8);
+        e.store16(pair, E::RCX);
+        cycles += 2;
+        break;
+    }
+    case 0x23: case 0x33:
+        e.inc16(opcode == 0x23 ? REG_HL : REG_SP);
+        cycles += 2;
+        break;
+    case 0x2B: case 0x3B:
+        e.dec16(opcode == 0x2B ? REG_HL : REG_SP);
+        cycles += 2;
+        break;
+    case 0x07: case 0x0F: case 0x17: case 0x1F: {
+        // Unlike their prefixed versions these clear Z
+        bool live = are_flags_live(ALL_FLAGS);
+        if (live) {
+            e.mov_imm(E::RDX, 0);
+        }
+        if (opcode >= 0x17) {
+            e.bt(REG_F, 4);
+        }
+        e.shift8(SHIFT_OPS[opcode >> 3], REG_A, 1);
+        if (live) {
+            e.setcc(E::COND_B, E::RDX);
+            e.shift(E::SHIFT_SHL, E::RDX, 4);
+            e.mov(REG_F, E::RDX);
+        }
+        cycles += 1;
+        break;
+    }
+    case 0x08:
+        e.mov_imm(E::RSI, op.operand);
+        e.mov(E::RDX, REG_SP);
+        write_word();
+        check_stale(op.next_pc, cycles + 5);
+        cycles += 5;
+        break;
+    case 0x2F:
+        e.alu_imm(E::ALU_XOR, REG_A, 0xFF);
+        if (are_flags_live(ICpu::N_FLAG | ICpu::H_FLAG)) {
+            e.alu_imm(E::ALU_OR, REG_F, ICpu::N_FLAG | ICpu::H_FLAG);
+        }
+        cycles += 1;
+        break;
+    case 0x37:
+        if (are_flags_live(ALL_FLAGS & ~ICpu::Z_FLAG)) {
+            e.alu_imm(E::ALU_AND, REG_F, ICpu::Z_FLAG);
+            e.alu_imm(E::ALU_OR, REG_F, ICpu::C_FLAG);
+        }
+        cycles += 1;
+        break;
+    case 0x3F:
+        if (are_flags_live(ALL_FLAGS & ~ICpu::Z_FLAG)) {
+            e.alu_imm(E::ALU_AND, REG_F, ICpu::Z_FLAG | ICpu::C_FLAG);
+            e.alu_imm(E::ALU_XOR, REG_F, ICpu::C_FLAG);
+        }
+        cycles += 1;
+        break;
+    case 0x18:
+        static_exit(get_relative_target(op.operand, op.next_pc), cycles + 3);
+        break;
+    case 0x20: case 0x28: case 0x30: case 0x38: {
+        E::Label not_taken;
+        skip_unless(opcode, not_taken);
+        static_exit(get_relative_target(op.operand, op.next_pc), cycles + 3);
+        e.bind(not_taken);
+        static_exit(op.next_pc, cycles + 2);
+        break;
+    }
+    case 0xC3:
+        static_exit(op.operand, cycles + 4);
+        break;
+    case 0xC2: case 0xCA: case 0xD2: case 0xDA: {
+        E::Label not_taken;
+        skip_unless(opcode, not_taken);
+        static_exit(op.operand, cycles + 4);
+        e.bind(not_taken);
+        static_exit(op.next_pc, cycles + 3);
+        break;
+    }
+    case 0xCD:
+        emit_call(op.next_pc);
+        check_stale_call(op, cycles + 6);
+        static_exit(op.operand, cycles + 6);
+        break;
+    case 0xC4: case 0xCC: case 0xD4: case 0xDC: {
+        E::Label not_taken;
+        skip_unless(opcode, not_taken);
+        emit_call(op.next_pc);
+        check_stale_call(op, cycles + 6);
+        static_exit(op.operand, cycles + 6);
+        e.bind(not_taken);
+        static_exit(op.next_pc, cycles + 3);
+        break;
+    }
+    case 0xC7: case 0xCF: case 0xD7: case 0xDF:
+    case 0xE7: case 0xEF: case 0xF7: case 0xFF:
+        emit_call(op.next_pc);
+        check_stale(opcode & 0x38, cycles + 4);
+        static_exit(opcode & 0x38, cycles + 4);
+        break;
+    case 0xC9:
+        emit_ret();
+        dynamic_exit(cycles + 4);
+        break;
+    case 0xC0: case 0xC8: case 0xD0: case 0xD8: {
+        E::Label not_taken;
+        skip_unless(opcode, not_taken);
+        emit_ret();
+        dynamic_exit(cycles + 5);
+        e.bind(not_taken);
+        static_exit(op.next_pc, cycles + 2);
+        break;
+    }
+    case 0xC1: case 0xD1: case 0xE1: case 0xF1: {
+        int high = opcode == 0xF1 ? GUEST_A : (opcode >> 3) & 6;
+        int low = opcode == 0xF1 ? GUEST_F : high + 1;
+        load_stack_address(0);
+        read_byte();
+        store_reg(low, E::RAX);
+        load_stack_address(1);
+        read_byte();
+        store_reg(high, E::RAX);
+        e.alu_imm(E::ALU_ADD, REG_SP, 2);
+        e.alu_imm(E::ALU_AND, REG_SP, 0xFFFF);
+        cycles += 3;
+        break;
+    }
+    case 0xC5: case 0xD5: case 0xE5: case 0xF5: {
+        int high = opcode == 0xF5 ? GUEST_A : (opcode >> 3) & 6;
+        int low = opcode == 0xF5 ? GUEST_F : high + 1;
+        load_stack_address(-1);
+        load_reg(high, E::RDX);
+        write_byte();
+        load_stack_address(-2);
+        load_reg(low, E::RDX);
+        write_byte();
+        e.alu_imm(E::ALU_SUB, REG_SP, 2);
+        e.alu_imm(E::ALU_AND, REG_SP, 0xFFFF);
+        check_stale(op.next_pc, cycles + 4);
+        cycles += 4;
+        break;
+    }
+    case 0xC6: case 0xCE: case 0xD6: case 0xDE:
+    case 0xE6: case 0xEE: case 0xF6: case 0xFE:
+        e.mov_imm(E::RCX, op.operand);
+        cycles += 2;
+        emit_alu(dst);
+        break;
+    case 0xE0: case 0xE2: case 0xEA:
+        if (opcode == 0xE2) {
+            load_reg(GUEST_C, E::RSI);
+            e.alu_imm(E::ALU_OR, E::RSI, 0xFF00);
+        } else {
+            e.mov_imm(E::RSI, opcode == 0xE0 ? 0xFF00 + (op.operand & 0xFF) : op.operand);
+        }
+        e.mov(E::RDX, REG_A);
+        write_byte();
+        check_stale(op.next_pc, cycles + (opcode == 0xEA ? 4 : 3));
+        cycles += opcode == 0xEA ? 4 : 3;
+        break;
+    case 0xF0: case 0xF2: case 0xFA:
+        if (opcode == 0xF2) {
+            load_reg(GUEST_C, E::RSI);
+            e.alu_imm(E::ALU_OR, E::RSI, 0xFF00);
+        } else {
+            e.mov_imm(E::RSI, opcode == 0xF0 ? 0xFF00 + (op.operand & 0xFF) : op.operand);
+        }
+        read_byte();
+        e.mov(REG_A, E::RAX);
+        cycles += opcode == 0xF0 ? 3 : opcode == 0xF2 ? 2 : 4;
+        break;
+    case 0xF9:
+        e.mov(REG_SP, REG_HL);
+        cycles += 2;
+        break;
+    default:
+        emit_interpreted(op);
+        break;
+    }
+}
+
+
+void JitCpu::Compiler::emit_prefixed(const Op& op) {
+    int reg = op.opcode & 7;
+    int sub_op = (op.opcode >> 3) & 7;
+    int kind = (op.opcode >> 6) & 3;
+
+    if (reg == GUEST_MHL) {
+        e.mov(E::RSI, REG_HL);
+        read_byte();
+    } else {
+        load_reg(reg, E::RAX);
+    }
+
+    switch (kind) {
+    case 0:
+        emit_shift(sub_op);
+        break;
+    case 1:
+        e.test8_imm(E::RAX, 1 << sub_op);
+        if (are_flags_live(ALL_FLAGS & ~ICpu::C_FLAG)) {
+            set_flags(ICpu::Z_FLAG, ICpu::H_FLAG, ICpu::C_FLAG);
+        }
+        break;
+    case 2:
+        e.alu_imm(E::ALU_AND, E::RAX, ~(1 << sub_op) & 0xFF);
+        break;
+    case 3:
+        e.alu_imm(E::ALU_OR, E::RAX, 1 << sub_op);
+        break;
+    }
+
+    // Like the handlers, bit writes the value at (HL) back
+    if (reg == GUEST_MHL) {
+        e.movzx8(E::RDX, E::RAX);
+        e.mov(E::RSI, REG_HL);
+        write_byte();
+        check_stale(op.next_pc, cycles + 4);
+        cycles += 4;
+    } else {
+        if (kind != 1) {
+            store_reg(reg, E::RAX);
+        }
+        cycles += 2;
+    }
+}
+
+
+// A op ECX
+void JitCpu::Compiler::emit_alu(int alu_op) {
+    if (alu_op == 3) {
+        emit_sbc();
+        return;
+    }
+
+    bool live = are_flags_live(ALL_FLAGS);
+    if (alu_op == 7 && !live) {
+        return;
+    }
+
+    if (alu_op == 1) {
+        e.bt(REG_F, 4);
+    }
+    e.alu8(ALU_OPS[alu_op], REG_A, E::RCX);
+
+    if (!live) {
+        return;
+    }
+
+    switch (alu_op) {
+    case 0: case 1:
+        set_flags(ICpu::Z_FLAG | ICpu::H_FLAG | ICpu::C_FLAG, 0, 0);
+        break;
+    case 2: case 7:
+        set_flags(ICpu::Z_FLAG | ICpu::H_FLAG | ICpu::C_FLAG, ICpu::N_FLAG, 0);
+        break;
+    case 4:
+        set_flags(ICpu::Z_FLAG, ICpu::H_FLAG, 0);
+        break;
+    default:
+        set_flags(ICpu::Z_FLAG, 0, 0);
+        break;
+    }
+}
+
+
+// The handler subtracts the operand minus the carry, with the carries of
+// that compared as ints. x86 has nothing alike, so it's done the long way.
+void JitCpu::Compiler::emit_sbc() {
+    bool live = are_flags_live(ALL_FLAGS);
+
+    e.mov(E::RDX, REG_F);
+    e.shift(E::SHIFT_SHR, E::RDX, 4);
+    e.alu_imm(E::ALU_AND, E::RDX, 1);
+    e.mov(E::RSI, E::RCX);
+    e.alu(E::ALU_SUB, E::RSI, E::RDX);
+
+    if (live) {
+        e.mov_imm(E::R8, 0);
+        e.alu(E::ALU_CMP, REG_A, E::RSI);
+        e.setcc(E::COND_L, E::R8);
+
+        e.mov_imm(E::R9, 0);
+        e.alu_imm(E::ALU_AND, E::RCX, 0xF);
+        e.alu(E::ALU_SUB, E::RCX, E::RDX);
+        e.mov(E::RDI, REG_A);
+        e.alu_imm(E::ALU_AND, E::RDI, 0xF);
+        e.alu(E::ALU_CMP, E::RDI, E::RCX);
+        e.setcc(E::COND_L, E::R9);
+
+        e.mov_imm(E::RAX, 0);
+    }
+
+    e.alu(E::ALU_SUB, REG_A, E::RSI);
+    e.alu_imm(E::ALU_AND, REG_A, 0xFF);
+
+    if (live) {
+        e.setcc(E::COND_E, E::RAX);
+        e.shift(E::SHIFT_SHL, E::RAX, 7);
+        e.shift(E::SHIFT_SHL, E::R9, 5);
+        e.shift(E::SHIFT_SHL, E::R8, 4);
+        e.alu(E::ALU_OR, E::RAX, E::R9);
+        e.alu(E::ALU_OR, E::RAX, E::R8);
+        e.alu_imm(E::ALU_OR, E::RAX, ICpu::N_FLAG);
+        e.mov(REG_F, E::RAX);
+    }
+}
+
+
+// On AL, rotates don't set x86's zero flag so it's tested for separately
+void JitCpu::Compiler::emit_shift(int shift_op) {
+    bool live = are_flags_live(ALL_FLAGS);
+    bool is_rotate = shift_op < 4;
+
+    if (live && is_rotate) {
+        e.mov_imm(E::RDX, 0);
+    }
+    if (shift_op == 2 || shift_op == 3) {
+        e.bt(REG_F, 4);
+    }
+    e.shift8(SHIFT_OPS[shift_op], E::RAX, shift_op == 6 ? 4 : 1);
+
+    if (!live) {
+        return;
+    }
+
+    if (is_rotate) {
+        e.setcc(E::COND_B, E::RDX);
+        e.test8(E::RAX, E::RAX);
+        set_flags(ICpu::Z_FLAG, 0, 0);
+        e.shift(E::SHIFT_SHL, E::RDX, 4);
+        e.alu(E::ALU_OR, REG_F, E::RDX);
+    } else if (shift_op == 6) {
+        e.test8(E::RAX, E::RAX);
+        set_flags(ICpu::Z_FLAG, 0, 0);
+    } else {
+        set_flags(ICpu::Z_FLAG | ICpu::C_FLAG, 0, 0);
+    }
+}
+
+
+void JitCpu::Compiler::emit_call(uint16_t return_pc) {
+    load_stack_address(-2);
+    e.mov_imm(E::RDX, return_pc);
+    write_word();
+    e.alu_imm(E::ALU_SUB, REG_SP, 2);
+    e.alu_imm(E::ALU_AND, REG_SP, 0xFFFF);
+}
+
+
+void JitCpu::Compiler::emit_ret() {
+    e.mov(E::RSI, REG_SP);
+    read_word();
+    e.store16(regs_field(offsetof(Registers, pc)), E::RAX);
+    e.alu_imm(E::ALU_ADD, REG_SP, 2);
+    e.alu_imm(E::ALU_AND, REG_SP, 0xFFFF);
+}
+
+
+// The handler fetches its own operands and takes its cycles from the budget
+void JitCpu::Compiler::emit_interpreted(const Op& op) {
+    store_registers(e);
+    e.store16_imm(regs_field(offsetof(Registers, pc)), op.operand_pc);
+    e.mov64(E::RDI, REG_CONTEXT);
+    e.mov_imm(E::RSI, op.opcode);
+    e.call(context_field(offsetof(Context, run_instruction)));
+    load_registers(e);
+
+    if (is_block_end(op.opcode)) {
+        dynamic_exit(cycles);
+    } else {
+        check_stale(op.next_pc, cycles);
+    }
+}
+
+
+// F = (x86 flags mapped to Z, H and C & from_host) | set | (F & kept)
+void JitCpu::Compiler::set_flags(int from_host, int set, int kept) {
+    e.lahf();
+    e.movzx_ah(E::RCX);
+    e.load8(E::RCX, E::mem(REG_CONTEXT, E::RCX, 1, offsetof(Context, flag_table)));
+    if (from_host != (ICpu::Z_FLAG | ICpu::H_FLAG | ICpu::C_FLAG)) {
+        e.alu_imm(E::ALU_AND, E::RCX, from_host);
+    }
+    if (set) {
+        e.alu_imm(E::ALU_OR, E::RCX, set);
+    }
+
+    if (kept) {
+        e.alu_imm(E::ALU_AND, REG_F, kept);
+        e.alu(E::ALU_OR, REG_F, E::RCX);
+    } else {
+        e.mov(REG_F, E::RCX);
+    }
+}
+
+
+// Zero extended into dst
+void JitCpu::Compiler::load_reg(int reg, int dst) {
+    switch (reg) {
+    case GUEST_H:
+        e.mov(dst, REG_HL);
+        e.shift(E::SHIFT_SHR, dst, 8);
+        break;
+    case GUEST_L:
+        e.movzx8(dst, REG_HL);
+        break;
+    case GUEST_A:
+        e.mov(dst, REG_A);
+        break;
+    case GUEST_F:
+        e.mov(dst, REG_F);
+        break;
+    default:
+        e.load8(dst, regs_field(offsetof(Registers, b) + reg));
+        break;
+    }
+}
+
+
+// From the low byte of src, which may be changed. Host flags are lost.
+void JitCpu::Compiler::store_reg(int reg, int src) {
+    switch (reg) {
+    case GUEST_H:
+        e.movzx8(src, src);
+        e.shift(E::SHIFT_SHL, src, 8);
+        e.alu_imm(E::ALU_AND, REG_HL, 0xFF);
+        e.alu(E::ALU_OR, REG_HL, src);
+        break;
+    case GUEST_L:
+        e.mov8(REG_HL, src);
+        break;
+    case GUEST_A:
+        e.movzx8(REG_A, src);
+        break;
+    case GUEST_F:
+        e.movzx8(REG_F, src);
+        break;
+    default:
+        e.store8(regs_field(offsetof(Registers, b) + reg), src);
+        break;
+    }
+}
+
+
+// BC or DE, which are stored high byte first
+void JitCpu::Compiler::load_pair_address(int high) {
+    e.load16(E::RSI, regs_field(offsetof(Registers, b) + high));
+    e.shift16(E::SHIFT_ROL, E::RSI, 8);
+}
+
+
+void JitCpu::Compiler::load_stack_address(int offset) {
+    e.mov(E::RSI, REG_SP);
+    if (offset) {
+        e.alu_imm(E::ALU_ADD, E::RSI, offset);
+        e.alu_imm(E::ALU_AND, E::RSI, 0xFFFF);
+    }
+}
+
+
+void JitCpu::Compiler::read_byte() {
+    SlowPath& slow_path = add_slow_path(SLOW_READ_BYTE);
+    e.mov(E::RAX, E::RSI);
+    e.shift(E::SHIFT_SHR, E::RAX, PAGE_SHIFT);
+    e.load64(E::RDX, context_field(offsetof(Context, read_pages)));
+    e.load64(E::RAX, E::mem(E::RDX, E::RAX, 8));
+    e.test64(E::RAX, E::RAX);
+    e.jcc(E::COND_E, slow_path.entry);
+    e.movzx8(E::RCX, E::RSI);
+    e.load8(E::RAX, E::mem(E::RAX, E::RCX, 1));
+    e.bind(slow_path.done);
+}
+
+
+// Like the MMU, words at the end of a page take the slow path
+void JitCpu::Compiler::read_word() {
+    SlowPath& slow_path = add_slow_path(SLOW_READ_WORD);
+    e.alu8_imm(E::ALU_CMP, E::RSI, 0xFF);
+    e.jcc(E::COND_E, slow_path.entry);
+    e.mov(E::RAX, E::RSI);
+    e.shift(E::SHIFT_SHR, E::RAX, PAGE_SHIFT);
+    e.load64(E::RDX, context_field(offsetof(Context, read_pages)));
+    e.load64(E::RAX, E::mem(E::RDX, E::RAX, 8));
+    e.test64(E::RAX, E::RAX);
+    e.jcc(E::COND_E, slow_path.entry);
+    e.movzx8(E::RCX, E::RSI);
+    e.load16(E::RAX, E::mem(E::RAX, E::RCX, 1));
+    e.bind(slow_path.done);
+}
+
+
+// Pages holding code take the slow path, through the tracker
+void JitCpu::Compiler::write_byte() {
+    SlowPath& slow_path = add_slow_path(SLOW_WRITE_BYTE);
+    e.mov(E::RAX, E::RSI);
+    e.shift(E::SHIFT_SHR, E::RAX, PAGE_SHIFT);
+    e.alu8_mem_imm(E::ALU_CMP, E::mem(REG_CONTEXT, E::RAX, 1, offsetof(Context, code_pages)), 0);
+    e.jcc(E::COND_NE, slow_path.entry);
+    e.load64(E::RCX, context_field(offsetof(Context, write_pages)));
+    e.load64(E::RAX, E::mem(E::RCX, E::RAX, 8));
+    e.test64(E::RAX, E::RAX);
+    e.jcc(E::COND_E, slow_path.entry);
+    e.movzx8(E::RCX, E::RSI);
+    e.store8(E::mem(E::RAX, E::RCX, 1), E::RDX);
+    e.bind(slow_path.done);
+}
+
+
+void JitCpu::Compiler::write_word() {
+    SlowPath& slow_path = add_slow_path(SLOW_WRITE_WORD);
+    e.alu8_imm(E::ALU_CMP, E::RSI, 0xFF);
+    e.jcc(E::COND_E, slow_path.entry);
+    e.mov(E::RAX, E::RSI);
+    e.shift(E::SHIFT_SHR, E::RAX, PAGE_SHIFT);
+    e.alu8_mem_imm(E::ALU_CMP, E::mem(REG_CONTEXT, E::RAX, 1, offsetof(Context, code_pages)), 0);
+    e.jcc(E::COND_NE, slow_path.entry);
+    e.load64(E::RCX, context_field(offsetof(Context, write_pages)));
+    e.load64(E::RAX, E::mem(E::RCX, E::RAX, 8));
+    e.test64(E::RAX, E::RAX);
+    e.jcc(E::COND_E, slow_path.entry);
+    e.movzx8(E::RCX, E::RSI);
+    e.store16(E::mem(E::RAX, E::RCX, 1), E::RDX);
+    e.bind(slow_path.done);
+}
+
+
+JitCpu::Compiler::SlowPath& JitCpu::Compiler::add_slow_path(int kind) {
+    uint32_t arg = cycles;
+    if (accessed) {
+        arg |= NO_BAIL;
+    }
+    accessed = true;
+
+    slow_paths.push_back({{}, {}, kind, arg, bail_exit});
+    return slow_paths.back();
+}
+
+
+size_t JitCpu::Compiler::add_exit(uint16_t pc, int exit_cycles) {
+    exits.push_back({{}, pc, exit_cycles});
+    return exits.size() - 1;
+}
+
+
+void JitCpu::Compiler::check_stale(uint16_t pc, int exit_cycles) {
+    size_t exit = add_exit(pc, exit_cycles);
+    e.alu8_mem_imm(E::ALU_CMP, context_field(offsetof(Context, stale)), 0);
+    e.jcc(E::COND_NE, exits[exit].label);
+}
+
+
+// The handler reads the target after pushing, which may have overwritten it
+void JitCpu::Compiler::check_stale_call(const Op& op, int exit_cycles) {
+    E::Label fresh;
+    e.alu8_mem_imm(E::ALU_CMP, context_field(offsetof(Context, stale)), 0);
+    e.jcc(E::COND_E, fresh);
+    e.mov_imm(E::RSI, op.operand_pc);
+    read_word();
+    e.store16(regs_field(offsetof(Registers, pc)), E::RAX);
+    dynamic_exit(exit_cycles);
+    e.bind(fresh);
+}
+
+
+// Goes to the link stub until execute() links it, or out of the block once
+// the budget is used up.
+void JitCpu::Compiler::static_exit(uint16_t pc, int exit_cycles) {
+    auto exit = std::make_unique<Exit>();
+    exit->owner = &block;
+    exit->target = nullptr;
+
+    E::Label link_stub;
+    E::Label out;
+    e.alu_mem_imm(E::ALU_SUB, context_field(offsetof(Context, budget)), exit_cycles);
+    e.jcc(E::COND_LE, out);
+    e.jmp(link_stub);
+    exit->jump = e.get_position() - 4;
+
+    e.bind(link_stub);
+    exit->link_stub = e.get_position();
+    e.mov64_imm(E::RAX, reinterpret_cast<uintptr_t>(exit.get()));
+    e.store64(context_field(offsetof(Context, link_exit)), E::RAX);
+
+    e.bind(out);
+    e.store16_imm(regs_field(offsetof(Registers, pc)), pc);
+    e.jmp(cpu.epilogue);
+
+    block.exits.push_back(std::move(exit));
+}
+
+
+// PC is already stored
+void JitCpu::Compiler::dynamic_exit(int exit_cycles) {
+    if (exit_cycles) {
+        e.alu_mem_imm(E::ALU_SUB, context_field(offsetof(Context, budget)), exit_cycles);
+    }
+    e.jmp(cpu.epilogue);
+}
+
+
+void JitCpu::Compiler::skip_unless(uint16_t opcode, E::Label& not_taken) {
+    int condition = (opcode >> 3) & 3;
+    e.test8_imm(REG_F, condition < 2 ? ICpu::Z_FLAG : ICpu::C_FLAG);
+    e.jcc(condition & 1 ? E::COND_E : E::COND_NE, not_taken);
+}
+
+
+// CPU only keeps a reference to its MMU, so it can be handed the tracker
+// before the tracker itself has been constructed.
+JitCpu::JitCpu(IMmu& mmu_in, Registers& regs_in, const Scheduler* scheduler_in,
+               Interrupts* interrupts_in)
+    : CPU(write_tracker, regs_in, scheduler_in, interrupts_in),
+    write_tracker(mmu_in, *this),
+    read_page_snapshot{},
+    write_page_snapshot{},
+    context{},
+    code_buffer(CODE_CACHE_SIZE),
+    enter{},
+    epilogue{},
+    runtime_size{},
+    code_size{},
+    flush_count{},
+    blocks{},
+    page_blocks{},
+    unlinks{},
+    error{} {
+    // MMUs without tables never remap their pages, so copies of them do
+    context.read_pages = mmu_in.get_read_page_table();
+    context.write_pages = mmu_in.get_write_page_table();
+    if (!context.read_pages || !context.write_pages) {
+        // Except for the IO registers, which are always accessed through it
+        for (int page = 0; page != NBR_PAGES - 1; ++page) {
+            read_page_snapshot[page] = mmu_in.get_read_page(page << PAGE_SHIFT);
+            write_page_snapshot[page] = mmu_in.get_write_page(page << PAGE_SHIFT);
+        }
+
+        context.read_pages = read_page_snapshot.data();
+        context.write_pages = write_page_snapshot.data();
+    }
+
+    context.cpu = this;
+    context.read_byte = read_byte_slow;
+    context.read_word = read_word_slow;
+    context.write_byte = write_byte_slow;
+    context.write_word = write_word_slow;
+    context.run_instruction = run_instruction;
+
+    // lahf puts ZF in bit 6, AF in bit 4 and CF in bit 0
+    for (int i = 0; i != 0x100; ++i) {
+        context.flag_table[i] = (i & 0x40 ? ICpu::Z_FLAG : 0) |
+            (i & 0x10 ? ICpu::H_FLAG : 0) |
+            (i & 0x01 ? ICpu::C_FLAG : 0);
+    }
+
+    emit_runtime();
+}
+
+
+int JitCpu::execute() {
+    return execute(std::numeric_limits<int>::max());
+}
+
+int JitCpu::execute(int max_cycles) {
+    // The instruction after ei has to run on its own, interrupts may be
+    // dispatched right after it.
+    if (is_uncached(regs.pc) || halted || ime_pending) {
+        return CPU::execute(max_cycles);
+    }
+
+    if (int interrupt_cycles = handle_interrupts(max_cycles)) {
+        cycles += interrupt_cycles;
+        return interrupt_cycles;
+    }
+
+    // A block that might not be done in time runs one instruction at a time
+    Block* block = get_block(regs.pc);
+    if (!block->code || block->max_cycles > max_cycles) {
+        return CPU::execute(max_cycles);
+    }
+
+    // Blocks start while the budget lasts, it runs out early enough for the
+    // longest block to be done within max_cycles.
+    sync_registers();
+    int latest_start = max_cycles - MAX_BLOCK_OPS * MAX_INSTRUCTION_CYCLES + 1;
+    int budget = std::clamp(latest_start, 1, get_run_budget());
+    context.budget = budget;
+    context.start_budget = budget;
+
+    while (true) {
+        context.stale = 0;
+        context.stop = 0;
+        context.link_exit = nullptr;
+        apply_unlinks();
+        code_buffer.make_executable();
+        enter(&context, &regs, block->code);
+
+        if (context.stop || context.budget <= 0 || is_uncached(regs.pc)) {
+            break;
+        }
+
+        // A stale run may have left through an exit that is gone
+        Exit* exit = context.stale ? nullptr : context.link_exit;
+        unsigned flushes = flush_count;
+        block = get_block(regs.pc);
+        if (!block->code) {
+            break;
+        }
+
+        if (exit && flush_count == flushes) {
+            link(*exit, *block);
+        }
+    }
+
+    int executed = budget - context.budget;
+    cycles += executed;
+    if (error) {
+        std::rethrow_exception(std::exchange(error, nullptr));
+    }
+
+    return executed;
+}
+
+
+void JitCpu::load_state(StateReader& reader) {
+    CPU::load_state(reader);
+    flush();
+}
+
+
+// enter(context, regs, code) saves what the ABI has callees preserve, loads
+// the guest registers and jumps to code. Blocks jump to the epilogue, which
+// stores the registers and returns from enter().
+void JitCpu::emit_runtime() {
+    static const int SAVED_REGS[] = {E::RBX, E::RBP, E::R12, E::R13, E::R14, E::R15};
+
+    code_buffer.make_writable();
+    X64Emitter e(code_buffer.get_data(), code_buffer.get_size());
+
+    for (int reg : SAVED_REGS) {
+        e.push(reg);
+    }
+    // Keeps the stack 16 byte aligned for calls from generated code
+    e.alu64_imm(E::ALU_SUB, E::RSP, 8);
+    e.mov64(REG_CONTEXT, E::RDI);
+    e.mov64(REG_REGS, E::RSI);
+    load_registers(e);
+    e.jmp(E::RDX);
+
+    epilogue = e.get_position();
+    store_registers(e);
+    e.alu64_imm(E::ALU_ADD, E::RSP, 8);
+    for (int i = std::size(SAVED_REGS); i--; ) {
+        e.pop(SAVED_REGS[i]);
+    }
+    e.ret();
+
+    enter = reinterpret_cast<EnterFunction>(code_buffer.get_data());
+    runtime_size = e.get_size();
+    code_size = runtime_size;
+}
+
+
+int JitCpu::get_run_budget() const {
+    if (!scheduler) {
+        return MAX_RUN_CYCLES;
+    }
+
+    uint64_t time = scheduler->get_time();
+    uint64_t next_event_time = scheduler->get_next_event_time();
+    if (next_event_time == Scheduler::NEVER) {
+        return MAX_RUN_CYCLES;
+    }
+
+    // An event that is already due still lets one block run
+    if (next_event_time <= time) {
+        return 1;
+    }
+
+    return static_cast<int>(std::min<uint64_t>(next_event_time - time, MAX_RUN_CYCLES));
+}
+
+
+JitCpu::Block* JitCpu::get_block(uint16_t pc) {
+    uint32_t key = (static_cast<uint32_t>(mmu.get_bank(pc)) << 16) + pc;
+    auto it = blocks.find(key);
+    if (it != blocks.end()) {
+        return it->second.get();
+    }
+
+    auto block = std::make_unique<Block>();
+    block->key = key;
+    block->start_pc = pc;
+    block->code = nullptr;
+
+    std::vector<Op> ops = decode_block(*block);
+    block->max_cycles = static_cast<int>(ops.size()) * MAX_INSTRUCTION_CYCLES;
+    if (!ops.empty()) {
+        compile_block(*block, ops);
+    }
+
+    for (int page = block->start_pc >> PAGE_SHIFT;
+         page <= (block->end_pc - 1) >> PAGE_SHIFT;
+         ++page) {
+        page_blocks[page].push_back(key);
+        update_code_page(page);
+    }
+
+    Block* compiled = block.get();
+    blocks.emplace(key, std::move(block));
+    return compiled;
+}
+
+
+// Blocks end like the cached interpreter's, or right before an undefined
+// instruction, which is left to the interpreter to throw for.
+std::vector<JitCpu::Op> JitCpu::decode_block(Block& block) {
+    std::vector<Op> ops;
+
+    int addr = block.start_pc;
+    for (int i = 0; i != MAX_BLOCK_OPS; ++i) {
+        Op op{};
+        op.pc = addr;
+        op.opcode = mmu.read_byte(addr);
+
+        int length = get_opcode_length(op.opcode);
+        if (op.opcode == PREFIX_CB) {
+            op.opcode = 0x100 + mmu.read_byte(addr + 1);
+            op.operand_pc = addr + 2;
+        } else {
+            op.operand_pc = addr + 1;
+            if (length == 2) {
+                op.operand = mmu.read_byte(addr + 1);
+            } else if (length == 3) {
+                op.operand = mmu.read_word(addr + 1);
+            }
+        }
+
+        if (is_undefined(op.opcode)) {
+            // Still covered, so the block is dropped once the byte changes
+            addr += ops.empty();
+            break;
+        }
+
+        addr += length;
+        op.next_pc = addr;
+        ops.push_back(op);
+
+        if (is_block_end(op.opcode) || addr > 0xFFFF || is_uncached(addr)) {
+            break;
+        }
+    }
+
+    block.end_pc = std::min(addr, 0x10000);
+    return ops;
+}
+
+
+void JitCpu::compile_block(Block& block, const std::vector<Op>& ops) {
+    code_buffer.make_writable();
+
+    std::unique_ptr<Compiler> compiler = std::make_unique<Compiler>(*this, block, ops);
+    if (!compiler->compile()) {
+        // Nothing is reclaimed until the cache is full, then all of it is
+        flush();
+        block.exits.clear();
+        compiler = std::make_unique<Compiler>(*this, block, ops);
+        compiler->compile();
+    }
+
+    block.code = code_buffer.get_data() + code_size;
+    code_size += compiler->get_size();
+}
+
+
+// Only within a bank, banks of code that is running are never switched
+// away, but they may be later and blocks don't know about each other.
+void JitCpu::link(Exit& exit, Block& target) {
+    if ((exit.owner->key >> 16) != (target.key >> 16)) {
+        return;
+    }
+
+    apply_unlinks();
+    code_buffer.make_writable();
+    X64Emitter::patch_jump(exit.jump, target.code);
+    exit.target = &target;
+    target.incoming.push_back(&exit);
+}
+
+
+void JitCpu::apply_unlinks() {
+    if (unlinks.empty()) {
+        return;
+    }
+
+    code_buffer.make_writable();
+    for (const auto& [jump, link_stub] : unlinks) {
+        X64Emitter::patch_jump(jump, link_stub);
+    }
+    unlinks.clear();
+}
+
+
+void JitCpu::invalidate(uint16_t addr) {
+    remove_blocks_at(addr);
+    uint16_t mirror = get_echo_mirror(addr);
+    if (mirror != addr) {
+        remove_blocks_at(mirror);
+    }
+}
+
+void JitCpu::remove_blocks_at(uint16_t addr) {
+    std::vector<uint32_t>& keys = page_blocks[addr >> PAGE_SHIFT];
+
+    std::size_t i = 0;
+    while (i < keys.size()) {
+        const Block& block = *blocks.at(keys[i]);
+        if (addr >= block.start_pc && addr < block.end_pc) {
+            // Also erases the key from this page, the next one moves into i.
+            remove_block(keys[i]);
+        } else {
+            ++i;
+        }
+    }
+}
+
+
+// May run from within generated code, which can't be written to until it
+// returns. Its code stays around until the cache is flushed.
+void JitCpu::remove_block(uint32_t key) {
+    auto it = blocks.find(key);
+    Block& block = *it->second;
+
+    for (int page = block.start_pc >> PAGE_SHIFT;
+         page <= (block.end_pc - 1) >> PAGE_SHIFT;
+         ++page) {
+        std::vector<uint32_t>& keys = page_blocks[page];
+        auto key_it = std::find(keys.begin(), keys.end(), key);
+        *key_it = keys.back();
+        keys.pop_back();
+        update_code_page(page);
+    }
+
+    for (const std::unique_ptr<Exit>& exit : block.exits) {
+        if (exit->target && exit->target != &block) {
+            std::vector<Exit*>& incoming = exit->target->incoming;
+            incoming.erase(std::find(incoming.begin(), incoming.end(), exit.get()));
+        }
+    }
+
+    for (Exit* exit : block.incoming) {
+        if (exit->owner != &block) {
+            unlinks.emplace_back(exit->jump, exit->link_stub);
+            exit->target = nullptr;
+        }
+    }
+
+    blocks.erase(it);
+    context.stale = 1;
+}
+
+
+// Generated code writes to a page itself unless code at the page or its echo
+// has to be invalidated first.
+void JitCpu::update_code_page(int page) {
+    int mirror = get_echo_mirror(page << PAGE_SHIFT) >> PAGE_SHIFT;
+    uint8_t has_code = !page_blocks[page].empty() || !page_blocks[mirror].empty();
+    context.code_pages[page] = has_code;
+    context.code_pages[mirror] = has_code;
+}
+
+
+void JitCpu::flush() {
+    blocks.clear();
+    for (std::vector<uint32_t>& keys : page_blocks) {
+        keys.clear();
+    }
+    std::fill(std::begin(context.code_pages), std::end(context.code_pages), 0);
+
+    unlinks.clear();
+    code_size = runtime_size;
+    ++flush_count;
+}
+
+
+uint32_t JitCpu::read_byte_slow(Context* context, uint32_t addr, uint32_t arg) {
+    if (must_bail(*context, addr, arg)) {
+        return BAIL;
+    }
+
+    try {
+        return context->cpu->write_tracker.read_byte(addr);
+    } catch (...) {
+        fail(*context);
+        return BAIL;
+    }
+}
+
+
+uint32_t JitCpu::read_word_slow(Context* context, uint32_t addr, uint32_t arg) {
+    if (must_bail(*context, addr, arg)) {
+        return BAIL;
+    }
+
+    try {
+        return context->cpu->write_tracker.read_word(addr);
+    } catch (...) {
+        fail(*context);
+        return BAIL;
+    }
+}
+
+
+// Writes to IO registers may raise interrupts or move events, so the run
+// ends after them.
+uint32_t JitCpu::write_byte_slow(Context* context, uint32_t addr, uint32_t val, uint32_t arg) {
+    if (must_bail(*context, addr, arg)) {
+        return BAIL;
+    }
+
+    try {
+        context->cpu->write_tracker.write_byte(addr, val);
+    } catch (...) {
+        fail(*context);
+        return BAIL;
+    }
+
+    if (is_uncached(addr)) {
+        context->stop = 1;
+        context->stale = 1;
+    }
+    return 0;
+}
+
+
+uint32_t JitCpu::write_word_slow(Context* context, uint32_t addr, uint32_t val, uint32_t arg) {
+    if (must_bail(*context, addr, arg)) {
+        return BAIL;
+    }
+
+    try {
+        context->cpu->write_tracker.write_word(addr, val);
+    } catch (...) {
+        fail(*context);
+        return BAIL;
+    }
+
+    if (is_uncached(addr) || is_uncached(addr + 1)) {
+        context->stop = 1;
+        context->stale = 1;
+    }
+    return 0;
+}
+
+
+void JitCpu::run_instruction(Context* context, uint32_t opcode) {
+    JitCpu& cpu = *context->cpu;
+    bool ime = cpu.ime;
+
+    try {
+        context->budget -= cpu.instructions[opcode]();
+        cpu.sync_registers();
+    } catch (...) {
+        fail(*context);
+        return;
+    }
+
+    // Interrupts may be dispatched after these
+    if (cpu.halted || cpu.ime_pending || cpu.ime != ime) {
+        context->stop = 1;
+        context->stale = 1;
+    }
+}
+
+
+// IO registers are accessed at the time the run started at, which only holds
+// for its first instruction. Except for IF and LY, which only change with
+// events, and no event is due before the budget is used up. The run ends
+// before an instruction that bails, the next one starts with it.
+bool JitCpu::must_bail(Context& context, uint16_t addr, uint32_t arg) {
+    if ((arg & NO_BAIL) || !is_uncached(addr)) {
+        return false;
+    }
+
+    int elapsed = context.start_budget - context.budget + static_cast<int>(arg & CYCLES_MASK);
+    bool bail = is_event_driven(addr) ? elapsed >= context.start_budget : elapsed > 0;
+    if (bail) {
+        context.stop = 1;
+    }
+
+    return bail;
+}
+
+
+void JitCpu::fail(Context& context) {
+    context.cpu->error = std::current_exception();
+    context.stop = 1;
+    context.stale = 1;
+}
+
+
+}
+
+#endif
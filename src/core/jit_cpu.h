@@ -0,0 +1,162 @@
+#pragma once
+
+#include "x64_emitter.h"
+
+#ifdef GEEMUBOI_HAS_JIT
+
+#include "cpu.h"
+#include "write_tracker.h"
+
+#include <array>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace geemuboi::core {
+
+
+// Recompiles guest basic blocks into x86-64 code and runs them chained
+// together until the scheduler's next event is due.
+//
+// A, F, HL and SP live in host registers while generated code runs, F is
+// only computed where an instruction later in the block can see it. Memory
+// accesses go straight to the MMU's pages and only call back into C++ for
+// pages without one, or pages holding code so the tracker sees the write.
+// Accesses to IO registers end the run early unless they happen at the time
+// execute() was called at, so the hardware sees them at the right time.
+//
+// Instructions that are rare or too irregular to be worth it are run by the
+// regular handlers from within the generated code.
+class JitCpu : public CPU {
+public:
+    JitCpu(IMmu& mmu_in, Registers& regs_in, const Scheduler* scheduler_in = nullptr,
+           Interrupts* interrupts_in = nullptr);
+
+    int execute();
+    int execute(int max_cycles);
+    // Memory may have changed behind the tracker's back, every block is dropped
+    void load_state(StateReader& reader);
+private:
+    friend class WriteTracker<JitCpu>;
+    class Compiler;
+
+    struct Op {
+        uint16_t pc;
+        uint16_t opcode;
+        uint16_t operand;
+        uint16_t operand_pc;
+        uint16_t next_pc;
+    };
+
+    struct Block;
+
+    // A jump out of a block to a fixed PC. Until it is linked it goes to a
+    // stub that hands the exit to execute(), which then points it straight
+    // at the target block.
+    struct Exit {
+        Block* owner;
+        Block* target;
+        uint8_t* jump;
+        const uint8_t* link_stub;
+    };
+
+    struct Block {
+        uint32_t key;
+        uint16_t start_pc;
+        int end_pc;
+        // At the most, taking every branch
+        int max_cycles;
+        // nullptr if the block starts with an undefined instruction
+        const uint8_t* code;
+
+        std::vector<std::unique_ptr<Exit>> exits;
+        std::vector<Exit*> incoming;
+    };
+
+    // Everything the generated code reads or writes besides the registers,
+    // addressed relative to a host register.
+    struct Context {
+        // Blocks only chain while the budget lasts
+        int32_t budget;
+        int32_t start_budget;
+        // A block was removed, the running one may be gone
+        uint8_t stale;
+        // The run has to end after the current instruction
+        uint8_t stop;
+
+        const uint8_t* const* read_pages;
+        uint8_t* const* write_pages;
+        Exit* link_exit;
+        JitCpu* cpu;
+
+        uint32_t (*read_byte)(Context* context, uint32_t addr, uint32_t arg);
+        uint32_t (*read_word)(Context* context, uint32_t addr, uint32_t arg);
+        uint32_t (*write_byte)(Context* context, uint32_t addr, uint32_t val, uint32_t arg);
+        uint32_t (*write_word)(Context* context, uint32_t addr, uint32_t val, uint32_t arg);
+        void (*run_instruction)(Context* context, uint32_t opcode);
+
+        // Non-zero for pages any block was decoded from, or their echo
+        uint8_t code_pages[0x100];
+        // lahf's flags to Z, H and C
+        uint8_t flag_table[0x100];
+    };
+
+    using EnterFunction = void (*)(Context* context, Registers* regs, const uint8_t* code);
+
+    static constexpr int MAX_BLOCK_OPS = 32;
+    static constexpr int MAX_RUN_CYCLES = 1024;
+    static constexpr int PAGE_SHIFT = 8;
+    static constexpr int NBR_PAGES = 0x100;
+    static constexpr size_t CODE_CACHE_SIZE = 4 << 20;
+
+    void emit_runtime();
+    int get_run_budget() const;
+    Block* get_block(uint16_t pc);
+    std::vector<Op> decode_block(Block& block);
+    void compile_block(Block& block, const std::vector<Op>& ops);
+    void link(Exit& exit, Block& target);
+    void apply_unlinks();
+    void invalidate(uint16_t addr);
+    void remove_blocks_at(uint16_t addr);
+    void remove_block(uint32_t key);
+    void update_code_page(int page);
+    void flush();
+
+    static uint32_t read_byte_slow(Context* context, uint32_t addr, uint32_t arg);
+    static uint32_t read_word_slow(Context* context, uint32_t addr, uint32_t arg);
+    static uint32_t write_byte_slow(Context* context, uint32_t addr, uint32_t val, uint32_t arg);
+    static uint32_t write_word_slow(Context* context, uint32_t addr, uint32_t val, uint32_t arg);
+    static void run_instruction(Context* context, uint32_t opcode);
+    static bool must_bail(Context& context, uint16_t addr, uint32_t arg);
+    static void fail(Context& context);
+
+    WriteTracker<JitCpu> write_tracker;
+
+    std::array<const uint8_t*, NBR_PAGES> read_page_snapshot;
+    std::array<uint8_t*, NBR_PAGES> write_page_snapshot;
+    Context context;
+
+    CodeBuffer code_buffer;
+    EnterFunction enter;
+    const uint8_t* epilogue;
+    size_t runtime_size;
+    size_t code_size;
+    unsigned flush_count;
+
+    std::unordered_map<uint32_t, std::unique_ptr<Block>> blocks;
+    std::array<std::vector<uint32_t>, NBR_PAGES> page_blocks;
+    // Jumps to removed blocks, pointed back at their link stubs once the
+    // generated code has returned and the cache can be written again.
+    std::vector<std::pair<uint8_t*, const uint8_t*>> unlinks;
+
+    // Thrown by a handler called from generated code, rethrown once out of it
+    std::exception_ptr error;
+};
+
+
+}
+
+#endif
@@ -0,0 +1,79 @@
+#include "core/link_cable.h"
+
+#include "core/scheduler.h"
+#include "core/serial.h"
+
+#include <algorithm>
+
+namespace geemuboi::core {
+
+
+LinkCable::LinkCable(Machine& first_in, Machine& second_in) : machines{&first_in, &second_in},
+    first_sink(second_in.get_serial()),
+    second_sink(first_in.get_serial()) {
+
+    first_in.set_serial_sink(&first_sink);
+    second_in.set_serial_sink(&second_sink);
+}
+
+LinkCable::~LinkCable() {
+    for (Machine* machine : machines) {
+        machine->set_serial_sink(nullptr);
+    }
+}
+
+void LinkCable::step_frame() {
+    bool done[NBR_MACHINES] = {};
+    uint64_t limits[NBR_MACHINES];
+    for (int i = 0; i != NBR_MACHINES; ++i) {
+        limits[i] = machines[i]->get_time() + Machine::MAX_FRAME_CYCLES;
+    }
+
+    while (!done[0] || !done[1]) {
+        uint64_t target = get_round_target();
+        int first = get_first_in_round(target);
+        for (int i : {first, 1 - first}) {
+            Machine& machine = *machines[i];
+            Machine& other = *machines[1 - i];
+            bool needed = !done[i] || other.get_time() >= target ||
+                          other.get_serial().get_transfer_end_time() <= target;
+            if (needed) {
+                done[i] |= machine.run_until(target) || machine.get_time() >= limits[i];
+            }
+        }
+    }
+}
+
+void LinkCable::run_until(uint64_t time) {
+    while (machines[0]->get_time() < time || machines[1]->get_time() < time) {
+        uint64_t target = std::min(get_round_target(), time);
+        int first = get_first_in_round(target);
+        for (int i : {first, 1 - first}) {
+            // Finished frames don't matter here
+            while (machines[i]->run_until(target)) {}
+        }
+    }
+}
+
+uint64_t LinkCable::get_horizon(int index) const {
+    const Machine& machine = *machines[index];
+    uint64_t transfer_end = machine.get_serial().get_transfer_end_time();
+    if (transfer_end != Scheduler::NEVER) {
+        return transfer_end;
+    }
+
+    // A transfer started by the next instruction completes this late at the
+    // earliest, the other machine has to stop short of it.
+    return machine.get_time() + Serial::TRANSFER_CYCLES - 1;
+}
+
+uint64_t LinkCable::get_round_target() const {
+    return std::min(get_horizon(0), get_horizon(1));
+}
+
+int LinkCable::get_first_in_round(uint64_t target) const {
+    return machines[0]->get_serial().get_transfer_end_time() <= target ? 1 : 0;
+}
+
+
+}
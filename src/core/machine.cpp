@@ -0,0 +1,223 @@
+#include "core/machine.h"
+
+#include "core/hash.h"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+namespace geemuboi::core {
+
+using namespace geemuboi::view;
+
+
+Machine::FrameRenderer::FrameRenderer() : pixels{}, frame_done{}, hash_frames{}, frame_hash{} {}
+
+uint32_t* Machine::FrameRenderer::lock_frame(int& pitch) {
+    pitch = SCREEN_WIDTH;
+    return pixels;
+}
+
+void Machine::FrameRenderer::unlock_frame() {
+    frame_done = true;
+    if (hash_frames) {
+        frame_hash = hash_bytes(pixels, sizeof(pixels));
+    }
+}
+
+
+Machine::Machine(const std::vector<uint8_t>& rom, const std::vector<uint8_t>& bios,
+                 CpuType cpu_type) : renderer{},
+    audio_sink{},
+    scheduler{},
+    interrupts{},
+    gpu(renderer, scheduler, interrupts),
+    input{},
+    timer(scheduler, interrupts),
+    serial(scheduler, interrupts),
+    apu(scheduler, audio_sink),
+    mmu(gpu, input, interrupts, timer, serial, scheduler, apu, bios, rom),
+    regs{},
+    cpu{create_cpu(mmu, regs, cpu_type, &scheduler, &interrupts)},
+    frames{},
+    state_size{} {
+
+    if (bios.empty()) {
+        skip_bios();
+    }
+
+    state_size = save_state().size();
+}
+
+void Machine::skip_bios() {
+    regs.a = 0x01;
+    regs.f = 0xB0;
+    regs.b = 0x00;
+    regs.c = 0x13;
+    regs.d = 0x00;
+    regs.e = 0xD8;
+    regs.h = 0x01;
+    regs.l = 0x4D;
+    regs.sp = 0xFFFE;
+    regs.pc = 0x0100;
+
+    // Sound on with the boot chime's channel 1 settings left behind, the
+    // display on with the usual palettes
+    const std::pair<uint16_t, uint8_t> IO_REGISTERS[] = {
+        {0xFF26, 0xF1}, {0xFF11, 0x80}, {0xFF12, 0xF3}, {0xFF24, 0x77}, {0xFF25, 0xF3},
+        {0xFF40, 0x91}, {0xFF47, 0xFC}, {0xFF48, 0xFF}, {0xFF49, 0xFF}
+    };
+    for (const auto& [addr, val] : IO_REGISTERS) {
+        mmu.write_byte(addr, val);
+    }
+}
+
+void Machine::step_frame() {
+    renderer.frame_done = false;
+
+    int frame_cycles = 0;
+    while (!renderer.frame_done && frame_cycles < MAX_FRAME_CYCLES) {
+        int cycles = cpu->execute();
+        scheduler.advance(cycles);
+        frame_cycles += cycles;
+    }
+
+    ++frames;
+}
+
+bool Machine::run_until(uint64_t time) {
+    renderer.frame_done = false;
+    while (!renderer.frame_done && scheduler.get_time() < time) {
+        uint64_t max_cycles = std::min<uint64_t>(time - scheduler.get_time(),
+                                                 std::numeric_limits<int>::max());
+        scheduler.advance(cpu->execute(static_cast<int>(max_cycles)));
+    }
+
+    if (renderer.frame_done) {
+        ++frames;
+    }
+
+    return renderer.frame_done;
+}
+
+uint64_t Machine::get_time() const {
+    return scheduler.get_time();
+}
+
+void Machine::set_buttons(uint8_t buttons) {
+    // Pressed buttons read as 0, one column for actions and one for directions
+    uint8_t actions = 0xF;
+    actions &= buttons & BUTTON_A ? Input::BUTTON_A : 0xF;
+    actions &= buttons & BUTTON_B ? Input::BUTTON_B : 0xF;
+    actions &= buttons & BUTTON_SELECT ? Input::BUTTON_SELECT : 0xF;
+    actions &= buttons & BUTTON_START ? Input::BUTTON_START : 0xF;
+
+    uint8_t directions = 0xF;
+    directions &= buttons & BUTTON_RIGHT ? Input::BUTTON_RIGHT : 0xF;
+    directions &= buttons & BUTTON_LEFT ? Input::BUTTON_LEFT : 0xF;
+    directions &= buttons & BUTTON_UP ? Input::BUTTON_UP : 0xF;
+    directions &= buttons & BUTTON_DOWN ? Input::BUTTON_DOWN : 0xF;
+
+    input.set_buttons_pressed(0, actions);
+    input.set_buttons_pressed(1, directions);
+}
+
+void Machine::set_serial_sink(SerialSink* sink) {
+    serial.set_sink(sink);
+}
+
+Serial& Machine::get_serial() {
+    return serial;
+}
+
+const Serial& Machine::get_serial() const {
+    return serial;
+}
+
+Input& Machine::get_input() {
+    return input;
+}
+
+Scheduler& Machine::get_scheduler() {
+    return scheduler;
+}
+
+const uint32_t* Machine::get_framebuffer() const {
+    return renderer.pixels;
+}
+
+uint64_t Machine::get_frame_count() const {
+    return frames;
+}
+
+void Machine::set_frame_hashing(bool enabled) {
+    renderer.hash_frames = enabled;
+}
+
+uint64_t Machine::get_frame_hash() const {
+    return renderer.frame_hash;
+}
+
+void Machine::copy_ram(uint8_t* out) const {
+    std::copy_n(mmu.get_wram(), MMU::WRAM_SIZE, out);
+    std::copy_n(mmu.get_hram(), MMU::HRAM_SIZE, out + MMU::WRAM_SIZE);
+}
+
+std::vector<uint8_t> Machine::save_state() const {
+    StateWriter writer;
+    writer.reserve(state_size);
+    writer.write(STATE_MAGIC);
+    writer.write(STATE_VERSION);
+
+    scheduler.save_state(writer);
+    interrupts.save_state(writer);
+    gpu.save_state(writer);
+    input.save_state(writer);
+    timer.save_state(writer);
+    serial.save_state(writer);
+    apu.save_state(writer);
+    mmu.save_state(writer);
+    cpu->save_state(writer);
+
+    writer.write(frames);
+    // The frame being drawn, lines already drawn are not drawn again
+    writer.write(renderer.pixels);
+
+    return writer.release();
+}
+
+size_t Machine::get_state_size() const {
+    return state_size;
+}
+
+void Machine::load_state(const uint8_t* data, size_t size) {
+    StateReader reader(data, size);
+    uint32_t magic;
+    uint32_t version;
+    reader.read(magic);
+    reader.read(version);
+    if (magic != STATE_MAGIC || version != STATE_VERSION) {
+        throw InvalidStateException("The save state is not from this version.");
+    }
+
+    // Every state of a build has the same size
+    if (size != state_size) {
+        throw InvalidStateException("The save state has the wrong size.");
+    }
+
+    scheduler.load_state(reader);
+    interrupts.load_state(reader);
+    gpu.load_state(reader);
+    input.load_state(reader);
+    timer.load_state(reader);
+    serial.load_state(reader);
+    apu.load_state(reader);
+    mmu.load_state(reader);
+    cpu->load_state(reader);
+
+    reader.read(frames);
+    reader.read(renderer.pixels);
+}
+
+
+}
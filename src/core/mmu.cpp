@@ -1,50 +1,76 @@
 #include "core/mmu.h"
 
+#include <algorithm>
+#include <cstring>
 #include <fstream>
+#include <iterator>
 #include <iostream>
 
 namespace geemuboi::core {
 
+namespace {
 
-MMU::MMU(GPU& gpu_in, Input& input_in, const std::string& bios_file, const std::string& rom_file) : 
+std::vector<uint8_t> read_file(const std::string& file, const std::string& description,
+                               bool required) {
+    std::ifstream ifs(file, std::ios::binary);
+    if (!ifs) {
+        std::cout << "Could not open " << description << " file" << std::endl;
+        if (required) {
+            exit(1);
+        }
+
+        return {};
+    }
+
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+}
+
+}
+
+
+MMU::MMU(GPU& gpu_in, Input& input_in, Interrupts& interrupts_in, Timer& timer_in,
+         Serial& serial_in, Scheduler& scheduler_in, APU& apu_in,
+         const std::string& bios_file, const std::string& rom_file) :
+    MMU(gpu_in, input_in, interrupts_in, timer_in, serial_in, scheduler_in, apu_in,
+        read_file(bios_file, "bios", false), read_file(rom_file, "rom", true)) {}
+
+MMU::MMU(GPU& gpu_in, Input& input_in, Interrupts& interrupts_in, Timer& timer_in,
+         Serial& serial_in, Scheduler& scheduler_in, APU& apu_in,
+         const std::vector<uint8_t>& bios_in, const std::vector<uint8_t>& rom_in) :
     gpu(gpu_in), 
     input(input_in),
-    in_bios{true},
+    interrupts(interrupts_in),
+    timer(timer_in),
+    serial(serial_in),
+    scheduler(scheduler_in),
+    apu(apu_in),
+    in_bios{!bios_in.empty()},
     bios{},
     rom{},
     eram{},
     wram{},
-    hram{} {
-
-    // TODO helper function for reading files
-    std::ifstream ifs(bios_file);
-
-    if (!ifs) {
-        std::cout << "Could not open bios file" << std::endl;
-    } else {
-        int byte;
-        for (int i = 0; (byte = ifs.get()) != EOF; i++) {
-            bios[i] = static_cast<uint8_t>(byte);
-        }
-    }
-
-    ifs.close();
+    hram{},
+    read_pages{},
+    write_pages{},
+    dma_active{},
+    dma_source{},
+    dma_open_bus{},
+    dma_ignored_writes{} {
 
-    std::ifstream ifs2(rom_file);
-    if (!ifs2) {
-        std::cout << "Could not open rom file" << std::endl;
-        exit(1);
-    }
+    std::fill(std::begin(dma_open_bus), std::end(dma_open_bus), 0xFF);
+    scheduler.set_handler(Scheduler::EVENT_DMA, [this]() { end_dma(); });
 
-    int byte;
-    for (int i = 0; (byte = ifs2.get()) != EOF; i++) {
-        rom[i] = static_cast<uint8_t>(byte);
-    }
+    std::copy_n(bios_in.begin(), std::min(bios_in.size(), sizeof(bios)), bios);
+    std::copy_n(rom_in.begin(), std::min(rom_in.size(), sizeof(rom)), rom);
 
-    ifs2.close();
+    map_pages();
 }
 
 uint8_t MMU::read_byte(uint16_t addr) {
+    if (const uint8_t* page = read_pages[addr >> PAGE_SHIFT]) {
+        return page[addr & PAGE_MASK];
+    }
+
     switch (get_area(addr)) {
     case AREA_BIOS: return bios[addr];
     case AREA_ROM0: return rom[addr];
@@ -58,26 +84,41 @@ uint8_t MMU::read_byte(uint16_t addr) {
     case AREA_UNUSED: 
         throw NotImplementedMemoryRegionException("AREA_UNUSED", addr, "READ_BYTE");
     case AREA_IO:
+        if (addr >= APU::FIRST_REGISTER && addr <= APU::LAST_REGISTER) {
+            return apu.read_register(addr);
+        }
         switch (addr) {
         case JOYPAD_REG: return input.get_buttons_pressed();
+        case SERIAL_REG_DATA: return serial.get_data();
+        case SERIAL_REG_CONTROL: return serial.get_control();
+        case TIMER_REG_DIVIDER: return timer.get_divider();
+        case TIMER_REG_COUNTER: return timer.get_counter();
+        case TIMER_REG_MODULO: return timer.get_modulo();
+        case TIMER_REG_CONTROL: return timer.get_control();
+        case INTERRUPT_REG_FLAGS: return interrupts.get_requested();
         case GPU_REG_LCD_CONTROL: return gpu.get_lcd_control();
         case GPU_REG_SCROLL_Y: return gpu.get_scroll_y();
         case GPU_REG_SCROLL_X: return gpu.get_scroll_x();
         case GPU_REG_CURR_SCANLINE: return gpu.get_curr_scanline();
+        case GPU_REG_DMA: return dma_source;
         case GPU_REG_OBJ_PALETTE_0: return gpu.get_obj_palette(0);
         case GPU_REG_OBJ_PALETTE_1: return gpu.get_obj_palette(1);
         default: 
             throw NotImplementedMemoryRegionException("AREA_IO", addr, "READ_BYTE");
         }
     case AREA_HRAM: return hram[addr & 0x7F];
-    case AREA_IE_REG: 
-        throw NotImplementedMemoryRegionException("AREA_IE_REG", addr, "READ_BYTE");
+    case AREA_IE_REG: return interrupts.get_enabled();
     default: 
         throw NotImplementedMemoryRegionException("UNDEFINED_AREA", addr, "READ_BYTE");
     }
 }
 
 uint16_t MMU::read_word(uint16_t addr) {
+    const uint8_t* page = read_pages[addr >> PAGE_SHIFT];
+    if (page && (addr & PAGE_MASK) != PAGE_MASK) {
+        return page[addr & PAGE_MASK] + (page[(addr & PAGE_MASK) + 1] << 8);
+    }
+
     switch (get_area(addr)) {
     case AREA_BIOS: return bios[addr] + (bios[addr + 1] << 8);
     case AREA_ROM0: return rom[addr] + (rom[addr + 1] << 8);
@@ -101,44 +142,62 @@ uint16_t MMU::read_word(uint16_t addr) {
 }
 
 void MMU::write_byte(uint16_t addr, uint8_t val) {
+    if (uint8_t* page = write_pages[addr >> PAGE_SHIFT]) {
+        page[addr & PAGE_MASK] = val;
+        return;
+    }
+
     switch (get_area(addr)) {
-    case AREA_BIOS: bios[addr] = val; break;
-    case AREA_ROM0: rom[addr] = val; break;
-    case AREA_ROM1: rom[addr] = val; break;
+    // Read only, and without a memory bank controller writes to the
+    // cartridge don't switch banks either
+    case AREA_BIOS: break;
+    case AREA_ROM0: break;
+    case AREA_ROM1: break;
     case AREA_VRAM: gpu.write_byte_vram(addr - 0x8000, val); break;
     case AREA_ERAM: eram[addr & 0x1FFF] = val; break;
     case AREA_WRAM: wram[addr & 0x1FFF] = val; break;
     case AREA_OAM: gpu.write_byte_oam(addr - 0xFE00, val); break;
     case AREA_UNUSED: break;
     case AREA_IO: 
+        if (addr >= APU::FIRST_REGISTER && addr <= APU::LAST_REGISTER) {
+            apu.write_register(addr, val);
+            break;
+        }
         switch (addr) {
         case JOYPAD_REG: input.set_buttons_pressed_switch(val); break;
+        case SERIAL_REG_DATA: serial.set_data(val); break;
+        case SERIAL_REG_CONTROL: serial.set_control(val); break;
+        case TIMER_REG_DIVIDER: timer.reset_divider(); break;
+        case TIMER_REG_COUNTER: timer.set_counter(val); break;
+        case TIMER_REG_MODULO: timer.set_modulo(val); break;
+        case TIMER_REG_CONTROL: timer.set_control(val); break;
+        case INTERRUPT_REG_FLAGS: interrupts.set_requested(val); break;
         case GPU_REG_LCD_CONTROL: gpu.set_lcd_control(val); break;
         case GPU_REG_SCROLL_Y: gpu.set_scroll_y(val); break;
         case GPU_REG_SCROLL_X: gpu.set_scroll_x(val); break;
+        case GPU_REG_DMA: start_dma(val); break;
         case GPU_REG_BG_PALETTE: gpu.set_bg_palette(val); break;
         case GPU_REG_OBJ_PALETTE_0: gpu.set_obj_palette(0, val); break;
         case GPU_REG_OBJ_PALETTE_1: gpu.set_obj_palette(1, val); break;
         }
         break;
     case AREA_HRAM: hram[addr & 0x7F] = val; break;
-    case AREA_IE_REG: break;
+    case AREA_IE_REG: interrupts.set_enabled(val); break;
     }
 }
 
 void MMU::write_word(uint16_t addr, uint16_t val) {
+    uint8_t* page = write_pages[addr >> PAGE_SHIFT];
+    if (page && (addr & PAGE_MASK) != PAGE_MASK) {
+        page[addr & PAGE_MASK] = val;
+        page[(addr & PAGE_MASK) + 1] = val >> 8;
+        return;
+    }
+
     switch (get_area(addr)) {
-    case AREA_BIOS: 
-        bios[addr] = val; 
-        bios[addr + 1] = val >> 8; 
-        break;
-    case AREA_ROM0:
-        rom[addr] = val;
-        rom[addr + 1] = val >> 8;
-        break;
-    case AREA_ROM1:
-        rom[addr] = val;
-        break;
+    case AREA_BIOS: break;
+    case AREA_ROM0: break;
+    case AREA_ROM1: break;
     case AREA_VRAM: gpu.write_word_vram(addr - 0x8000, val); break;
     case AREA_ERAM: eram[addr & 0x1FFF] = val; break;
     case AREA_WRAM: wram[addr & 0x1FFF] = val; break;
@@ -153,10 +212,116 @@ void MMU::write_word(uint16_t addr, uint16_t val) {
     }
 }
 
+int MMU::get_bank(uint16_t addr) {
+    return get_area(addr);
+}
+
+const uint8_t* MMU::get_read_page(uint16_t addr) {
+    return read_pages[addr >> PAGE_SHIFT];
+}
+
+uint8_t* MMU::get_write_page(uint16_t addr) {
+    return write_pages[addr >> PAGE_SHIFT];
+}
+
+const uint8_t* const* MMU::get_read_page_table() {
+    return read_pages;
+}
+
+uint8_t* const* MMU::get_write_page_table() {
+    return write_pages;
+}
+
+const uint8_t* MMU::get_wram() const {
+    return wram;
+}
+
+const uint8_t* MMU::get_hram() const {
+    return hram;
+}
+
+void MMU::save_state(StateWriter& writer) const {
+    writer.write(in_bios);
+    writer.write(eram);
+    writer.write(wram);
+    writer.write(hram);
+    writer.write(dma_active);
+    writer.write(dma_source);
+}
+
+void MMU::load_state(StateReader& reader) {
+    reader.read(in_bios);
+    reader.read(eram);
+    reader.read(wram);
+    reader.read(hram);
+    reader.read(dma_active);
+    reader.read(dma_source);
+    map_pages();
+}
+
+void MMU::map_pages() {
+    if (dma_active) {
+        for (int page = 0; page != HIGH_PAGE; ++page) {
+            read_pages[page] = dma_open_bus;
+            write_pages[page] = dma_ignored_writes;
+        }
+
+        return;
+    }
+
+    // Only pages of plain memory are mapped, everything else (IO, OAM, the
+    // BIOS overlay and writes to ROM) goes through get_area.
+    for (int page = 0; page != NBR_PAGES; ++page) {
+        int addr = page << PAGE_SHIFT;
+        read_pages[page] = nullptr;
+        write_pages[page] = nullptr;
+
+        if (addr < 0x8000) {
+            if (!in_bios || addr >= 0x200) {
+                read_pages[page] = &rom[addr];
+            }
+        } else if (addr < 0xA000) {
+            read_pages[page] = write_pages[page] = &gpu.get_vram()[addr & 0x1FFF];
+        } else if (addr < 0xC000) {
+            read_pages[page] = write_pages[page] = &eram[addr & 0x1FFF];
+        } else if (addr < 0xFE00) {
+            read_pages[page] = write_pages[page] = &wram[addr & 0x1FFF];
+        }
+    }
+}
+
+void MMU::start_dma(uint8_t val) {
+    dma_source = val;
+
+    // Sources from 0xE000 and up read WRAM, like the echo area does.
+    uint16_t source = (val < 0xE0 ? val : val - 0x20) << PAGE_SHIFT;
+
+    // Nothing but HRAM can be accessed until the DMA is done, so the whole
+    // transfer may as well happen right away.
+    end_dma();
+    if (const uint8_t* page = read_pages[source >> PAGE_SHIFT]) {
+        std::memcpy(gpu.get_oam(), page, DMA_LENGTH);
+    } else {
+        for (int i = 0; i != DMA_LENGTH; ++i) {
+            gpu.get_oam()[i] = read_byte(source + i);
+        }
+    }
+
+    dma_active = true;
+    map_pages();
+    scheduler.schedule_in(Scheduler::EVENT_DMA, DMA_CYCLES);
+}
+
+void MMU::end_dma() {
+    dma_active = false;
+    map_pages();
+}
+
 int MMU::get_area(uint16_t addr) {
     if (addr < 0x4000) {
         if (in_bios && addr == 0x100) {
             in_bios = false;
+            map_pages();
         }
         if (addr < 0x100 && in_bios) {
             return AREA_BIOS;
@@ -0,0 +1,188 @@
+#include "core/movie.h"
+
+#include "core/byte_codec.h"
+
+#include <fstream>
+#include <iterator>
+
+namespace geemuboi::core {
+
+
+namespace {
+
+// "GBMV"
+const uint32_t MOVIE_MAGIC = 0x564D4247;
+const uint32_t MOVIE_VERSION = 2;
+
+using MovieReader = ByteReader<InvalidMovieException>;
+
+}
+
+
+uint64_t MovieEvent::get_time() const {
+    return frame * GPU::CYCLES_PER_FRAME + cycle;
+}
+
+
+std::vector<uint8_t> encode_movie(const Movie& movie) {
+    std::vector<uint8_t> out;
+    write_fixed(out, MOVIE_MAGIC, 4);
+    write_fixed(out, MOVIE_VERSION, 4);
+    write_fixed(out, movie.rom_hash, 8);
+    write_fixed(out, movie.bios_hash, 8);
+    write_fixed(out, movie.cpu_type, 1);
+    write_varint(out, movie.events.size());
+
+    uint64_t frame = 0;
+    for (const MovieEvent& event : movie.events) {
+        write_varint(out, event.frame - frame);
+        write_varint(out, event.cycle);
+        out.push_back(static_cast<uint8_t>(event.column << 4 | event.buttons_pressed));
+        frame = event.frame;
+    }
+
+    return out;
+}
+
+Movie decode_movie(const uint8_t* data, size_t size) {
+    MovieReader reader(data, size, "movie");
+    if (reader.read_fixed(4) != MOVIE_MAGIC || reader.read_fixed(4) != MOVIE_VERSION) {
+        throw InvalidMovieException("Not a movie of this version.");
+    }
+
+    Movie movie{};
+    movie.rom_hash = reader.read_fixed(8);
+    movie.bios_hash = reader.read_fixed(8);
+    uint64_t cpu_type = reader.read_fixed(1);
+    if (cpu_type > CPU_TYPE_JIT) {
+        throw InvalidMovieException("The movie has an unknown CPU type.");
+    }
+    movie.cpu_type = static_cast<CpuType>(cpu_type);
+
+    uint64_t count = reader.read_varint();
+    // Every event takes at least three bytes, don't trust the count further
+    if (count > size / 3) {
+        throw InvalidMovieException("The movie is truncated.");
+    }
+    movie.events.reserve(count);
+
+    uint64_t frame = 0;
+    for (uint64_t i = 0; i != count; ++i) {
+        MovieEvent event{};
+        frame += reader.read_varint();
+        event.frame = frame;
+
+        uint64_t cycle = reader.read_varint();
+        if (cycle >= GPU::CYCLES_PER_FRAME) {
+            throw InvalidMovieException("The movie has an event outside its frame.");
+        }
+        event.cycle = static_cast<uint32_t>(cycle);
+
+        uint8_t buttons = static_cast<uint8_t>(reader.read_fixed(1));
+        event.column = buttons >> 4;
+        event.buttons_pressed = buttons & 0xF;
+        if (event.column > 1) {
+            throw InvalidMovieException("The movie has an invalid button column.");
+        }
+
+        movie.events.push_back(event);
+    }
+
+    if (!reader.at_end()) {
+        throw InvalidMovieException("The movie has trailing data.");
+    }
+
+    return movie;
+}
+
+void write_movie(const std::string& path, const Movie& movie) {
+    std::vector<uint8_t> data = encode_movie(movie);
+    std::ofstream ofs(path, std::ios::binary);
+    ofs.write(reinterpret_cast<const char*>(data.data()), data.size());
+    if (!ofs) {
+        throw std::runtime_error("Could not write " + path);
+    }
+}
+
+Movie read_movie(const std::string& path) {
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs) {
+        throw std::runtime_error("Could not open " + path);
+    }
+
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    return decode_movie(data.data(), data.size());
+}
+
+
+MovieRecorder::MovieRecorder(Input& input_in, const Scheduler& scheduler_in, uint64_t rom_hash,
+                             uint64_t bios_hash, CpuType cpu_type) : input(input_in),
+    scheduler(scheduler_in),
+    movie{rom_hash, bios_hash, cpu_type, {}} {
+
+    input.set_listener(this);
+}
+
+MovieRecorder::~MovieRecorder() {
+    input.set_listener(nullptr);
+}
+
+void MovieRecorder::buttons_changed(int column, uint8_t buttons_pressed) {
+    uint64_t time = scheduler.get_time();
+    movie.events.push_back({
+        time / GPU::CYCLES_PER_FRAME,
+        static_cast<uint32_t>(time % GPU::CYCLES_PER_FRAME),
+        static_cast<uint8_t>(column),
+        static_cast<uint8_t>(buttons_pressed & 0xF)
+    });
+}
+
+const Movie& MovieRecorder::get_movie() const {
+    return movie;
+}
+
+
+MoviePlayer::MoviePlayer(const Movie& movie_in, Input& input_in, Scheduler& scheduler_in,
+                         CpuType cpu_type)
+    : movie(movie_in),
+    input(input_in),
+    scheduler(scheduler_in),
+    next_event{} {
+
+    if (movie.cpu_type != cpu_type) {
+        throw InvalidMovieException("The movie was recorded with another CPU type.");
+    }
+
+    scheduler.set_handler(Scheduler::EVENT_INPUT, [this]() { play_events(); });
+    schedule_next();
+}
+
+MoviePlayer::~MoviePlayer() {
+    scheduler.cancel(Scheduler::EVENT_INPUT);
+}
+
+bool MoviePlayer::is_done() const {
+    return next_event == movie.events.size();
+}
+
+void MoviePlayer::play_events() {
+    // Both columns can change at the same read
+    uint64_t time = scheduler.get_time();
+    while (!is_done() && movie.events[next_event].get_time() <= time) {
+        const MovieEvent& event = movie.events[next_event++];
+        input.set_buttons_pressed(event.column, event.buttons_pressed);
+    }
+
+    schedule_next();
+}
+
+void MoviePlayer::schedule_next() {
+    if (is_done()) {
+        scheduler.cancel(Scheduler::EVENT_INPUT);
+    } else {
+        scheduler.schedule(Scheduler::EVENT_INPUT, movie.events[next_event].get_time());
+    }
+}
+
+
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+
+namespace geemuboi::core {
+
+
+// What the code caches need to know about instructions before running them.
+// Prefixed instructions are numbered 0x100 and up.
+
+const uint16_t PREFIX_CB = 0xCB;
+
+// call, nothing takes longer
+const int MAX_INSTRUCTION_CYCLES = 6;
+
+// Operands included. The length of 0xCB covers the prefixed opcode.
+inline int get_opcode_length(uint8_t opcode) {
+    static const uint8_t LENGTHS[0x100] = {
+        1, 3, 1, 1, 1, 1, 2, 1, 3, 1, 1, 1, 1, 1, 2, 1,
+        2, 3, 1, 1, 1, 1, 2, 1, 2, 1, 1, 1, 1, 1, 2, 1,
+        2, 3, 1, 1, 1, 1, 2, 1, 2, 1, 1, 1, 1, 1, 2, 1,
+        2, 3, 1, 1, 1, 1, 2, 1, 2, 1, 1, 1, 1, 1, 2, 1,
+        1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+        1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+        1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+        1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+        1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+        1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+        1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+        1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+        1, 1, 3, 3, 3, 1, 2, 1, 1, 1, 3, 2, 3, 3, 2, 1,
+        1, 1, 3, 1, 3, 1, 2, 1, 1, 1, 3, 1, 3, 1, 2, 1,
+        2, 1, 1, 1, 1, 1, 2, 1, 2, 1, 3, 1, 1, 1, 2, 1,
+        2, 1, 1, 1, 1, 1, 2, 1, 2, 1, 3, 1, 1, 1, 2, 1
+    };
+
+    return LENGTHS[opcode];
+}
+
+inline bool is_undefined(uint16_t opcode) {
+    switch (opcode) {
+    case 0xD3: case 0xDB: case 0xDD: case 0xE3: case 0xE4: case 0xEB:
+    case 0xEC: case 0xED: case 0xF4: case 0xFC: case 0xFD:
+        return true;
+    default:
+        return false;
+    }
+}
+
+inline bool is_block_end(uint16_t opcode) {
+    switch (opcode) {
+    // jr, jp, call, ret and rst
+    case 0x18: case 0x20: case 0x28: case 0x30: case 0x38:
+    case 0xC2: case 0xC3: case 0xCA: case 0xD2: case 0xDA: case 0xE9:
+    case 0xC4: case 0xCC: case 0xCD: case 0xD4: case 0xDC:
+    case 0xC0: case 0xC8: case 0xC9: case 0xD0: case 0xD8: case 0xD9:
+    case 0xC7: case 0xCF: case 0xD7: case 0xDF:
+    case 0xE7: case 0xEF: case 0xF7: case 0xFF:
+    // stop, halt, di and ei
+    case 0x10: case 0x76: case 0xF3: case 0xFB:
+        return true;
+    default:
+        return is_undefined(opcode);
+    }
+}
+
+inline bool is_uncached(uint16_t pc) {
+    // IO registers and IE are never run as cached code
+    return pc >= 0xFF00 && (pc < 0xFF80 || pc == 0xFFFF);
+}
+
+// Echo RAM at E000-FDFF and C000-DDFF are the same memory, a write to one
+// changes code at the other. Returns the other address, or addr itself
+// outside of both.
+inline uint16_t get_echo_mirror(uint16_t addr) {
+    if (addr >= 0xC000 && addr < 0xDE00) {
+        return addr + 0x2000;
+    }
+    if (addr >= 0xE000 && addr < 0xFE00) {
+        return addr - 0x2000;
+    }
+    return addr;
+}
+
+inline bool is_event_driven(uint16_t addr) {
+    // IF and LY, which are only changed by hardware events
+    return addr == 0xFF0F || addr == 0xFF44;
+}
+
+
+}
@@ -0,0 +1,246 @@
+#include "core/profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace geemuboi::core {
+
+
+namespace {
+
+const char* SECTION_NAMES[PerfStats::NBR_SECTIONS] = {
+    "cpu", "gpu", "audio", "input", "present", "sleep", "frame"
+};
+
+const std::chrono::milliseconds CALIBRATION_TIME(20);
+
+uint64_t steady_nanos() {
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+double measure_ticks_per_second() {
+#if defined(__x86_64__) || defined(__i386__)
+    uint64_t start_nanos = steady_nanos();
+    uint64_t start_ticks = read_ticks();
+    std::this_thread::sleep_for(CALIBRATION_TIME);
+    uint64_t nanos = steady_nanos() - start_nanos;
+    uint64_t ticks = read_ticks() - start_ticks;
+    return ticks * 1e9 / nanos;
+#else
+    return 1e9;
+#endif
+}
+
+int get_bucket(uint64_t nanos) {
+    int bucket = 0;
+    for (uint64_t micros = nanos / 1000; micros && bucket != Histogram::NBR_BUCKETS - 1; micros >>= 1) {
+        ++bucket;
+    }
+    return bucket;
+}
+
+std::string format_number(double val) {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.6g", val);
+    return text;
+}
+
+}
+
+
+uint64_t read_ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return steady_nanos();
+#endif
+}
+
+double get_ticks_per_second() {
+    static const double ticks_per_second = measure_ticks_per_second();
+    return ticks_per_second;
+}
+
+
+Histogram::Snapshot Histogram::Snapshot::since(const Snapshot& earlier) const {
+    Snapshot diff = *this;
+    diff.count -= earlier.count;
+    diff.sum_nanos -= earlier.sum_nanos;
+    for (int i = 0; i != NBR_BUCKETS; ++i) {
+        diff.buckets[i] -= earlier.buckets[i];
+    }
+    return diff;
+}
+
+double Histogram::Snapshot::get_mean_millis() const {
+    return count ? sum_nanos / 1e6 / count : 0;
+}
+
+uint64_t Histogram::Snapshot::get_percentile_nanos(double percentile) const {
+    if (!count) {
+        return 0;
+    }
+
+    uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(percentile * count + 0.5));
+    uint64_t seen = 0;
+    for (int i = 0; i != NBR_BUCKETS - 1; ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return std::min(get_bucket_limit_nanos(i), max_nanos);
+        }
+    }
+    return max_nanos;
+}
+
+Histogram::Histogram() : count{0}, sum_nanos{0}, max_nanos{0}, buckets{} {
+    for (std::atomic<uint64_t>& bucket : buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+void Histogram::record(uint64_t nanos) {
+    buckets[get_bucket(nanos)].fetch_add(1, std::memory_order_relaxed);
+    sum_nanos.fetch_add(nanos, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+
+    uint64_t max = max_nanos.load(std::memory_order_relaxed);
+    while (nanos > max && !max_nanos.compare_exchange_weak(max, nanos, std::memory_order_relaxed)) {
+    }
+}
+
+Histogram::Snapshot Histogram::get_snapshot() const {
+    // Not taken atomically as a whole, a sample being recorded may be
+    // missing from some of the fields
+    Snapshot snapshot{};
+    snapshot.count = count.load(std::memory_order_relaxed);
+    snapshot.sum_nanos = sum_nanos.load(std::memory_order_relaxed);
+    snapshot.max_nanos = max_nanos.load(std::memory_order_relaxed);
+    for (int i = 0; i != NBR_BUCKETS; ++i) {
+        snapshot.buckets[i] = buckets[i].load(std::memory_order_relaxed);
+    }
+    return snapshot;
+}
+
+uint64_t Histogram::get_bucket_limit_nanos(int bucket) {
+    return (uint64_t{1} << bucket) * 1000;
+}
+
+
+const char* PerfStats::get_section_name(int section) {
+    return SECTION_NAMES[section];
+}
+
+void PerfStats::record_ticks(int section, uint64_t ticks) {
+    histograms[section].record(static_cast<uint64_t>(ticks * 1e9 / get_ticks_per_second()));
+}
+
+Histogram& PerfStats::get_histogram(int section) {
+    return histograms[section];
+}
+
+const Histogram& PerfStats::get_histogram(int section) const {
+    return histograms[section];
+}
+
+std::string PerfStats::format_json() const {
+    std::string json = "{\"sections\":{";
+    for (int section = 0; section != NBR_SECTIONS; ++section) {
+        Histogram::Snapshot snapshot = histograms[section].get_snapshot();
+        if (section) {
+            json += ",";
+        }
+        json += "\"" + std::string(SECTION_NAMES[section]) + "\":{";
+        json += "\"count\":" + std::to_string(snapshot.count);
+        json += ",\"mean_ms\":" + format_number(snapshot.get_mean_millis());
+        json += ",\"p50_ms\":" + format_number(snapshot.get_percentile_nanos(0.5) / 1e6);
+        json += ",\"p99_ms\":" + format_number(snapshot.get_percentile_nanos(0.99) / 1e6);
+        json += ",\"max_ms\":" + format_number(snapshot.max_nanos / 1e6);
+        json += "}";
+    }
+    json += "}}\n";
+    return json;
+}
+
+std::string PerfStats::format_prometheus() const {
+    const std::string name = "geemuboi_section_seconds";
+    std::string text = "# HELP " + name + " Time per frame spent in each part of the emulator.\n";
+    text += "# TYPE " + name + " histogram\n";
+
+    for (int section = 0; section != NBR_SECTIONS; ++section) {
+        Histogram::Snapshot snapshot = histograms[section].get_snapshot();
+        const std::string label = "section=\"" + std::string(SECTION_NAMES[section]) + "\"";
+
+        uint64_t cumulative = 0;
+        for (int i = 0; i != Histogram::NBR_BUCKETS - 1; ++i) {
+            cumulative += snapshot.buckets[i];
+            text += name + "_bucket{" + label + ",le=\"" +
+                format_number(Histogram::get_bucket_limit_nanos(i) / 1e9) + "\"} " +
+                std::to_string(cumulative) + "\n";
+        }
+        text += name + "_bucket{" + label + ",le=\"+Inf\"} " + std::to_string(snapshot.count) + "\n";
+        text += name + "_sum{" + label + "} " + format_number(snapshot.sum_nanos / 1e9) + "\n";
+        text += name + "_count{" + label + "} " + std::to_string(snapshot.count) + "\n";
+    }
+
+    return text;
+}
+
+
+Profiler::Profiler(PerfStats& stats_in) : stats(stats_in),
+    section_start{read_ticks()},
+    frame_start{section_start},
+    stack{},
+    depth{},
+    section_ticks{},
+    entered{} {}
+
+void Profiler::enter(int section) {
+    switch_section();
+    if (depth < MAX_DEPTH) {
+        stack[depth] = section;
+    }
+    ++depth;
+    entered[section] = true;
+}
+
+void Profiler::leave() {
+    switch_section();
+    --depth;
+}
+
+void Profiler::end_frame() {
+    flush();
+    uint64_t now = read_ticks();
+    stats.record_ticks(PerfStats::SECTION_FRAME, now - frame_start);
+    frame_start = now;
+}
+
+void Profiler::flush() {
+    switch_section();
+    for (int section = 0; section != PerfStats::NBR_SECTIONS; ++section) {
+        if (entered[section]) {
+            stats.record_ticks(section, section_ticks[section]);
+        }
+        section_ticks[section] = 0;
+        entered[section] = false;
+    }
+}
+
+void Profiler::switch_section() {
+    // Time outside of any section isn't counted anywhere
+    uint64_t now = read_ticks();
+    if (depth) {
+        section_ticks[stack[std::min(depth, MAX_DEPTH) - 1]] += now - section_start;
+    }
+    section_start = now;
+}
+
+
+}
@@ -0,0 +1,113 @@
+#include "core/scheduler.h"
+
+#include <utility>
+
+namespace geemuboi::core {
+
+
+namespace {
+
+// The others are counted as the CPU that caused them
+const int EVENT_SECTIONS[Scheduler::NBR_EVENTS] = {
+    PerfStats::SECTION_GPU,
+    -1,
+    -1,
+    PerfStats::SECTION_AUDIO,
+    -1,
+    -1
+};
+
+}
+
+
+Scheduler::Scheduler() : time{},
+    next_event_time{NEVER},
+    next_event{},
+    event_times{},
+    handlers{},
+    profiler{} {
+
+    for (uint64_t& event_time : event_times) {
+        event_time = NEVER;
+    }
+}
+
+void Scheduler::set_handler(int event, std::function<void()> handler) {
+    handlers[event] = std::move(handler);
+}
+
+void Scheduler::set_profiler(Profiler* profiler_in) {
+    profiler = profiler_in;
+}
+
+void Scheduler::schedule(int event, uint64_t event_time) {
+    event_times[event] = event_time;
+    find_next_event();
+}
+
+void Scheduler::schedule_in(int event, uint64_t cycles) {
+    schedule(event, time + cycles);
+}
+
+void Scheduler::cancel(int event) {
+    schedule(event, NEVER);
+}
+
+void Scheduler::advance(int cycles) {
+    uint64_t target_time = time + cycles;
+
+    while (next_event_time <= target_time) {
+        // Handlers see the time the event was due at, so that they can
+        // schedule their next event without drifting.
+        int event = next_event;
+        time = next_event_time;
+        event_times[event] = NEVER;
+        find_next_event();
+
+        if (profiler && EVENT_SECTIONS[event] != -1) {
+            profiler->enter(EVENT_SECTIONS[event]);
+            handlers[event]();
+            profiler->leave();
+        } else {
+            handlers[event]();
+        }
+    }
+
+    time = target_time;
+}
+
+uint64_t Scheduler::get_time() const {
+    return time;
+}
+
+uint64_t Scheduler::get_next_event_time() const {
+    return next_event_time;
+}
+
+uint64_t Scheduler::get_event_time(int event) const {
+    return event_times[event];
+}
+
+void Scheduler::save_state(StateWriter& writer) const {
+    writer.write(time);
+    writer.write(event_times);
+}
+
+void Scheduler::load_state(StateReader& reader) {
+    reader.read(time);
+    reader.read(event_times);
+    find_next_event();
+}
+
+void Scheduler::find_next_event() {
+    next_event_time = NEVER;
+    for (int event = 0; event != NBR_EVENTS; ++event) {
+        if (event_times[event] < next_event_time) {
+            next_event_time = event_times[event];
+            next_event = event;
+        }
+    }
+}
+
+
+}
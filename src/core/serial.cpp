@@ -0,0 +1,76 @@
+#include "core/serial.h"
+
+namespace geemuboi::core {
+
+
+Serial::Serial(Scheduler& scheduler_in, Interrupts& interrupts_in) : scheduler(scheduler_in),
+    interrupts(interrupts_in),
+    sink{},
+    data{},
+    control{} {
+
+    scheduler.set_handler(Scheduler::EVENT_SERIAL, [this]() { end_transfer(); });
+}
+
+uint8_t Serial::get_data() const {
+    return data;
+}
+
+void Serial::set_data(uint8_t val) {
+    data = val;
+}
+
+uint8_t Serial::get_control() const {
+    // The unused bits always read as set
+    return control | ~(CONTROL_INTERNAL_CLOCK | CONTROL_START);
+}
+
+void Serial::set_control(uint8_t val) {
+    control = val & (CONTROL_INTERNAL_CLOCK | CONTROL_START);
+    if ((control & CONTROL_START) && (control & CONTROL_INTERNAL_CLOCK)) {
+        scheduler.schedule_in(Scheduler::EVENT_SERIAL, TRANSFER_CYCLES);
+    } else {
+        scheduler.cancel(Scheduler::EVENT_SERIAL);
+    }
+}
+
+void Serial::set_sink(SerialSink* sink_in) {
+    sink = sink_in;
+}
+
+uint64_t Serial::get_transfer_end_time() const {
+    return scheduler.get_event_time(Scheduler::EVENT_SERIAL);
+}
+
+uint8_t Serial::receive(uint8_t val) {
+    if (!(control & CONTROL_START) || (control & CONTROL_INTERNAL_CLOCK)) {
+        return 0xFF;
+    }
+
+    uint8_t sent = data;
+    complete(val);
+    return sent;
+}
+
+void Serial::save_state(StateWriter& writer) const {
+    writer.write(data);
+    writer.write(control);
+}
+
+void Serial::load_state(StateReader& reader) {
+    reader.read(data);
+    reader.read(control);
+}
+
+void Serial::end_transfer() {
+    complete(sink ? sink->transfer(data) : 0xFF);
+}
+
+void Serial::complete(uint8_t val) {
+    data = val;
+    control &= ~CONTROL_START;
+    interrupts.request(Interrupts::INTERRUPT_SERIAL);
+}
+
+
+}
@@ -0,0 +1,55 @@
+#include "core/serial_sink.h"
+
+#include "core/serial.h"
+
+#include <stdexcept>
+
+namespace geemuboi::core {
+
+
+namespace {
+
+// Nothing drives the data line, it is pulled high
+const uint8_t DISCONNECTED = 0xFF;
+
+}
+
+
+BufferSerialSink::BufferSerialSink() : text{} {}
+
+uint8_t BufferSerialSink::transfer(uint8_t val) {
+    text.push_back(static_cast<char>(val));
+    return DISCONNECTED;
+}
+
+const std::string& BufferSerialSink::get_text() const {
+    return text;
+}
+
+void BufferSerialSink::clear() {
+    text.clear();
+}
+
+
+FileSerialSink::FileSerialSink(const std::string& path) : file(path, std::ios::binary) {
+    if (!file) {
+        throw std::runtime_error("Could not create " + path);
+    }
+}
+
+uint8_t FileSerialSink::transfer(uint8_t val) {
+    // Flushed per byte so the output can be followed while running
+    file.put(static_cast<char>(val));
+    file.flush();
+    return DISCONNECTED;
+}
+
+
+LinkSerialSink::LinkSerialSink(Serial& peer_in) : peer(peer_in) {}
+
+uint8_t LinkSerialSink::transfer(uint8_t val) {
+    return peer.receive(val);
+}
+
+
+}
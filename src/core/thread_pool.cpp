@@ -0,0 +1,123 @@
+#include "core/thread_pool.h"
+
+#include <algorithm>
+
+namespace geemuboi::core {
+
+
+ThreadPool::ThreadPool(int threads) : workers{},
+    shares{},
+    nbr_shares{},
+    mutex{},
+    started{},
+    finished{},
+    generation{},
+    busy_workers{},
+    stopping{},
+    error{},
+    job{} {
+
+    if (threads <= 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    nbr_shares = threads;
+    shares = std::make_unique<Share[]>(nbr_shares);
+
+    for (int i = 1; i != threads; ++i) {
+        workers.emplace_back([this, i]() { work_loop(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    started.notify_all();
+
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+int ThreadPool::get_threads() const {
+    return nbr_shares;
+}
+
+void ThreadPool::run(int count, const std::function<void(int)>& body) {
+    for (int i = 0; i != nbr_shares; ++i) {
+        shares[i].next.store(static_cast<int>(static_cast<long long>(count) * i / nbr_shares),
+                             std::memory_order_relaxed);
+        shares[i].end = static_cast<int>(static_cast<long long>(count) * (i + 1) / nbr_shares);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &body;
+        busy_workers = static_cast<int>(workers.size());
+        ++generation;
+    }
+    started.notify_all();
+
+    work(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [this]() { return busy_workers == 0; });
+    job = nullptr;
+
+    if (error) {
+        std::exception_ptr first_error = error;
+        error = nullptr;
+        std::rethrow_exception(first_error);
+    }
+}
+
+void ThreadPool::work_loop(int index) {
+    unsigned seen_generation = 0;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            started.wait(lock, [&]() { return stopping || generation != seen_generation; });
+            if (stopping) {
+                return;
+            }
+            seen_generation = generation;
+        }
+
+        work(index);
+
+        bool last;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            last = --busy_workers == 0;
+        }
+        if (last) {
+            finished.notify_one();
+        }
+    }
+}
+
+void ThreadPool::work(int index) {
+    // Own share first, then the others starting with the next thread over
+    for (int i = 0; i != nbr_shares; ++i) {
+        Share& share = shares[(index + i) % nbr_shares];
+        int iteration;
+        while ((iteration = share.next.fetch_add(1, std::memory_order_relaxed)) < share.end) {
+            // Letting it escape would terminate a worker, or leave the
+            // calling thread while the workers still use the job
+            try {
+                (*job)(iteration);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+        }
+    }
+}
+
+
+}
@@ -0,0 +1,145 @@
+#include "core/timer.h"
+
+namespace geemuboi::core {
+
+
+// In M-cycles, for 4096, 262144, 65536 and 16384 Hz
+const int Timer::PERIODS[4] = {256, 4, 16, 64};
+
+
+Timer::Timer(Scheduler& scheduler_in, Interrupts& interrupts_in) : scheduler(scheduler_in),
+    interrupts(interrupts_in),
+    divider_reset_time{},
+    counter_sync_time{},
+    counter{},
+    modulo{},
+    control{} {
+
+    scheduler.set_handler(Scheduler::EVENT_TIMER, [this]() { overflow(); });
+}
+
+uint8_t Timer::get_divider() const {
+    return get_divider_cycles(scheduler.get_time()) >> DIVIDER_SHIFT;
+}
+
+void Timer::reset_divider() {
+    // Resetting the divider may pull the selected bit low, which counts as
+    // a tick.
+    sync();
+    bool signal = get_tick_signal();
+    divider_reset_time = scheduler.get_time();
+    if (signal) {
+        increment_counter();
+    }
+
+    reschedule();
+}
+
+uint8_t Timer::get_counter() {
+    sync();
+    return counter;
+}
+
+void Timer::set_counter(uint8_t val) {
+    sync();
+    counter = val;
+    reschedule();
+}
+
+uint8_t Timer::get_modulo() const {
+    return modulo;
+}
+
+void Timer::set_modulo(uint8_t val) {
+    modulo = val;
+}
+
+uint8_t Timer::get_control() const {
+    // The unused upper bits always read as set
+    return control | ~(CONTROL_CLOCK_SELECT | CONTROL_ENABLE);
+}
+
+void Timer::set_control(uint8_t val) {
+    sync();
+    bool signal = get_tick_signal();
+    control = val & (CONTROL_CLOCK_SELECT | CONTROL_ENABLE);
+    if (signal && !get_tick_signal()) {
+        increment_counter();
+    }
+
+    reschedule();
+}
+
+void Timer::save_state(StateWriter& writer) const {
+    writer.write(divider_reset_time);
+    writer.write(counter_sync_time);
+    writer.write(counter);
+    writer.write(modulo);
+    writer.write(control);
+}
+
+void Timer::load_state(StateReader& reader) {
+    reader.read(divider_reset_time);
+    reader.read(counter_sync_time);
+    reader.read(counter);
+    reader.read(modulo);
+    reader.read(control);
+}
+
+void Timer::overflow() {
+    // The event is due exactly at the tick that overflows the counter.
+    counter = modulo;
+    counter_sync_time = scheduler.get_time();
+    interrupts.request(Interrupts::INTERRUPT_TIMER);
+    reschedule();
+}
+
+void Timer::sync() {
+    uint64_t time = scheduler.get_time();
+    if (control & CONTROL_ENABLE) {
+        int period = get_period();
+        uint64_t ticks = get_divider_cycles(time) / period -
+            get_divider_cycles(counter_sync_time) / period;
+        counter += ticks;
+    }
+
+    counter_sync_time = time;
+}
+
+void Timer::increment_counter() {
+    if (++counter == 0) {
+        counter = modulo;
+        interrupts.request(Interrupts::INTERRUPT_TIMER);
+    }
+}
+
+void Timer::reschedule() {
+    if (!(control & CONTROL_ENABLE)) {
+        scheduler.cancel(Scheduler::EVENT_TIMER);
+        return;
+    }
+
+    int period = get_period();
+    uint64_t divider_cycles = get_divider_cycles(scheduler.get_time());
+    uint64_t next_tick = (divider_cycles / period + 1) * period;
+    uint64_t overflow_tick = next_tick + (0xFF - counter) * static_cast<uint64_t>(period);
+    scheduler.schedule(Scheduler::EVENT_TIMER, divider_reset_time + overflow_tick);
+}
+
+bool Timer::get_tick_signal() const {
+    // The selected divider bit, it is high for the second half of a period
+    int period = get_period();
+    return (control & CONTROL_ENABLE) &&
+        get_divider_cycles(scheduler.get_time()) % period >= static_cast<uint64_t>(period / 2);
+}
+
+uint64_t Timer::get_divider_cycles(uint64_t time) const {
+    return time - divider_reset_time;
+}
+
+int Timer::get_period() const {
+    return PERIODS[control & CONTROL_CLOCK_SELECT];
+}
+
+
+}
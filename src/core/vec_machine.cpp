@@ -0,0 +1,144 @@
+#include "core/vec_machine.h"
+
+#include "view/renderer.h"
+
+#include <stdexcept>
+
+namespace geemuboi::core {
+
+using namespace geemuboi::view;
+
+
+VecMachine::VecMachine(int count, const std::vector<uint8_t>& rom, int observation_in,
+                       int downsample_in, int threads, CpuType cpu_type) : machines{},
+    initial_state{},
+    crash_reasons{},
+    observation{observation_in},
+    downsample{downsample_in},
+    pool(threads),
+    step_job{[this](int index) { step_machine(index); }},
+    observe_job{[this](int index) {
+        observe_machine(index, step_observations + index * get_observation_size());
+    }},
+    step_actions{},
+    step_frames{},
+    step_observations{} {
+
+    if (count < 1) {
+        throw std::invalid_argument("At least one machine is needed");
+    }
+
+    if (observation != OBSERVATION_PIXELS && observation != OBSERVATION_RAM) {
+        throw std::invalid_argument("Unknown observation");
+    }
+
+    if (downsample < 1 || Renderer::SCREEN_WIDTH % downsample ||
+        Renderer::SCREEN_HEIGHT % downsample) {
+        throw std::invalid_argument("The downsample factor has to divide the screen size");
+    }
+
+    for (int i = 0; i != count; ++i) {
+        machines.push_back(std::make_unique<Machine>(rom, std::vector<uint8_t>{}, cpu_type));
+    }
+
+    initial_state = machines.front()->save_state();
+    crash_reasons.resize(count);
+}
+
+int VecMachine::get_count() const {
+    return static_cast<int>(machines.size());
+}
+
+int VecMachine::get_observation_width() const {
+    return Renderer::SCREEN_WIDTH / downsample;
+}
+
+int VecMachine::get_observation_height() const {
+    return Renderer::SCREEN_HEIGHT / downsample;
+}
+
+int VecMachine::get_observation_size() const {
+    if (observation == OBSERVATION_RAM) {
+        return Machine::RAM_SIZE;
+    }
+
+    return get_observation_width() * get_observation_height();
+}
+
+void VecMachine::step(const uint8_t* actions, int frames, uint8_t* observations) {
+    step_actions = actions;
+    step_frames = frames;
+    step_observations = observations;
+    pool.run(get_count(), step_job);
+}
+
+void VecMachine::observe(uint8_t* observations) {
+    step_observations = observations;
+    pool.run(get_count(), observe_job);
+}
+
+void VecMachine::reset(int index) {
+    machines[index]->load_state(initial_state.data(), initial_state.size());
+    crash_reasons[index].clear();
+}
+
+bool VecMachine::has_crashed(int index) const {
+    return !crash_reasons[index].empty();
+}
+
+const std::string& VecMachine::get_crash_reason(int index) const {
+    return crash_reasons[index];
+}
+
+Machine& VecMachine::get_machine(int index) {
+    return *machines[index];
+}
+
+void VecMachine::step_machine(int index) {
+    Machine& machine = *machines[index];
+    if (!has_crashed(index)) {
+        try {
+            machine.set_buttons(step_actions[index]);
+            for (int i = 0; i != step_frames; ++i) {
+                machine.step_frame();
+            }
+        } catch (const std::exception& e) {
+            crash_reasons[index] = *e.what() ? e.what() : "Unknown error";
+        }
+    }
+
+    observe_machine(index, step_observations + index * get_observation_size());
+}
+
+void VecMachine::observe_machine(int index, uint8_t* out) const {
+    if (observation == OBSERVATION_RAM) {
+        machines[index]->copy_ram(out);
+    } else {
+        downsample_frame(machines[index]->get_framebuffer(), out);
+    }
+}
+
+void VecMachine::downsample_frame(const uint32_t* frame, uint8_t* out) const {
+    const int width = get_observation_width();
+    const int height = get_observation_height();
+    const int block_pixels = downsample * downsample;
+
+    for (int y = 0; y != height; ++y) {
+        for (int x = 0; x != width; ++x) {
+            int sum = 0;
+            for (int block_y = 0; block_y != downsample; ++block_y) {
+                const uint32_t* row = frame + (y * downsample + block_y) * Renderer::SCREEN_WIDTH +
+                                      x * downsample;
+                for (int block_x = 0; block_x != downsample; ++block_x) {
+                    uint32_t color = row[block_x];
+                    sum += ((color >> 16) & 0xFF) + ((color >> 7) & 0x1FE) + (color & 0xFF);
+                }
+            }
+
+            out[y * width + x] = static_cast<uint8_t>(sum / (block_pixels * 4));
+        }
+    }
+}
+
+
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "core/immu.h"
+
+#include <cstdint>
+
+namespace geemuboi::core {
+
+
+// Forwards to the real MMU and has the code cache drop the blocks a write
+// overlaps, before the write happens. Cache is anything with an
+// invalidate(uint16_t) the tracker can reach.
+template <typename Cache>
+class WriteTracker : public IMmu {
+public:
+    WriteTracker(IMmu& mmu_in, Cache& cache_in) : mmu(mmu_in), cache(cache_in) {}
+
+    virtual uint8_t read_byte(uint16_t addr) {
+        return mmu.read_byte(addr);
+    }
+
+    virtual uint16_t read_word(uint16_t addr) {
+        return mmu.read_word(addr);
+    }
+
+    virtual void write_byte(uint16_t addr, uint8_t val) {
+        cache.invalidate(addr);
+        mmu.write_byte(addr, val);
+    }
+
+    virtual void write_word(uint16_t addr, uint16_t val) {
+        cache.invalidate(addr);
+        cache.invalidate(addr + 1);
+        mmu.write_word(addr, val);
+    }
+
+    virtual int get_bank(uint16_t addr) {
+        return mmu.get_bank(addr);
+    }
+
+    virtual const uint8_t* get_read_page(uint16_t addr) {
+        return mmu.get_read_page(addr);
+    }
+
+    // Writes through the page bypass the tracker, the caller invalidates.
+    virtual uint8_t* get_write_page(uint16_t addr) {
+        return mmu.get_write_page(addr);
+    }
+
+    virtual const uint8_t* const* get_read_page_table() {
+        return mmu.get_read_page_table();
+    }
+
+    virtual uint8_t* const* get_write_page_table() {
+        return mmu.get_write_page_table();
+    }
+
+private:
+    IMmu& mmu;
+    Cache& cache;
+};
+
+
+}
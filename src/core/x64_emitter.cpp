@@ -0,0 +1,362 @@
+#include "x64_emitter.h"
+
+#ifdef GEEMUBOI_HAS_JIT
+
+#include <cstring>
+#include <new>
+
+#include <sys/mman.h>
+
+namespace geemuboi::core {
+
+
+CodeBuffer::CodeBuffer(size_t size_in) : data{}, size{size_in}, writable{true} {
+    void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+
+    data = static_cast<uint8_t*>(mapping);
+}
+
+CodeBuffer::~CodeBuffer() {
+    munmap(data, size);
+}
+
+void CodeBuffer::make_writable() {
+    if (!writable) {
+        mprotect(data, size, PROT_READ | PROT_WRITE);
+        writable = true;
+    }
+}
+
+void CodeBuffer::make_executable() {
+    if (writable) {
+        mprotect(data, size, PROT_READ | PROT_EXEC);
+        writable = false;
+    }
+}
+
+
+X64Emitter::X64Emitter(uint8_t* buffer_in, size_t capacity_in)
+    : buffer{buffer_in},
+    capacity{capacity_in},
+    size{} {}
+
+
+void X64Emitter::mov(int dst, int src) {
+    emit_rr(0, false, false, 0x89, src, dst);
+}
+
+void X64Emitter::mov64(int dst, int src) {
+    emit_rr(0, true, false, 0x89, src, dst);
+}
+
+void X64Emitter::mov_imm(int dst, uint32_t imm) {
+    emit_rex(false, false, 0, 0, dst);
+    emit8(0xB8 + (dst & 7));
+    emit32(imm);
+}
+
+void X64Emitter::mov64_imm(int dst, uint64_t imm) {
+    emit_rex(true, false, 0, 0, dst);
+    emit8(0xB8 + (dst & 7));
+    emit64(imm);
+}
+
+void X64Emitter::load64(int dst, const Mem& src) {
+    emit_rm(0, true, false, 0x8B, dst, src);
+}
+
+void X64Emitter::store64(const Mem& dst, int src) {
+    emit_rm(0, true, false, 0x89, src, dst);
+}
+
+void X64Emitter::load8(int dst, const Mem& src) {
+    emit_rm(0, false, false, 0x0FB6, dst, src);
+}
+
+void X64Emitter::load16(int dst, const Mem& src) {
+    emit_rm(0, false, false, 0x0FB7, dst, src);
+}
+
+void X64Emitter::store8(const Mem& dst, int src) {
+    emit_rm(0, false, true, 0x88, src, dst);
+}
+
+void X64Emitter::store8_imm(const Mem& dst, uint8_t imm) {
+    emit_rm(0, false, false, 0xC6, 0, dst);
+    emit8(imm);
+}
+
+void X64Emitter::store16(const Mem& dst, int src) {
+    emit_rm(0x66, false, false, 0x89, src, dst);
+}
+
+void X64Emitter::store16_imm(const Mem& dst, uint16_t imm) {
+    emit_rm(0x66, false, false, 0xC7, 0, dst);
+    emit16(imm);
+}
+
+void X64Emitter::mov8(int dst, int src) {
+    emit_rr(0, false, true, 0x88, src, dst);
+}
+
+void X64Emitter::movzx8(int dst, int src) {
+    emit_rr(0, false, true, 0x0FB6, dst, src);
+}
+
+void X64Emitter::movzx_ah(int dst) {
+    emit8(0x0F);
+    emit8(0xB6);
+    emit8(0xC0 | (dst << 3) | RSP);
+}
+
+
+void X64Emitter::alu(int op, int dst, int src) {
+    emit_rr(0, false, false, op * 8 + 1, src, dst);
+}
+
+void X64Emitter::alu_imm(int op, int dst, int32_t imm) {
+    if (imm >= -128 && imm <= 127) {
+        emit_rr(0, false, false, 0x83, op, dst);
+        emit8(imm);
+    } else {
+        emit_rr(0, false, false, 0x81, op, dst);
+        emit32(imm);
+    }
+}
+
+void X64Emitter::alu8(int op, int dst, int src) {
+    emit_rr(0, false, true, op * 8, src, dst);
+}
+
+void X64Emitter::alu8_imm(int op, int dst, uint8_t imm) {
+    emit_rr(0, false, true, 0x80, op, dst);
+    emit8(imm);
+}
+
+void X64Emitter::alu_mem_imm(int op, const Mem& dst, int32_t imm) {
+    if (imm >= -128 && imm <= 127) {
+        emit_rm(0, false, false, 0x83, op, dst);
+        emit8(imm);
+    } else {
+        emit_rm(0, false, false, 0x81, op, dst);
+        emit32(imm);
+    }
+}
+
+void X64Emitter::alu8_mem_imm(int op, const Mem& dst, uint8_t imm) {
+    emit_rm(0, false, false, 0x80, op, dst);
+    emit8(imm);
+}
+
+void X64Emitter::alu64_imm(int op, int dst, int32_t imm) {
+    if (imm >= -128 && imm <= 127) {
+        emit_rr(0, true, false, 0x83, op, dst);
+        emit8(imm);
+    } else {
+        emit_rr(0, true, false, 0x81, op, dst);
+        emit32(imm);
+    }
+}
+
+void X64Emitter::shift(int op, int reg, uint8_t count) {
+    emit_rr(0, false, false, 0xC1, op, reg);
+    emit8(count);
+}
+
+void X64Emitter::shift8(int op, int reg, uint8_t count) {
+    emit_rr(0, false, true, 0xC0, op, reg);
+    emit8(count);
+}
+
+void X64Emitter::shift16(int op, int reg, uint8_t count) {
+    emit_rr(0x66, false, false, 0xC1, op, reg);
+    emit8(count);
+}
+
+void X64Emitter::inc8(int reg) {
+    emit_rr(0, false, true, 0xFE, 0, reg);
+}
+
+void X64Emitter::dec8(int reg) {
+    emit_rr(0, false, true, 0xFE, 1, reg);
+}
+
+void X64Emitter::inc16(int reg) {
+    emit_rr(0x66, false, false, 0xFF, 0, reg);
+}
+
+void X64Emitter::dec16(int reg) {
+    emit_rr(0x66, false, false, 0xFF, 1, reg);
+}
+
+void X64Emitter::test8_imm(int reg, uint8_t imm) {
+    emit_rr(0, false, true, 0xF6, 0, reg);
+    emit8(imm);
+}
+
+void X64Emitter::test8(int reg, int other) {
+    emit_rr(0, false, true, 0x84, other, reg);
+}
+
+void X64Emitter::test64(int reg, int other) {
+    emit_rr(0, true, false, 0x85, other, reg);
+}
+
+void X64Emitter::bt(int reg, uint8_t bit) {
+    emit_rr(0, false, false, 0x0FBA, 4, reg);
+    emit8(bit);
+}
+
+void X64Emitter::setcc(int cond, int reg) {
+    emit_rr(0, false, true, 0x0F90 + cond, 0, reg);
+}
+
+void X64Emitter::lahf() {
+    emit8(0x9F);
+}
+
+
+void X64Emitter::push(int reg) {
+    emit_rex(false, false, 0, 0, reg);
+    emit8(0x50 + (reg & 7));
+}
+
+void X64Emitter::pop(int reg) {
+    emit_rex(false, false, 0, 0, reg);
+    emit8(0x58 + (reg & 7));
+}
+
+void X64Emitter::ret() {
+    emit8(0xC3);
+}
+
+void X64Emitter::call(const Mem& target) {
+    emit_rm(0, false, false, 0xFF, 2, target);
+}
+
+void X64Emitter::jmp(int reg) {
+    emit_rr(0, false, false, 0xFF, 4, reg);
+}
+
+void X64Emitter::jmp(const uint8_t* target) {
+    emit8(0xE9);
+    emit_rel32(target);
+}
+
+void X64Emitter::jmp(Label& label) {
+    emit8(0xE9);
+    emit_label_offset(label);
+}
+
+void X64Emitter::jcc(int cond, Label& label) {
+    emit8(0x0F);
+    emit8(0x80 + cond);
+    emit_label_offset(label);
+}
+
+void X64Emitter::bind(Label& label) {
+    label.offset = size;
+    for (size_t fixup : label.fixups) {
+        if (fixup + 4 <= capacity) {
+            patch_jump(buffer + fixup, buffer + size);
+        }
+    }
+    label.fixups.clear();
+}
+
+
+void X64Emitter::patch_jump(uint8_t* offset, const uint8_t* target) {
+    int32_t rel = static_cast<int32_t>(target - (offset + 4));
+    std::memcpy(offset, &rel, sizeof(rel));
+}
+
+
+void X64Emitter::emit8(uint8_t val) {
+    if (size < capacity) {
+        buffer[size] = val;
+    }
+    ++size;
+}
+
+void X64Emitter::emit16(uint16_t val) {
+    emit8(val);
+    emit8(val >> 8);
+}
+
+void X64Emitter::emit32(uint32_t val) {
+    emit16(val);
+    emit16(val >> 16);
+}
+
+void X64Emitter::emit64(uint64_t val) {
+    emit32(val);
+    emit32(val >> 32);
+}
+
+void X64Emitter::emit_rr(int prefix, bool wide, bool bytes, int opcode, int reg, int rm) {
+    if (prefix) {
+        emit8(prefix);
+    }
+    emit_rex(wide, bytes, reg, 0, rm);
+    emit_opcode(opcode);
+    emit8(0xC0 | ((reg & 7) << 3) | (rm & 7));
+}
+
+void X64Emitter::emit_rm(int prefix, bool wide, bool bytes, int opcode, int reg, const Mem& rm) {
+    if (prefix) {
+        emit8(prefix);
+    }
+    emit_rex(wide, bytes, reg, rm.index < 0 ? 0 : rm.index, rm.base);
+    emit_opcode(opcode);
+
+    // Always with a displacement, so RBP and R13 need no special case
+    bool short_disp = rm.disp >= -128 && rm.disp <= 127;
+    bool sib = rm.index >= 0 || (rm.base & 7) == RSP;
+    emit8(((short_disp ? 1 : 2) << 6) | ((reg & 7) << 3) | (sib ? RSP : rm.base & 7));
+    if (sib) {
+        int scale = rm.scale == 8 ? 3 : rm.scale == 4 ? 2 : rm.scale == 2 ? 1 : 0;
+        int index = rm.index < 0 ? RSP : rm.index;
+        emit8((scale << 6) | ((index & 7) << 3) | (rm.base & 7));
+    }
+
+    if (short_disp) {
+        emit8(rm.disp);
+    } else {
+        emit32(rm.disp);
+    }
+}
+
+void X64Emitter::emit_rex(bool wide, bool force, int reg, int index, int base) {
+    uint8_t rex = 0x40 | (wide << 3) | ((reg & 8) >> 1) | ((index & 8) >> 2) | ((base & 8) >> 3);
+    if (rex != 0x40 || force) {
+        emit8(rex);
+    }
+}
+
+void X64Emitter::emit_opcode(int opcode) {
+    if (opcode > 0xFF) {
+        emit8(opcode >> 8);
+    }
+    emit8(opcode);
+}
+
+void X64Emitter::emit_rel32(const uint8_t* target) {
+    emit32(static_cast<uint32_t>(target - (get_position() + 4)));
+}
+
+void X64Emitter::emit_label_offset(Label& label) {
+    if (label.offset >= 0) {
+        emit32(static_cast<uint32_t>(label.offset - static_cast<long>(size + 4)));
+    } else {
+        label.fixups.push_back(size);
+        emit32(0);
+    }
+}
+
+
+}
+
+#endif
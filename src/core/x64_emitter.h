@@ -0,0 +1,152 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Generated code needs an x86-64 host and mmap
+#if defined(__x86_64__) && defined(__unix__)
+#define GEEMUBOI_HAS_JIT
+#endif
+
+namespace geemuboi::core {
+
+
+// Memory for generated code, mapped either writable or executable but never
+// both at once.
+class CodeBuffer {
+public:
+    explicit CodeBuffer(size_t size_in);
+    ~CodeBuffer();
+
+    CodeBuffer(const CodeBuffer&) = delete;
+    CodeBuffer& operator=(const CodeBuffer&) = delete;
+
+    uint8_t* get_data() { return data; }
+    size_t get_size() const { return size; }
+
+    // Both only call into the kernel if the mapping changes
+    void make_writable();
+    void make_executable();
+
+private:
+    uint8_t* data;
+    size_t size;
+    bool writable;
+};
+
+
+// Just enough of an x86-64 assembler for the recompiler. Registers are
+// numbered as in Regs, operations are 32-bit unless their name says
+// otherwise. Writing past the end of the buffer is recorded instead of done,
+// has_overflowed() tells.
+class X64Emitter {
+public:
+    enum Regs { RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI, R8, R9, R10, R11, R12, R13, R14, R15 };
+
+    // In encoding order
+    enum Conditions {
+        COND_O, COND_NO, COND_B, COND_AE, COND_E, COND_NE, COND_BE, COND_A,
+        COND_S, COND_NS, COND_P, COND_NP, COND_L, COND_GE, COND_LE, COND_G
+    };
+    enum AluOps { ALU_ADD, ALU_OR, ALU_ADC, ALU_SBB, ALU_AND, ALU_SUB, ALU_XOR, ALU_CMP };
+    enum ShiftOps { SHIFT_ROL, SHIFT_ROR, SHIFT_RCL, SHIFT_RCR, SHIFT_SHL, SHIFT_SHR, SHIFT_SAR = 7 };
+
+    // [base + index * scale + disp], without an index if index is -1
+    struct Mem {
+        int base;
+        int index;
+        int scale;
+        int32_t disp;
+    };
+
+    static Mem mem(int base, int32_t disp = 0) { return {base, -1, 1, disp}; }
+    static Mem mem(int base, int index, int scale, int32_t disp = 0) { return {base, index, scale, disp}; }
+
+    // A jump target within the buffer, bound before or after the jumps to it
+    struct Label {
+        Label() : offset{-1}, fixups{} {}
+
+        long offset;
+        std::vector<size_t> fixups;
+    };
+
+    X64Emitter(uint8_t* buffer_in, size_t capacity_in);
+
+    uint8_t* get_position() { return buffer + size; }
+    size_t get_size() const { return size; }
+    bool has_overflowed() const { return size > capacity; }
+
+    void mov(int dst, int src);
+    void mov64(int dst, int src);
+    void mov_imm(int dst, uint32_t imm);
+    void mov64_imm(int dst, uint64_t imm);
+    void load64(int dst, const Mem& src);
+    void store64(const Mem& dst, int src);
+    // Zero extending loads
+    void load8(int dst, const Mem& src);
+    void load16(int dst, const Mem& src);
+    void store8(const Mem& dst, int src);
+    void store8_imm(const Mem& dst, uint8_t imm);
+    void store16(const Mem& dst, int src);
+    void store16_imm(const Mem& dst, uint16_t imm);
+    void mov8(int dst, int src);
+    void movzx8(int dst, int src);
+    // movzx from AH, which can only go to RAX to RDI
+    void movzx_ah(int dst);
+
+    void alu(int op, int dst, int src);
+    void alu_imm(int op, int dst, int32_t imm);
+    void alu8(int op, int dst, int src);
+    void alu8_imm(int op, int dst, uint8_t imm);
+    void alu_mem_imm(int op, const Mem& dst, int32_t imm);
+    void alu8_mem_imm(int op, const Mem& dst, uint8_t imm);
+    void alu64_imm(int op, int dst, int32_t imm);
+    void shift(int op, int reg, uint8_t count);
+    void shift8(int op, int reg, uint8_t count);
+    void shift16(int op, int reg, uint8_t count);
+    void inc8(int reg);
+    void dec8(int reg);
+    void inc16(int reg);
+    void dec16(int reg);
+    void test8_imm(int reg, uint8_t imm);
+    void test8(int reg, int other);
+    void test64(int reg, int other);
+    void bt(int reg, uint8_t bit);
+    void setcc(int cond, int reg);
+    void lahf();
+
+    void push(int reg);
+    void pop(int reg);
+    void ret();
+    void call(const Mem& target);
+    void jmp(int reg);
+    void jmp(const uint8_t* target);
+    void jmp(Label& label);
+    void jcc(int cond, Label& label);
+    void bind(Label& label);
+
+    // Points the rel32 of an already emitted jump, found at offset, at target
+    static void patch_jump(uint8_t* offset, const uint8_t* target);
+
+private:
+    void emit8(uint8_t val);
+    void emit16(uint16_t val);
+    void emit32(uint32_t val);
+    void emit64(uint64_t val);
+    // The prefix goes before REX, the opcode may be two bytes. Byte
+    // operands always get a REX, which selects SPL to DIL over AH to BH.
+    void emit_rr(int prefix, bool wide, bool bytes, int opcode, int reg, int rm);
+    void emit_rm(int prefix, bool wide, bool bytes, int opcode, int reg, const Mem& rm);
+    void emit_rex(bool wide, bool force, int reg, int index, int base);
+    void emit_opcode(int opcode);
+    void emit_rel32(const uint8_t* target);
+    void emit_label_offset(Label& label);
+
+    uint8_t* buffer;
+    size_t capacity;
+    size_t size;
+};
+
+
+}
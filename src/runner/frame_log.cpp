@@ -0,0 +1,53 @@
+#include "runner/frame_log.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+
+namespace geemuboi::runner {
+
+
+std::vector<uint64_t> read_frame_log(const std::string& path) {
+    std::ifstream ifs(path);
+    if (!ifs) {
+        throw std::runtime_error("Could not open frame log " + path);
+    }
+
+    std::vector<uint64_t> hashes;
+    uint64_t hash;
+    while (ifs >> std::hex >> hash) {
+        hashes.push_back(hash);
+    }
+
+    if (!ifs.eof()) {
+        throw std::runtime_error("Invalid hash on line " + std::to_string(hashes.size() + 1) +
+                                 " of frame log " + path);
+    }
+
+    return hashes;
+}
+
+void write_frame_log(const std::string& path, const std::vector<uint64_t>& hashes) {
+    std::ofstream ofs(path, std::ios::trunc);
+    for (uint64_t hash : hashes) {
+        ofs << std::hex << std::setw(16) << std::setfill('0') << hash << '\n';
+    }
+
+    if (!ofs) {
+        throw std::runtime_error("Could not write frame log " + path);
+    }
+}
+
+int find_divergent_frame(const std::vector<uint64_t>& golden, const std::vector<uint64_t>& hashes) {
+    auto [golden_it, hashes_it] = std::mismatch(golden.begin(), golden.end(),
+                                                hashes.begin(), hashes.end());
+    if (golden_it == golden.end() && hashes_it == hashes.end()) {
+        return -1;
+    }
+
+    return static_cast<int>(golden_it - golden.begin());
+}
+
+
+}
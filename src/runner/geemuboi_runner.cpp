@@ -0,0 +1,124 @@
+#include "core/hash.h"
+#include "core/thread_pool.h"
+#include "runner/job.h"
+#include "runner/manifest.h"
+#include "runner/result_cache.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <args.hxx>
+
+using namespace geemuboi::core;
+using namespace geemuboi::runner;
+
+namespace {
+
+const char* const STATUS_NAMES[] = {"PASS", "FAIL", "ERROR"};
+
+// Results are only reused by the exact same emulator binary
+uint64_t get_build_hash(const char* argv0) {
+    std::vector<uint8_t> build = read_rom("/proc/self/exe");
+    if (build.empty()) {
+        build = read_rom(argv0);
+    }
+
+    return hash_bytes(build.data(), build.size());
+}
+
+}
+
+
+int main(int argc, char* argv[]) {
+    using namespace std::chrono;
+
+    args::ArgumentParser parser("Runs ROMs headless and checks the outcome of each.");
+    args::HelpFlag help(parser, "help", "Display this help menu", {'h', "help"});
+    args::Positional<std::string> manifest_file(parser, "MANIFEST", "The tests to run.");
+    args::ValueFlag<int> jobs(parser, "jobs", "Number of tests run at once, one per core by default.", {'j', "jobs"});
+    args::ValueFlag<std::string> cache_file(parser, "cache", "Where results are cached.", {"cache"});
+    args::Flag no_cache(parser, "no-cache", "Run every test, even if its result is cached.", {"no-cache"});
+    args::Flag update_logs(parser, "update-logs",
+            "Write the frame logs of log: tests instead of checking them.", {"update-logs"});
+
+    try {
+        parser.ParseCLI(argc, argv);
+    } catch (args::Help&) {
+        std::cout << parser;
+        return 0;
+    } catch (args::ParseError& e) {
+        std::cerr << e.what() << std::endl;
+        std::cerr << parser;
+        return 1;
+    }
+
+    if (!manifest_file) {
+        std::cout << "Missing MANIFEST argument" << std::endl;
+        return 1;
+    }
+
+    std::vector<ManifestEntry> entries;
+    try {
+        entries = read_manifest(args::get(manifest_file));
+    } catch (const ManifestException& e) {
+        std::cerr << args::get(manifest_file) << ":" << e.get_line() << ": " << e.what() << std::endl;
+        return 1;
+    }
+
+    std::string cache_path = cache_file ? args::get(cache_file) : "geemuboi_runner.cache";
+    ResultCache cache(cache_path);
+    uint64_t build_hash = get_build_hash(argv[0]);
+
+    ThreadPool pool(jobs ? args::get(jobs) : 0);
+    std::vector<JobResult> results(entries.size());
+    std::mutex output_mutex;
+    int counts[3] = {};
+    int cached = 0;
+
+    auto start = steady_clock::now();
+    pool.run(static_cast<int>(entries.size()), [&](int i) {
+        const ManifestEntry& entry = entries[i];
+        std::vector<uint8_t> rom = read_rom(entry.rom);
+        uint64_t key = get_cache_key(entry, rom, build_hash);
+
+        // Updated logs are new golden logs, the results don't say anything
+        bool use_cache = !rom.empty() && !update_logs;
+        bool hit = use_cache && !no_cache && cache.lookup(key, results[i]);
+        if (!hit) {
+            results[i] = run_job(entry, rom, static_cast<bool>(update_logs));
+            if (use_cache) {
+                cache.store(key, results[i]);
+            }
+        }
+
+        const JobResult& result = results[i];
+        std::lock_guard<std::mutex> lock(output_mutex);
+        ++counts[result.status];
+        cached += hit;
+        std::cout << std::left << std::setw(6) << STATUS_NAMES[result.status] << entry.rom
+                  << std::fixed << std::setprecision(2) << " (" << result.seconds << " s"
+                  << (hit ? ", cached" : "") << ")";
+        if (!result.detail.empty()) {
+            std::cout << ": " << result.detail;
+        }
+        std::cout << std::endl;
+    });
+
+    if (!cache.save()) {
+        std::cerr << "Could not write the result cache " << cache_path << std::endl;
+    }
+
+    double seconds = duration<double>(steady_clock::now() - start).count();
+    std::cout << counts[JobResult::STATUS_PASS] << " passed, "
+              << counts[JobResult::STATUS_FAIL] << " failed, "
+              << counts[JobResult::STATUS_ERROR] << " errors, "
+              << cached << " cached, in " << std::fixed << std::setprecision(2) << seconds
+              << " s on " << pool.get_threads() << " threads" << std::endl;
+
+    return counts[JobResult::STATUS_PASS] == static_cast<int>(entries.size()) ? 0 : 1;
+}
@@ -0,0 +1,189 @@
+#include "runner/job.h"
+
+#include "core/hash.h"
+#include "core/machine.h"
+#include "core/serial_sink.h"
+#include "runner/frame_log.h"
+#include "view/renderer.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <sstream>
+
+namespace geemuboi::runner {
+
+using namespace geemuboi::core;
+using geemuboi::view::Renderer;
+
+
+namespace {
+
+// Test ROMs that don't make it say so
+const std::string FAILED_TEXT = "Failed";
+// Of serial output in failure details, from the end
+const size_t MAX_DETAIL_TEXT = 200;
+
+std::string format_hash(uint64_t hash) {
+    std::ostringstream text;
+    text << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return text.str();
+}
+
+// On a single line, with anything unprintable as a dot
+std::string format_serial(const std::string& text) {
+    std::string formatted;
+    if (text.size() > MAX_DETAIL_TEXT) {
+        formatted = "...";
+    }
+
+    for (size_t i = text.size() - std::min(text.size(), MAX_DETAIL_TEXT); i != text.size(); ++i) {
+        unsigned char c = text[i];
+        if (c == '\n') {
+            formatted += "\\n";
+        } else {
+            formatted += std::isprint(c) ? static_cast<char>(c) : '.';
+        }
+    }
+
+    return "\"" + formatted + "\"";
+}
+
+void check_frame_hash(const ManifestEntry& entry, Machine& machine, JobResult& result) {
+    for (int i = 0; i != entry.frames; ++i) {
+        machine.step_frame();
+    }
+
+    uint64_t hash = hash_bytes(machine.get_framebuffer(),
+                               Renderer::SCREEN_WIDTH * Renderer::SCREEN_HEIGHT * sizeof(uint32_t));
+    if (hash == entry.frame_hash) {
+        result.status = JobResult::STATUS_PASS;
+    } else {
+        result.status = JobResult::STATUS_FAIL;
+        result.detail = "frame hash " + format_hash(hash) + ", expected " +
+                        format_hash(entry.frame_hash);
+    }
+}
+
+void check_frame_log(const ManifestEntry& entry, Machine& machine, bool update_logs,
+                     JobResult& result) {
+    std::vector<uint64_t> hashes;
+    hashes.reserve(entry.frames);
+    machine.set_frame_hashing(true);
+    for (int i = 0; i != entry.frames; ++i) {
+        machine.step_frame();
+        hashes.push_back(machine.get_frame_hash());
+    }
+
+    if (update_logs) {
+        write_frame_log(entry.frame_log, hashes);
+        result.status = JobResult::STATUS_PASS;
+        result.detail = "wrote " + entry.frame_log;
+        return;
+    }
+
+    std::vector<uint64_t> golden = read_frame_log(entry.frame_log);
+    int frame = find_divergent_frame(golden, hashes);
+    if (frame == -1) {
+        result.status = JobResult::STATUS_PASS;
+    } else if (frame == static_cast<int>(golden.size())) {
+        result.status = JobResult::STATUS_FAIL;
+        result.detail = "the golden log ends at frame " + std::to_string(frame);
+    } else {
+        result.status = JobResult::STATUS_FAIL;
+        result.detail = "frame " + std::to_string(frame) + " diverges, hash " +
+                        format_hash(hashes[frame]) + ", expected " + format_hash(golden[frame]);
+    }
+}
+
+void check_serial(const ManifestEntry& entry, Machine& machine, JobResult& result) {
+    BufferSerialSink serial;
+    machine.set_serial_sink(&serial);
+
+    const std::string& text = serial.get_text();
+    int frame = 0;
+    while (frame != entry.frames) {
+        machine.step_frame();
+        ++frame;
+
+        if (text.find(entry.serial_text) != std::string::npos) {
+            result.status = JobResult::STATUS_PASS;
+            break;
+        }
+
+        if (text.find(FAILED_TEXT) != std::string::npos) {
+            break;
+        }
+    }
+
+    machine.set_serial_sink(nullptr);
+    if (result.status != JobResult::STATUS_PASS) {
+        result.status = JobResult::STATUS_FAIL;
+        result.detail = "serial output " + format_serial(text) + " after " +
+                        std::to_string(frame) + " frames";
+    }
+}
+
+}
+
+
+std::vector<uint8_t> read_rom(const std::string& path) {
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs) {
+        return {};
+    }
+
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+}
+
+uint64_t get_cache_key(const ManifestEntry& entry, const std::vector<uint8_t>& rom,
+                       uint64_t build_hash) {
+    const uint64_t parameters[] = {
+        static_cast<uint64_t>(entry.frames),
+        static_cast<uint64_t>(entry.expectation),
+        entry.frame_hash
+    };
+
+    uint64_t key = hash_bytes(rom.data(), rom.size(), build_hash);
+    key = hash_bytes(entry.serial_text.data(), entry.serial_text.size(), key);
+    if (entry.expectation == ManifestEntry::EXPECT_FRAME_LOG) {
+        std::vector<uint8_t> golden = read_rom(entry.frame_log);
+        key = hash_bytes(golden.data(), golden.size(), key);
+    }
+    return hash_bytes(parameters, sizeof(parameters), key);
+}
+
+JobResult run_job(const ManifestEntry& entry, const std::vector<uint8_t>& rom,
+                  bool update_logs) {
+    using namespace std::chrono;
+
+    JobResult result{JobResult::STATUS_ERROR, "", 0};
+    if (rom.empty()) {
+        result.detail = "Could not read " + entry.rom;
+        return result;
+    }
+
+    auto start = steady_clock::now();
+    try {
+        Machine machine(rom);
+        if (entry.expectation == ManifestEntry::EXPECT_SERIAL) {
+            check_serial(entry, machine, result);
+        } else if (entry.expectation == ManifestEntry::EXPECT_FRAME_LOG) {
+            check_frame_log(entry, machine, update_logs, result);
+        } else {
+            check_frame_hash(entry, machine, result);
+        }
+    } catch (const std::exception& e) {
+        result.detail = e.what();
+    }
+
+    result.seconds = duration<double>(steady_clock::now() - start).count();
+    return result;
+}
+
+
+}
@@ -0,0 +1,113 @@
+#include "runner/manifest.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace geemuboi::runner {
+
+
+namespace {
+
+const std::string HASH_PREFIX = "hash:";
+const std::string SERIAL_PREFIX = "serial:";
+const std::string LOG_PREFIX = "log:";
+
+std::string resolve(const std::string& path, const std::string& base_dir) {
+    std::filesystem::path resolved(path);
+    if (resolved.is_relative()) {
+        return (std::filesystem::path(base_dir) / resolved).string();
+    }
+
+    return path;
+}
+
+void parse_expectation(const std::string& text, ManifestEntry& entry) {
+    if (text.compare(0, HASH_PREFIX.size(), HASH_PREFIX) == 0) {
+        std::string digits = text.substr(HASH_PREFIX.size());
+        size_t parsed = 0;
+        try {
+            entry.frame_hash = std::stoull(digits, &parsed, 16);
+        } catch (const std::logic_error&) {
+            parsed = 0;
+        }
+
+        if (digits.empty() || parsed != digits.size()) {
+            throw ManifestException("Invalid frame hash " + digits, entry.line);
+        }
+
+        entry.expectation = ManifestEntry::EXPECT_FRAME_HASH;
+        return;
+    }
+
+    if (text.compare(0, SERIAL_PREFIX.size(), SERIAL_PREFIX) == 0) {
+        entry.serial_text = text.substr(SERIAL_PREFIX.size());
+        if (entry.serial_text.empty()) {
+            throw ManifestException("Empty serial text", entry.line);
+        }
+
+        entry.expectation = ManifestEntry::EXPECT_SERIAL;
+        return;
+    }
+
+    if (text.compare(0, LOG_PREFIX.size(), LOG_PREFIX) == 0) {
+        entry.frame_log = text.substr(LOG_PREFIX.size());
+        if (entry.frame_log.empty()) {
+            throw ManifestException("Missing frame log path", entry.line);
+        }
+
+        entry.expectation = ManifestEntry::EXPECT_FRAME_LOG;
+        return;
+    }
+
+    throw ManifestException("Unknown expectation " + text, entry.line);
+}
+
+}
+
+
+std::vector<ManifestEntry> parse_manifest(std::istream& in, const std::string& base_dir) {
+    std::vector<ManifestEntry> entries;
+
+    std::string line;
+    for (int line_nbr = 1; std::getline(in, line); ++line_nbr) {
+        std::istringstream fields(line);
+        ManifestEntry entry{};
+        entry.line = line_nbr;
+
+        if (!(fields >> entry.rom) || entry.rom[0] == '#') {
+            continue;
+        }
+
+        if (!(fields >> entry.frames) || entry.frames < 0) {
+            throw ManifestException("Missing or invalid frame count", line_nbr);
+        }
+
+        std::string expectation;
+        if (!(fields >> std::ws) || !std::getline(fields, expectation)) {
+            throw ManifestException("Missing expectation", line_nbr);
+        }
+        parse_expectation(expectation.substr(0, expectation.find_last_not_of(" \t\r") + 1), entry);
+
+        entry.rom = resolve(entry.rom, base_dir);
+        if (!entry.frame_log.empty()) {
+            entry.frame_log = resolve(entry.frame_log, base_dir);
+        }
+
+        entries.push_back(entry);
+    }
+
+    return entries;
+}
+
+std::vector<ManifestEntry> read_manifest(const std::string& path) {
+    std::ifstream ifs(path);
+    if (!ifs) {
+        throw ManifestException("Could not open manifest " + path, 0);
+    }
+
+    return parse_manifest(ifs, std::filesystem::path(path).parent_path().string());
+}
+
+
+}
@@ -0,0 +1,56 @@
+#include "runner/result_cache.h"
+
+#include <fstream>
+#include <sstream>
+
+namespace geemuboi::runner {
+
+
+ResultCache::ResultCache(const std::string& path_in) : path{path_in},
+    results{},
+    mutex{} {
+
+    std::ifstream ifs(path);
+    std::string line;
+    while (std::getline(ifs, line)) {
+        std::istringstream fields(line);
+        uint64_t key;
+        JobResult result{};
+        if (!(fields >> std::hex >> key >> std::dec >> result.status >> result.seconds)) {
+            continue;
+        }
+
+        std::getline(fields >> std::ws, result.detail);
+        results[key] = result;
+    }
+}
+
+bool ResultCache::lookup(uint64_t key, JobResult& result) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = results.find(key);
+    if (it == results.end()) {
+        return false;
+    }
+
+    result = it->second;
+    return true;
+}
+
+void ResultCache::store(uint64_t key, const JobResult& result) {
+    std::lock_guard<std::mutex> lock(mutex);
+    results[key] = result;
+}
+
+bool ResultCache::save() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::ofstream ofs(path, std::ios::trunc);
+    for (const auto& [key, result] : results) {
+        ofs << std::hex << key << std::dec << ' ' << result.status << ' ' << result.seconds << ' '
+            << result.detail << '\n';
+    }
+
+    return static_cast<bool>(ofs);
+}
+
+
+}
@@ -0,0 +1,139 @@
+#include "view/capture.h"
+
+#include "core/byte_codec.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+namespace geemuboi::view {
+
+
+namespace {
+
+// "GBVC"
+const uint32_t CAPTURE_MAGIC = 0x43564247;
+const uint32_t CAPTURE_VERSION = 1;
+
+const int PIXELS = Renderer::SCREEN_WIDTH * Renderer::SCREEN_HEIGHT;
+const int PACKED_SIZE = PIXELS / 4;
+
+using geemuboi::core::write_fixed;
+using geemuboi::core::write_varint;
+using CaptureReader = geemuboi::core::ByteReader<InvalidCaptureException>;
+
+}
+
+
+CaptureEncoder::CaptureEncoder() : previous(PACKED_SIZE), packed(PACKED_SIZE), next_frame{} {}
+
+void CaptureEncoder::encode_header(std::vector<uint8_t>& out) const {
+    write_fixed(out, CAPTURE_MAGIC, 4);
+    write_fixed(out, CAPTURE_VERSION, 4);
+    write_fixed(out, Renderer::SCREEN_WIDTH, 2);
+    write_fixed(out, Renderer::SCREEN_HEIGHT, 2);
+}
+
+void CaptureEncoder::encode_frame(const uint8_t shades[], uint64_t frame, std::vector<uint8_t>& out) {
+    for (int i = 0; i != PACKED_SIZE; ++i) {
+        const uint8_t* four = shades + i * 4;
+        uint8_t byte = static_cast<uint8_t>((four[0] & 0x3) | (four[1] & 0x3) << 2 |
+                                            (four[2] & 0x3) << 4 | (four[3] & 0x3) << 6);
+        packed[i] = byte ^ previous[i];
+        previous[i] = byte;
+    }
+
+    write_varint(out, frame - next_frame);
+    next_frame = frame + 1;
+
+    // Alternating runs of unchanged and changed bytes. A lone unchanged byte
+    // is cheaper kept in the changed run than ending it.
+    int i = 0;
+    while (i != PACKED_SIZE) {
+        int same = i;
+        while (same != PACKED_SIZE && !packed[same]) {
+            ++same;
+        }
+
+        int changed = same;
+        while (changed != PACKED_SIZE &&
+               (packed[changed] || (changed + 1 != PACKED_SIZE && packed[changed + 1]))) {
+            ++changed;
+        }
+
+        write_varint(out, same - i);
+        write_varint(out, changed - same);
+        out.insert(out.end(), packed.begin() + same, packed.begin() + changed);
+        i = changed;
+    }
+}
+
+std::vector<CaptureFrame> decode_capture(const uint8_t* data, size_t size) {
+    CaptureReader reader(data, size, "capture");
+    if (reader.read_fixed(4) != CAPTURE_MAGIC || reader.read_fixed(4) != CAPTURE_VERSION) {
+        throw InvalidCaptureException("Not a capture of this version.");
+    }
+
+    if (reader.read_fixed(2) != Renderer::SCREEN_WIDTH ||
+        reader.read_fixed(2) != Renderer::SCREEN_HEIGHT) {
+        throw InvalidCaptureException("The capture has another screen size.");
+    }
+
+    std::vector<CaptureFrame> frames;
+    std::vector<uint8_t> packed(PACKED_SIZE);
+    uint64_t next_frame = 0;
+    while (!reader.at_end()) {
+        CaptureFrame frame{};
+        frame.frame = next_frame + reader.read_varint();
+        next_frame = frame.frame + 1;
+
+        uint64_t i = 0;
+        while (i != PACKED_SIZE) {
+            uint64_t same = reader.read_varint();
+            uint64_t changed = reader.read_varint();
+            if (same > PACKED_SIZE - i || changed > PACKED_SIZE - i - same) {
+                throw InvalidCaptureException("The capture has a run outside its frame.");
+            }
+
+            i += same;
+            const uint8_t* bytes = reader.read_bytes(changed);
+            for (uint64_t j = 0; j != changed; ++j) {
+                packed[i++] ^= bytes[j];
+            }
+        }
+
+        frame.shades.resize(PIXELS);
+        for (int p = 0; p != PIXELS; ++p) {
+            frame.shades[p] = (packed[p / 4] >> (2 * (p % 4))) & 0x3;
+        }
+        frames.push_back(std::move(frame));
+    }
+
+    return frames;
+}
+
+std::vector<CaptureFrame> read_capture(const std::string& path) {
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs) {
+        throw std::runtime_error("Could not open " + path);
+    }
+
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    return decode_capture(data.data(), data.size());
+}
+
+
+void shades_to_yuv(const uint8_t shades[], uint8_t yuv[]) {
+    // The luma of Renderer::expand_shades() colors
+    static const uint8_t SHADE_LUMA[Renderer::NBR_SHADES] = {235, 181, 95, 16};
+
+    for (int i = 0; i != PIXELS; ++i) {
+        yuv[i] = SHADE_LUMA[shades[i] & 0x3];
+    }
+
+    // Grays have no color
+    std::fill(yuv + PIXELS, yuv + YUV_FRAME_SIZE, 128);
+}
+
+
+}
@@ -0,0 +1,201 @@
+#include "view/recording_renderer.h"
+
+#include "view/capture.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+namespace geemuboi::view {
+
+
+namespace {
+
+const int PIXELS = Renderer::SCREEN_WIDTH * Renderer::SCREEN_HEIGHT;
+
+// Bounds how late the writer is for a wakeup it missed
+const std::chrono::milliseconds WRITER_TIMEOUT(10);
+
+}
+
+
+RecordingRenderer::RecordingRenderer(Renderer& renderer_in, std::ostream& out_in, int format_in,
+                                     int pool_frames) : renderer(renderer_in),
+    out(out_in),
+    format{format_in},
+    pool{},
+    pool_frame_numbers{},
+    queued{0},
+    written{0},
+    dropped{0},
+    failed{false},
+    next_frame{},
+    staging(PIXELS),
+    colors(PIXELS),
+    locked{},
+    locked_pitch{},
+    writer_mutex{},
+    frame_queued{},
+    stopping{false},
+    writer{} {
+
+    if (format != FORMAT_INDEXED && format != FORMAT_YUV) {
+        throw std::invalid_argument("Unknown capture format");
+    }
+
+    if (pool_frames < 1) {
+        throw std::invalid_argument("At least one frame is needed in the pool");
+    }
+
+    // Everything is allocated up front, recording allocates nothing
+    pool.resize(pool_frames, std::vector<uint8_t>(PIXELS));
+    pool_frame_numbers.resize(pool_frames);
+
+    writer = std::thread([this]() { write_frames(); });
+}
+
+RecordingRenderer::~RecordingRenderer() {
+    stopping = true;
+    frame_queued.notify_one();
+    writer.join();
+}
+
+void RecordingRenderer::render_frame(uint32_t img[]) {
+    uint8_t* frame = claim_frame();
+    if (frame) {
+        reduce_colors(img, PIXELS, frame);
+        queue_frame();
+    }
+    renderer.render_frame(img);
+}
+
+bool RecordingRenderer::accepts_shades() const {
+    return true;
+}
+
+void RecordingRenderer::render_shades(uint8_t shades[]) {
+    copy_frame(shades, SCREEN_WIDTH);
+    show_shades(shades);
+}
+
+uint8_t* RecordingRenderer::lock_shades(int& pitch) {
+    // Drawn straight into the wrapped renderer when it can take shades
+    locked = renderer.accepts_shades() ? renderer.lock_shades(locked_pitch) : nullptr;
+    if (!locked) {
+        locked = staging.data();
+        locked_pitch = SCREEN_WIDTH;
+    }
+
+    pitch = locked_pitch;
+    return locked;
+}
+
+void RecordingRenderer::unlock_frame() {
+    copy_frame(locked, locked_pitch);
+    if (locked == staging.data()) {
+        show_shades(staging.data());
+    } else {
+        renderer.unlock_frame();
+    }
+}
+
+uint64_t RecordingRenderer::get_written_frames() const {
+    return written.load(std::memory_order_acquire);
+}
+
+uint64_t RecordingRenderer::get_dropped_frames() const {
+    return dropped.load(std::memory_order_relaxed);
+}
+
+bool RecordingRenderer::has_failed() const {
+    return failed;
+}
+
+uint8_t* RecordingRenderer::claim_frame() {
+    uint64_t frame = next_frame++;
+    uint64_t head = queued.load(std::memory_order_relaxed);
+    if (head - written.load(std::memory_order_acquire) == pool.size()) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    pool_frame_numbers[head % pool.size()] = frame;
+    return pool[head % pool.size()].data();
+}
+
+void RecordingRenderer::queue_frame() {
+    queued.fetch_add(1, std::memory_order_release);
+    frame_queued.notify_one();
+}
+
+void RecordingRenderer::copy_frame(const uint8_t* shades, int pitch) {
+    uint8_t* frame = claim_frame();
+    if (!frame) {
+        return;
+    }
+
+    for (int y = 0; y != SCREEN_HEIGHT; ++y) {
+        std::copy(shades + y * pitch, shades + y * pitch + SCREEN_WIDTH, frame + y * SCREEN_WIDTH);
+    }
+    queue_frame();
+}
+
+void RecordingRenderer::show_shades(uint8_t shades[]) {
+    if (renderer.accepts_shades()) {
+        renderer.render_shades(shades);
+    } else {
+        expand_shades(shades, PIXELS, colors.data());
+        renderer.render_frame(colors.data());
+    }
+}
+
+void RecordingRenderer::write_frames() {
+    CaptureEncoder encoder;
+    std::vector<uint8_t> bytes;
+    bytes.reserve(format == FORMAT_YUV ? YUV_FRAME_SIZE : PIXELS);
+
+    if (format == FORMAT_INDEXED) {
+        encoder.encode_header(bytes);
+        out.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+        failed = !out;
+    }
+
+    while (true) {
+        // Read before the queue, whatever was queued before stopping is seen
+        bool stop = stopping;
+        uint64_t tail = written.load(std::memory_order_relaxed);
+        if (tail == queued.load(std::memory_order_acquire)) {
+            if (stop) {
+                break;
+            }
+
+            std::unique_lock<std::mutex> lock(writer_mutex);
+            frame_queued.wait_for(lock, WRITER_TIMEOUT);
+            continue;
+        }
+
+        // After a failure frames are still taken, so emulation keeps going
+        if (out) {
+            const uint8_t* frame = pool[tail % pool.size()].data();
+            bytes.clear();
+            if (format == FORMAT_INDEXED) {
+                encoder.encode_frame(frame, pool_frame_numbers[tail % pool.size()], bytes);
+            } else {
+                bytes.resize(YUV_FRAME_SIZE);
+                shades_to_yuv(frame, bytes.data());
+            }
+            out.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+            failed = !out;
+        }
+
+        written.store(tail + 1, std::memory_order_release);
+    }
+
+    if (out) {
+        out.flush();
+        failed = !out;
+    }
+}
+
+
+}
@@ -0,0 +1,374 @@
+#include "view/scaler.h"
+
+#include "view/renderer.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace geemuboi::view {
+
+
+namespace {
+
+const int WIDTH = Renderer::SCREEN_WIDTH;
+const int HEIGHT = Renderer::SCREEN_HEIGHT;
+const int STRIDE = WIDTH + 2;
+
+// The kernels are written once against these lane types. Comparisons give
+// masks of all ones or all zeros per pixel, which select() picks with.
+struct ScalarLanes {
+    static const int LANES = 1;
+    using Vec = uint32_t;
+
+    static Vec load(const uint32_t* p) { return *p; }
+    static Vec load(const int32_t* p) { return *p; }
+    static void store(uint32_t* p, Vec v) { *p = v; }
+
+    static void store2(uint32_t* p, Vec a, Vec b) {
+        p[0] = a;
+        p[1] = b;
+    }
+
+    static void store3(uint32_t* p, Vec a, Vec b, Vec c) {
+        p[0] = a;
+        p[1] = b;
+        p[2] = c;
+    }
+
+    static Vec eq(Vec a, Vec b) { return a == b ? ~0u : 0; }
+    static Vec ne(Vec a, Vec b) { return a != b ? ~0u : 0; }
+    static Vec lt(Vec a, Vec b) {
+        return static_cast<int32_t>(a) < static_cast<int32_t>(b) ? ~0u : 0;
+    }
+
+    static Vec bit_and(Vec a, Vec b) { return a & b; }
+    static Vec bit_or(Vec a, Vec b) { return a | b; }
+    static Vec select(Vec mask, Vec a, Vec b) { return (a & mask) | (b & ~mask); }
+
+    static Vec add(Vec a, Vec b) { return a + b; }
+    static Vec times4(Vec a) { return a << 2; }
+    static Vec distance(Vec a, Vec b) {
+        int32_t difference = static_cast<int32_t>(a - b);
+        return difference < 0 ? -difference : difference;
+    }
+
+    // Per channel, rounding up like the vector versions
+    static Vec average(Vec a, Vec b) { return (a | b) - (((a ^ b) >> 1) & 0x7F7F7F7F); }
+};
+
+#if defined(__AVX2__)
+
+struct VectorLanes {
+    static const int LANES = 8;
+    using Vec = __m256i;
+
+    static Vec load(const uint32_t* p) { return _mm256_loadu_si256(reinterpret_cast<const Vec*>(p)); }
+    static Vec load(const int32_t* p) { return _mm256_loadu_si256(reinterpret_cast<const Vec*>(p)); }
+    static void store(uint32_t* p, Vec v) { _mm256_storeu_si256(reinterpret_cast<Vec*>(p), v); }
+
+    static void store2(uint32_t* p, Vec a, Vec b) {
+        // Unpacking works within 128-bit halves, the permutes put them in order
+        Vec low = _mm256_unpacklo_epi32(a, b);
+        Vec high = _mm256_unpackhi_epi32(a, b);
+        store(p, _mm256_permute2x128_si256(low, high, 0x20));
+        store(p + LANES, _mm256_permute2x128_si256(low, high, 0x31));
+    }
+
+    static void store3(uint32_t* p, Vec a, Vec b, Vec c) {
+        alignas(32) uint32_t lanes[3][LANES];
+        _mm256_store_si256(reinterpret_cast<Vec*>(lanes[0]), a);
+        _mm256_store_si256(reinterpret_cast<Vec*>(lanes[1]), b);
+        _mm256_store_si256(reinterpret_cast<Vec*>(lanes[2]), c);
+        for (int i = 0; i != LANES; ++i) {
+            p[i * 3] = lanes[0][i];
+            p[i * 3 + 1] = lanes[1][i];
+            p[i * 3 + 2] = lanes[2][i];
+        }
+    }
+
+    static Vec eq(Vec a, Vec b) { return _mm256_cmpeq_epi32(a, b); }
+    static Vec ne(Vec a, Vec b) { return _mm256_xor_si256(eq(a, b), _mm256_set1_epi32(-1)); }
+    static Vec lt(Vec a, Vec b) { return _mm256_cmpgt_epi32(b, a); }
+
+    static Vec bit_and(Vec a, Vec b) { return _mm256_and_si256(a, b); }
+    static Vec bit_or(Vec a, Vec b) { return _mm256_or_si256(a, b); }
+    static Vec select(Vec mask, Vec a, Vec b) { return _mm256_blendv_epi8(b, a, mask); }
+
+    static Vec add(Vec a, Vec b) { return _mm256_add_epi32(a, b); }
+    static Vec times4(Vec a) { return _mm256_slli_epi32(a, 2); }
+    static Vec distance(Vec a, Vec b) { return _mm256_abs_epi32(_mm256_sub_epi32(a, b)); }
+    static Vec average(Vec a, Vec b) { return _mm256_avg_epu8(a, b); }
+};
+
+#elif defined(__SSE2__)
+
+struct VectorLanes {
+    static const int LANES = 4;
+    using Vec = __m128i;
+
+    static Vec load(const uint32_t* p) { return _mm_loadu_si128(reinterpret_cast<const Vec*>(p)); }
+    static Vec load(const int32_t* p) { return _mm_loadu_si128(reinterpret_cast<const Vec*>(p)); }
+    static void store(uint32_t* p, Vec v) { _mm_storeu_si128(reinterpret_cast<Vec*>(p), v); }
+
+    static void store2(uint32_t* p, Vec a, Vec b) {
+        store(p, _mm_unpacklo_epi32(a, b));
+        store(p + LANES, _mm_unpackhi_epi32(a, b));
+    }
+
+    // a0 b0 c0 a1 | b1 c1 a2 b2 | c2 a3 b3 c3
+    static void store3(uint32_t* p, Vec a, Vec b, Vec c) {
+        Vec c0a1 = _mm_unpacklo_epi32(c, _mm_srli_si128(a, 4));
+        Vec b1c1 = _mm_unpacklo_epi32(_mm_srli_si128(b, 4), _mm_srli_si128(c, 4));
+        Vec c2a3 = _mm_unpacklo_epi32(_mm_srli_si128(c, 8), _mm_srli_si128(a, 12));
+        store(p, _mm_unpacklo_epi64(_mm_unpacklo_epi32(a, b), c0a1));
+        store(p + LANES, _mm_unpacklo_epi64(b1c1, _mm_unpackhi_epi32(a, b)));
+        store(p + LANES * 2, _mm_unpacklo_epi64(c2a3, _mm_srli_si128(_mm_unpackhi_epi32(b, c), 8)));
+    }
+
+    static Vec eq(Vec a, Vec b) { return _mm_cmpeq_epi32(a, b); }
+    static Vec ne(Vec a, Vec b) { return _mm_xor_si128(eq(a, b), _mm_set1_epi32(-1)); }
+    static Vec lt(Vec a, Vec b) { return _mm_cmplt_epi32(a, b); }
+
+    static Vec bit_and(Vec a, Vec b) { return _mm_and_si128(a, b); }
+    static Vec bit_or(Vec a, Vec b) { return _mm_or_si128(a, b); }
+    static Vec select(Vec mask, Vec a, Vec b) {
+        return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+    }
+
+    static Vec add(Vec a, Vec b) { return _mm_add_epi32(a, b); }
+    static Vec times4(Vec a) { return _mm_slli_epi32(a, 2); }
+    static Vec distance(Vec a, Vec b) {
+        Vec difference = _mm_sub_epi32(a, b);
+        Vec sign = _mm_srai_epi32(difference, 31);
+        return _mm_sub_epi32(_mm_xor_si128(difference, sign), sign);
+    }
+    static Vec average(Vec a, Vec b) { return _mm_avg_epu8(a, b); }
+};
+
+#else
+
+using VectorLanes = ScalarLanes;
+
+#endif
+
+// The 3x3 neighbourhood of LANES pixels, named as
+//   A B C
+//   D E F
+//   G H I
+template <typename L, typename Pixel>
+struct Neighbours {
+    Neighbours(const Pixel* p) : a{L::load(p - STRIDE - 1)},
+        b{L::load(p - STRIDE)},
+        c{L::load(p - STRIDE + 1)},
+        d{L::load(p - 1)},
+        e{L::load(p)},
+        f{L::load(p + 1)},
+        g{L::load(p + STRIDE - 1)},
+        h{L::load(p + STRIDE)},
+        i{L::load(p + STRIDE + 1)} {}
+
+    typename L::Vec a, b, c, d, e, f, g, h, i;
+};
+
+// Runs block for every LANES pixels of a row, the rest one by one
+template <typename Block>
+void for_each_block(Block block) {
+    const int vector_end = WIDTH - WIDTH % VectorLanes::LANES;
+    for (int x = 0; x != vector_end; x += VectorLanes::LANES) {
+        block(VectorLanes{}, x);
+    }
+    if constexpr (vector_end != WIDTH) {
+        for (int x = vector_end; x != WIDTH; ++x) {
+            block(ScalarLanes{}, x);
+        }
+    }
+}
+
+template <typename L>
+void scale2x_block(const uint32_t* src, uint32_t* dst0, uint32_t* dst1) {
+    Neighbours<L, uint32_t> n(src);
+
+    typename L::Vec db = L::bit_and(L::eq(n.d, n.b), L::bit_and(L::ne(n.b, n.f), L::ne(n.d, n.h)));
+    typename L::Vec bf = L::bit_and(L::eq(n.b, n.f), L::bit_and(L::ne(n.b, n.d), L::ne(n.f, n.h)));
+    typename L::Vec dh = L::bit_and(L::eq(n.d, n.h), L::bit_and(L::ne(n.d, n.b), L::ne(n.h, n.f)));
+    typename L::Vec hf = L::bit_and(L::eq(n.h, n.f), L::bit_and(L::ne(n.d, n.h), L::ne(n.b, n.f)));
+
+    L::store2(dst0, L::select(db, n.d, n.e), L::select(bf, n.f, n.e));
+    L::store2(dst1, L::select(dh, n.d, n.e), L::select(hf, n.f, n.e));
+}
+
+template <typename L>
+void scale3x_block(const uint32_t* src, uint32_t* dst0, uint32_t* dst1, uint32_t* dst2) {
+    Neighbours<L, uint32_t> n(src);
+
+    typename L::Vec db = L::bit_and(L::eq(n.d, n.b), L::bit_and(L::ne(n.d, n.h), L::ne(n.b, n.f)));
+    typename L::Vec bf = L::bit_and(L::eq(n.b, n.f), L::bit_and(L::ne(n.b, n.d), L::ne(n.f, n.h)));
+    typename L::Vec dh = L::bit_and(L::eq(n.d, n.h), L::bit_and(L::ne(n.d, n.b), L::ne(n.h, n.f)));
+    typename L::Vec hf = L::bit_and(L::eq(n.h, n.f), L::bit_and(L::ne(n.h, n.b), L::ne(n.f, n.d)));
+
+    typename L::Vec top = L::bit_or(L::bit_and(db, L::ne(n.e, n.c)), L::bit_and(bf, L::ne(n.e, n.a)));
+    typename L::Vec left = L::bit_or(L::bit_and(db, L::ne(n.e, n.g)), L::bit_and(dh, L::ne(n.e, n.a)));
+    typename L::Vec right = L::bit_or(L::bit_and(bf, L::ne(n.e, n.i)), L::bit_and(hf, L::ne(n.e, n.c)));
+    typename L::Vec bottom = L::bit_or(L::bit_and(dh, L::ne(n.e, n.i)), L::bit_and(hf, L::ne(n.e, n.g)));
+
+    L::store3(dst0, L::select(db, n.d, n.e), L::select(top, n.b, n.e), L::select(bf, n.f, n.e));
+    L::store3(dst1, L::select(left, n.d, n.e), n.e, L::select(right, n.f, n.e));
+    L::store3(dst2, L::select(dh, n.d, n.e), L::select(bottom, n.h, n.e), L::select(hf, n.f, n.e));
+}
+
+// One corner of the output pixel, facing the neighbours p and q and the
+// diagonal r between them. s and t are the other two diagonals, u and v
+// the neighbours opposite p and q. An edge cuts off the corner when the
+// pixels along it (E to s and t, p to q) are closer than those across it
+// (q to u, p to v, E to r), and the corner is then blended halfway towards
+// whichever of p and q is closer to E.
+template <typename L>
+typename L::Vec xbr_corner(typename L::Vec e, typename L::Vec p, typename L::Vec q,
+                           typename L::Vec lum_e, typename L::Vec lum_p, typename L::Vec lum_q,
+                           typename L::Vec lum_r, typename L::Vec lum_s, typename L::Vec lum_t,
+                           typename L::Vec lum_u, typename L::Vec lum_v) {
+    typename L::Vec along = L::add(L::add(L::distance(lum_e, lum_s), L::distance(lum_e, lum_t)),
+                                   L::times4(L::distance(lum_p, lum_q)));
+    typename L::Vec across = L::add(L::add(L::distance(lum_q, lum_u), L::distance(lum_p, lum_v)),
+                                    L::times4(L::distance(lum_e, lum_r)));
+
+    // Blends towards whichever side is closer to E
+    typename L::Vec closer = L::select(L::lt(L::distance(lum_e, lum_q), L::distance(lum_e, lum_p)), q, p);
+    return L::select(L::lt(along, across), L::average(e, closer), e);
+}
+
+template <typename L>
+void xbr_block(const uint32_t* src, const int32_t* luma, uint32_t* dst0, uint32_t* dst1) {
+    Neighbours<L, uint32_t> n(src);
+    Neighbours<L, int32_t> l(luma);
+
+    typename L::Vec top_left = xbr_corner<L>(n.e, n.d, n.b, l.e, l.d, l.b, l.a, l.g, l.c, l.f, l.h);
+    typename L::Vec top_right = xbr_corner<L>(n.e, n.b, n.f, l.e, l.b, l.f, l.c, l.a, l.i, l.h, l.d);
+    typename L::Vec bottom_left = xbr_corner<L>(n.e, n.h, n.d, l.e, l.h, l.d, l.g, l.i, l.a, l.f, l.b);
+    typename L::Vec bottom_right = xbr_corner<L>(n.e, n.f, n.h, l.e, l.f, l.h, l.i, l.c, l.g, l.d, l.b);
+
+    L::store2(dst0, top_left, top_right);
+    L::store2(dst1, bottom_left, bottom_right);
+}
+
+}
+
+
+Scaler::Scaler(int filter_in, int factor_in) : filter{filter_in},
+    factor{},
+    padded(STRIDE * (HEIGHT + 2)),
+    luma{} {
+
+    switch (filter) {
+    case FILTER_NEAREST:
+        if (factor_in < 1 || factor_in > MAX_FACTOR) {
+            throw std::invalid_argument("Unsupported nearest neighbour factor");
+        }
+        factor = factor_in;
+        break;
+    case FILTER_SCALE2X:
+        factor = 2;
+        break;
+    case FILTER_SCALE3X:
+        factor = 3;
+        break;
+    case FILTER_XBR_LITE:
+        factor = 2;
+        luma.resize(padded.size());
+        break;
+    default:
+        throw std::invalid_argument("Unknown scaler filter");
+    }
+}
+
+int Scaler::get_factor() const {
+    return factor;
+}
+
+void Scaler::scale(const uint32_t* src, int src_pitch, uint32_t* dst, int dst_pitch) {
+    if (filter == FILTER_NEAREST) {
+        for (int y = 0; y != HEIGHT; ++y) {
+            const uint32_t* row = src + y * src_pitch;
+            uint32_t* dst0 = dst + y * factor * dst_pitch;
+
+            if (factor == 2) {
+                for_each_block([&](auto lanes, int x) {
+                    using L = decltype(lanes);
+                    typename L::Vec e = L::load(row + x);
+                    L::store2(dst0 + x * 2, e, e);
+                });
+            } else if (factor == 3) {
+                for_each_block([&](auto lanes, int x) {
+                    using L = decltype(lanes);
+                    typename L::Vec e = L::load(row + x);
+                    L::store3(dst0 + x * 3, e, e, e);
+                });
+            } else {
+                for (int x = 0; x != WIDTH; ++x) {
+                    std::fill(dst0 + x * factor, dst0 + (x + 1) * factor, row[x]);
+                }
+            }
+
+            for (int i = 1; i != factor; ++i) {
+                std::copy(dst0, dst0 + WIDTH * factor, dst0 + i * dst_pitch);
+            }
+        }
+        return;
+    }
+
+    pad(src, src_pitch);
+
+    for (int y = 0; y != HEIGHT; ++y) {
+        const uint32_t* row = &padded[(y + 1) * STRIDE + 1];
+        const int32_t* luma_row = luma.empty() ? nullptr : &luma[(y + 1) * STRIDE + 1];
+        uint32_t* dst0 = dst + y * factor * dst_pitch;
+        uint32_t* dst1 = dst0 + dst_pitch;
+        uint32_t* dst2 = dst1 + dst_pitch;
+
+        switch (filter) {
+        case FILTER_SCALE2X:
+            for_each_block([&](auto lanes, int x) {
+                scale2x_block<decltype(lanes)>(row + x, dst0 + x * 2, dst1 + x * 2);
+            });
+            break;
+        case FILTER_SCALE3X:
+            for_each_block([&](auto lanes, int x) {
+                scale3x_block<decltype(lanes)>(row + x, dst0 + x * 3, dst1 + x * 3, dst2 + x * 3);
+            });
+            break;
+        case FILTER_XBR_LITE:
+            for_each_block([&](auto lanes, int x) {
+                xbr_block<decltype(lanes)>(row + x, luma_row + x, dst0 + x * 2, dst1 + x * 2);
+            });
+            break;
+        }
+    }
+}
+
+void Scaler::pad(const uint32_t* src, int src_pitch) {
+    for (int y = 0; y != HEIGHT + 2; ++y) {
+        const uint32_t* src_row = src + std::clamp(y - 1, 0, HEIGHT - 1) * src_pitch;
+        uint32_t* row = &padded[y * STRIDE];
+        std::copy(src_row, src_row + WIDTH, row + 1);
+        row[0] = src_row[0];
+        row[WIDTH + 1] = src_row[WIDTH - 1];
+    }
+
+    if (luma.empty()) {
+        return;
+    }
+
+    for (std::size_t i = 0; i != padded.size(); ++i) {
+        uint32_t pixel = padded[i];
+        luma[i] = 2 * ((pixel >> 16) & 0xFF) + 5 * ((pixel >> 8) & 0xFF) + (pixel & 0xFF);
+    }
+}
+
+
+}
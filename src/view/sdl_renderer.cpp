@@ -1,44 +1,135 @@
 #include "view/sdl_renderer.h"
 
+#include <algorithm>
 #include <iostream>
 #include <string>
 
 namespace geemuboi::view {
 
 
-SDLRenderer::SDLRenderer() : window{},
+SDLRenderer::SDLRenderer(bool streaming_in, std::unique_ptr<Scaler> scaler_in) : window{},
     renderer{},
-    framebuffer{} {
+    framebuffer{},
+    streaming{streaming_in},
+    scaler{std::move(scaler_in)},
+    unscaled{},
+    scaled{},
+    overlay{} {
 
     if (SDL_Init(SDL_INIT_VIDEO) < 0) {
         std::cout << "SDL could not be initialized: " << SDL_GetError() << std::endl;
         exit(1);
     }
 
-    SDL_CreateWindowAndRenderer(SCREEN_WIDTH * 3, SCREEN_HEIGHT * 3, 0, &window, &renderer);
+    // The window is at least 3x and a whole multiple of the scaled texture
+    int factor = scaler ? scaler->get_factor() : 1;
+    int window_scale = (3 + factor - 1) / factor * factor;
+    SDL_CreateWindowAndRenderer(SCREEN_WIDTH * window_scale, SCREEN_HEIGHT * window_scale, 0,
+            &window, &renderer);
 
     if (window == NULL) {
         std::cout << "Window could not be created: " << SDL_GetError() << std::endl;
         exit(1);
     }
 
-    SDL_RenderSetScale(renderer, 3.0, 3.0);
+    float render_scale = static_cast<float>(window_scale / factor);
+    SDL_RenderSetScale(renderer, render_scale, render_scale);
     framebuffer = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888,
-            SDL_TEXTUREACCESS_STATIC, SCREEN_WIDTH, SCREEN_HEIGHT);
+            streaming ? SDL_TEXTUREACCESS_STREAMING : SDL_TEXTUREACCESS_STATIC,
+            SCREEN_WIDTH * factor, SCREEN_HEIGHT * factor);
+
+    if (scaler) {
+        unscaled.resize(SCREEN_WIDTH * SCREEN_HEIGHT);
+    }
 }
 
 void SDLRenderer::render_frame(uint32_t img[]) {
+    if (scaler) {
+        present_scaled(img);
+        return;
+    }
+
     SDL_UpdateTexture(framebuffer, NULL, img, SCREEN_WIDTH * sizeof(uint32_t));
+    present();
+}
+
+uint32_t* SDLRenderer::lock_frame(int& pitch) {
+    if (scaler) {
+        pitch = SCREEN_WIDTH;
+        return unscaled.data();
+    }
+
+    void* pixels;
+    int pitch_bytes;
+    if (!streaming || SDL_LockTexture(framebuffer, NULL, &pixels, &pitch_bytes) < 0) {
+        return nullptr;
+    }
+
+    pitch = pitch_bytes / sizeof(uint32_t);
+    return static_cast<uint32_t*>(pixels);
+}
+
+void SDLRenderer::unlock_frame() {
+    if (scaler) {
+        present_scaled(unscaled.data());
+        return;
+    }
+
+    SDL_UnlockTexture(framebuffer);
+    present();
+}
+
+void SDLRenderer::present_scaled(const uint32_t* img) {
+    int factor = scaler->get_factor();
+    void* pixels;
+    int pitch_bytes;
+    if (streaming && SDL_LockTexture(framebuffer, NULL, &pixels, &pitch_bytes) == 0) {
+        scaler->scale(img, SCREEN_WIDTH, static_cast<uint32_t*>(pixels),
+                pitch_bytes / sizeof(uint32_t));
+        SDL_UnlockTexture(framebuffer);
+    } else {
+        scaled.resize(SCREEN_WIDTH * SCREEN_HEIGHT * factor * factor);
+        scaler->scale(img, SCREEN_WIDTH, scaled.data(), SCREEN_WIDTH * factor);
+        SDL_UpdateTexture(framebuffer, NULL, scaled.data(),
+                SCREEN_WIDTH * factor * sizeof(uint32_t));
+    }
+
+    present();
+}
+
+void SDLRenderer::present() {
     SDL_RenderCopy(renderer, framebuffer, NULL, NULL);
+
+    // In texture pixels, the render scale takes it to the window
+    int factor = scaler ? scaler->get_factor() : 1;
+    const int width = SCREEN_WIDTH * factor;
+    const int height = 2 * factor;
+    int x = 0;
+    for (const OverlayBar& bar : overlay) {
+        int bar_width = std::min(static_cast<int>(bar.fraction * width + 0.5), width - x);
+        SDL_Rect rect{x, SCREEN_HEIGHT * factor - height, bar_width, height};
+        SDL_SetRenderDrawColor(renderer, (bar.color >> 16) & 0xFF, (bar.color >> 8) & 0xFF,
+                bar.color & 0xFF, 0xFF);
+        SDL_RenderFillRect(renderer, &rect);
+        x += bar_width;
+    }
+
     SDL_RenderPresent(renderer);
 }
 
-void SDLRenderer::update_fps_indicator(int fps) {
+void SDLRenderer::update_fps_indicator(int fps, const std::string& details) {
     std::string title("geemuboi (");
     title += std::to_string(fps);
     title += ")";
+    if (!details.empty()) {
+        title += " " + details;
+    }
     SDL_SetWindowTitle(window, title.c_str());
 }
 
+void SDLRenderer::set_overlay(const std::vector<OverlayBar>& overlay_in) {
+    overlay = overlay_in;
+}
+
 
 }
@@ -0,0 +1,78 @@
+#include "view/threaded_renderer.h"
+
+#include <algorithm>
+
+namespace geemuboi::view {
+
+
+ThreadedRenderer::ThreadedRenderer(Renderer& renderer_in) : renderer(renderer_in),
+    frames(SCREEN_WIDTH * SCREEN_HEIGHT),
+    colors(SCREEN_WIDTH * SCREEN_HEIGHT),
+    frame_mutex{},
+    frame_ready{} {}
+
+void ThreadedRenderer::render_frame(uint32_t img[]) {
+    reduce_colors(img, SCREEN_WIDTH * SCREEN_HEIGHT, frames.get_back());
+    publish();
+}
+
+bool ThreadedRenderer::accepts_shades() const {
+    return true;
+}
+
+void ThreadedRenderer::render_shades(uint8_t shades[]) {
+    std::copy(shades, shades + SCREEN_WIDTH * SCREEN_HEIGHT, frames.get_back());
+    publish();
+}
+
+uint8_t* ThreadedRenderer::lock_shades(int& pitch) {
+    pitch = SCREEN_WIDTH;
+    return frames.get_back();
+}
+
+void ThreadedRenderer::unlock_frame() {
+    publish();
+}
+
+bool ThreadedRenderer::present(std::chrono::milliseconds timeout) {
+    if (!frames.acquire()) {
+        // Frames are published under the mutex, so none can slip in between
+        // the check and the wait.
+        std::unique_lock<std::mutex> lock(frame_mutex);
+        if (!frame_ready.wait_for(lock, timeout, [this] { return frames.acquire(); })) {
+            return false;
+        }
+    }
+
+    uint8_t* front = frames.get_front();
+    if (renderer.accepts_shades()) {
+        renderer.render_shades(front);
+        return true;
+    }
+
+    // Expanded straight into the renderer's memory when it has some
+    int pitch;
+    uint32_t* target = renderer.lock_frame(pitch);
+    if (!target) {
+        expand_shades(front, SCREEN_WIDTH * SCREEN_HEIGHT, colors.data());
+        renderer.render_frame(colors.data());
+        return true;
+    }
+
+    for (int y = 0; y != SCREEN_HEIGHT; ++y) {
+        expand_shades(front + y * SCREEN_WIDTH, SCREEN_WIDTH, target + y * pitch);
+    }
+    renderer.unlock_frame();
+    return true;
+}
+
+void ThreadedRenderer::publish() {
+    {
+        std::lock_guard<std::mutex> lock(frame_mutex);
+        frames.publish();
+    }
+    frame_ready.notify_one();
+}
+
+
+}
@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+
+#include "audio/dsp.h"
+
+#include <random>
+#include <vector>
+
+namespace geemuboi::audio {
+
+
+class DspTest : public ::testing::Test {
+protected:
+    DspTest() : random{1234} {}
+
+    std::mt19937 random;
+};
+
+TEST_F(DspTest, add_impulse_matches_scalar) {
+    std::uniform_int_distribution<int> values(-0x8000, 0x7FFF);
+    std::vector<int16_t> kernel(16);
+    for (int16_t& tap : kernel) {
+        tap = values(random);
+    }
+
+    for (int delta : {0, 1, -1, 7680, -7680, 0x7FFF, -0x8000}) {
+        std::vector<int32_t> expected(16, 100);
+        std::vector<int32_t> actual(16, 100);
+        dsp::scalar::add_impulse(expected.data(), kernel.data(), 16, delta);
+        dsp::add_impulse(actual.data(), kernel.data(), 16, delta);
+        EXPECT_EQ(actual, expected);
+    }
+}
+
+TEST_F(DspTest, interpolate_cubic_matches_scalar) {
+    std::uniform_real_distribution<float> samples(-32768.0f, 32767.0f);
+    std::uniform_real_distribution<float> fractions(0.0f, 1.0f);
+    std::vector<float> in(64);
+    for (float& sample : in) {
+        sample = samples(random);
+    }
+
+    // Not a multiple of any vector width, so the tail is covered as well
+    const int COUNT = 59;
+    std::vector<int32_t> index(COUNT);
+    std::vector<float> t(COUNT);
+    for (int i = 0; i != COUNT; ++i) {
+        index[i] = i;
+        t[i] = fractions(random);
+    }
+
+    std::vector<float> expected(COUNT);
+    std::vector<float> actual(COUNT);
+    dsp::scalar::interpolate_cubic(in.data(), index.data(), t.data(), COUNT, expected.data());
+    dsp::interpolate_cubic(in.data(), index.data(), t.data(), COUNT, actual.data());
+    for (int i = 0; i != COUNT; ++i) {
+        EXPECT_NEAR(actual[i], expected[i], 0.05f);
+    }
+}
+
+TEST_F(DspTest, interleave_rounds_and_saturates) {
+    std::vector<float> left{0.5f, 1.5f, -2.5f, 40000.0f, -40000.0f, 3.4f, 100.0f};
+    std::vector<float> right{-0.5f, 2.5f, 32767.4f, -32768.4f, 7.6f, -3.4f, -100.0f};
+    std::vector<int16_t> out(14);
+
+    dsp::interleave(left.data(), right.data(), 7, out.data());
+
+    std::vector<int16_t> expected{0, 0, 2, 2, -2, 32767, 32767, -32768, -32768, 8, 3, -3, 100, -100};
+    EXPECT_EQ(out, expected);
+}
+
+
+}
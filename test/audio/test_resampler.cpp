@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+
+#include "audio/resampler.h"
+
+#include <cmath>
+#include <vector>
+
+namespace geemuboi::audio {
+
+
+namespace {
+
+const double PI = std::acos(-1.0);
+
+std::vector<int16_t> sine(int frames, double period) {
+    std::vector<int16_t> samples;
+    for (int i = 0; i != frames; ++i) {
+        int16_t sample = static_cast<int16_t>(10000 * std::sin(2 * PI * i / period));
+        samples.push_back(sample);
+        samples.push_back(-sample);
+    }
+    return samples;
+}
+
+}
+
+
+TEST(ResamplerTest, unit_ratio_delays_by_two_frames) {
+    Resampler resampler;
+    std::vector<int16_t> in = sine(100, 20.0);
+    std::vector<int16_t> out;
+
+    EXPECT_EQ(resampler.process(in.data(), 100, out), 100);
+    for (int i = 2; i != 100; ++i) {
+        EXPECT_EQ(out[i * 2], in[(i - 2) * 2]);
+        EXPECT_EQ(out[i * 2 + 1], in[(i - 2) * 2 + 1]);
+    }
+}
+
+TEST(ResamplerTest, ratio_scales_frame_count) {
+    Resampler resampler;
+    std::vector<int16_t> in(2 * 10000);
+    std::vector<int16_t> out;
+
+    resampler.set_ratio(1.005);
+    EXPECT_NEAR(resampler.process(in.data(), 10000, out), 10050, 1);
+
+    out.clear();
+    resampler.set_ratio(0.995);
+    EXPECT_NEAR(resampler.process(in.data(), 10000, out), 9950, 1);
+}
+
+TEST(ResamplerTest, output_is_split_across_calls) {
+    Resampler whole;
+    Resampler split;
+    std::vector<int16_t> in = sine(1000, 37.0);
+    std::vector<int16_t> whole_out;
+    std::vector<int16_t> split_out;
+
+    whole.set_ratio(1.3);
+    split.set_ratio(1.3);
+    whole.process(in.data(), 1000, whole_out);
+    for (int i = 0; i != 1000; i += 100) {
+        split.process(&in[i * 2], 100, split_out);
+    }
+
+    EXPECT_EQ(whole_out, split_out);
+}
+
+TEST(ResamplerTest, interpolates_smooth_signals) {
+    Resampler resampler;
+    std::vector<int16_t> in = sine(2000, 64.0);
+    std::vector<int16_t> out;
+
+    resampler.set_ratio(2.0);
+    int frames = resampler.process(in.data(), 2000, out);
+    ASSERT_EQ(frames, 4000);
+
+    // Every output frame lags its input by two frames
+    for (int i = 8; i != frames; ++i) {
+        double expected = 10000 * std::sin(2 * PI * (i / 2.0 - 2) / 64.0);
+        EXPECT_NEAR(out[i * 2], expected, 40);
+        EXPECT_EQ(out[i * 2 + 1], -out[i * 2]);
+    }
+}
+
+
+}
@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+
+#include "audio/sample_ring.h"
+
+#include <thread>
+#include <vector>
+
+namespace geemuboi::audio {
+
+
+TEST(SampleRingTest, capacity_is_rounded_to_power_of_two) {
+    SampleRing ring(1000);
+    EXPECT_EQ(ring.get_capacity(), 1024);
+}
+
+TEST(SampleRingTest, frames_are_read_in_order) {
+    SampleRing ring(8);
+    int16_t in[] = {1, -1, 2, -2, 3, -3};
+    EXPECT_EQ(ring.write(in, 3), 3);
+    EXPECT_EQ(ring.get_frames_available(), 3);
+
+    int16_t out[6] = {};
+    EXPECT_EQ(ring.read(out, 2), 2);
+    EXPECT_EQ(out[0], 1);
+    EXPECT_EQ(out[3], -2);
+    EXPECT_EQ(ring.read(out, 4), 1);
+    EXPECT_EQ(out[0], 3);
+    EXPECT_EQ(out[1], -3);
+    EXPECT_EQ(ring.get_frames_available(), 0);
+}
+
+TEST(SampleRingTest, frames_that_dont_fit_are_dropped) {
+    SampleRing ring(4);
+    std::vector<int16_t> in(12, 7);
+    EXPECT_EQ(ring.write(in.data(), 6), 4);
+    EXPECT_EQ(ring.write(in.data(), 1), 0);
+
+    int16_t out[2] = {};
+    EXPECT_EQ(ring.read(out, 1), 1);
+    EXPECT_EQ(ring.write(in.data(), 3), 1);
+}
+
+TEST(SampleRingTest, wraps_around) {
+    SampleRing ring(4);
+    int16_t out[8] = {};
+    for (int16_t i = 0; i != 20; ++i) {
+        int16_t in[] = {i, static_cast<int16_t>(-i), static_cast<int16_t>(i + 1),
+                        static_cast<int16_t>(-i - 1)};
+        ASSERT_EQ(ring.write(in, 2), 2);
+        ASSERT_EQ(ring.read(out, 4), 2);
+        EXPECT_EQ(out[0], i);
+        EXPECT_EQ(out[3], -i - 1);
+    }
+}
+
+TEST(SampleRingTest, one_writer_and_one_reader) {
+    const int FRAMES = 10000;
+    SampleRing ring(64);
+
+    std::thread writer([&ring]() {
+        int16_t next = 0;
+        while (next != FRAMES) {
+            int16_t frame[] = {next, static_cast<int16_t>(~next)};
+            next += ring.write(frame, 1);
+        }
+    });
+
+    int16_t frame[2];
+    for (int16_t expected = 0; expected != FRAMES;) {
+        if (ring.read(frame, 1)) {
+            ASSERT_EQ(frame[0], expected);
+            ASSERT_EQ(frame[1], static_cast<int16_t>(~expected));
+            ++expected;
+        }
+    }
+
+    writer.join();
+}
+
+
+}
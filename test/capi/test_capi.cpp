@@ -0,0 +1,57 @@
+#include "gtest/gtest.h"
+
+#include "capi/geemuboi.h"
+
+#include "core/test_roms.h"
+
+#include <vector>
+
+using geemuboi::test::core::make_counting_rom;
+
+
+TEST(CApiTest, requires_a_rom) {
+    geemuboi_machine* machine = geemuboi_create();
+    ASSERT_NE(nullptr, machine);
+
+    EXPECT_EQ(GEEMUBOI_ERROR_NO_ROM, geemuboi_step_frame(machine));
+    EXPECT_EQ(GEEMUBOI_ERROR_NO_ROM, geemuboi_set_input(machine, GEEMUBOI_BUTTON_A));
+    EXPECT_EQ(nullptr, geemuboi_get_framebuffer(machine));
+    EXPECT_EQ(0u, geemuboi_get_state_size(machine));
+    EXPECT_EQ(GEEMUBOI_ERROR_INVALID_ARGUMENT, geemuboi_load_rom(machine, nullptr, 0, nullptr, 0));
+
+    geemuboi_destroy(machine);
+}
+
+TEST(CApiTest, rejects_null_machines) {
+    EXPECT_EQ(GEEMUBOI_ERROR_INVALID_ARGUMENT, geemuboi_step_frame(nullptr));
+    EXPECT_EQ(GEEMUBOI_ERROR_INVALID_ARGUMENT, geemuboi_set_input(nullptr, 0));
+    EXPECT_EQ(nullptr, geemuboi_get_framebuffer(nullptr));
+    geemuboi_destroy(nullptr);
+}
+
+TEST(CApiTest, saves_and_loads_states) {
+    std::vector<uint8_t> rom = make_counting_rom();
+    geemuboi_machine* machine = geemuboi_create();
+    ASSERT_EQ(GEEMUBOI_OK, geemuboi_load_rom(machine, rom.data(), rom.size(), nullptr, 0));
+    ASSERT_EQ(GEEMUBOI_OK, geemuboi_step_frame(machine));
+    ASSERT_EQ(GEEMUBOI_OK, geemuboi_set_input(machine, GEEMUBOI_BUTTON_START));
+
+    size_t size = geemuboi_get_state_size(machine);
+    ASSERT_NE(0u, size);
+    std::vector<uint8_t> state(size);
+    EXPECT_EQ(GEEMUBOI_ERROR_BUFFER_TOO_SMALL, geemuboi_save_state(machine, state.data(), size - 1));
+    ASSERT_EQ(GEEMUBOI_OK, geemuboi_save_state(machine, state.data(), size));
+
+    ASSERT_EQ(GEEMUBOI_OK, geemuboi_step_frame(machine));
+    const uint32_t* framebuffer = geemuboi_get_framebuffer(machine);
+    std::vector<uint32_t> expected(framebuffer,
+                                   framebuffer + GEEMUBOI_SCREEN_WIDTH * GEEMUBOI_SCREEN_HEIGHT);
+
+    ASSERT_EQ(GEEMUBOI_OK, geemuboi_load_state(machine, state.data(), size));
+    ASSERT_EQ(GEEMUBOI_OK, geemuboi_step_frame(machine));
+    EXPECT_EQ(expected, std::vector<uint32_t>(framebuffer, framebuffer + expected.size()));
+
+    EXPECT_EQ(GEEMUBOI_ERROR_INVALID_STATE, geemuboi_load_state(machine, state.data(), size / 2));
+
+    geemuboi_destroy(machine);
+}
@@ -0,0 +1,191 @@
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "audio/audio_sink.h"
+#include "core/apu.h"
+#include "core/scheduler.h"
+
+#include <cstdlib>
+#include <vector>
+
+namespace geemuboi::core {
+
+
+class RecordingSink : public geemuboi::audio::AudioSink {
+public:
+    int get_sample_rate() const { return 48000; }
+    void write_samples(const int16_t* in, int frames) {
+        samples.insert(samples.end(), in, in + frames * 2);
+    }
+
+    int get_peak() const {
+        int peak = 0;
+        for (int16_t sample : samples) {
+            peak = std::max(peak, std::abs(sample));
+        }
+        return peak;
+    }
+
+    std::vector<int16_t> samples;
+};
+
+class ApuTest : public ::testing::Test {
+protected:
+    ApuTest() : scheduler{}, sink{}, apu{scheduler, sink} {}
+
+    void run(int cycles) {
+        while (cycles > 0) {
+            int step = std::min(cycles, 1000);
+            scheduler.advance(step);
+            cycles -= step;
+        }
+    }
+
+    void enable_output() {
+        apu.write_register(NR50, 0x77);
+        apu.write_register(NR51, 0xFF);
+    }
+
+    static const uint16_t NR11 = 0xFF11;
+    static const uint16_t NR12 = 0xFF12;
+    static const uint16_t NR13 = 0xFF13;
+    static const uint16_t NR14 = 0xFF14;
+    static const uint16_t NR21 = 0xFF16;
+    static const uint16_t NR22 = 0xFF17;
+    static const uint16_t NR24 = 0xFF19;
+    static const uint16_t NR50 = 0xFF24;
+    static const uint16_t NR51 = 0xFF25;
+    static const uint16_t NR52 = 0xFF26;
+
+    // One flush of the output buffers
+    static const int FRAME_CYCLES = 8 * 2048;
+
+    Scheduler scheduler;
+    RecordingSink sink;
+    APU apu;
+};
+
+TEST_F(ApuTest, unused_and_write_only_bits_read_as_set) {
+    apu.write_register(NR11, 0x85);
+    apu.write_register(NR13, 0x12);
+    apu.write_register(NR50, 0x35);
+
+    EXPECT_EQ(apu.read_register(NR11), 0xBF);
+    EXPECT_EQ(apu.read_register(NR13), 0xFF);
+    EXPECT_EQ(apu.read_register(NR50), 0x35);
+    EXPECT_EQ(apu.read_register(0xFF27), 0xFF);
+    EXPECT_EQ(apu.read_register(NR52), 0xF0);
+}
+
+TEST_F(ApuTest, registers_of_no_channel_leave_channels_alone) {
+    for (uint16_t addr = NR50; addr != 0xFF30; ++addr) {
+        if (addr != NR52) {
+            apu.write_register(addr, 0xFF);
+        }
+    }
+
+    EXPECT_EQ(apu.read_register(NR51), 0xFF);
+    EXPECT_EQ(apu.read_register(NR52), 0xF0);
+}
+
+TEST_F(ApuTest, wave_ram_is_read_back) {
+    apu.write_register(0xFF30, 0x12);
+    apu.write_register(0xFF3F, 0xEF);
+
+    EXPECT_EQ(apu.read_register(0xFF30), 0x12);
+    EXPECT_EQ(apu.read_register(0xFF3F), 0xEF);
+}
+
+TEST_F(ApuTest, silent_without_channels) {
+    enable_output();
+    run(2 * FRAME_CYCLES);
+
+    // 2 * 65536 T-cycles at 48 kHz
+    EXPECT_NEAR(sink.samples.size() / 2, 1500, 2);
+    EXPECT_EQ(sink.get_peak(), 0);
+}
+
+TEST_F(ApuTest, triggered_square_is_audible) {
+    enable_output();
+    apu.write_register(NR12, 0xF0);
+    apu.write_register(NR13, 0x00);
+    apu.write_register(NR14, 0x87);
+    EXPECT_EQ(apu.read_register(NR52), 0xF1);
+
+    run(2 * FRAME_CYCLES);
+
+    EXPECT_GT(sink.get_peak(), 1000);
+}
+
+TEST_F(ApuTest, output_follows_panning) {
+    apu.write_register(NR50, 0x77);
+    apu.write_register(NR51, 0x01);
+    apu.write_register(NR12, 0xF0);
+    apu.write_register(NR14, 0x87);
+    run(2 * FRAME_CYCLES);
+
+    int left_peak = 0;
+    int right_peak = 0;
+    for (std::size_t i = 0; i < sink.samples.size(); i += 2) {
+        left_peak = std::max(left_peak, std::abs(sink.samples[i]));
+        right_peak = std::max(right_peak, std::abs(sink.samples[i + 1]));
+    }
+
+    EXPECT_EQ(left_peak, 0);
+    EXPECT_GT(right_peak, 1000);
+}
+
+TEST_F(ApuTest, length_counter_disables_channel) {
+    apu.write_register(NR21, 0x3E);
+    apu.write_register(NR22, 0xF0);
+    apu.write_register(NR24, 0xC0);
+    EXPECT_EQ(apu.read_register(NR52), 0xF2);
+
+    // Lengths are clocked every other frame sequencer step
+    run(2 * 2048);
+    EXPECT_EQ(apu.read_register(NR52), 0xF2);
+    run(2 * 2048);
+    EXPECT_EQ(apu.read_register(NR52), 0xF0);
+}
+
+TEST_F(ApuTest, dac_off_disables_channel) {
+    apu.write_register(NR12, 0xF0);
+    apu.write_register(NR14, 0x80);
+    EXPECT_EQ(apu.read_register(NR52), 0xF1);
+
+    apu.write_register(NR12, 0x00);
+    EXPECT_EQ(apu.read_register(NR52), 0xF0);
+}
+
+TEST_F(ApuTest, power_off_clears_and_ignores_registers) {
+    enable_output();
+    apu.write_register(NR12, 0xF0);
+    apu.write_register(NR14, 0x80);
+
+    apu.write_register(NR52, 0x00);
+    EXPECT_EQ(apu.read_register(NR52), 0x70);
+    EXPECT_EQ(apu.read_register(NR50), 0x00);
+
+    apu.write_register(NR50, 0x77);
+    EXPECT_EQ(apu.read_register(NR50), 0x00);
+
+    apu.write_register(NR52, 0x80);
+    apu.write_register(NR50, 0x77);
+    EXPECT_EQ(apu.read_register(NR50), 0x77);
+}
+
+TEST_F(ApuTest, power_off_silences_output) {
+    enable_output();
+    apu.write_register(NR12, 0xF0);
+    apu.write_register(NR14, 0x87);
+    run(FRAME_CYCLES);
+    apu.write_register(NR52, 0x00);
+    run(3 * FRAME_CYCLES);
+
+    sink.samples.clear();
+    run(FRAME_CYCLES);
+    EXPECT_LT(sink.get_peak(), 16);
+}
+
+
+}
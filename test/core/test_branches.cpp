@@ -0,0 +1,69 @@
+#include "gtest/gtest.h"
+
+#include "core/icpu.h"
+#include "core/cpu_factory.h"
+#include "core/scheduler.h"
+
+#include <memory>
+
+#include "core/flat_mmu.h"
+
+namespace geemuboi::test::core {
+
+using namespace geemuboi::core;
+
+
+class BranchTest : public ::testing::TestWithParam<CpuType> {
+protected:
+    // Runs the branch at 0x1000 with the given flags and returns the cycles
+    // it took. The event that is already due stops the recompiler after it.
+    int run_branch(uint8_t opcode, int offset, uint8_t flags) {
+        mmu.memory[0x1000] = opcode;
+        mmu.memory[0x1001] = static_cast<uint8_t>(offset);
+
+        Scheduler scheduler;
+        scheduler.schedule(Scheduler::EVENT_GPU, 0);
+        regs = {};
+        regs.pc = 0x1000;
+        regs.f = flags;
+        std::unique_ptr<ICpu> cpu{create_cpu(mmu, regs, GetParam(), &scheduler)};
+        return cpu->execute();
+    }
+
+    FlatMmu mmu;
+    ICpu::Registers regs;
+};
+
+TEST_P(BranchTest, relative_jumps_reach_every_offset) {
+    struct Condition {
+        uint8_t opcode;
+        uint8_t taken_flags;
+        uint8_t not_taken_flags;
+    };
+    const Condition conditions[] = {
+        {0x20, 0, ICpu::Z_FLAG},
+        {0x28, ICpu::Z_FLAG, 0},
+        {0x30, 0, ICpu::C_FLAG},
+        {0x38, ICpu::C_FLAG, 0},
+    };
+
+    for (const Condition& condition : conditions) {
+        for (int offset = -128; offset != 128; ++offset) {
+            EXPECT_EQ(run_branch(condition.opcode, offset, condition.taken_flags), 3);
+            EXPECT_EQ(regs.pc, 0x1002 + offset)
+                << "opcode 0x" << std::hex << int{condition.opcode} << std::dec
+                << ", offset " << offset;
+
+            EXPECT_EQ(run_branch(condition.opcode, offset, condition.not_taken_flags), 2);
+            EXPECT_EQ(regs.pc, 0x1002)
+                << "opcode 0x" << std::hex << int{condition.opcode} << std::dec
+                << ", offset " << offset;
+        }
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(CpuTypes, BranchTest,
+                         ::testing::Values(CPU_TYPE_INTERPRETER, CPU_TYPE_CACHED, CPU_TYPE_JIT));
+
+
+}
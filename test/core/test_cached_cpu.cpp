@@ -0,0 +1,321 @@
+#include "gtest/gtest.h"
+
+#include "core/icpu.h"
+#include "core/cpu_factory.h"
+#include "core/interrupts.h"
+#include "core/scheduler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <vector>
+
+#include "core/flat_mmu.h"
+#include "core/random_program.h"
+
+namespace geemuboi::test::core {
+
+using namespace geemuboi::core;
+
+
+class CachedCpuTest : public ::testing::Test {
+protected:
+    CachedCpuTest() : mmu{}, regs{}, cpu{create_cpu(mmu, regs, CPU_TYPE_CACHED)} {}
+
+    void load_program(uint16_t addr, std::initializer_list<uint8_t> program) {
+        mmu.load(addr, program);
+    }
+
+    FlatMmu mmu;
+    ICpu::Registers regs;
+    std::unique_ptr<ICpu> cpu;
+};
+
+TEST_F(CachedCpuTest, executes_whole_block) {
+    // ld b,0x12; ld de,0x3456; inc b; jp 0x0100
+    load_program(0x0000, {0x06, 0x12, 0x11, 0x56, 0x34, 0x04, 0xC3, 0x00, 0x01});
+
+    EXPECT_EQ(cpu->execute(), 2 + 3 + 1 + 4);
+
+    EXPECT_EQ(regs.b, 0x13);
+    EXPECT_EQ(regs.d, 0x34);
+    EXPECT_EQ(regs.e, 0x56);
+    EXPECT_EQ(regs.pc, 0x0100);
+    EXPECT_EQ(cpu->get_cycles_executed(), 10);
+}
+
+TEST_F(CachedCpuTest, conditional_branch_ends_block) {
+    // dec b; nop; jr nz,-4
+    load_program(0x0000, {0x05, 0x00, 0x20, 0xFC});
+    regs.b = 2;
+
+    EXPECT_EQ(cpu->execute(), 1 + 1 + 3);
+    EXPECT_EQ(regs.pc, 0x0000);
+    EXPECT_EQ(regs.b, 1);
+
+    EXPECT_EQ(cpu->execute(), 1 + 1 + 2);
+    EXPECT_EQ(regs.pc, 0x0004);
+    EXPECT_EQ(regs.b, 0);
+    cpu->sync_registers();
+    EXPECT_TRUE(regs.f & ICpu::Z_FLAG);
+}
+
+TEST_F(CachedCpuTest, write_invalidates_cached_block) {
+    // ld a,0x01; jp 0x0000
+    load_program(0x0000, {0x3E, 0x01, 0xC3, 0x00, 0x00});
+    cpu->execute();
+    EXPECT_EQ(regs.a, 0x01);
+
+    // ld hl,0x0001; ld (hl),0x02; jp 0x0000
+    load_program(0x0100, {0x21, 0x01, 0x00, 0x36, 0x02, 0xC3, 0x00, 0x00});
+    regs.pc = 0x0100;
+    cpu->execute();
+
+    cpu->execute();
+    EXPECT_EQ(regs.a, 0x02);
+}
+
+TEST_F(CachedCpuTest, write_to_own_block_stops_it) {
+    // ld hl,0x0007; ld (hl),0x04; ld b,0x00; nop (patched to inc b); jp 0x0000
+    load_program(0x0000, {0x21, 0x07, 0x00, 0x36, 0x04, 0x06, 0x00, 0x00, 0xC3, 0x00, 0x00});
+    regs.b = 0x10;
+
+    EXPECT_EQ(cpu->execute(), 3 + 3);
+    EXPECT_EQ(regs.pc, 0x0005);
+
+    cpu->execute();
+    EXPECT_EQ(regs.b, 0x01);
+}
+
+TEST_F(CachedCpuTest, write_through_echo_ram_invalidates) {
+    // Code at either address, patched through the other one
+    for (uint16_t start : {0xC000, 0xE000}) {
+        EchoMmu echo_mmu;
+        ICpu::Registers echo_regs{};
+        echo_regs.pc = start;
+        std::unique_ptr<ICpu> echo_cpu{create_cpu(echo_mmu, echo_regs, CPU_TYPE_CACHED)};
+
+        // ld hl,(start + 7 through the echo); ld (hl),0x04; ld b,0x00;
+        // nop (patched to inc b); halt
+        uint16_t patched = (start ^ 0x2000) + 7;
+        uint8_t low = patched & 0xFF;
+        uint8_t high = patched >> 8;
+        echo_mmu.load(start & 0xDFFF, {0x21, low, high, 0x36, 0x04, 0x06, 0x00, 0x00, 0x76});
+
+        for (int i = 0; i != 4 && echo_regs.pc != start + 9; ++i) {
+            echo_cpu->execute();
+        }
+        EXPECT_EQ(echo_regs.pc, start + 9);
+        EXPECT_EQ(echo_regs.b, 0x01) << "code at 0x" << std::hex << start;
+    }
+}
+
+TEST_F(CachedCpuTest, call_and_ret) {
+    // call 0x0010; (0x0010) ld c,0x42; ret
+    load_program(0x0000, {0xCD, 0x10, 0x00});
+    load_program(0x0010, {0x0E, 0x42, 0xC9});
+    regs.sp = 0xFFFE;
+
+    EXPECT_EQ(cpu->execute(), 6);
+    EXPECT_EQ(regs.pc, 0x0010);
+    EXPECT_EQ(regs.sp, 0xFFFC);
+
+    EXPECT_EQ(cpu->execute(), 2 + 4);
+    EXPECT_EQ(regs.pc, 0x0003);
+    EXPECT_EQ(regs.sp, 0xFFFE);
+    EXPECT_EQ(regs.c, 0x42);
+}
+
+TEST_F(CachedCpuTest, countdown_loop_runs_at_once) {
+    // dec b; jr nz,-3
+    load_program(0x0000, {0x05, 0x20, 0xFD});
+    regs.b = 5;
+
+    EXPECT_EQ(cpu->execute(), 5 * (1 + 3) - 1);
+    EXPECT_EQ(regs.pc, 0x0003);
+    EXPECT_EQ(regs.b, 0);
+    cpu->sync_registers();
+    EXPECT_TRUE(regs.f & ICpu::Z_FLAG);
+    EXPECT_TRUE(regs.f & ICpu::N_FLAG);
+}
+
+TEST_F(CachedCpuTest, copy_loop_runs_at_once) {
+    // ld a,(hl+); ld (de),a; inc de; dec b; jr nz,-6
+    load_program(0x0000, {0x2A, 0x12, 0x13, 0x05, 0x20, 0xFA});
+    for (int i = 0; i != 0x100; ++i) {
+        mmu.memory[0xC080 + i] = i;
+    }
+    regs.h = 0xC0;
+    regs.l = 0x80;
+    regs.d = 0x80;
+    regs.e = 0x00;
+    regs.b = 0;
+
+    EXPECT_EQ(cpu->execute(), 0x100 * (2 + 2 + 2 + 1 + 3) - 1);
+    EXPECT_EQ(regs.pc, 0x0006);
+    EXPECT_EQ(regs.a, 0xFF);
+    EXPECT_EQ((regs.h << 8) + regs.l, 0xC180);
+    EXPECT_EQ((regs.d << 8) + regs.e, 0x8100);
+    EXPECT_EQ(std::memcmp(&mmu.memory[0x8000], &mmu.memory[0xC080], 0x100), 0);
+}
+
+TEST_F(CachedCpuTest, fill_loop_runs_at_once) {
+    // ld (hl-),a; dec c; jr nz,-4
+    load_program(0x0000, {0x32, 0x0D, 0x20, 0xFC});
+    std::memset(&mmu.memory[0x9F00], 0x55, 0x100);
+    regs.a = 0x00;
+    regs.h = 0x9F;
+    regs.l = 0xFF;
+    regs.c = 0x20;
+
+    EXPECT_EQ(cpu->execute(), 0x20 * (2 + 1 + 3) - 1);
+    EXPECT_EQ(regs.pc, 0x0004);
+    EXPECT_EQ((regs.h << 8) + regs.l, 0x9FDF);
+    EXPECT_EQ(mmu.memory[0x9FDF], 0x55);
+    EXPECT_EQ(mmu.memory[0x9FE0], 0x00);
+    EXPECT_EQ(mmu.memory[0x9FFF], 0x00);
+}
+
+TEST_F(CachedCpuTest, idle_loop_skips_to_next_event) {
+    Scheduler scheduler;
+    scheduler.set_handler(Scheduler::EVENT_GPU, [this]() { mmu.memory[0xFF44] = 0x90; });
+    scheduler.schedule(Scheduler::EVENT_GPU, 100);
+    cpu = create_cpu(mmu, regs, CPU_TYPE_CACHED, &scheduler);
+
+    // ldh a,(0x44); cp 0x90; jr nz,-6
+    load_program(0x0000, {0xF0, 0x44, 0xFE, 0x90, 0x20, 0xFA});
+
+    int cycles = cpu->execute();
+    EXPECT_EQ(cycles, 13 * (3 + 2 + 3));
+    EXPECT_EQ(regs.pc, 0x0000);
+
+    scheduler.advance(cycles);
+    EXPECT_EQ(cpu->execute(), 3 + 2 + 2);
+    EXPECT_EQ(regs.pc, 0x0006);
+    EXPECT_EQ(regs.a, 0x90);
+}
+
+TEST_F(CachedCpuTest, fused_loop_stops_for_interrupt) {
+    Scheduler scheduler;
+    Interrupts interrupts;
+    interrupts.set_enabled(Interrupts::INTERRUPT_TIMER);
+    scheduler.set_handler(Scheduler::EVENT_TIMER, [&interrupts]() {
+        interrupts.request(Interrupts::INTERRUPT_TIMER);
+    });
+    scheduler.schedule(Scheduler::EVENT_TIMER, 1 + 2 + 40);
+    cpu = create_cpu(mmu, regs, CPU_TYPE_CACHED, &scheduler, &interrupts);
+    regs.sp = 0xDFFE;
+
+    // ei; ld b,0x00; dec b; jr nz,-3
+    load_program(0x0000, {0xFB, 0x06, 0x00, 0x05, 0x20, 0xFD});
+    scheduler.advance(cpu->execute());
+    scheduler.advance(cpu->execute());
+
+    // Ten iterations reach the event, the other 246 are left
+    int cycles = cpu->execute();
+    EXPECT_EQ(cycles, 10 * (1 + 3));
+    EXPECT_EQ(regs.pc, 0x0003);
+    EXPECT_EQ(regs.b, 246);
+    cpu->sync_registers();
+    EXPECT_FALSE(regs.f & ICpu::Z_FLAG);
+
+    scheduler.advance(cycles);
+    cpu->execute();
+    EXPECT_EQ(regs.pc, 0x0050);
+    EXPECT_EQ(mmu.memory[0xDFFC], 0x03);
+    EXPECT_EQ(mmu.memory[0xDFFD], 0x00);
+}
+
+TEST_F(CachedCpuTest, fused_loops_match_interpreter) {
+    struct Case {
+        std::vector<uint8_t> program;
+        uint16_t hl;
+        uint16_t de;
+        uint8_t b;
+    };
+
+    const Case cases[] = {
+        // Copies within RAM, across pages, into ROM and over themselves
+        {{0x2A, 0x12, 0x13, 0x05, 0x20, 0xFA}, 0xC0F0, 0x9FF8, 0x00},
+        {{0x2A, 0x12, 0x13, 0x05, 0x20, 0xFA}, 0xC000, 0x7FF0, 0x40},
+        {{0x2A, 0x12, 0x13, 0x05, 0x20, 0xFA}, 0xC000, 0xC001, 0x40},
+        {{0x2A, 0x12, 0x13, 0x05, 0x20, 0xFA}, 0xFFF0, 0xC000, 0x40},
+        // Fills upwards and downwards, including over address 0
+        {{0x22, 0x05, 0x20, 0xFC}, 0xDFC0, 0x0000, 0x80},
+        {{0x32, 0x05, 0x20, 0xFC}, 0x8010, 0x0000, 0x40},
+        {{0x32, 0x05, 0x20, 0xFC}, 0x0010, 0x0000, 0x40},
+        // Counter set to 0 runs 256 times
+        {{0x05, 0x20, 0xFD}, 0x0000, 0x0000, 0x00},
+        // Poll that falls through right away
+        {{0xF0, 0x44, 0xFE, 0x00, 0x28, 0xFA}, 0x0000, 0x0000, 0x00},
+    };
+
+    for (const Case& test_case : cases) {
+        RomMmu cached_mmu;
+        RomMmu reference_mmu;
+        for (int i = 0; i != 0x10000; ++i) {
+            cached_mmu.memory[i] = i * 7;
+        }
+        std::copy(test_case.program.begin(), test_case.program.end(), &cached_mmu.memory[0x1000]);
+        std::memcpy(reference_mmu.memory, cached_mmu.memory, sizeof(cached_mmu.memory));
+
+        ICpu::Registers cached_regs{};
+        cached_regs.pc = 0x1000;
+        cached_regs.h = test_case.hl >> 8;
+        cached_regs.l = test_case.hl & 0xFF;
+        cached_regs.d = test_case.de >> 8;
+        cached_regs.e = test_case.de & 0xFF;
+        cached_regs.b = test_case.b;
+        ICpu::Registers reference_regs = cached_regs;
+        std::unique_ptr<ICpu> cached{create_cpu(cached_mmu, cached_regs, CPU_TYPE_CACHED)};
+        std::unique_ptr<ICpu> reference{create_cpu(reference_mmu, reference_regs)};
+
+        uint16_t end = 0x1000 + test_case.program.size();
+        while (cached_regs.pc != end) {
+            cached->execute();
+        }
+        while (reference_regs.pc != end) {
+            reference->execute();
+        }
+
+        cached->sync_registers();
+        reference->sync_registers();
+        EXPECT_EQ(reference->get_cycles_executed(), cached->get_cycles_executed());
+        EXPECT_EQ(std::memcmp(&reference_regs, &cached_regs, sizeof(ICpu::Registers)), 0);
+        EXPECT_EQ(std::memcmp(reference_mmu.memory, cached_mmu.memory, sizeof(cached_mmu.memory)), 0);
+    }
+}
+
+TEST_F(CachedCpuTest, matches_interpreter_in_lock_step) {
+    RomMmu cached_mmu;
+    RomMmu reference_mmu;
+    generate_program(cached_mmu.memory, 0x2000, 1234);
+    std::memcpy(reference_mmu.memory, cached_mmu.memory, sizeof(cached_mmu.memory));
+
+    ICpu::Registers cached_regs{};
+    ICpu::Registers reference_regs{};
+    cached_regs.sp = reference_regs.sp = 0xDFFE;
+    std::unique_ptr<ICpu> cached{create_cpu(cached_mmu, cached_regs, CPU_TYPE_CACHED)};
+    std::unique_ptr<ICpu> reference{create_cpu(reference_mmu, reference_regs)};
+
+    for (int i = 0; i != 20000; ++i) {
+        uint16_t block_pc = cached_regs.pc;
+        cached->execute();
+        while (reference->get_cycles_executed() < cached->get_cycles_executed()) {
+            reference->execute();
+        }
+
+        cached->sync_registers();
+        reference->sync_registers();
+        ASSERT_EQ(reference->get_cycles_executed(), cached->get_cycles_executed())
+            << "block at 0x" << std::hex << block_pc;
+        ASSERT_EQ(std::memcmp(&reference_regs, &cached_regs, sizeof(ICpu::Registers)), 0)
+            << "block at 0x" << std::hex << block_pc;
+        ASSERT_EQ(std::memcmp(reference_mmu.memory, cached_mmu.memory, sizeof(cached_mmu.memory)), 0)
+            << "block at 0x" << std::hex << block_pc;
+    }
+}
+
+
+}
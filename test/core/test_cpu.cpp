@@ -25,6 +25,7 @@ protected:
     void execute_instruction(uint8_t instr) {
         EXPECT_CALL(mmu, read_byte(regs.pc)).WillOnce(Return(instr));
         cpu->execute();
+        cpu->sync_registers();
     }
 
     void verify_state_changes(const ICpu::Registers& expected_regs) {
@@ -2031,6 +2032,16 @@ TEST_F(CpuTest, ld_a_a) {
     verify_ld_r8_r8(0x7F, expected_regs);
 }
 
+TEST_F(CpuTest, flags_are_synced_on_request) {
+    // xor a
+    EXPECT_CALL(mmu, read_byte(0)).WillOnce(Return(0xAF));
+    cpu->execute();
+    EXPECT_EQ(regs.f, 0);
+
+    cpu->sync_registers();
+    EXPECT_EQ(regs.f, static_cast<int>(ICpu::Z_FLAG));
+}
+
 // TEST_F(CpuTest, add_a_b) {
 //     // execute_instruction(x);
 
@@ -0,0 +1,158 @@
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "core/gpu.h"
+#include "core/interrupts.h"
+#include "core/scheduler.h"
+
+#include <vector>
+
+#include "view/mock_renderer.h"
+
+namespace geemuboi::core {
+
+using namespace geemuboi::view;
+using namespace geemuboi::test::view;
+using ::testing::_;
+
+
+namespace {
+
+// Hands out memory wider than the screen, like a texture with padded rows
+class LockingRenderer : public Renderer {
+public:
+    static const int PITCH = SCREEN_WIDTH + 16;
+    static constexpr uint32_t PADDING = 0xDEADBEEF;
+
+    LockingRenderer() : pixels(PITCH * SCREEN_HEIGHT, PADDING),
+        locks{},
+        unlocks{} {}
+
+    void render_frame(uint32_t[]) { ADD_FAILURE() << "Frame wasn't drawn in place"; }
+
+    uint32_t* lock_frame(int& pitch) {
+        ++locks;
+        pitch = PITCH;
+        return pixels.data();
+    }
+
+    void unlock_frame() { ++unlocks; }
+
+    std::vector<uint32_t> pixels;
+    int locks;
+    int unlocks;
+};
+
+class ShadeRenderer : public Renderer {
+public:
+    void render_frame(uint32_t[]) { ADD_FAILURE() << "Frame was expanded to colors"; }
+    bool accepts_shades() const { return true; }
+    void render_shades(uint8_t shades[]) {
+        frames.emplace_back(shades, shades + SCREEN_WIDTH * SCREEN_HEIGHT);
+    }
+
+    std::vector<std::vector<uint8_t>> frames;
+};
+
+const int CYCLES_PER_FRAME = 154 * 114;
+
+}
+
+
+TEST(GpuTest, renders_whole_frames_without_locking) {
+    MockRenderer renderer;
+    Scheduler scheduler;
+    Interrupts interrupts;
+    GPU gpu(renderer, scheduler, interrupts);
+
+    EXPECT_CALL(renderer, render_frame(_)).Times(2);
+    scheduler.advance(2 * CYCLES_PER_FRAME);
+}
+
+TEST(GpuTest, draws_into_locked_frame_with_pitch) {
+    LockingRenderer renderer;
+    Scheduler scheduler;
+    Interrupts interrupts;
+    GPU gpu(renderer, scheduler, interrupts);
+    EXPECT_EQ(renderer.locks, 1);
+
+    scheduler.advance(CYCLES_PER_FRAME);
+    EXPECT_EQ(renderer.unlocks, 1);
+    EXPECT_EQ(renderer.locks, 2);
+
+    for (int y = 0; y != Renderer::SCREEN_HEIGHT; ++y) {
+        for (int x = 0; x != LockingRenderer::PITCH; ++x) {
+            uint32_t expected = x < Renderer::SCREEN_WIDTH ? 0x00FFFFFF : LockingRenderer::PADDING;
+            ASSERT_EQ(renderer.pixels[y * LockingRenderer::PITCH + x], expected);
+        }
+    }
+}
+
+
+TEST(GpuTest, passes_shades_to_renderers_taking_them) {
+    ShadeRenderer renderer;
+    Scheduler scheduler;
+    Interrupts interrupts;
+    GPU gpu(renderer, scheduler, interrupts);
+
+    // Tile 0 row 0 is color 3, mapped to shade 2 by the palette
+    gpu.write_byte_vram(0x1000, 0xFF);
+    gpu.write_byte_vram(0x1001, 0xFF);
+    gpu.set_bg_palette(0x80);
+    gpu.set_lcd_control(0x01);
+    // The first frame starts out in horizontal blank, after line 0
+    scheduler.advance(2 * CYCLES_PER_FRAME);
+
+    ASSERT_EQ(renderer.frames.size(), 2u);
+    const std::vector<uint8_t>& shades = renderer.frames[1];
+    EXPECT_EQ(shades[0], Renderer::SHADE_DARK_GREY);
+    EXPECT_EQ(shades[Renderer::SCREEN_WIDTH - 1], Renderer::SHADE_DARK_GREY);
+    EXPECT_EQ(shades[Renderer::SCREEN_WIDTH], Renderer::SHADE_WHITE);
+    EXPECT_EQ(shades[8 * Renderer::SCREEN_WIDTH], Renderer::SHADE_DARK_GREY);
+}
+
+TEST(GpuTest, background_tiles_from_0x8000_are_unsigned_and_scroll_within_tiles) {
+    ShadeRenderer renderer;
+    Scheduler scheduler;
+    Interrupts interrupts;
+    GPU gpu(renderer, scheduler, interrupts);
+
+    // Tile 0x81 row 0 is color 1, in the first map entry only
+    gpu.write_byte_vram(0x0810, 0xFF);
+    gpu.write_byte_vram(0x1800, 0x81);
+    gpu.set_bg_palette(0xE4);
+    gpu.set_scroll_x(3);
+    gpu.set_lcd_control(0x11);
+    scheduler.advance(2 * CYCLES_PER_FRAME);
+
+    ASSERT_EQ(renderer.frames.size(), 2u);
+    const std::vector<uint8_t>& shades = renderer.frames[1];
+    EXPECT_EQ(shades[0], Renderer::SHADE_LIGHT_GREY);
+    EXPECT_EQ(shades[4], Renderer::SHADE_LIGHT_GREY);
+    EXPECT_EQ(shades[5], Renderer::SHADE_WHITE);
+}
+
+TEST(GpuTest, background_map_wraps_horizontally) {
+    ShadeRenderer renderer;
+    Scheduler scheduler;
+    Interrupts interrupts;
+    GPU gpu(renderer, scheduler, interrupts);
+
+    // Tile 0x81 row 0 is color 1, in the first entry of the first map row
+    gpu.write_byte_vram(0x0810, 0xFF);
+    gpu.write_byte_vram(0x1800, 0x81);
+    gpu.set_bg_palette(0xE4);
+    gpu.set_scroll_x(200);
+    gpu.set_lcd_control(0x11);
+    scheduler.advance(2 * CYCLES_PER_FRAME);
+
+    // Screen x 56 is map x 256, which is the start of the same row again
+    ASSERT_EQ(renderer.frames.size(), 2u);
+    const std::vector<uint8_t>& shades = renderer.frames[1];
+    EXPECT_EQ(shades[55], Renderer::SHADE_WHITE);
+    EXPECT_EQ(shades[56], Renderer::SHADE_LIGHT_GREY);
+    EXPECT_EQ(shades[63], Renderer::SHADE_LIGHT_GREY);
+    EXPECT_EQ(shades[64], Renderer::SHADE_WHITE);
+}
+
+}
@@ -0,0 +1,79 @@
+#include "gtest/gtest.h"
+
+#include "core/hash.h"
+
+#include <set>
+#include <vector>
+
+namespace geemuboi::core {
+
+
+TEST(HashTest, is_deterministic_and_seeded) {
+    std::vector<uint8_t> data(1000);
+    for (size_t i = 0; i != data.size(); ++i) {
+        data[i] = static_cast<uint8_t>(i * 7);
+    }
+
+    EXPECT_EQ(hash_bytes(data.data(), data.size()), hash_bytes(data.data(), data.size()));
+    EXPECT_NE(hash_bytes(data.data(), data.size(), 0), hash_bytes(data.data(), data.size(), 1));
+}
+
+TEST(HashTest, matches_reference_values) {
+    // From the scalar version, whatever vector version is built has to match
+    struct Reference {
+        size_t size;
+        uint64_t seed;
+        uint64_t hash;
+    };
+    const Reference REFERENCES[] = {
+        {0, 0x0u, 0xc9af9c68ec47a4ecu},
+        {0, 0x9e3779b97f4a7c15u, 0x717297eb190b1c63u},
+        {7, 0x0u, 0x86331ea8bdfe4aa3u},
+        {7, 0x9e3779b97f4a7c15u, 0x78a7de869a9dd322u},
+        {64, 0x0u, 0xfb273d8b187b9519u},
+        {64, 0x9e3779b97f4a7c15u, 0xaaeeaf512da59648u},
+        {1000, 0x0u, 0x111cfe1747ae0cfbu},
+        {1000, 0x9e3779b97f4a7c15u, 0xaf16e3f9e77a7b93u},
+        {1024, 0x0u, 0x9127a9d082e193feu},
+        {1024, 0x9e3779b97f4a7c15u, 0xef1cbaa52ddfe108u},
+        {2573, 0x0u, 0x182d8f6bd13a2671u},
+        {2573, 0x9e3779b97f4a7c15u, 0x57b73d3ae75a2ff4u}
+    };
+
+    std::vector<uint8_t> data(64 * 40 + 13);
+    for (size_t i = 0; i != data.size(); ++i) {
+        data[i] = static_cast<uint8_t>(i * 131 + (i >> 5));
+    }
+
+    for (const Reference& reference : REFERENCES) {
+        EXPECT_EQ(hash_bytes(data.data(), reference.size, reference.seed), reference.hash)
+            << reference.size;
+    }
+}
+
+TEST(HashTest, every_byte_matters) {
+    // Over several blocks, with a tail that doesn't fill a stripe
+    std::vector<uint8_t> data(64 * 40 + 13);
+    std::set<uint64_t> hashes{hash_bytes(data.data(), data.size())};
+
+    for (size_t i = 0; i != data.size(); ++i) {
+        data[i] = 1;
+        hashes.insert(hash_bytes(data.data(), data.size()));
+        data[i] = 0;
+    }
+
+    EXPECT_EQ(data.size() + 1, hashes.size());
+}
+
+TEST(HashTest, trailing_zeros_change_the_hash) {
+    std::vector<uint8_t> data(100);
+    std::set<uint64_t> hashes;
+    for (size_t size = 0; size <= data.size(); ++size) {
+        hashes.insert(hash_bytes(data.data(), size));
+    }
+
+    EXPECT_EQ(data.size() + 1, hashes.size());
+}
+
+
+}
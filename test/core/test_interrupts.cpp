@@ -0,0 +1,144 @@
+#include "gtest/gtest.h"
+
+#include "core/icpu.h"
+#include "core/cpu_factory.h"
+#include "core/interrupts.h"
+#include "core/scheduler.h"
+
+#include <initializer_list>
+#include <memory>
+
+#include "core/flat_mmu.h"
+
+namespace geemuboi::test::core {
+
+using namespace geemuboi::core;
+
+
+class InterruptsTest : public ::testing::TestWithParam<CpuType> {
+protected:
+    InterruptsTest() : mmu{}, regs{}, scheduler{}, interrupts{},
+        cpu{create_cpu(mmu, regs, GetParam(), &scheduler, &interrupts)} {
+
+        regs.sp = 0xDFFE;
+        interrupts.set_enabled(Interrupts::INTERRUPT_VBLANK | Interrupts::INTERRUPT_TIMER);
+        scheduler.set_handler(Scheduler::EVENT_GPU, [this]() {
+            interrupts.request(Interrupts::INTERRUPT_TIMER);
+        });
+    }
+
+    void load_program(uint16_t addr, std::initializer_list<uint8_t> program) {
+        mmu.load(addr, program);
+    }
+
+    int execute() {
+        int cycles = cpu->execute();
+        scheduler.advance(cycles);
+        return cycles;
+    }
+
+    FlatMmu mmu;
+    ICpu::Registers regs;
+    Scheduler scheduler;
+    Interrupts interrupts;
+    std::unique_ptr<ICpu> cpu;
+};
+
+TEST_P(InterruptsTest, not_dispatched_while_disabled) {
+    // nop; jp 0x0000
+    load_program(0x0000, {0x00, 0xC3, 0x00, 0x00});
+    interrupts.request(Interrupts::INTERRUPT_VBLANK);
+
+    execute();
+    EXPECT_NE(regs.pc, 0x0040);
+    EXPECT_EQ(interrupts.get_pending(), Interrupts::INTERRUPT_VBLANK);
+}
+
+TEST_P(InterruptsTest, ei_takes_effect_after_next_instruction) {
+    // ei; nop; nop
+    load_program(0x0100, {0xFB, 0x00, 0x00});
+    regs.pc = 0x0100;
+    interrupts.request(Interrupts::INTERRUPT_VBLANK);
+
+    execute();
+    EXPECT_EQ(regs.pc, 0x0101);
+    execute();
+    EXPECT_EQ(regs.pc, 0x0102);
+
+    EXPECT_EQ(execute(), 5);
+    EXPECT_EQ(regs.pc, 0x0040);
+    EXPECT_EQ(regs.sp, 0xDFFC);
+    EXPECT_EQ(mmu.read_word(0xDFFC), 0x0102);
+    EXPECT_EQ(interrupts.get_pending(), 0);
+}
+
+TEST_P(InterruptsTest, di_right_after_ei_keeps_disabled) {
+    // ei; di; nop
+    load_program(0x0100, {0xFB, 0xF3, 0x00});
+    regs.pc = 0x0100;
+    interrupts.request(Interrupts::INTERRUPT_VBLANK);
+
+    execute();
+    execute();
+    execute();
+    EXPECT_NE(regs.pc, 0x0040);
+    EXPECT_EQ(interrupts.get_pending(), Interrupts::INTERRUPT_VBLANK);
+}
+
+TEST_P(InterruptsTest, highest_priority_first_and_reti_enables) {
+    // ei; nop
+    load_program(0x0100, {0xFB, 0x00});
+    // reti
+    load_program(0x0040, {0xD9});
+    regs.pc = 0x0100;
+    interrupts.request(Interrupts::INTERRUPT_VBLANK | Interrupts::INTERRUPT_TIMER);
+
+    execute();
+    execute();
+    execute();
+    EXPECT_EQ(regs.pc, 0x0040);
+
+    EXPECT_EQ(execute(), 4);
+    EXPECT_EQ(regs.pc, 0x0102);
+
+    EXPECT_EQ(execute(), 5);
+    EXPECT_EQ(regs.pc, 0x0050);
+}
+
+TEST_P(InterruptsTest, halt_sleeps_until_next_event) {
+    // ei; halt; nop
+    load_program(0x0100, {0xFB, 0x76, 0x00});
+    regs.pc = 0x0100;
+    scheduler.schedule(Scheduler::EVENT_GPU, 1000);
+
+    execute();
+    execute();
+    EXPECT_EQ(scheduler.get_time(), 2u);
+
+    EXPECT_EQ(execute(), 998);
+    EXPECT_EQ(scheduler.get_time(), 1000u);
+
+    EXPECT_EQ(execute(), 5);
+    EXPECT_EQ(regs.pc, 0x0050);
+    EXPECT_EQ(mmu.read_word(regs.sp), 0x0102);
+}
+
+TEST_P(InterruptsTest, halt_resumes_without_dispatch_when_disabled) {
+    // halt; nop
+    load_program(0x0100, {0x76, 0x00});
+    regs.pc = 0x0100;
+    scheduler.schedule(Scheduler::EVENT_GPU, 10);
+
+    execute();
+    EXPECT_EQ(execute(), 9);
+
+    execute();
+    EXPECT_EQ(regs.pc, 0x0102);
+    EXPECT_EQ(interrupts.get_pending(), Interrupts::INTERRUPT_TIMER);
+}
+
+INSTANTIATE_TEST_SUITE_P(CpuTypes, InterruptsTest,
+                         ::testing::Values(CPU_TYPE_INTERPRETER, CPU_TYPE_CACHED, CPU_TYPE_JIT));
+
+
+}
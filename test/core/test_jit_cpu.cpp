@@ -0,0 +1,216 @@
+#include "gtest/gtest.h"
+
+#include "core/icpu.h"
+#include "core/cpu_factory.h"
+#include "core/scheduler.h"
+
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+
+#include "core/flat_mmu.h"
+#include "core/random_program.h"
+
+namespace geemuboi::test::core {
+
+using namespace geemuboi::core;
+
+
+namespace {
+
+// Runs the recompiler on jit_mmu and the interpreter on reference_mmu, which
+// start out the same, comparing everything after every call to execute().
+void expect_lock_step(FlatMmu& jit_mmu, FlatMmu& reference_mmu, const ICpu::Registers& start,
+                      int iterations) {
+    ICpu::Registers jit_regs = start;
+    ICpu::Registers reference_regs = start;
+    std::unique_ptr<ICpu> jit{create_cpu(jit_mmu, jit_regs, CPU_TYPE_JIT)};
+    std::unique_ptr<ICpu> reference{create_cpu(reference_mmu, reference_regs)};
+
+    for (int i = 0; i != iterations; ++i) {
+        uint16_t run_pc = jit_regs.pc;
+        jit->execute();
+        while (reference->get_cycles_executed() < jit->get_cycles_executed()) {
+            reference->execute();
+        }
+
+        jit->sync_registers();
+        reference->sync_registers();
+        ASSERT_EQ(reference->get_cycles_executed(), jit->get_cycles_executed())
+            << "run at 0x" << std::hex << run_pc;
+        ASSERT_EQ(std::memcmp(&reference_regs, &jit_regs, sizeof(ICpu::Registers)), 0)
+            << "run at 0x" << std::hex << run_pc;
+        ASSERT_EQ(std::memcmp(reference_mmu.memory, jit_mmu.memory, sizeof(jit_mmu.memory)), 0)
+            << "run at 0x" << std::hex << run_pc;
+    }
+}
+
+}
+
+
+class JitCpuTest : public ::testing::Test {
+protected:
+    JitCpuTest() : mmu{}, regs{}, cpu{create_cpu(mmu, regs, CPU_TYPE_JIT)} {}
+
+    void load_program(uint16_t addr, std::initializer_list<uint8_t> program) {
+        mmu.load(addr, program);
+    }
+
+    FlatMmu mmu;
+    ICpu::Registers regs;
+    std::unique_ptr<ICpu> cpu;
+};
+
+TEST_F(JitCpuTest, runs_until_undefined_instruction) {
+    // ld b,0x12; ld de,0x3456; inc b; jp 0x0100; (0x0100) nop; 0xD3
+    load_program(0x0000, {0x06, 0x12, 0x11, 0x56, 0x34, 0x04, 0xC3, 0x00, 0x01});
+    load_program(0x0100, {0x00, 0xD3});
+
+    EXPECT_EQ(cpu->execute(), 2 + 3 + 1 + 4 + 1);
+
+    EXPECT_EQ(regs.b, 0x13);
+    EXPECT_EQ(regs.d, 0x34);
+    EXPECT_EQ(regs.e, 0x56);
+    EXPECT_EQ(regs.pc, 0x0101);
+    EXPECT_EQ(cpu->get_cycles_executed(), 11);
+}
+
+TEST_F(JitCpuTest, chained_loop_keeps_flags) {
+    // dec b; nop; jr nz,-4; 0xD3
+    load_program(0x0000, {0x05, 0x00, 0x20, 0xFC, 0xD3});
+    regs.b = 3;
+
+    EXPECT_EQ(cpu->execute(), 3 * (1 + 1) + 2 * 3 + 2);
+    EXPECT_EQ(regs.pc, 0x0004);
+    EXPECT_EQ(regs.b, 0);
+    cpu->sync_registers();
+    EXPECT_TRUE(regs.f & ICpu::Z_FLAG);
+    EXPECT_TRUE(regs.f & ICpu::N_FLAG);
+}
+
+TEST_F(JitCpuTest, write_to_own_block_stops_it) {
+    // ld hl,0x0007; ld (hl),0x04; ld b,0x00; nop (patched to inc b); 0xD3
+    load_program(0x0000, {0x21, 0x07, 0x00, 0x36, 0x04, 0x06, 0x00, 0x00, 0xD3});
+    regs.b = 0x10;
+
+    cpu->execute();
+    EXPECT_EQ(regs.b, 0x01);
+    EXPECT_EQ(regs.pc, 0x0008);
+}
+
+TEST_F(JitCpuTest, write_invalidates_linked_block) {
+    // ld hl,0x0005; inc (hl); ld a,0x00; jp 0x0003, which patches the
+    // immediate of the loop it's in
+    load_program(0x0000, {0x21, 0x05, 0x00, 0x34, 0x3E, 0x00, 0xC3, 0x03, 0x00});
+
+    FlatMmu reference_mmu;
+    std::memcpy(reference_mmu.memory, mmu.memory, sizeof(mmu.memory));
+    expect_lock_step(mmu, reference_mmu, regs, 100);
+    EXPECT_NE(mmu.memory[0x0005], 0x00);
+}
+
+TEST_F(JitCpuTest, write_through_echo_ram_invalidates) {
+    // Code at either address, patched through the other one
+    for (uint16_t start : {0xC000, 0xE000}) {
+        EchoMmu echo_mmu;
+        ICpu::Registers echo_regs{};
+        echo_regs.pc = start;
+        std::unique_ptr<ICpu> echo_cpu{create_cpu(echo_mmu, echo_regs, CPU_TYPE_JIT)};
+
+        // ld hl,(start + 7 through the echo); ld (hl),0x04; ld b,0x00;
+        // nop (patched to inc b); halt
+        uint16_t patched = (start ^ 0x2000) + 7;
+        uint8_t low = patched & 0xFF;
+        uint8_t high = patched >> 8;
+        echo_mmu.load(start & 0xDFFF, {0x21, low, high, 0x36, 0x04, 0x06, 0x00, 0x00, 0x76});
+
+        for (int i = 0; i != 4 && echo_regs.pc != start + 9; ++i) {
+            echo_cpu->execute();
+        }
+        EXPECT_EQ(echo_regs.pc, start + 9);
+        EXPECT_EQ(echo_regs.b, 0x01) << "code at 0x" << std::hex << start;
+    }
+}
+
+TEST_F(JitCpuTest, call_and_ret) {
+    // call 0x0010; 0xD3; (0x0010) ld c,0x42; ret
+    load_program(0x0000, {0xCD, 0x10, 0x00, 0xD3});
+    load_program(0x0010, {0x0E, 0x42, 0xC9});
+    regs.sp = 0xDFFE;
+
+    EXPECT_EQ(cpu->execute(), 6 + 2 + 4);
+    EXPECT_EQ(regs.pc, 0x0003);
+    EXPECT_EQ(regs.sp, 0xDFFE);
+    EXPECT_EQ(regs.c, 0x42);
+    EXPECT_EQ(mmu.memory[0xDFFC], 0x03);
+    EXPECT_EQ(mmu.memory[0xDFFD], 0x00);
+}
+
+TEST_F(JitCpuTest, io_access_waits_for_start_of_run) {
+    // nop; ldh a,(0x05); jr -5
+    load_program(0x0000, {0x00, 0xF0, 0x05, 0x18, 0xFB});
+    mmu.memory[0xFF05] = 0x42;
+
+    EXPECT_EQ(cpu->execute(), 1);
+    EXPECT_EQ(regs.pc, 0x0001);
+    EXPECT_EQ(regs.a, 0x00);
+
+    EXPECT_EQ(cpu->execute(), 3 + 3 + 1);
+    EXPECT_EQ(regs.pc, 0x0001);
+    EXPECT_EQ(regs.a, 0x42);
+}
+
+TEST_F(JitCpuTest, io_write_ends_run) {
+    // ld a,0x05; ldh (0x05),a; 0xD3
+    load_program(0x0000, {0x3E, 0x05, 0xE0, 0x05, 0xD3});
+
+    EXPECT_EQ(cpu->execute(), 2);
+    EXPECT_EQ(regs.pc, 0x0002);
+
+    EXPECT_EQ(cpu->execute(), 3);
+    EXPECT_EQ(regs.pc, 0x0004);
+    EXPECT_EQ(mmu.memory[0xFF05], 0x05);
+}
+
+TEST_F(JitCpuTest, runs_until_next_event) {
+    Scheduler scheduler;
+    scheduler.set_handler(Scheduler::EVENT_GPU, [this]() { mmu.memory[0xFF44] = 0x90; });
+    scheduler.schedule(Scheduler::EVENT_GPU, 100);
+    cpu = create_cpu(mmu, regs, CPU_TYPE_JIT, &scheduler);
+
+    // ldh a,(0x44); cp 0x90; jr nz,-6; 0xD3
+    load_program(0x0000, {0xF0, 0x44, 0xFE, 0x90, 0x20, 0xFA, 0xD3});
+
+    int cycles = cpu->execute();
+    EXPECT_EQ(cycles, 13 * (3 + 2 + 3));
+    EXPECT_EQ(regs.pc, 0x0000);
+
+    scheduler.advance(cycles);
+    EXPECT_EQ(cpu->execute(), 3 + 2 + 2);
+    EXPECT_EQ(regs.pc, 0x0006);
+    EXPECT_EQ(regs.a, 0x90);
+}
+
+TEST_F(JitCpuTest, undefined_instruction_throws) {
+    // nop; 0xD3
+    load_program(0x0000, {0x00, 0xD3});
+
+    EXPECT_EQ(cpu->execute(), 1);
+    EXPECT_THROW(cpu->execute(), UndefinedInstructionException);
+}
+
+TEST_F(JitCpuTest, matches_interpreter_in_lock_step) {
+    for (unsigned seed : {1234u, 42u, 7u, 2024u}) {
+        RomMmu jit_mmu;
+        RomMmu reference_mmu;
+        generate_program(jit_mmu.memory, 0x2000, seed);
+        std::memcpy(reference_mmu.memory, jit_mmu.memory, sizeof(jit_mmu.memory));
+
+        ICpu::Registers start{};
+        start.sp = 0xDFFE;
+        expect_lock_step(jit_mmu, reference_mmu, start, 2000);
+    }
+}
+
+
+}
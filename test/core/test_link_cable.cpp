@@ -0,0 +1,138 @@
+#include "gtest/gtest.h"
+
+#include "core/link_cable.h"
+#include "core/machine.h"
+#include "core/serial.h"
+#include "core/test_roms.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace geemuboi::core {
+
+using geemuboi::test::core::make_rom;
+
+
+namespace {
+
+// Sends the zero terminated bytes at 0x200 on its own clock and stores what
+// comes back from 0xC000 on
+std::vector<uint8_t> make_master_rom(const std::vector<uint8_t>& bytes) {
+    return make_rom({
+        0x21, 0x00, 0x02,   // ld hl,0x200
+        0x11, 0x00, 0xC0,   // ld de,0xC000
+        0x2A,               // ld a,(hl+)
+        0xB7,               // or a
+        0x28, 0x12,         // jr z,+18
+        0xE0, 0x01,         // ldh (0x01),a
+        0x3E, 0x81,         // ld a,0x81
+        0xE0, 0x02,         // ldh (0x02),a
+        0xF0, 0x02,         // ldh a,(0x02)
+        0xE6, 0x80,         // and 0x80
+        0x20, 0xFA,         // jr nz,-6
+        0xF0, 0x01,         // ldh a,(0x01)
+        0x12,               // ld (de),a
+        0x13,               // inc de
+        0x18, 0xEA,         // jr -22
+        0x18, 0xFE          // jr -2
+    }, 0x200, bytes);
+}
+
+// Waits for bytes on the external clock, stores them from 0xC000 on and
+// answers each with the byte plus one, the first with 0
+std::vector<uint8_t> make_slave_rom() {
+    return make_rom({
+        0x11, 0x00, 0xC0,   // ld de,0xC000
+        0xAF,               // xor a
+        0xE0, 0x01,         // ldh (0x01),a
+        0x3E, 0x80,         // ld a,0x80
+        0xE0, 0x02,         // ldh (0x02),a
+        0xF0, 0x02,         // ldh a,(0x02)
+        0xE6, 0x80,         // and 0x80
+        0x20, 0xFA,         // jr nz,-6
+        0xF0, 0x01,         // ldh a,(0x01)
+        0x12,               // ld (de),a
+        0x13,               // inc de
+        0x3C,               // inc a
+        0x18, 0xED          // jr -19
+    });
+}
+
+std::vector<uint8_t> get_wram(const Machine& machine, int size) {
+    std::vector<uint8_t> ram(Machine::RAM_SIZE);
+    machine.copy_ram(ram.data());
+    return std::vector<uint8_t>(ram.begin(), ram.begin() + size);
+}
+
+}
+
+
+TEST(LinkCableTest, machines_exchange_bytes) {
+    Machine master(make_master_rom({0x10, 0x20, 0x30, 0x40, 0x00}));
+    Machine slave(make_slave_rom());
+    LinkCable cable(master, slave);
+
+    cable.step_frame();
+    cable.step_frame();
+
+    EXPECT_EQ(get_wram(slave, 5), std::vector<uint8_t>({0x10, 0x20, 0x30, 0x40, 0x00}));
+    EXPECT_EQ(get_wram(master, 5), std::vector<uint8_t>({0x00, 0x11, 0x21, 0x31, 0x00}));
+    EXPECT_EQ(master.get_frame_count(), 2u);
+    EXPECT_EQ(slave.get_frame_count(), 2u);
+}
+
+TEST(LinkCableTest, works_either_way_round) {
+    Machine slave(make_slave_rom());
+    Machine master(make_master_rom({0x01, 0x02, 0x03, 0x00}));
+    LinkCable cable(slave, master);
+
+    cable.run_until(Machine::MAX_FRAME_CYCLES);
+
+    EXPECT_EQ(get_wram(slave, 3), std::vector<uint8_t>({0x01, 0x02, 0x03}));
+    EXPECT_EQ(get_wram(master, 3), std::vector<uint8_t>({0x00, 0x02, 0x03}));
+}
+
+TEST(LinkCableTest, machines_stay_within_a_transfer_of_each_other) {
+    Machine master(make_master_rom({0x01, 0x00}));
+    Machine slave(make_slave_rom());
+    LinkCable cable(master, slave);
+
+    for (int i = 0; i != 5; ++i) {
+        cable.step_frame();
+        uint64_t skew = std::max(master.get_time(), slave.get_time()) -
+                        std::min(master.get_time(), slave.get_time());
+        EXPECT_LT(skew, static_cast<uint64_t>(Serial::TRANSFER_CYCLES));
+    }
+}
+
+TEST(LinkCableTest, block_cpus_stay_within_a_transfer_of_each_other) {
+    for (CpuType cpu_type : {CPU_TYPE_CACHED, CPU_TYPE_JIT}) {
+        Machine master(make_master_rom({0x10, 0x20, 0x30, 0x40, 0x00}), {}, cpu_type);
+        Machine slave(make_slave_rom(), {}, cpu_type);
+        LinkCable cable(master, slave);
+
+        for (int i = 0; i != 5; ++i) {
+            cable.step_frame();
+            uint64_t skew = std::max(master.get_time(), slave.get_time()) -
+                            std::min(master.get_time(), slave.get_time());
+            EXPECT_LT(skew, static_cast<uint64_t>(Serial::TRANSFER_CYCLES)) << cpu_type;
+        }
+
+        EXPECT_EQ(get_wram(slave, 5), std::vector<uint8_t>({0x10, 0x20, 0x30, 0x40, 0x00}));
+        EXPECT_EQ(get_wram(master, 5), std::vector<uint8_t>({0x00, 0x11, 0x21, 0x31, 0x00}));
+    }
+}
+
+TEST(LinkCableTest, unplugs_when_destroyed) {
+    Machine master(make_master_rom({0x10, 0x20, 0x00}));
+    Machine slave(make_slave_rom());
+    {
+        LinkCable cable(master, slave);
+    }
+
+    master.step_frame();
+    EXPECT_EQ(get_wram(master, 2), std::vector<uint8_t>({0xFF, 0xFF}));
+}
+
+
+}
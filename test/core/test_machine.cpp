@@ -0,0 +1,164 @@
+#include "gtest/gtest.h"
+
+#include "core/hash.h"
+#include "core/machine.h"
+#include "core/serial_sink.h"
+#include "core/test_roms.h"
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace geemuboi::core {
+
+using namespace geemuboi::view;
+using geemuboi::test::core::make_counting_rom;
+using geemuboi::test::core::make_serial_rom;
+
+
+namespace {
+
+const int PIXELS = Renderer::SCREEN_WIDTH * Renderer::SCREEN_HEIGHT;
+
+std::vector<uint32_t> get_frame(const Machine& machine) {
+    return std::vector<uint32_t>(machine.get_framebuffer(), machine.get_framebuffer() + PIXELS);
+}
+
+void step_frames(Machine& machine, int count) {
+    for (int i = 0; i != count; ++i) {
+        machine.step_frame();
+    }
+}
+
+}
+
+
+TEST(MachineTest, steps_whole_frames) {
+    Machine machine(make_counting_rom());
+    EXPECT_EQ(0u, machine.get_frame_count());
+
+    machine.step_frame();
+    EXPECT_EQ(1u, machine.get_frame_count());
+    std::vector<uint32_t> first = get_frame(machine);
+
+    machine.step_frame();
+    EXPECT_EQ(2u, machine.get_frame_count());
+    EXPECT_NE(first, get_frame(machine));
+}
+
+TEST(MachineTest, starts_without_bios) {
+    Machine machine(make_counting_rom());
+    machine.step_frame();
+
+    // Only the top line of every tile changes, the rest is white in the boot palette
+    const uint32_t* frame = machine.get_framebuffer();
+    EXPECT_EQ(0x00FFFFFFu, frame[Renderer::SCREEN_WIDTH * 4]);
+}
+
+TEST(MachineTest, hashes_finished_frames) {
+    Machine machine(make_counting_rom());
+    machine.step_frame();
+    EXPECT_EQ(machine.get_frame_hash(), 0u);
+
+    machine.set_frame_hashing(true);
+    for (int i = 0; i != 3; ++i) {
+        machine.step_frame();
+        EXPECT_EQ(machine.get_frame_hash(),
+                  hash_bytes(machine.get_framebuffer(), PIXELS * sizeof(uint32_t)));
+    }
+}
+
+TEST(MachineTest, serial_output_reaches_the_sink) {
+    Machine machine(make_serial_rom("Passed"));
+    BufferSerialSink sink;
+    machine.set_serial_sink(&sink);
+
+    machine.step_frame();
+    EXPECT_EQ(sink.get_text(), "Passed");
+}
+
+TEST(MachineTest, run_until_overshoots_by_an_instruction_at_most) {
+    for (CpuType cpu_type : {CPU_TYPE_INTERPRETER, CPU_TYPE_CACHED, CPU_TYPE_JIT}) {
+        Machine machine(make_counting_rom(), {}, cpu_type);
+
+        // No instruction takes more than 6 M-cycles
+        for (uint64_t time = 1; time < 10000; time += 37) {
+            EXPECT_FALSE(machine.run_until(time));
+            EXPECT_GE(machine.get_time(), time) << cpu_type;
+            EXPECT_LT(machine.get_time(), time + 6) << cpu_type;
+        }
+    }
+}
+
+TEST(MachineTest, load_state_resumes_identically) {
+    for (CpuType cpu_type : {CPU_TYPE_INTERPRETER, CPU_TYPE_CACHED, CPU_TYPE_JIT}) {
+        Machine machine(make_counting_rom(), {}, cpu_type);
+        step_frames(machine, 3);
+        std::vector<uint8_t> state = machine.save_state();
+
+        step_frames(machine, 5);
+        std::vector<uint8_t> expected_state = machine.save_state();
+        std::vector<uint32_t> expected_frame = get_frame(machine);
+
+        machine.load_state(state.data(), state.size());
+        EXPECT_EQ(3u, machine.get_frame_count());
+        step_frames(machine, 5);
+        EXPECT_EQ(expected_state, machine.save_state());
+        EXPECT_EQ(expected_frame, get_frame(machine));
+    }
+}
+
+TEST(MachineTest, state_moves_between_instances) {
+    Machine source(make_counting_rom());
+    step_frames(source, 4);
+    std::vector<uint8_t> state = source.save_state();
+
+    Machine destination(make_counting_rom());
+    destination.load_state(state.data(), state.size());
+    step_frames(source, 2);
+    step_frames(destination, 2);
+    EXPECT_EQ(source.save_state(), destination.save_state());
+}
+
+TEST(MachineTest, rejects_invalid_states) {
+    Machine machine(make_counting_rom());
+    machine.step_frame();
+    std::vector<uint8_t> before = machine.save_state();
+
+    std::vector<uint8_t> truncated(before.begin(), before.end() - 1);
+    EXPECT_THROW(machine.load_state(truncated.data(), truncated.size()), InvalidStateException);
+
+    std::vector<uint8_t> corrupted = before;
+    corrupted[0] ^= 0xFF;
+    EXPECT_THROW(machine.load_state(corrupted.data(), corrupted.size()), InvalidStateException);
+
+    EXPECT_THROW(machine.load_state(nullptr, 0), InvalidStateException);
+    EXPECT_EQ(before, machine.save_state());
+}
+
+TEST(MachineTest, instances_run_independently_on_threads) {
+    const int INSTANCES = 8;
+    const int FRAMES = 10;
+
+    Machine reference(make_counting_rom());
+    step_frames(reference, FRAMES);
+
+    std::vector<std::unique_ptr<Machine>> machines;
+    std::vector<std::thread> threads;
+    for (int i = 0; i != INSTANCES; ++i) {
+        machines.push_back(std::make_unique<Machine>(make_counting_rom()));
+        threads.emplace_back([&machine = *machines.back()]() { step_frames(machine, FRAMES); });
+    }
+
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    for (const auto& machine : machines) {
+        EXPECT_EQ(reference.save_state(), machine->save_state());
+    }
+}
+
+
+}
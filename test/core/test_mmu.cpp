@@ -0,0 +1,151 @@
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "audio/null_audio_sink.h"
+#include "core/apu.h"
+#include "core/gpu.h"
+#include "core/input.h"
+#include "core/interrupts.h"
+#include "core/mmu.h"
+#include "core/scheduler.h"
+#include "core/serial.h"
+#include "core/timer.h"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "view/mock_renderer.h"
+
+namespace geemuboi::test::core {
+
+using namespace geemuboi::core;
+using namespace geemuboi::test::view;
+
+
+namespace {
+
+std::string write_file(const std::string& name, int size) {
+    std::string path = (std::filesystem::temp_directory_path() / name).string();
+    std::ofstream ofs(path, std::ios::binary);
+    for (int i = 0; i != size; ++i) {
+        ofs.put(static_cast<char>(i * 3 + (i >> 8)));
+    }
+    return path;
+}
+
+}
+
+
+class MmuTest : public ::testing::Test {
+protected:
+    MmuTest() : renderer{},
+        scheduler{},
+        interrupts{},
+        gpu{renderer, scheduler, interrupts},
+        input{},
+        timer{scheduler, interrupts},
+        serial{scheduler, interrupts},
+        audio_sink{},
+        apu{scheduler, audio_sink},
+        mmu{gpu, input, interrupts, timer, serial, scheduler, apu,
+            write_file("geemuboi_test_bios.bin", 0x100),
+            write_file("geemuboi_test_rom.gb", 0x8000)} {}
+
+    static uint8_t rom_byte(int addr) {
+        return addr * 3 + (addr >> 8);
+    }
+
+    MockRenderer renderer;
+    Scheduler scheduler;
+    Interrupts interrupts;
+    GPU gpu;
+    Input input;
+    Timer timer;
+    Serial serial;
+    geemuboi::audio::NullAudioSink audio_sink;
+    APU apu;
+    MMU mmu;
+};
+
+TEST_F(MmuTest, both_rom_banks_are_readable) {
+    EXPECT_EQ(mmu.read_byte(0x0200), rom_byte(0x0200));
+    EXPECT_EQ(mmu.read_byte(0x4000), rom_byte(0x4000));
+    EXPECT_EQ(mmu.read_word(0x7FFE), rom_byte(0x7FFE) + (rom_byte(0x7FFF) << 8));
+}
+
+TEST_F(MmuTest, rom_and_bios_are_read_only) {
+    mmu.write_byte(0x0010, 0x42);
+    mmu.write_byte(0x2000, 0x01);
+    mmu.write_word(0x4000, 0x1234);
+    mmu.write_word(0x7FFF, 0x1234);
+
+    // The BIOS file has the same bytes as the ROM file
+    EXPECT_EQ(mmu.read_byte(0x0010), rom_byte(0x0010));
+    EXPECT_EQ(mmu.read_byte(0x2000), rom_byte(0x2000));
+    EXPECT_EQ(mmu.read_word(0x4000), rom_byte(0x4000) + (rom_byte(0x4001) << 8));
+    EXPECT_EQ(mmu.read_byte(0x7FFF), rom_byte(0x7FFF));
+}
+
+TEST_F(MmuTest, wram_words_and_echo) {
+    mmu.write_word(0xC010, 0x1234);
+    EXPECT_EQ(mmu.read_word(0xC010), 0x1234);
+    EXPECT_EQ(mmu.read_byte(0xE011), 0x12);
+}
+
+TEST_F(MmuTest, sound_registers) {
+    mmu.write_byte(0xFF24, 0x35);
+    mmu.write_byte(0xFF30, 0xA5);
+
+    EXPECT_EQ(mmu.read_byte(0xFF24), 0x35);
+    EXPECT_EQ(mmu.read_byte(0xFF30), 0xA5);
+    EXPECT_EQ(mmu.read_byte(0xFF26), 0xF0);
+}
+
+TEST_F(MmuTest, interrupt_registers) {
+    mmu.write_byte(0xFFFF, 0x05);
+    mmu.write_byte(0xFF0F, 0x01);
+
+    EXPECT_EQ(mmu.read_byte(0xFFFF), 0x05);
+    EXPECT_EQ(mmu.read_byte(0xFF0F), 0xE1);
+    EXPECT_EQ(interrupts.get_pending(), Interrupts::INTERRUPT_VBLANK);
+}
+
+TEST_F(MmuTest, serial_registers) {
+    mmu.write_byte(0xFF01, 0x42);
+    mmu.write_byte(0xFF02, 0x81);
+    EXPECT_EQ(mmu.read_byte(0xFF01), 0x42);
+    EXPECT_EQ(mmu.read_byte(0xFF02), 0xFF);
+
+    scheduler.advance(1024);
+    EXPECT_EQ(mmu.read_byte(0xFF01), 0xFF);
+    EXPECT_EQ(mmu.read_byte(0xFF02), 0x7F);
+    EXPECT_TRUE(interrupts.get_requested() & Interrupts::INTERRUPT_SERIAL);
+}
+
+TEST_F(MmuTest, dma_copies_to_oam_and_only_leaves_hram_accessible) {
+    for (int i = 0; i != 0xA0; ++i) {
+        mmu.write_byte(0xC100 + i, i);
+    }
+    mmu.write_byte(0xFF80, 0x42);
+
+    mmu.write_byte(0xFF46, 0xC1);
+    EXPECT_EQ(mmu.read_byte(0xFF46), 0xC1);
+
+    scheduler.advance(159);
+    EXPECT_EQ(mmu.read_byte(0xC100), 0xFF);
+    EXPECT_EQ(mmu.read_byte(0xFE00), 0xFF);
+    EXPECT_EQ(mmu.read_byte(0x0200), 0xFF);
+    EXPECT_EQ(mmu.read_byte(0xFF80), 0x42);
+    mmu.write_byte(0xC100, 0x99);
+
+    scheduler.advance(1);
+    EXPECT_EQ(mmu.read_byte(0xC100), 0x00);
+    EXPECT_EQ(mmu.read_byte(0x0200), rom_byte(0x0200));
+    for (int i = 0; i != 0xA0; ++i) {
+        EXPECT_EQ(mmu.read_byte(0xFE00 + i), i);
+    }
+}
+
+
+}
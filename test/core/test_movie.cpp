@@ -0,0 +1,143 @@
+#include "gtest/gtest.h"
+
+#include "core/cpu_factory.h"
+#include "core/hash.h"
+#include "core/machine.h"
+#include "core/movie.h"
+#include "core/test_roms.h"
+
+#include <iterator>
+#include <vector>
+
+namespace geemuboi::core {
+
+using geemuboi::test::core::make_rom;
+
+
+namespace {
+
+// Adds every read of the action buttons into a ring of 256 bytes at 0xC000,
+// so when a change is seen shows up in RAM:
+// ld a,0x10 / ldh (0x00),a / ld hl,0xC000 / ldh a,(0x00) / add (hl) / ld (hl),a /
+// inc l / jr -7
+std::vector<uint8_t> make_button_rom() {
+    return make_rom({0x3E, 0x10, 0xE0, 0x00, 0x21, 0x00, 0xC0, 0xF0, 0x00, 0x86, 0x77, 0x2C, 0x18, 0xF9});
+}
+
+std::vector<uint8_t> get_ram(const Machine& machine) {
+    std::vector<uint8_t> ram(Machine::RAM_SIZE);
+    machine.copy_ram(ram.data());
+    return ram;
+}
+
+const uint8_t BUTTONS[] = {
+    0, Machine::BUTTON_A, Machine::BUTTON_A | Machine::BUTTON_START, 0, Machine::BUTTON_B,
+    Machine::BUTTON_B | Machine::BUTTON_RIGHT, Machine::BUTTON_SELECT
+};
+
+}
+
+
+TEST(MovieTest, encodes_compactly_and_decodes) {
+    Movie movie{0x1234, 0x5678, CPU_TYPE_CACHED, {
+        {0, 100, 0, 0xE},
+        {0, 200, 1, 0x7},
+        {3, 17555, 0, 0xF},
+        {70000, 0, 1, 0xF}
+    }};
+
+    std::vector<uint8_t> data = encode_movie(movie);
+    EXPECT_LE(data.size(), 25u + 1 + 4 * 5);
+
+    Movie decoded = decode_movie(data.data(), data.size());
+    EXPECT_EQ(decoded.rom_hash, 0x1234u);
+    EXPECT_EQ(decoded.bios_hash, 0x5678u);
+    EXPECT_EQ(decoded.cpu_type, CPU_TYPE_CACHED);
+    ASSERT_EQ(decoded.events.size(), movie.events.size());
+    for (size_t i = 0; i != movie.events.size(); ++i) {
+        EXPECT_EQ(decoded.events[i].frame, movie.events[i].frame);
+        EXPECT_EQ(decoded.events[i].cycle, movie.events[i].cycle);
+        EXPECT_EQ(decoded.events[i].column, movie.events[i].column);
+        EXPECT_EQ(decoded.events[i].buttons_pressed, movie.events[i].buttons_pressed);
+    }
+    EXPECT_EQ(decoded.events[2].get_time(), 3u * GPU::CYCLES_PER_FRAME + 17555);
+}
+
+TEST(MovieTest, rejects_invalid_movies) {
+    Movie movie{1, 2, CPU_TYPE_JIT, {{0, 100, 0, 0xE}, {1, 10, 1, 0x7}}};
+    std::vector<uint8_t> data = encode_movie(movie);
+
+    for (size_t size = 0; size != data.size(); ++size) {
+        EXPECT_THROW(decode_movie(data.data(), size), InvalidMovieException) << size;
+    }
+
+    std::vector<uint8_t> invalid = data;
+    invalid[0] ^= 0xFF;
+    EXPECT_THROW(decode_movie(invalid.data(), invalid.size()), InvalidMovieException);
+
+    invalid = data;
+    invalid[24] = CPU_TYPE_JIT + 1;
+    EXPECT_THROW(decode_movie(invalid.data(), invalid.size()), InvalidMovieException);
+
+    invalid = data;
+    invalid.push_back(0);
+    EXPECT_THROW(decode_movie(invalid.data(), invalid.size()), InvalidMovieException);
+
+    invalid = data;
+    invalid.back() = 0x2E;
+    EXPECT_THROW(decode_movie(invalid.data(), invalid.size()), InvalidMovieException);
+}
+
+TEST(MovieTest, replays_exactly) {
+    for (CpuType cpu_type : {CPU_TYPE_INTERPRETER, CPU_TYPE_CACHED, CPU_TYPE_JIT}) {
+        std::vector<uint8_t> rom = make_button_rom();
+        Machine recorded(rom, {}, cpu_type);
+        std::vector<uint8_t> data;
+        {
+            MovieRecorder recorder(recorded.get_input(), recorded.get_scheduler(),
+                                   hash_bytes(rom.data(), rom.size()), hash_bytes(nullptr, 0),
+                                   cpu_type);
+            for (uint8_t buttons : BUTTONS) {
+                recorded.set_buttons(buttons);
+                recorded.step_frame();
+            }
+
+            // One per column that changed
+            EXPECT_EQ(recorder.get_movie().events.size(), 7u);
+            data = encode_movie(recorder.get_movie());
+        }
+
+        Movie movie = decode_movie(data.data(), data.size());
+        Machine replayed(rom, {}, cpu_type);
+        MoviePlayer player(movie, replayed.get_input(), replayed.get_scheduler(), cpu_type);
+        for (size_t i = 0; i != std::size(BUTTONS); ++i) {
+            replayed.step_frame();
+        }
+
+        EXPECT_TRUE(player.is_done());
+        EXPECT_EQ(get_ram(replayed), get_ram(recorded));
+
+        // Pressing the same buttons a little later is not the same run
+        Machine late(rom, {}, cpu_type);
+        for (uint8_t buttons : BUTTONS) {
+            late.step_frame();
+            late.get_scheduler().advance(3);
+            late.set_buttons(buttons);
+        }
+        late.step_frame();
+        EXPECT_NE(get_ram(late), get_ram(recorded));
+    }
+}
+
+TEST(MovieTest, rejects_another_cpu_type) {
+    Movie movie{1, 2, CPU_TYPE_CACHED, {{0, 100, 0, 0xE}}};
+    Machine machine(make_button_rom(), {}, CPU_TYPE_JIT);
+
+    EXPECT_THROW(MoviePlayer(movie, machine.get_input(), machine.get_scheduler(), CPU_TYPE_JIT),
+                 InvalidMovieException);
+    MoviePlayer player(movie, machine.get_input(), machine.get_scheduler(), CPU_TYPE_CACHED);
+    EXPECT_FALSE(player.is_done());
+}
+
+
+}
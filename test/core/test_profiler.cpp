@@ -0,0 +1,117 @@
+#include "gtest/gtest.h"
+
+#include "core/profiler.h"
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+namespace geemuboi::test::core {
+
+using namespace geemuboi::core;
+
+
+namespace {
+
+const uint64_t MILLI = 1000000;
+
+void sleep_millis(int millis) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(millis));
+}
+
+}
+
+
+TEST(HistogramTest, counts_into_power_of_two_buckets) {
+    Histogram histogram;
+    histogram.record(500);
+    histogram.record(1500);
+    histogram.record(3 * MILLI);
+    histogram.record(UINT64_MAX / 2);
+
+    Histogram::Snapshot snapshot = histogram.get_snapshot();
+    EXPECT_EQ(snapshot.count, 4u);
+    EXPECT_EQ(snapshot.max_nanos, UINT64_MAX / 2);
+    EXPECT_EQ(snapshot.buckets[0], 1u);
+    EXPECT_EQ(snapshot.buckets[1], 1u);
+    // 3000 microseconds is above 2^11 and below 2^12
+    EXPECT_EQ(snapshot.buckets[12], 1u);
+    EXPECT_EQ(snapshot.buckets[Histogram::NBR_BUCKETS - 1], 1u);
+}
+
+TEST(HistogramTest, percentiles_are_bucket_limits) {
+    Histogram histogram;
+    for (int i = 0; i != 99; ++i) {
+        histogram.record(MILLI);
+    }
+    histogram.record(5 * MILLI);
+
+    Histogram::Snapshot snapshot = histogram.get_snapshot();
+    EXPECT_EQ(snapshot.get_percentile_nanos(0.5), Histogram::get_bucket_limit_nanos(10));
+    EXPECT_EQ(snapshot.get_percentile_nanos(1), 5 * MILLI);
+    EXPECT_DOUBLE_EQ(snapshot.get_mean_millis(), 1.04);
+}
+
+TEST(HistogramTest, snapshots_subtract) {
+    Histogram histogram;
+    histogram.record(MILLI);
+    Histogram::Snapshot earlier = histogram.get_snapshot();
+    histogram.record(3 * MILLI);
+
+    Histogram::Snapshot diff = histogram.get_snapshot().since(earlier);
+    EXPECT_EQ(diff.count, 1u);
+    EXPECT_DOUBLE_EQ(diff.get_mean_millis(), 3);
+    EXPECT_EQ(diff.buckets[10], 0u);
+}
+
+TEST(ProfilerTest, nested_sections_are_exclusive) {
+    PerfStats stats;
+    Profiler profiler(stats);
+
+    profiler.enter(PerfStats::SECTION_CPU);
+    sleep_millis(20);
+    profiler.enter(PerfStats::SECTION_GPU);
+    sleep_millis(20);
+    profiler.leave();
+    profiler.leave();
+    profiler.end_frame();
+
+    uint64_t cpu = stats.get_histogram(PerfStats::SECTION_CPU).get_snapshot().sum_nanos;
+    uint64_t gpu = stats.get_histogram(PerfStats::SECTION_GPU).get_snapshot().sum_nanos;
+    uint64_t frame = stats.get_histogram(PerfStats::SECTION_FRAME).get_snapshot().sum_nanos;
+    EXPECT_GE(cpu, 19 * MILLI);
+    EXPECT_GE(gpu, 19 * MILLI);
+    EXPECT_LE(cpu + gpu, frame);
+}
+
+TEST(ProfilerTest, records_only_entered_sections) {
+    PerfStats stats;
+    Profiler profiler(stats);
+
+    profiler.enter(PerfStats::SECTION_INPUT);
+    profiler.leave();
+    profiler.flush();
+    profiler.flush();
+
+    EXPECT_EQ(stats.get_histogram(PerfStats::SECTION_INPUT).get_snapshot().count, 1u);
+    EXPECT_EQ(stats.get_histogram(PerfStats::SECTION_PRESENT).get_snapshot().count, 0u);
+    EXPECT_EQ(stats.get_histogram(PerfStats::SECTION_FRAME).get_snapshot().count, 0u);
+}
+
+TEST(PerfStatsTest, formats_metrics) {
+    PerfStats stats;
+    stats.get_histogram(PerfStats::SECTION_GPU).record(2 * MILLI);
+
+    std::string json = stats.format_json();
+    EXPECT_NE(json.find("\"gpu\":{\"count\":1,\"mean_ms\":2,"), std::string::npos);
+
+    std::string text = stats.format_prometheus();
+    EXPECT_NE(text.find("# TYPE geemuboi_section_seconds histogram"), std::string::npos);
+    EXPECT_NE(text.find("geemuboi_section_seconds_bucket{section=\"gpu\",le=\"0.002048\"} 1\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("geemuboi_section_seconds_sum{section=\"gpu\"} 0.002\n"), std::string::npos);
+    EXPECT_NE(text.find("geemuboi_section_seconds_count{section=\"cpu\"} 0\n"), std::string::npos);
+}
+
+
+}
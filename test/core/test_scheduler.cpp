@@ -0,0 +1,87 @@
+#include "gtest/gtest.h"
+
+#include "core/scheduler.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace geemuboi::test::core {
+
+using namespace geemuboi::core;
+
+
+class SchedulerTest : public ::testing::Test {
+protected:
+    SchedulerTest() : scheduler{}, fired{} {
+        scheduler.set_handler(Scheduler::EVENT_GPU, [this]() {
+            fired.push_back(scheduler.get_time());
+        });
+    }
+
+    Scheduler scheduler;
+    std::vector<uint64_t> fired;
+};
+
+TEST_F(SchedulerTest, nothing_scheduled) {
+    scheduler.advance(100);
+
+    EXPECT_EQ(scheduler.get_time(), 100u);
+    EXPECT_EQ(scheduler.get_next_event_time(), Scheduler::NEVER);
+    EXPECT_TRUE(fired.empty());
+}
+
+TEST_F(SchedulerTest, event_runs_at_its_time) {
+    scheduler.schedule_in(Scheduler::EVENT_GPU, 10);
+    EXPECT_EQ(scheduler.get_next_event_time(), 10u);
+
+    scheduler.advance(9);
+    EXPECT_TRUE(fired.empty());
+
+    scheduler.advance(5);
+    ASSERT_EQ(fired.size(), 1u);
+    EXPECT_EQ(fired[0], 10u);
+    EXPECT_EQ(scheduler.get_time(), 14u);
+    EXPECT_EQ(scheduler.get_next_event_time(), Scheduler::NEVER);
+}
+
+TEST_F(SchedulerTest, rescheduling_from_handler_does_not_drift) {
+    scheduler.set_handler(Scheduler::EVENT_GPU, [this]() {
+        fired.push_back(scheduler.get_time());
+        scheduler.schedule_in(Scheduler::EVENT_GPU, 4);
+    });
+    scheduler.schedule(Scheduler::EVENT_GPU, 4);
+
+    scheduler.advance(3);
+    scheduler.advance(11);
+
+    EXPECT_EQ(fired, (std::vector<uint64_t>{4, 8, 12}));
+    EXPECT_EQ(scheduler.get_next_event_time(), 16u);
+}
+
+TEST_F(SchedulerTest, cancelled_event_does_not_run) {
+    scheduler.schedule_in(Scheduler::EVENT_GPU, 10);
+    scheduler.cancel(Scheduler::EVENT_GPU);
+    scheduler.advance(20);
+
+    EXPECT_TRUE(fired.empty());
+}
+
+TEST_F(SchedulerTest, profiler_times_sectioned_events) {
+    PerfStats stats;
+    Profiler profiler(stats);
+    scheduler.set_profiler(&profiler);
+    scheduler.set_handler(Scheduler::EVENT_TIMER, []() {});
+    scheduler.schedule(Scheduler::EVENT_GPU, 4);
+    scheduler.schedule(Scheduler::EVENT_TIMER, 6);
+
+    scheduler.advance(10);
+    profiler.flush();
+
+    EXPECT_EQ(fired.size(), 1u);
+    EXPECT_EQ(stats.get_histogram(PerfStats::SECTION_GPU).get_snapshot().count, 1u);
+    // Timer events count as the CPU, which wasn't entered here
+    EXPECT_EQ(stats.get_histogram(PerfStats::SECTION_CPU).get_snapshot().count, 0u);
+}
+
+
+}
@@ -0,0 +1,144 @@
+#include "gtest/gtest.h"
+
+#include "core/interrupts.h"
+#include "core/scheduler.h"
+#include "core/serial.h"
+#include "core/serial_sink.h"
+#include "core/state.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+namespace geemuboi::test::core {
+
+using namespace geemuboi::core;
+
+
+class SerialTest : public ::testing::Test {
+protected:
+    SerialTest() : scheduler{}, interrupts{}, serial{scheduler, interrupts} {}
+
+    void send(uint8_t val) {
+        serial.set_data(val);
+        serial.set_control(0x81);
+        scheduler.advance(TRANSFER_CYCLES);
+    }
+
+    static const int TRANSFER_CYCLES = 1024;
+
+    Scheduler scheduler;
+    Interrupts interrupts;
+    Serial serial;
+};
+
+TEST_F(SerialTest, internal_clock_transfer_takes_a_byte_time) {
+    serial.set_data(0x42);
+    serial.set_control(0x81);
+
+    scheduler.advance(TRANSFER_CYCLES - 1);
+    EXPECT_EQ(serial.get_control(), 0xFF);
+    EXPECT_EQ(serial.get_data(), 0x42);
+    EXPECT_EQ(interrupts.get_requested() & Interrupts::INTERRUPT_SERIAL, 0);
+
+    scheduler.advance(1);
+    EXPECT_EQ(serial.get_control(), 0x7F);
+    // Nothing connected shifts in ones
+    EXPECT_EQ(serial.get_data(), 0xFF);
+    EXPECT_EQ(interrupts.get_requested() & Interrupts::INTERRUPT_SERIAL,
+              Interrupts::INTERRUPT_SERIAL);
+}
+
+TEST_F(SerialTest, external_clock_waits_for_a_peer) {
+    serial.set_data(0x42);
+    serial.set_control(0x80);
+
+    scheduler.advance(TRANSFER_CYCLES * 10);
+    EXPECT_EQ(serial.get_control(), 0xFE);
+    EXPECT_EQ(serial.get_data(), 0x42);
+    EXPECT_EQ(interrupts.get_requested() & Interrupts::INTERRUPT_SERIAL, 0);
+
+    serial.set_control(0x00);
+    EXPECT_EQ(serial.receive(0x17), 0xFF);
+    EXPECT_EQ(serial.get_data(), 0x42);
+}
+
+TEST_F(SerialTest, buffer_sink_collects_bytes) {
+    BufferSerialSink sink;
+    serial.set_sink(&sink);
+
+    for (char c : std::string("Passed")) {
+        send(c);
+    }
+    EXPECT_EQ(sink.get_text(), "Passed");
+
+    sink.clear();
+    EXPECT_EQ(sink.get_text(), "");
+}
+
+TEST_F(SerialTest, file_sink_writes_bytes) {
+    std::string path = (std::filesystem::temp_directory_path() / "geemuboi_test_serial.txt").string();
+    {
+        FileSerialSink sink(path);
+        serial.set_sink(&sink);
+        send('o');
+        send('k');
+        serial.set_sink(nullptr);
+    }
+
+    std::ifstream ifs(path, std::ios::binary);
+    EXPECT_EQ(std::string(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>()), "ok");
+}
+
+TEST_F(SerialTest, link_sink_exchanges_bytes_with_the_peer) {
+    Scheduler peer_scheduler;
+    Interrupts peer_interrupts;
+    Serial peer(peer_scheduler, peer_interrupts);
+    LinkSerialSink cable(peer);
+    serial.set_sink(&cable);
+
+    peer.set_data(0x99);
+    peer.set_control(0x80);
+    send(0x42);
+
+    EXPECT_EQ(serial.get_data(), 0x99);
+    EXPECT_EQ(peer.get_data(), 0x42);
+    EXPECT_EQ(peer.get_control(), 0x7E);
+    EXPECT_EQ(peer_interrupts.get_requested() & Interrupts::INTERRUPT_SERIAL,
+              Interrupts::INTERRUPT_SERIAL);
+
+    // The peer is not listening anymore
+    send(0x43);
+    EXPECT_EQ(serial.get_data(), 0xFF);
+    EXPECT_EQ(peer.get_data(), 0x42);
+}
+
+TEST_F(SerialTest, transfer_in_progress_survives_save_state) {
+    serial.set_data(0x42);
+    serial.set_control(0x81);
+    scheduler.advance(100);
+
+    StateWriter writer;
+    scheduler.save_state(writer);
+    serial.save_state(writer);
+
+    Scheduler other_scheduler;
+    Interrupts other_interrupts;
+    Serial other(other_scheduler, other_interrupts);
+    BufferSerialSink sink;
+    other.set_sink(&sink);
+
+    StateReader reader(writer.get_data().data(), writer.get_data().size());
+    other_scheduler.load_state(reader);
+    other.load_state(reader);
+    EXPECT_TRUE(reader.at_end());
+
+    other_scheduler.advance(TRANSFER_CYCLES - 101);
+    EXPECT_EQ(sink.get_text(), "");
+    other_scheduler.advance(1);
+    EXPECT_EQ(sink.get_text(), "B");
+}
+
+
+}
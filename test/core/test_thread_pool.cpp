@@ -0,0 +1,84 @@
+#include "gtest/gtest.h"
+
+#include "core/thread_pool.h"
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace geemuboi::core {
+
+
+TEST(ThreadPoolTest, runs_every_iteration_once) {
+    ThreadPool pool(4);
+    EXPECT_EQ(4, pool.get_threads());
+
+    for (int count : {0, 1, 3, 4, 101}) {
+        std::vector<std::atomic<int>> runs(count);
+        std::function<void(int)> body = [&](int i) { ++runs[i]; };
+        pool.run(count, body);
+
+        for (int i = 0; i != count; ++i) {
+            EXPECT_EQ(1, runs[i].load()) << "count " << count << " iteration " << i;
+        }
+    }
+}
+
+TEST(ThreadPoolTest, idle_threads_steal_work) {
+    ThreadPool pool(2);
+
+    // The first half is all slow, the thread owning it can't finish it
+    // alone before the other one comes looking.
+    std::vector<std::thread::id> threads(8);
+    std::function<void(int)> body = [&](int i) {
+        if (i < 4) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        threads[i] = std::this_thread::get_id();
+    };
+    pool.run(8, body);
+
+    bool stolen = false;
+    for (int i = 1; i != 4; ++i) {
+        stolen |= threads[i] != threads[0];
+    }
+    EXPECT_TRUE(stolen);
+}
+
+TEST(ThreadPoolTest, runs_on_the_calling_thread_alone) {
+    ThreadPool pool(1);
+
+    std::vector<std::thread::id> threads(5);
+    std::function<void(int)> body = [&](int i) { threads[i] = std::this_thread::get_id(); };
+    pool.run(5, body);
+
+    for (std::thread::id id : threads) {
+        EXPECT_EQ(std::this_thread::get_id(), id);
+    }
+}
+
+TEST(ThreadPoolTest, rethrows_after_every_iteration_ran) {
+    ThreadPool pool(4);
+
+    std::vector<std::atomic<int>> runs(40);
+    std::function<void(int)> body = [&](int i) {
+        ++runs[i];
+        if (i % 10 == 3) {
+            throw std::runtime_error("iteration failed");
+        }
+    };
+    EXPECT_THROW(pool.run(40, body), std::runtime_error);
+
+    for (int i = 0; i != 40; ++i) {
+        EXPECT_EQ(1, runs[i].load()) << "iteration " << i;
+    }
+
+    // Nothing is left over for the next run
+    std::function<void(int)> nothing = [](int) {};
+    EXPECT_NO_THROW(pool.run(4, nothing));
+}
+
+
+}
@@ -0,0 +1,151 @@
+#include "gtest/gtest.h"
+
+#include "core/interrupts.h"
+#include "core/scheduler.h"
+#include "core/timer.h"
+
+namespace geemuboi::test::core {
+
+using namespace geemuboi::core;
+
+
+class TimerTest : public ::testing::Test {
+protected:
+    TimerTest() : scheduler{}, interrupts{}, timer{scheduler, interrupts} {}
+
+    // Reference model, increments a 16 bit T-cycle divider one M-cycle at
+    // a time and ticks TIMA on falling edges of the selected bit.
+    struct CountingTimer {
+        uint16_t divider;
+        uint8_t counter;
+        uint8_t modulo;
+        uint8_t control;
+        int overflows;
+
+        bool signal() const {
+            static const int bits[4] = {9, 3, 5, 7};
+            return (control & 0x4) && (divider >> bits[control & 0x3] & 1);
+        }
+
+        void tick() {
+            if (++counter == 0) {
+                counter = modulo;
+                ++overflows;
+            }
+        }
+
+        void step() {
+            bool before = signal();
+            divider += 4;
+            if (before && !signal()) {
+                tick();
+            }
+        }
+    };
+
+    Scheduler scheduler;
+    Interrupts interrupts;
+    Timer timer;
+};
+
+TEST_F(TimerTest, divider_follows_time) {
+    scheduler.advance(63);
+    EXPECT_EQ(timer.get_divider(), 0);
+    scheduler.advance(1);
+    EXPECT_EQ(timer.get_divider(), 1);
+
+    scheduler.advance(64 * 255);
+    EXPECT_EQ(timer.get_divider(), 0);
+
+    scheduler.advance(100);
+    timer.reset_divider();
+    EXPECT_EQ(timer.get_divider(), 0);
+}
+
+TEST_F(TimerTest, disabled_counter_does_not_count) {
+    timer.set_control(0x01);
+    scheduler.advance(1000);
+
+    EXPECT_EQ(timer.get_counter(), 0);
+    EXPECT_EQ(scheduler.get_next_event_time(), Scheduler::NEVER);
+}
+
+TEST_F(TimerTest, overflow_reloads_and_requests_interrupt) {
+    interrupts.set_enabled(Interrupts::INTERRUPT_TIMER);
+    timer.set_modulo(0xF0);
+    timer.set_counter(0xFE);
+    timer.set_control(0x05);
+
+    EXPECT_EQ(scheduler.get_next_event_time(), 8u);
+
+    scheduler.advance(7);
+    EXPECT_EQ(timer.get_counter(), 0xFF);
+    EXPECT_EQ(interrupts.get_pending(), 0);
+
+    scheduler.advance(1);
+    EXPECT_EQ(timer.get_counter(), 0xF0);
+    EXPECT_EQ(interrupts.get_pending(), Interrupts::INTERRUPT_TIMER);
+    EXPECT_EQ(scheduler.get_next_event_time(), 8u + 16 * 4);
+}
+
+TEST_F(TimerTest, matches_counting_timer) {
+    CountingTimer reference{};
+    interrupts.set_enabled(Interrupts::INTERRUPT_TIMER);
+
+    // Register writes at odd times, including ones that glitch a tick
+    struct Write {
+        int time;
+        int reg;
+        uint8_t val;
+    };
+    const Write writes[] = {
+        {0, 7, 0x05}, {3, 6, 0x80}, {50, 4, 0}, {171, 7, 0x06}, {173, 5, 0xFA},
+        {1000, 7, 0x04}, {1130, 4, 0}, {1131, 7, 0x07}, {4000, 7, 0x03},
+        {4500, 7, 0x05}, {4502, 7, 0x00}, {4600, 7, 0x05}, {20000, 6, 0xFE},
+    };
+
+    int next_write = 0;
+    int overflows = 0;
+    for (int time = 0; time != 100000; ++time) {
+        while (next_write != sizeof(writes) / sizeof(writes[0]) && writes[next_write].time == time) {
+            const Write& write = writes[next_write++];
+            switch (write.reg) {
+            case 4: {
+                bool before = reference.signal();
+                timer.reset_divider();
+                reference.divider = 0;
+                if (before) {
+                    reference.tick();
+                }
+                break;
+            }
+            case 5: timer.set_counter(write.val); reference.counter = write.val; break;
+            case 6: timer.set_modulo(write.val); reference.modulo = write.val; break;
+            case 7: {
+                bool before = reference.signal();
+                timer.set_control(write.val);
+                reference.control = write.val & 0x7;
+                if (before && !reference.signal()) {
+                    reference.tick();
+                }
+                break;
+            }
+            }
+        }
+
+        ASSERT_EQ(timer.get_divider(), reference.divider >> 8) << "at " << time;
+        ASSERT_EQ(timer.get_counter(), reference.counter) << "at " << time;
+
+        if (interrupts.get_pending()) {
+            interrupts.acknowledge(Interrupts::INTERRUPT_TIMER);
+            ++overflows;
+        }
+        ASSERT_EQ(overflows, reference.overflows) << "at " << time;
+
+        scheduler.advance(1);
+        reference.step();
+    }
+}
+
+
+}
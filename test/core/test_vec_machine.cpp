@@ -0,0 +1,120 @@
+#include "gtest/gtest.h"
+
+#include "core/test_roms.h"
+#include "core/vec_machine.h"
+#include "view/renderer.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+namespace geemuboi::core {
+
+using namespace geemuboi::view;
+using geemuboi::test::core::make_rom;
+
+
+namespace {
+
+// Selects the action buttons and copies them to 0xC000 forever:
+// ld a,0x10 / ldh (0x00),a / ldh a,(0x00) / ld (0xC000),a / jr -11
+std::vector<uint8_t> make_button_rom() {
+    return make_rom({0x3E, 0x10, 0xE0, 0x00, 0xF0, 0x00, 0xEA, 0x00, 0xC0, 0x18, 0xF5});
+}
+
+// Waits for the A button and then runs an undefined instruction:
+// ld a,0x10 / ldh (0x00),a / ldh a,(0x00) / bit 0,a / jr nz,-10 / 0xD3
+std::vector<uint8_t> make_crashing_rom() {
+    return make_rom({0x3E, 0x10, 0xE0, 0x00, 0xF0, 0x00, 0xCB, 0x47, 0x20, 0xF6, 0xD3});
+}
+
+}
+
+
+TEST(VecMachineTest, observation_sizes) {
+    VecMachine pixels(1, make_button_rom(), VecMachine::OBSERVATION_PIXELS, 4, 1);
+    EXPECT_EQ(40, pixels.get_observation_width());
+    EXPECT_EQ(36, pixels.get_observation_height());
+    EXPECT_EQ(40 * 36, pixels.get_observation_size());
+
+    VecMachine ram(1, make_button_rom(), VecMachine::OBSERVATION_RAM, 1, 1);
+    EXPECT_EQ(static_cast<int>(Machine::RAM_SIZE), ram.get_observation_size());
+
+    EXPECT_THROW(VecMachine(1, make_button_rom(), VecMachine::OBSERVATION_PIXELS, 3), std::invalid_argument);
+    EXPECT_THROW(VecMachine(0, make_button_rom()), std::invalid_argument);
+}
+
+TEST(VecMachineTest, actions_reach_their_machine) {
+    VecMachine machines(4, make_button_rom(), VecMachine::OBSERVATION_RAM, 1, 2);
+    const uint8_t ACTIONS[] = {0, Machine::BUTTON_A, Machine::BUTTON_START, Machine::BUTTON_A | Machine::BUTTON_B};
+    std::vector<uint8_t> observations(4 * machines.get_observation_size());
+
+    machines.step(ACTIONS, 2, observations.data());
+
+    const uint8_t EXPECTED[] = {0xF, 0xE, 0x7, 0xC};
+    for (int i = 0; i != 4; ++i) {
+        EXPECT_EQ(EXPECTED[i], observations[i * machines.get_observation_size()] & 0xF) << "machine " << i;
+    }
+}
+
+TEST(VecMachineTest, matches_machines_stepped_alone) {
+    const int COUNT = 6;
+    VecMachine machines(COUNT, make_button_rom(), VecMachine::OBSERVATION_PIXELS, 2, 3);
+    std::vector<uint8_t> actions(COUNT, 0);
+    std::vector<uint8_t> observations(COUNT * machines.get_observation_size());
+    machines.step(actions.data(), 3, observations.data());
+
+    Machine reference(make_button_rom());
+    for (int i = 0; i != 3; ++i) {
+        reference.step_frame();
+    }
+
+    for (int i = 0; i != COUNT; ++i) {
+        EXPECT_EQ(reference.save_state(), machines.get_machine(i).save_state());
+    }
+
+    // A blank screen is white
+    EXPECT_TRUE(std::all_of(observations.begin(), observations.end(),
+                            [](uint8_t gray) { return gray == 0xFF; }));
+}
+
+TEST(VecMachineTest, reset_restores_power_on) {
+    VecMachine machines(2, make_button_rom(), VecMachine::OBSERVATION_RAM, 1, 1);
+    std::vector<uint8_t> initial = machines.get_machine(0).save_state();
+
+    const uint8_t ACTIONS[] = {Machine::BUTTON_A, Machine::BUTTON_A};
+    std::vector<uint8_t> observations(2 * machines.get_observation_size());
+    machines.step(ACTIONS, 1, observations.data());
+
+    machines.reset(1);
+    EXPECT_EQ(initial, machines.get_machine(1).save_state());
+    EXPECT_NE(initial, machines.get_machine(0).save_state());
+
+    machines.observe(observations.data());
+    EXPECT_EQ(0, observations[machines.get_observation_size()]);
+}
+
+TEST(VecMachineTest, crashed_machines_leave_the_others_running) {
+    VecMachine machines(4, make_crashing_rom(), VecMachine::OBSERVATION_RAM, 1, 2);
+    const uint8_t ACTIONS[] = {0, Machine::BUTTON_A, 0, Machine::BUTTON_A};
+    std::vector<uint8_t> observations(4 * machines.get_observation_size());
+
+    machines.step(ACTIONS, 2, observations.data());
+
+    for (int i = 0; i != 4; ++i) {
+        EXPECT_EQ(ACTIONS[i] != 0, machines.has_crashed(i)) << "machine " << i;
+    }
+    EXPECT_EQ("An undefined instruction was called.", machines.get_crash_reason(1));
+    EXPECT_EQ("", machines.get_crash_reason(0));
+
+    // Stays crashed until reset
+    const uint8_t NO_ACTIONS[4] = {};
+    machines.step(NO_ACTIONS, 1, observations.data());
+    EXPECT_TRUE(machines.has_crashed(3));
+
+    machines.reset(3);
+    EXPECT_FALSE(machines.has_crashed(3));
+}
+
+
+}
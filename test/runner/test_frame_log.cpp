@@ -0,0 +1,53 @@
+#include "gtest/gtest.h"
+
+#include "runner/frame_log.h"
+
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace geemuboi::runner {
+
+
+namespace {
+
+std::string temp_path(const std::string& name) {
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+}
+
+
+TEST(FrameLogTest, written_logs_read_back) {
+    std::string path = temp_path("geemuboi_test_frame_log.log");
+    const std::vector<uint64_t> hashes{0, 0x1234, 0xFEDCBA9876543210};
+    write_frame_log(path, hashes);
+    EXPECT_EQ(hashes, read_frame_log(path));
+
+    std::ifstream ifs(path);
+    std::string line;
+    std::getline(ifs, line);
+    EXPECT_EQ("0000000000000000", line);
+}
+
+TEST(FrameLogTest, invalid_logs_throw) {
+    EXPECT_THROW(read_frame_log(temp_path("geemuboi_missing.log")), std::runtime_error);
+
+    std::string path = temp_path("geemuboi_test_invalid_frame_log.log");
+    std::ofstream(path) << "00ff\nnot a hash\n";
+    EXPECT_THROW(read_frame_log(path), std::runtime_error);
+}
+
+TEST(FrameLogTest, finds_the_first_divergent_frame) {
+    const std::vector<uint64_t> golden{1, 2, 3, 4};
+    EXPECT_EQ(-1, find_divergent_frame(golden, {1, 2, 3, 4}));
+    EXPECT_EQ(0, find_divergent_frame(golden, {9, 2, 3, 4}));
+    EXPECT_EQ(2, find_divergent_frame(golden, {1, 2, 9, 9}));
+    EXPECT_EQ(3, find_divergent_frame(golden, {1, 2, 3}));
+    EXPECT_EQ(4, find_divergent_frame(golden, {1, 2, 3, 4, 5}));
+}
+
+
+}
@@ -0,0 +1,126 @@
+#include "gtest/gtest.h"
+
+#include "core/hash.h"
+#include "core/machine.h"
+#include "core/test_roms.h"
+#include "runner/frame_log.h"
+#include "runner/job.h"
+#include "view/renderer.h"
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace geemuboi::runner {
+
+using namespace geemuboi::core;
+using geemuboi::view::Renderer;
+using geemuboi::test::core::make_counting_rom;
+using geemuboi::test::core::make_serial_rom;
+
+
+namespace {
+
+uint64_t hash_after(int frames) {
+    Machine machine(make_counting_rom());
+    for (int i = 0; i != frames; ++i) {
+        machine.step_frame();
+    }
+
+    return hash_bytes(machine.get_framebuffer(),
+                      Renderer::SCREEN_WIDTH * Renderer::SCREEN_HEIGHT * sizeof(uint32_t));
+}
+
+}
+
+
+TEST(JobTest, checks_the_last_frame) {
+    ManifestEntry entry{"test.gb", 5, ManifestEntry::EXPECT_FRAME_HASH, hash_after(5), "", "", 1};
+    EXPECT_EQ(JobResult::STATUS_PASS, run_job(entry, make_counting_rom()).status);
+
+    entry.frames = 6;
+    JobResult result = run_job(entry, make_counting_rom());
+    EXPECT_EQ(JobResult::STATUS_FAIL, result.status);
+    EXPECT_NE(std::string::npos, result.detail.find("expected"));
+}
+
+TEST(JobTest, serial_tests_end_when_the_text_shows_up) {
+    // Far more frames than this could run in the test's time if they all ran
+    ManifestEntry entry{"test.gb", 10000000, ManifestEntry::EXPECT_SERIAL, 0, "Passed", "", 1};
+    EXPECT_EQ(JobResult::STATUS_PASS, run_job(entry, make_serial_rom("cpu_instrs\n\nPassed\n")).status);
+
+    JobResult result = run_job(entry, make_serial_rom("01:ok 02:01\n\nFailed 1 tests.\n"));
+    EXPECT_EQ(JobResult::STATUS_FAIL, result.status);
+    EXPECT_NE(std::string::npos,
+              result.detail.find("\"01:ok 02:01\\n\\nFailed 1 tests.\\n\" after 2 frames"))
+        << result.detail;
+
+    entry.frames = 3;
+    result = run_job(entry, make_serial_rom("running"));
+    EXPECT_EQ(JobResult::STATUS_FAIL, result.status);
+    EXPECT_NE(std::string::npos, result.detail.find("after 3 frames")) << result.detail;
+}
+
+TEST(JobTest, frame_logs_report_the_first_divergent_frame) {
+    std::string path = (std::filesystem::temp_directory_path() / "geemuboi_test_job.log").string();
+    ManifestEntry entry{"test.gb", 5, ManifestEntry::EXPECT_FRAME_LOG, 0, "", path, 1};
+    EXPECT_EQ(JobResult::STATUS_PASS, run_job(entry, make_counting_rom(), true).status);
+
+    std::vector<uint64_t> golden = read_frame_log(path);
+    ASSERT_EQ(5u, golden.size());
+    EXPECT_EQ(hash_after(5), golden[4]);
+    EXPECT_EQ(JobResult::STATUS_PASS, run_job(entry, make_counting_rom()).status);
+
+    golden[3] ^= 1;
+    write_frame_log(path, golden);
+    JobResult result = run_job(entry, make_counting_rom());
+    EXPECT_EQ(JobResult::STATUS_FAIL, result.status);
+    EXPECT_EQ(0u, result.detail.find("frame 3 diverges")) << result.detail;
+
+    entry.frames = 6;
+    result = run_job(entry, make_counting_rom());
+    EXPECT_EQ(JobResult::STATUS_FAIL, result.status);
+
+    entry.frame_log = "/nonexistent/golden.log";
+    EXPECT_EQ(JobResult::STATUS_ERROR, run_job(entry, make_counting_rom()).status);
+}
+
+TEST(JobTest, missing_roms_are_errors) {
+    ManifestEntry entry{"missing.gb", 5, ManifestEntry::EXPECT_FRAME_HASH, 0, "", "", 1};
+    EXPECT_EQ(JobResult::STATUS_ERROR, run_job(entry, read_rom("/nonexistent/missing.gb")).status);
+}
+
+TEST(JobTest, cache_keys_cover_rom_build_and_entry) {
+    ManifestEntry entry{"test.gb", 5, ManifestEntry::EXPECT_FRAME_HASH, 1, "", "", 1};
+    std::vector<uint8_t> rom = make_counting_rom();
+    uint64_t key = get_cache_key(entry, rom, 1);
+
+    EXPECT_EQ(key, get_cache_key(entry, rom, 1));
+    EXPECT_NE(key, get_cache_key(entry, rom, 2));
+
+    ManifestEntry other = entry;
+    other.frames = 6;
+    EXPECT_NE(key, get_cache_key(other, rom, 1));
+    other = entry;
+    other.frame_hash = 2;
+    EXPECT_NE(key, get_cache_key(other, rom, 1));
+    other = entry;
+    other.serial_text = "Passed";
+    EXPECT_NE(key, get_cache_key(other, rom, 1));
+
+    // The golden log is part of a frame log test
+    std::string path = (std::filesystem::temp_directory_path() / "geemuboi_test_key.log").string();
+    write_frame_log(path, {1, 2});
+    other = entry;
+    other.expectation = ManifestEntry::EXPECT_FRAME_LOG;
+    other.frame_log = path;
+    uint64_t log_key = get_cache_key(other, rom, 1);
+    write_frame_log(path, {1, 3});
+    EXPECT_NE(log_key, get_cache_key(other, rom, 1));
+
+    rom[0x150] = 1;
+    EXPECT_NE(key, get_cache_key(entry, rom, 1));
+}
+
+
+}
@@ -0,0 +1,63 @@
+#include "gtest/gtest.h"
+
+#include "runner/manifest.h"
+
+#include <sstream>
+
+namespace geemuboi::runner {
+
+
+TEST(ManifestTest, parses_entries) {
+    std::istringstream in(
+        "# rom  frames  expectation\n"
+        "\n"
+        "games/tetris.gb  600  hash:3f2a9c0d1e4b5a67\n"
+        "/abs/test.gb\t10\thash:FF  \r\n"
+        "blargg/cpu_instrs.gb 3600 serial:All tests passed \n"
+        "games/tetris.gb 100 log:logs/tetris.log\n");
+
+    std::vector<ManifestEntry> entries = parse_manifest(in, "suite");
+    ASSERT_EQ(4u, entries.size());
+
+    EXPECT_EQ("suite/games/tetris.gb", entries[0].rom);
+    EXPECT_EQ(600, entries[0].frames);
+    EXPECT_EQ(ManifestEntry::EXPECT_FRAME_HASH, entries[0].expectation);
+    EXPECT_EQ(0x3f2a9c0d1e4b5a67u, entries[0].frame_hash);
+    EXPECT_EQ(3, entries[0].line);
+
+    EXPECT_EQ("/abs/test.gb", entries[1].rom);
+    EXPECT_EQ(10, entries[1].frames);
+    EXPECT_EQ(0xFFu, entries[1].frame_hash);
+
+    EXPECT_EQ(ManifestEntry::EXPECT_SERIAL, entries[2].expectation);
+    EXPECT_EQ("All tests passed", entries[2].serial_text);
+
+    EXPECT_EQ(ManifestEntry::EXPECT_FRAME_LOG, entries[3].expectation);
+    EXPECT_EQ("suite/logs/tetris.log", entries[3].frame_log);
+}
+
+TEST(ManifestTest, reports_the_line_of_errors) {
+    const char* const INVALID[] = {
+        "test.gb\n",
+        "test.gb -1 hash:00\n",
+        "test.gb 10\n",
+        "test.gb 10 hash:xyz\n",
+        "test.gb 10 hash:\n",
+        "test.gb 10 serial:\n",
+        "test.gb 10 log:\n",
+        "test.gb 10 pixels:00\n"
+    };
+
+    for (const char* text : INVALID) {
+        std::istringstream in(std::string("# header\n") + text);
+        try {
+            parse_manifest(in, "");
+            ADD_FAILURE() << "Accepted " << text;
+        } catch (const ManifestException& e) {
+            EXPECT_EQ(2, e.get_line()) << text;
+        }
+    }
+}
+
+
+}
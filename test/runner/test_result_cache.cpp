@@ -0,0 +1,41 @@
+#include "gtest/gtest.h"
+
+#include "runner/result_cache.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <string>
+
+namespace geemuboi::runner {
+
+
+TEST(ResultCacheTest, results_survive_a_save) {
+    std::string path = (std::filesystem::temp_directory_path() / "geemuboi_test_results.cache").string();
+    std::remove(path.c_str());
+
+    {
+        ResultCache cache(path);
+        JobResult result;
+        EXPECT_FALSE(cache.lookup(1, result));
+
+        cache.store(1, {JobResult::STATUS_PASS, "", 0.5});
+        cache.store(0xFEDCBA9876543210, {JobResult::STATUS_FAIL, "frame hash 00, expected 01", 2});
+        EXPECT_TRUE(cache.save());
+    }
+
+    ResultCache cache(path);
+    JobResult result;
+    ASSERT_TRUE(cache.lookup(1, result));
+    EXPECT_EQ(JobResult::STATUS_PASS, result.status);
+    EXPECT_EQ("", result.detail);
+    EXPECT_DOUBLE_EQ(0.5, result.seconds);
+
+    ASSERT_TRUE(cache.lookup(0xFEDCBA9876543210, result));
+    EXPECT_EQ(JobResult::STATUS_FAIL, result.status);
+    EXPECT_EQ("frame hash 00, expected 01", result.detail);
+
+    EXPECT_FALSE(cache.lookup(2, result));
+}
+
+
+}
@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+
+#include "view/capture.h"
+
+#include <vector>
+
+namespace geemuboi::view {
+
+
+namespace {
+
+const int PIXELS = Renderer::SCREEN_WIDTH * Renderer::SCREEN_HEIGHT;
+
+std::vector<uint8_t> make_pattern(int seed) {
+    std::vector<uint8_t> shades(PIXELS);
+    for (int i = 0; i != PIXELS; ++i) {
+        shades[i] = (i * seed + i / 7) % Renderer::NBR_SHADES;
+    }
+    return shades;
+}
+
+}
+
+
+TEST(CaptureTest, frames_round_trip) {
+    std::vector<std::vector<uint8_t>> frames{make_pattern(1), make_pattern(1), make_pattern(3)};
+    // A single changed pixel in the middle of a still screen
+    frames.push_back(frames.back());
+    frames.back()[PIXELS / 2] ^= 1;
+
+    CaptureEncoder encoder;
+    std::vector<uint8_t> data;
+    encoder.encode_header(data);
+    uint64_t frame_numbers[] = {0, 1, 4, 5};
+    for (int i = 0; i != 4; ++i) {
+        encoder.encode_frame(frames[i].data(), frame_numbers[i], data);
+    }
+
+    std::vector<CaptureFrame> decoded = decode_capture(data.data(), data.size());
+    ASSERT_EQ(decoded.size(), 4u);
+    for (int i = 0; i != 4; ++i) {
+        EXPECT_EQ(decoded[i].frame, frame_numbers[i]);
+        EXPECT_EQ(decoded[i].shades, frames[i]);
+    }
+}
+
+TEST(CaptureTest, unchanged_frames_take_a_few_bytes) {
+    std::vector<uint8_t> frame = make_pattern(5);
+    CaptureEncoder encoder;
+    std::vector<uint8_t> first;
+    encoder.encode_frame(frame.data(), 0, first);
+    std::vector<uint8_t> second;
+    encoder.encode_frame(frame.data(), 1, second);
+
+    EXPECT_GT(first.size(), static_cast<size_t>(PIXELS / 4));
+    EXPECT_EQ(second.size(), 4u);
+}
+
+TEST(CaptureTest, decode_rejects_bad_captures) {
+    std::vector<uint8_t> frame = make_pattern(2);
+    CaptureEncoder encoder;
+    std::vector<uint8_t> data;
+    encoder.encode_header(data);
+    encoder.encode_frame(frame.data(), 0, data);
+
+    std::vector<uint8_t> truncated(data.begin(), data.end() - 1);
+    EXPECT_THROW(decode_capture(truncated.data(), truncated.size()), InvalidCaptureException);
+
+    std::vector<uint8_t> bad_magic = data;
+    bad_magic[0] = 'X';
+    EXPECT_THROW(decode_capture(bad_magic.data(), bad_magic.size()), InvalidCaptureException);
+}
+
+TEST(CaptureTest, shades_become_grays) {
+    std::vector<uint8_t> shades(PIXELS, Renderer::SHADE_BLACK);
+    shades[0] = Renderer::SHADE_WHITE;
+    std::vector<uint8_t> yuv(YUV_FRAME_SIZE);
+    shades_to_yuv(shades.data(), yuv.data());
+
+    EXPECT_EQ(yuv[0], 235);
+    EXPECT_EQ(yuv[1], 16);
+    EXPECT_EQ(yuv[PIXELS], 128);
+    EXPECT_EQ(yuv.back(), 128);
+}
+
+
+}
@@ -0,0 +1,159 @@
+#include <gtest/gtest.h>
+
+#include "view/capture.h"
+#include "view/recording_renderer.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <sstream>
+#include <streambuf>
+#include <vector>
+
+namespace geemuboi::view {
+
+
+namespace {
+
+const int PIXELS = Renderer::SCREEN_WIDTH * Renderer::SCREEN_HEIGHT;
+
+class ColorRenderer : public Renderer {
+public:
+    void render_frame(uint32_t img[]) { frames.push_back(img[0]); }
+
+    std::vector<uint32_t> frames;
+};
+
+class LockingShadeRenderer : public Renderer {
+public:
+    static const int PITCH = SCREEN_WIDTH + 8;
+
+    LockingShadeRenderer() : shades(PITCH * SCREEN_HEIGHT) {}
+
+    void render_frame(uint32_t[]) { ADD_FAILURE() << "Shades were expanded"; }
+    bool accepts_shades() const { return true; }
+    uint8_t* lock_shades(int& pitch) {
+        pitch = PITCH;
+        return shades.data();
+    }
+    void unlock_frame() { ++unlocks; }
+
+    std::vector<uint8_t> shades;
+    int unlocks = 0;
+};
+
+// A disk that stands still until opened
+class BlockedBuffer : public std::stringbuf {
+public:
+    void open() {
+        std::lock_guard<std::mutex> lock(mutex);
+        is_open = true;
+        opened.notify_all();
+    }
+
+protected:
+    std::streamsize xsputn(const char* s, std::streamsize count) {
+        std::unique_lock<std::mutex> lock(mutex);
+        opened.wait(lock, [this]() { return is_open; });
+        return std::stringbuf::xsputn(s, count);
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable opened;
+    bool is_open = false;
+};
+
+std::vector<CaptureFrame> decode(const std::string& data) {
+    return decode_capture(reinterpret_cast<const uint8_t*>(data.data()), data.size());
+}
+
+}
+
+
+TEST(RecordingRendererTest, records_and_passes_on_frames) {
+    ColorRenderer target;
+    std::ostringstream out;
+    {
+        RecordingRenderer renderer(target, out);
+        for (uint8_t shade : {1, 3}) {
+            std::vector<uint8_t> frame(PIXELS, shade);
+            renderer.render_shades(frame.data());
+        }
+        std::vector<uint32_t> colors(PIXELS, 0x005C5C5C);
+        renderer.render_frame(colors.data());
+    }
+
+    EXPECT_EQ(target.frames, (std::vector<uint32_t>{0x00C0C0C0, 0x00000000, 0x005C5C5C}));
+
+    std::vector<CaptureFrame> frames = decode(out.str());
+    ASSERT_EQ(frames.size(), 3u);
+    EXPECT_EQ(frames[0].shades, std::vector<uint8_t>(PIXELS, Renderer::SHADE_LIGHT_GREY));
+    EXPECT_EQ(frames[1].shades, std::vector<uint8_t>(PIXELS, Renderer::SHADE_BLACK));
+    EXPECT_EQ(frames[2].shades, std::vector<uint8_t>(PIXELS, Renderer::SHADE_DARK_GREY));
+}
+
+TEST(RecordingRendererTest, draws_into_locking_target) {
+    LockingShadeRenderer target;
+    std::ostringstream out;
+    {
+        RecordingRenderer renderer(target, out);
+        int pitch;
+        uint8_t* frame = renderer.lock_shades(pitch);
+        ASSERT_EQ(frame, target.shades.data());
+        ASSERT_EQ(pitch, static_cast<int>(LockingShadeRenderer::PITCH));
+        frame[pitch + 1] = Renderer::SHADE_BLACK;
+        renderer.unlock_frame();
+    }
+
+    EXPECT_EQ(target.unlocks, 1);
+    std::vector<CaptureFrame> frames = decode(out.str());
+    ASSERT_EQ(frames.size(), 1u);
+    EXPECT_EQ(frames[0].shades[Renderer::SCREEN_WIDTH + 1], Renderer::SHADE_BLACK);
+    EXPECT_EQ(frames[0].shades[Renderer::SCREEN_WIDTH], Renderer::SHADE_WHITE);
+}
+
+TEST(RecordingRendererTest, drops_frames_when_the_pool_is_full) {
+    ColorRenderer target;
+    BlockedBuffer buffer;
+    std::ostream out(&buffer);
+    const int POOL_FRAMES = 4;
+    {
+        RecordingRenderer renderer(target, out, RecordingRenderer::FORMAT_INDEXED, POOL_FRAMES);
+        std::vector<uint8_t> frame(PIXELS);
+        for (int i = 0; i != POOL_FRAMES + 2; ++i) {
+            frame[0] = i % Renderer::NBR_SHADES;
+            renderer.render_shades(frame.data());
+        }
+
+        // Nothing waited for the writer
+        EXPECT_EQ(target.frames.size(), static_cast<size_t>(POOL_FRAMES + 2));
+        EXPECT_EQ(renderer.get_dropped_frames(), 2u);
+        EXPECT_EQ(renderer.get_written_frames(), 0u);
+
+        buffer.open();
+    }
+
+    std::vector<CaptureFrame> frames = decode(buffer.str());
+    ASSERT_EQ(frames.size(), static_cast<size_t>(POOL_FRAMES));
+    EXPECT_EQ(frames.back().frame, static_cast<uint64_t>(POOL_FRAMES - 1));
+}
+
+TEST(RecordingRendererTest, writes_raw_yuv) {
+    ColorRenderer target;
+    std::ostringstream out;
+    {
+        RecordingRenderer renderer(target, out, RecordingRenderer::FORMAT_YUV);
+        std::vector<uint8_t> frame(PIXELS, Renderer::SHADE_BLACK);
+        renderer.render_shades(frame.data());
+        renderer.render_shades(frame.data());
+        EXPECT_FALSE(renderer.has_failed());
+    }
+
+    std::string data = out.str();
+    ASSERT_EQ(data.size(), static_cast<size_t>(2 * YUV_FRAME_SIZE));
+    EXPECT_EQ(static_cast<uint8_t>(data[0]), 16);
+    EXPECT_EQ(static_cast<uint8_t>(data[YUV_FRAME_SIZE - 1]), 128);
+}
+
+
+}
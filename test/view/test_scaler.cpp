@@ -0,0 +1,175 @@
+#include <gtest/gtest.h>
+
+#include "view/renderer.h"
+#include "view/scaler.h"
+
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace geemuboi::view {
+
+
+namespace {
+
+const int WIDTH = Renderer::SCREEN_WIDTH;
+const int HEIGHT = Renderer::SCREEN_HEIGHT;
+
+const uint32_t WHITE = 0x00FFFFFF;
+const uint32_t BLACK = 0x00000000;
+
+// Few colors, so that the neighbour comparisons hit often
+std::vector<uint32_t> random_screen(unsigned seed) {
+    std::mt19937 random(seed);
+    std::uniform_int_distribution<int> shades(0, 3);
+    const uint32_t COLORS[] = {0x00FFFFFF, 0x00C0C0C0, 0x005C5C5C, 0x00000000};
+
+    std::vector<uint32_t> screen(WIDTH * HEIGHT);
+    for (uint32_t& pixel : screen) {
+        pixel = COLORS[shades(random)];
+    }
+    return screen;
+}
+
+uint32_t at(const std::vector<uint32_t>& screen, int x, int y) {
+    x = std::clamp(x, 0, WIDTH - 1);
+    y = std::clamp(y, 0, HEIGHT - 1);
+    return screen[y * WIDTH + x];
+}
+
+std::vector<uint32_t> reference_scale2x(const std::vector<uint32_t>& src) {
+    std::vector<uint32_t> dst(WIDTH * HEIGHT * 4);
+    for (int y = 0; y != HEIGHT; ++y) {
+        for (int x = 0; x != WIDTH; ++x) {
+            uint32_t b = at(src, x, y - 1);
+            uint32_t d = at(src, x - 1, y);
+            uint32_t e = at(src, x, y);
+            uint32_t f = at(src, x + 1, y);
+            uint32_t h = at(src, x, y + 1);
+
+            uint32_t* out = &dst[y * 2 * WIDTH * 2 + x * 2];
+            out[0] = (d == b && b != f && d != h) ? d : e;
+            out[1] = (b == f && b != d && f != h) ? f : e;
+            out[WIDTH * 2] = (d == h && d != b && h != f) ? d : e;
+            out[WIDTH * 2 + 1] = (h == f && d != h && b != f) ? f : e;
+        }
+    }
+    return dst;
+}
+
+std::vector<uint32_t> reference_scale3x(const std::vector<uint32_t>& src) {
+    std::vector<uint32_t> dst(WIDTH * HEIGHT * 9);
+    for (int y = 0; y != HEIGHT; ++y) {
+        for (int x = 0; x != WIDTH; ++x) {
+            uint32_t a = at(src, x - 1, y - 1);
+            uint32_t b = at(src, x, y - 1);
+            uint32_t c = at(src, x + 1, y - 1);
+            uint32_t d = at(src, x - 1, y);
+            uint32_t e = at(src, x, y);
+            uint32_t f = at(src, x + 1, y);
+            uint32_t g = at(src, x - 1, y + 1);
+            uint32_t h = at(src, x, y + 1);
+            uint32_t i = at(src, x + 1, y + 1);
+
+            uint32_t* out = &dst[y * 3 * WIDTH * 3 + x * 3];
+            int pitch = WIDTH * 3;
+            if (b != h && d != f) {
+                out[0] = d == b ? d : e;
+                out[1] = (d == b && e != c) || (b == f && e != a) ? b : e;
+                out[2] = b == f ? f : e;
+                out[pitch] = (d == b && e != g) || (d == h && e != a) ? d : e;
+                out[pitch + 1] = e;
+                out[pitch + 2] = (b == f && e != i) || (h == f && e != c) ? f : e;
+                out[pitch * 2] = d == h ? d : e;
+                out[pitch * 2 + 1] = (d == h && e != i) || (h == f && e != g) ? h : e;
+                out[pitch * 2 + 2] = h == f ? f : e;
+            } else {
+                for (int row = 0; row != 3; ++row) {
+                    std::fill(out + row * pitch, out + row * pitch + 3, e);
+                }
+            }
+        }
+    }
+    return dst;
+}
+
+}
+
+
+TEST(ScalerTest, factors) {
+    EXPECT_EQ(Scaler(Scaler::FILTER_NEAREST, 4).get_factor(), 4);
+    EXPECT_EQ(Scaler(Scaler::FILTER_SCALE2X).get_factor(), 2);
+    EXPECT_EQ(Scaler(Scaler::FILTER_SCALE3X).get_factor(), 3);
+    EXPECT_EQ(Scaler(Scaler::FILTER_XBR_LITE).get_factor(), 2);
+    EXPECT_THROW(Scaler(Scaler::FILTER_NEAREST, 0), std::invalid_argument);
+    EXPECT_THROW(Scaler(42), std::invalid_argument);
+}
+
+TEST(ScalerTest, nearest_repeats_pixels) {
+    std::vector<uint32_t> src = random_screen(1);
+    for (int factor : {1, 2, 3, 5}) {
+        Scaler scaler(Scaler::FILTER_NEAREST, factor);
+        int pitch = WIDTH * factor + 3;
+        std::vector<uint32_t> dst(pitch * HEIGHT * factor);
+        scaler.scale(src.data(), WIDTH, dst.data(), pitch);
+
+        for (int y = 0; y != HEIGHT * factor; ++y) {
+            for (int x = 0; x != WIDTH * factor; ++x) {
+                ASSERT_EQ(dst[y * pitch + x], src[y / factor * WIDTH + x / factor]);
+            }
+        }
+    }
+}
+
+TEST(ScalerTest, scale2x_matches_reference) {
+    for (unsigned seed : {1u, 2u, 3u}) {
+        std::vector<uint32_t> src = random_screen(seed);
+        std::vector<uint32_t> dst(WIDTH * HEIGHT * 4);
+        Scaler(Scaler::FILTER_SCALE2X).scale(src.data(), WIDTH, dst.data(), WIDTH * 2);
+        EXPECT_EQ(dst, reference_scale2x(src));
+    }
+}
+
+TEST(ScalerTest, scale3x_matches_reference) {
+    for (unsigned seed : {1u, 2u, 3u}) {
+        std::vector<uint32_t> src = random_screen(seed);
+        std::vector<uint32_t> dst(WIDTH * HEIGHT * 9);
+        Scaler(Scaler::FILTER_SCALE3X).scale(src.data(), WIDTH, dst.data(), WIDTH * 3);
+        EXPECT_EQ(dst, reference_scale3x(src));
+    }
+}
+
+TEST(ScalerTest, xbr_keeps_flat_areas) {
+    std::vector<uint32_t> src(WIDTH * HEIGHT, 0x00C0C0C0);
+    std::vector<uint32_t> dst(WIDTH * HEIGHT * 4);
+    Scaler(Scaler::FILTER_XBR_LITE).scale(src.data(), WIDTH, dst.data(), WIDTH * 2);
+
+    EXPECT_EQ(dst, std::vector<uint32_t>(WIDTH * HEIGHT * 4, 0x00C0C0C0));
+}
+
+TEST(ScalerTest, xbr_smooths_diagonal_edges) {
+    // Black below the diagonal, white above it
+    std::vector<uint32_t> src(WIDTH * HEIGHT);
+    for (int y = 0; y != HEIGHT; ++y) {
+        for (int x = 0; x != WIDTH; ++x) {
+            src[y * WIDTH + x] = x < y ? BLACK : WHITE;
+        }
+    }
+
+    std::vector<uint32_t> dst(WIDTH * HEIGHT * 4);
+    Scaler(Scaler::FILTER_XBR_LITE).scale(src.data(), WIDTH, dst.data(), WIDTH * 2);
+
+    // The white pixel on the diagonal gets its lower left corner cut
+    int x = 40;
+    int y = 40;
+    EXPECT_EQ(dst[(y * 2) * WIDTH * 2 + x * 2], WHITE);
+    EXPECT_EQ(dst[(y * 2 + 1) * WIDTH * 2 + x * 2 + 1], WHITE);
+    EXPECT_EQ(dst[(y * 2 + 1) * WIDTH * 2 + x * 2], 0x00808080u);
+
+    // Away from the edge nothing changes
+    EXPECT_EQ(dst[(y * 2) * WIDTH * 2 + (x + 10) * 2], WHITE);
+    EXPECT_EQ(dst[(y * 2) * WIDTH * 2 + (x - 10) * 2], BLACK);
+}
+
+
+}
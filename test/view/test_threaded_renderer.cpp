@@ -0,0 +1,154 @@
+#include <gtest/gtest.h>
+
+#include "view/threaded_renderer.h"
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace geemuboi::view {
+
+
+namespace {
+
+const uint32_t LIGHT_GREY = 0x00C0C0C0;
+const uint32_t DARK_GREY = 0x005C5C5C;
+const uint32_t BLACK = 0x00000000;
+
+class RecordingRenderer : public Renderer {
+public:
+    void render_frame(uint32_t img[]) {
+        frames.push_back(img[0]);
+    }
+
+    std::vector<uint32_t> frames;
+};
+
+class ShadeRenderer : public Renderer {
+public:
+    void render_frame(uint32_t[]) { ADD_FAILURE() << "Shades were expanded"; }
+    bool accepts_shades() const { return true; }
+    void render_shades(uint8_t shades[]) { frames.push_back(shades[0]); }
+
+    std::vector<uint8_t> frames;
+};
+
+class LockingRenderer : public Renderer {
+public:
+    static const int PITCH = SCREEN_WIDTH + 8;
+    static constexpr uint32_t PADDING = 0xDEADBEEF;
+
+    LockingRenderer() : pixels(PITCH * SCREEN_HEIGHT, PADDING) {}
+
+    void render_frame(uint32_t[]) { ADD_FAILURE() << "Frame wasn't expanded in place"; }
+    uint32_t* lock_frame(int& pitch) {
+        pitch = PITCH;
+        return pixels.data();
+    }
+
+    std::vector<uint32_t> pixels;
+};
+
+std::vector<uint8_t> make_shades(uint8_t shade) {
+    return std::vector<uint8_t>(Renderer::SCREEN_WIDTH * Renderer::SCREEN_HEIGHT, shade);
+}
+
+}
+
+
+TEST(ThreadedRendererTest, present_times_out_without_frames) {
+    RecordingRenderer target;
+    ThreadedRenderer renderer(target);
+
+    EXPECT_FALSE(renderer.present(std::chrono::milliseconds(1)));
+    EXPECT_TRUE(target.frames.empty());
+}
+
+TEST(ThreadedRendererTest, presents_newest_frame) {
+    RecordingRenderer target;
+    ThreadedRenderer renderer(target);
+
+    for (uint8_t shade : {1, 3, 2}) {
+        std::vector<uint8_t> frame = make_shades(shade);
+        renderer.render_shades(frame.data());
+    }
+
+    EXPECT_TRUE(renderer.present(std::chrono::milliseconds(1)));
+    EXPECT_FALSE(renderer.present(std::chrono::milliseconds(1)));
+    EXPECT_EQ(target.frames, std::vector<uint32_t>{DARK_GREY});
+}
+
+TEST(ThreadedRendererTest, present_wakes_up_for_frame) {
+    RecordingRenderer target;
+    ThreadedRenderer renderer(target);
+
+    std::thread emulation([&renderer]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        std::vector<uint8_t> frame = make_shades(Renderer::SHADE_BLACK);
+        renderer.render_shades(frame.data());
+    });
+
+    EXPECT_TRUE(renderer.present(std::chrono::seconds(5)));
+    emulation.join();
+    EXPECT_EQ(target.frames, std::vector<uint32_t>{BLACK});
+}
+
+TEST(ThreadedRendererTest, locked_shades_are_presented_on_unlock) {
+    RecordingRenderer target;
+    ThreadedRenderer renderer(target);
+
+    int pitch;
+    uint8_t* frame = renderer.lock_shades(pitch);
+    EXPECT_EQ(pitch, static_cast<int>(Renderer::SCREEN_WIDTH));
+    frame[0] = Renderer::SHADE_LIGHT_GREY;
+    EXPECT_FALSE(renderer.present(std::chrono::milliseconds(1)));
+
+    renderer.unlock_frame();
+    EXPECT_TRUE(renderer.present(std::chrono::milliseconds(1)));
+    EXPECT_EQ(target.frames, std::vector<uint32_t>{LIGHT_GREY});
+}
+
+TEST(ThreadedRendererTest, colors_are_reduced_to_shades) {
+    RecordingRenderer target;
+    ThreadedRenderer renderer(target);
+
+    for (uint32_t color : {LIGHT_GREY, DARK_GREY}) {
+        std::vector<uint32_t> frame(Renderer::SCREEN_WIDTH * Renderer::SCREEN_HEIGHT, color);
+        renderer.render_frame(frame.data());
+        EXPECT_TRUE(renderer.present(std::chrono::milliseconds(1)));
+    }
+
+    EXPECT_EQ(target.frames, (std::vector<uint32_t>{LIGHT_GREY, DARK_GREY}));
+}
+
+TEST(ThreadedRendererTest, shades_are_passed_on_unexpanded) {
+    ShadeRenderer target;
+    ThreadedRenderer renderer(target);
+
+    std::vector<uint8_t> frame = make_shades(Renderer::SHADE_DARK_GREY);
+    renderer.render_shades(frame.data());
+    EXPECT_TRUE(renderer.present(std::chrono::milliseconds(1)));
+
+    EXPECT_EQ(target.frames, std::vector<uint8_t>{Renderer::SHADE_DARK_GREY});
+}
+
+TEST(ThreadedRendererTest, expands_rows_into_locking_target) {
+    LockingRenderer target;
+    ThreadedRenderer renderer(target);
+
+    std::vector<uint8_t> frame = make_shades(0);
+    for (std::size_t i = 0; i != frame.size(); ++i) {
+        frame[i] = i % Renderer::NBR_SHADES;
+    }
+    renderer.render_shades(frame.data());
+    EXPECT_TRUE(renderer.present(std::chrono::milliseconds(1)));
+
+    // Pixel 161 is shade 1 and the last one shade 3
+    int last_y = Renderer::SCREEN_HEIGHT - 1;
+    EXPECT_EQ(target.pixels[LockingRenderer::PITCH + 1], LIGHT_GREY);
+    EXPECT_EQ(target.pixels[last_y * LockingRenderer::PITCH + Renderer::SCREEN_WIDTH - 1], BLACK);
+    EXPECT_EQ(target.pixels[Renderer::SCREEN_WIDTH], LockingRenderer::PADDING);
+}
+
+
+}
@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+
+#include "view/triple_buffer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+namespace geemuboi::view {
+
+
+TEST(TripleBufferTest, nothing_to_acquire_before_publish) {
+    TripleBuffer<uint32_t> buffer(4);
+    EXPECT_FALSE(buffer.acquire());
+}
+
+TEST(TripleBufferTest, published_frame_is_acquired_once) {
+    TripleBuffer<uint32_t> buffer(4);
+    std::fill(buffer.get_back(), buffer.get_back() + 4, 7);
+    buffer.publish();
+
+    EXPECT_TRUE(buffer.acquire());
+    EXPECT_EQ(buffer.get_front()[3], 7u);
+    EXPECT_FALSE(buffer.acquire());
+    EXPECT_EQ(buffer.get_front()[3], 7u);
+}
+
+TEST(TripleBufferTest, newest_frame_wins) {
+    TripleBuffer<uint32_t> buffer(4);
+    for (uint32_t frame = 1; frame != 4; ++frame) {
+        std::fill(buffer.get_back(), buffer.get_back() + 4, frame);
+        buffer.publish();
+    }
+
+    EXPECT_TRUE(buffer.acquire());
+    EXPECT_EQ(buffer.get_front()[0], 3u);
+}
+
+TEST(TripleBufferTest, producer_never_writes_the_front) {
+    TripleBuffer<uint32_t> buffer(4);
+    std::fill(buffer.get_back(), buffer.get_back() + 4, 1);
+    buffer.publish();
+    ASSERT_TRUE(buffer.acquire());
+
+    for (uint32_t frame = 2; frame != 10; ++frame) {
+        ASSERT_NE(buffer.get_back(), buffer.get_front());
+        std::fill(buffer.get_back(), buffer.get_back() + 4, frame);
+        buffer.publish();
+    }
+
+    EXPECT_EQ(buffer.get_front()[0], 1u);
+}
+
+TEST(TripleBufferTest, frames_are_whole_and_in_order_across_threads) {
+    const int FRAME_SIZE = 160 * 144;
+    const uint32_t FRAMES = 2000;
+    TripleBuffer<uint32_t> buffer(FRAME_SIZE);
+    std::atomic<bool> done{false};
+
+    std::thread producer([&]() {
+        for (uint32_t frame = 1; frame <= FRAMES; ++frame) {
+            std::fill(buffer.get_back(), buffer.get_back() + FRAME_SIZE, frame);
+            buffer.publish();
+        }
+        done = true;
+    });
+
+    uint32_t last = 0;
+    for (;;) {
+        bool finished = done;
+        if (!buffer.acquire()) {
+            if (finished) {
+                break;
+            }
+            continue;
+        }
+
+        const uint32_t* front = buffer.get_front();
+        ASSERT_GT(front[0], last);
+        ASSERT_TRUE(std::all_of(front, front + FRAME_SIZE, [&](uint32_t p) { return p == front[0]; }));
+        last = front[0];
+    }
+
+    producer.join();
+}
+
+
+}